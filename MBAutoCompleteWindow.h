@@ -15,7 +15,7 @@
 @interface MBAutoCompleteWindow : NSPanel
 
 @property (nonatomic, weak) id<MBAutoSelectDelegate> selectionDelegate;
-@property (nonatomic, strong) NSArray<NSString *> *completions;
+@property (nonatomic, copy) NSArray<NSString *> *completions;
 
 - (void)moveRowDown:(id)sender;
 - (void)moveRowUp:(id)sender;
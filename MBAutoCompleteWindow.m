@@ -27,41 +27,44 @@
 }
 
 - (void)setCompletions:(NSArray<NSString *> *)completions {
-	_completions = completions;
+	NSArray<NSString *> *previousCompletions = _completions;
+	_completions = [completions copy];
 	
-	if (!self.tableView) {
+	if (self.tableView) {
+		[self _updateTableViewFromCompletions:previousCompletions];
+		return;
+	}
 	
-		NSTableColumn *column1 = [[NSTableColumn alloc] initWithIdentifier:@"text"];
-		[column1 setEditable:NO];
-		[column1 setWidth:self.frame.size.width - 15];
-		
-		NSRect bounds = self.frame;
-		bounds.origin.x = 0;
-		bounds.origin.y = 0;
-		NSTableView *tableView = [[NSTableView alloc] initWithFrame:bounds];
-		self.tableView = tableView;
-		[tableView setSelectionHighlightStyle:NSTableViewSelectionHighlightStyleRegular];
-		[tableView setBackgroundColor:[NSColor clearColor]];
-		[tableView setIntercellSpacing:NSMakeSize(12, 0)];
-		[tableView setHeaderView:nil];
-		[tableView setRefusesFirstResponder:NO];
-		[tableView addTableColumn:column1];
-		[tableView setDelegate:self];
-		[tableView setDataSource:self];
-		
-		NSScrollView *tableScrollView = [[NSScrollView alloc] initWithFrame:bounds];
-		[tableScrollView setDrawsBackground:NO];
-		[tableScrollView setDocumentView:tableView];
-		[tableScrollView setHasVerticalScroller:YES];
-		tableScrollView.autoresizesSubviews = YES;
-		self.scrollView = tableScrollView;
-		
-		[self.contentView addSubview:tableScrollView];
+	NSTableColumn *column1 = [[NSTableColumn alloc] initWithIdentifier:@"text"];
+	[column1 setEditable:NO];
+	[column1 setWidth:self.frame.size.width - 15];
+	
+	NSRect bounds = self.frame;
+	bounds.origin.x = 0;
+	bounds.origin.y = 0;
+	NSTableView *tableView = [[NSTableView alloc] initWithFrame:bounds];
+	self.tableView = tableView;
+	[tableView setSelectionHighlightStyle:NSTableViewSelectionHighlightStyleRegular];
+	[tableView setBackgroundColor:[NSColor clearColor]];
+	[tableView setIntercellSpacing:NSMakeSize(12, 0)];
+	[tableView setHeaderView:nil];
+	[tableView setRefusesFirstResponder:NO];
+	[tableView addTableColumn:column1];
+	[tableView setDelegate:self];
+	[tableView setDataSource:self];
+	
+	NSScrollView *tableScrollView = [[NSScrollView alloc] initWithFrame:bounds];
+	[tableScrollView setDrawsBackground:NO];
+	[tableScrollView setDocumentView:tableView];
+	[tableScrollView setHasVerticalScroller:YES];
+	tableScrollView.autoresizesSubviews = YES;
+	self.scrollView = tableScrollView;
+	
+	[self.contentView addSubview:tableScrollView];
 
-		self.contentView.autoresizesSubviews = YES;
+	self.contentView.autoresizesSubviews = YES;
 
-		[self.tableView scrollToBeginningOfDocument:nil];
-	}
+	[self.tableView scrollToBeginningOfDocument:nil];
 	
 	[self.tableView setFrameSize:self.frame.size];
 	[self.scrollView setFrameSize:self.frame.size];
@@ -69,6 +72,44 @@
 	[self.scrollView flashScrollers];
 }
 
+- (void)_updateTableViewFromCompletions:(NSArray<NSString *> *)previousCompletions {
+	if (!NSEqualSizes(self.scrollView.frame.size, self.frame.size)) {
+		[self.tableView setFrameSize:self.frame.size];
+		[self.scrollView setFrameSize:self.frame.size];
+	}
+	
+	// Typing another character usually just narrows the list, so remove and insert rows rather than reloading them all
+	NSSet<NSString *> *previousSet = [NSSet setWithArray:previousCompletions];
+	NSSet<NSString *> *currentSet = [NSSet setWithArray:self.completions];
+	
+	NSIndexSet *removedIndexes = [previousCompletions indexesOfObjectsPassingTest:^BOOL(NSString *completion, NSUInteger index, BOOL *stop) {
+		return ![currentSet containsObject:completion];
+	}];
+	NSIndexSet *insertedIndexes = [self.completions indexesOfObjectsPassingTest:^BOOL(NSString *completion, NSUInteger index, BOOL *stop) {
+		return ![previousSet containsObject:completion];
+	}];
+	
+	// The rows that stay must keep their order, otherwise the diff doesn't describe the change
+	NSMutableArray<NSString *> *keptPrevious = [previousCompletions mutableCopy];
+	[keptPrevious removeObjectsAtIndexes:removedIndexes];
+	NSMutableArray<NSString *> *keptCurrent = [self.completions mutableCopy];
+	[keptCurrent removeObjectsAtIndexes:insertedIndexes];
+	
+	if (previousSet.count != previousCompletions.count || currentSet.count != self.completions.count || ![keptPrevious isEqualToArray:keptCurrent]) {
+		[self.tableView reloadData];
+		return;
+	}
+	
+	if (removedIndexes.count == 0 && insertedIndexes.count == 0) {
+		return;
+	}
+	
+	[self.tableView beginUpdates];
+	[self.tableView removeRowsAtIndexes:removedIndexes withAnimation:NSTableViewAnimationEffectNone];
+	[self.tableView insertRowsAtIndexes:insertedIndexes withAnimation:NSTableViewAnimationEffectNone];
+	[self.tableView endUpdates];
+}
+
 - (void)moveRowDown:(id)sender {
 	NSInteger selectedRow = self.tableView.selectedRow;
 	
@@ -33,7 +33,7 @@ typedef enum : NSUInteger {
 	MBSortUndetermined
 } MBSortDirection;
 
-@class MBTableGridHeaderView, MBTableGridFooterView, MBTableGridHeaderCell, MBTableGridContentView, MBTableGridShadowView;
+@class MBTableGridHeaderView, MBTableGridFooterView, MBTableGridHeaderCell, MBTableGridContentView, MBTableGridShadowView, MBTableGridDisplayList, MBTableGridUndoJournal, MBTableGridSelection, MBTableGridSortKey, MBTableGridFilter, MBTableGridStatistics, MBTableGridColumnStatistics;
 @protocol MBTableGridDelegate, MBTableGridDataSource;
 
 /* Notifications */
@@ -78,6 +78,17 @@ APPKIT_EXTERN NSString *MBTableGridDidMoveColumnsNotification;
 APPKIT_EXTERN NSString *MBTableGridDidMoveRowsNotification;
 APPKIT_EXTERN NSString *MBTableGridDidResizeColumnNotification;
 
+/**
+ * @brief		Posted when a search started with
+ *				\c findString:options: finds more matches, and once
+ *				more when it ends. The notification object is the
+ *				table grid being searched. The \c userInfo dictionary
+ *				contains the following information:
+ *				- \c @"Finished": An NSNumber holding \c YES if the
+ *					search has ended.
+ */
+APPKIT_EXTERN NSString *MBTableGridDidChangeFindMatchesNotification;
+
 APPKIT_EXTERN NSString *MBTableGridColumnDataType;
 APPKIT_EXTERN NSString *MBTableGridRowDataType;
 
@@ -93,6 +104,24 @@ typedef NS_ENUM(NSInteger, MBTableGridEdge) {
 	MBTableGridBottomEdge	= 4
 };
 
+typedef NS_OPTIONS(NSUInteger, MBTableGridFindOptions) {
+	MBTableGridFindCaseInsensitive		= 1 << 0,
+	MBTableGridFindWholeCell			= 1 << 1,
+	MBTableGridFindRawValues			= 1 << 2
+};
+
+typedef NS_ENUM(NSUInteger, MBTableGridAggregateFunction) {
+	MBTableGridAggregateSum,
+	MBTableGridAggregateMinimum,
+	MBTableGridAggregateMaximum,
+	MBTableGridAggregateAverage,
+	MBTableGridAggregateCount,
+	MBTableGridAggregateRowCount,
+	MBTableGridAggregateDistinctCount,
+	MBTableGridAggregateMedian,
+	MBTableGridAggregatePercentile95
+};
+
 typedef NS_ENUM(NSUInteger, MBHorizontalEdge) {
 	MBHorizontalEdgeLeft,
 	MBHorizontalEdgeRight
@@ -199,6 +228,34 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 - (void)reloadData;
 
+/**
+ * @brief		Tells the receiver that the data source has
+ *				inserted rows.
+ *
+ * @details		Use this rather than \c reloadData after adding
+ *				rows, so column aggregates move the rows after
+ *				them along instead of reading every column again,
+ *				and column widths are kept. Rows are sorted and
+ *				filtered again.
+ *
+ * @param		rowIndexes		The data source indexes of the new
+ *								rows, after they were inserted.
+ *
+ * @see			removeRowsAtIndexes:
+ */
+- (void)insertRowsAtIndexes:(NSIndexSet *)rowIndexes;
+
+/**
+ * @brief		Tells the receiver that the data source has
+ *				removed rows.
+ *
+ * @param		rowIndexes		The data source indexes the rows had
+ *								before they were removed.
+ *
+ * @see			insertRowsAtIndexes:
+ */
+- (void)removeRowsAtIndexes:(NSIndexSet *)rowIndexes;
+
 #pragma mark -
 #pragma mark Selecting Rows and Columns
 
@@ -294,16 +351,93 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 - (CGFloat)resizeColumnWithIndex:(NSUInteger)columnIndex withDistance:(float)distance location:(NSPoint)location;
 
+/**
+ * @brief		Resizes columns to fit their header and the text of
+ *				their cells.
+ *
+ * @details		Cells are measured as they are shown, formatted, on
+ *				background threads. Columns with up to 10,000 rows
+ *				are measured in full. Larger ones are measured from
+ *				an even sample of their rows and the rows on screen,
+ *				or from their statistics if these were already
+ *				worked out. The columns are resized together once
+ *				they have all been measured.
+ *
+ *				Double-clicking the separator after a column
+ *				autosizes it, unless the delegate implements
+ *				\c tableGrid:didDoubleClickSeparatorForColumn:.
+ *
+ * @param		columnIndexes	The columns to resize.
+ *
+ * @see			statisticsForColumn:completionHandler:
+ */
+- (void)autosizeColumns:(NSIndexSet *)columnIndexes;
+
 /**
  * @brief		Cache of column rects
  *
+ * @details		Column geometry is kept in an internal column
+ *				layout, so the grid neither reads nor clears this
+ *				dictionary. It is only kept for source
+ *				compatibility, and will be removed.
+ *
  * @return		A mutable dictionary containing the records for all the rows keyed by column index number
  *
  */
 
-@property (nonatomic, strong) NSMutableDictionary *columnRects;
+@property (nonatomic, strong) NSMutableDictionary *columnRects DEPRECATED_MSG_ATTRIBUTE("Column rects are no longer cached. Use rectOfColumn: instead.");
 
 
+/**
+ * @}
+ */
+
+#pragma mark -
+#pragma mark Hiding Columns
+
+/**
+ * @name		Hiding Columns
+ */
+/**
+ * @{
+ */
+
+/**
+ * @brief		Hides columns without changing the data source.
+ *
+ * @details		Hidden columns take up no space, aren't drawn and
+ *				can't be clicked, and the arrow keys step over them.
+ *				They keep their width for when they're shown again.
+ *				Hidden columns are saved with the other column
+ *				properties, and hidden again when the grid is first
+ *				loaded.
+ *
+ * @param		columnIndexes	The columns to hide.
+ *
+ * @see			unhideColumns:
+ * @see			hiddenColumnIndexes
+ */
+- (void)hideColumns:(NSIndexSet *)columnIndexes;
+
+/**
+ * @brief		Shows hidden columns again.
+ *
+ * @param		columnIndexes	The columns to show.
+ *
+ * @see			hideColumns:
+ */
+- (void)unhideColumns:(NSIndexSet *)columnIndexes;
+
+/**
+ * @brief		Returns whether a column is hidden.
+ */
+- (BOOL)isColumnHidden:(NSUInteger)columnIndex;
+
+/**
+ * @brief		The hidden columns.
+ */
+@property (nonatomic, readonly) NSIndexSet *hiddenColumnIndexes;
+
 /**
  * @}
  */
@@ -342,6 +476,127 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 @property(nonatomic, strong) NSMutableIndexSet *selectedRowIndexes;
 
+/**
+ * @brief		Returns every selected cell.
+ *
+ * @details		Command-clicking a cell when \c allowsMultipleSelection
+ *				is set keeps the current selection and starts a new
+ *				rectangle, so the selection can cover several
+ *				disjoint ranges. \c selectedColumnIndexes and
+ *				\c selectedRowIndexes describe only the rectangle
+ *				being edited, which is always the last one.
+ *
+ * @return		The selection, including the rectangle described by
+ *				\c selectedColumnIndexes and \c selectedRowIndexes.
+ *
+ * @see			selectedColumnIndexes
+ * @see			selectedRowIndexes
+ */
+@property(nonatomic, readonly) MBTableGridSelection *selection;
+
+/**
+ * @brief		The sum, count, extremes and average of the
+ *				selected cells.
+ *
+ * @details		Each column's selected rows are answered from its
+ *				aggregate tree in O(log n) per range of rows, so
+ *				this is cheap enough to read every time
+ *				\c MBTableGridDidChangeSelectionNotification is
+ *				posted, even while dragging out a selection. While
+ *				rows are sorted, filtered or grouped, a second tree
+ *				holds the same values in displayed order. It is
+ *				built in the background after the rows change,
+ *				without asking the data source, and kept up to date
+ *				by edits. Until a column's trees are built, its
+ *				selected cells are read one by one instead.
+ *				Cells count the same way as in
+ *				\c aggregateValue:forColumn:. The result is kept
+ *				until the selection or the values change.
+ */
+@property(nonatomic, readonly) MBTableGridStatistics *selectionStatistics;
+
+/**
+ * @}
+ */
+
+#pragma mark -
+#pragma mark Finding
+
+/**
+ * @name		Finding
+ */
+/**
+ * @{
+ */
+
+/**
+ * @brief		Searches every cell for a string.
+ *
+ * @details		Cells are compared in parallel on a background
+ *				queue, and matches are highlighted as they are
+ *				found. Group rows are not searched. Rows that are
+ *				filtered out or collapsed are, so sorting, filtering
+ *				and collapsing only move the highlights, and edited
+ *				cells are tested again on their own. Starting
+ *				another search cancels the current one, and
+ *				\c reloadData runs the search again.
+ *
+ *				Values are read from the data source on the main
+ *				thread, a little at a time, unless it returns
+ *				\c YES from \c tableGridSupportsConcurrentValueAccess:.
+ *
+ * @param		searchString	The text to look for. Passing an empty
+ *								string clears the matches.
+ * @param		options			By default, a cell matches if its
+ *								formatted text contains the string,
+ *								with the same case.
+ *
+ * @see			findNext:
+ * @see			findPrevious:
+ * @see			MBTableGridDidChangeFindMatchesNotification
+ */
+- (void)findString:(NSString *)searchString options:(MBTableGridFindOptions)options;
+
+/**
+ * @brief		Stops searching and removes the match highlights.
+ */
+- (void)clearFindMatches;
+
+/**
+ * @brief		Selects the first match after the selected cell,
+ *				going across each row and then down, and scrolls
+ *				to it. Wraps around at the end of the grid.
+ */
+- (IBAction)findNext:(id)sender;
+
+/**
+ * @brief		Selects the first match before the selected cell,
+ *				and scrolls to it. Wraps around at the start of the
+ *				grid.
+ */
+- (IBAction)findPrevious:(id)sender;
+
+/**
+ * @brief		The string the grid was last searched for, or
+ *				\c nil.
+ */
+@property (nonatomic, copy, readonly) NSString *findString;
+
+/**
+ * @brief		Whether a search is still running.
+ */
+@property (nonatomic, readonly, getter=isFinding) BOOL finding;
+
+/**
+ * @brief		The number of matching cells found so far.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfFindMatches;
+
+/**
+ * @brief		Returns the matching rows in a column.
+ */
+- (NSIndexSet *)findMatchesInColumn:(NSUInteger)columnIndex;
+
 /**
  * @}
  */
@@ -402,6 +657,309 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 - (NSImage *)indicatorImageInColumn:(NSUInteger)columnIndex;
 
+/**
+ * @}
+ */
+
+#pragma mark -
+#pragma mark Sorting
+
+/**
+ * @name		Sorting
+ */
+/**
+ * @{
+ */
+
+/**
+ * @brief		The columns the rows are sorted by, most significant
+ *				first.
+ *
+ * @details		Sorting never moves anything in the data source.
+ *				The grid keeps an order of its own, and translates
+ *				rows before asking the data source or the delegate
+ *				about a cell, so every \c row argument they receive
+ *				is a data source row. Selections, \c rectOfRow: and
+ *				the other layout methods work in displayed rows.
+ *
+ *				Rows are only sorted between group rows, which stay
+ *				where they are. Setting this property sorts the rows
+ *				at once; after that they are sorted again by
+ *				\c reloadData, not by each edit, so a row doesn't
+ *				jump away while it's being changed. Equal rows keep
+ *				their data source order.
+ *
+ *				Sorting by a column reads all its values. Implement
+ *				\c tableGrid:getSortValues:forColumn: to provide
+ *				them as numbers instead.
+ *
+ *				The header shows the direction of each key. Columns
+ *				for which \c tableGrid:sortDirectionForColumn:
+ *				returns \c MBSortUndetermined get a sort button that
+ *				sets this property, unless the delegate handles
+ *				\c tableGrid:didSortColumn: itself.
+ *
+ *				Set to an empty array to show the rows in data source
+ *				order.
+ *
+ * @see			modelRowForRow:
+ */
+@property (nonatomic, copy) NSArray<MBTableGridSortKey *> *sortKeys;
+
+/**
+ * @brief		Returns the data source row shown at a row, or
+ *				\c NSNotFound for a group row added by
+ *				\c groupingColumn.
+ *
+ * @see			rowForModelRow:
+ */
+- (NSUInteger)modelRowForRow:(NSUInteger)rowIndex;
+
+/**
+ * @brief		Returns the row a data source row is shown at, or
+ *				\c NSNotFound if it is filtered out or in a
+ *				collapsed group.
+ *
+ * @see			modelRowForRow:
+ */
+- (NSUInteger)rowForModelRow:(NSUInteger)modelRowIndex;
+
+/**
+ * @}
+ */
+
+#pragma mark -
+#pragma mark Filtering
+
+/**
+ * @name		Filtering
+ */
+/**
+ * @{
+ */
+
+/**
+ * @brief		The conditions a row has to meet to be shown.
+ *
+ * @details		A row is shown if it matches every filter. Group
+ *				rows are always shown. Hidden rows are skipped by
+ *				the layout, so \c numberOfRows only counts the rows
+ *				that are shown, and rows are translated to data
+ *				source rows the same way as when sorting.
+ *
+ *				Setting this property filters the rows at once,
+ *				without reloading the data or losing column widths.
+ *				After that, rows are filtered again by
+ *				\c reloadData, not by each edit. Numeric filters
+ *				are quickest on columns for which the data source
+ *				implements \c tableGrid:getSortValues:forColumn:.
+ *
+ * @see			rowForModelRow:
+ */
+@property (nonatomic, copy) NSArray<MBTableGridFilter *> *filters;
+
+/**
+ * @}
+ */
+
+#pragma mark -
+#pragma mark Grouping
+
+/**
+ * @name		Grouping
+ */
+/**
+ * @{
+ */
+
+/**
+ * @brief		The column whose values the rows are grouped by, or
+ *				\c NSNotFound to take group rows from the data
+ *				source.
+ *
+ * @details		Rows with equal values in the column are shown
+ *				together, under a heading row showing the value.
+ *				With \c includeGroupSummaryRows, each group ends
+ *				with a summary row showing the column's entry in
+ *				\c footerAggregates for the rows of the group.
+ *				These rows are added by the grid, so the data
+ *				source doesn't have any rows for them and isn't
+ *				asked \c tableGrid:isGroupRow:. \c modelRowForRow:
+ *				returns \c NSNotFound for them.
+ *
+ *				Groups are in ascending order of their value, or
+ *				in the direction of a sort key for the column in
+ *				\c sortKeys. The rows of each group are sorted by
+ *				the other sort keys, and hidden rows are left out,
+ *				so a group whose rows are all filtered out isn't
+ *				shown. Grouping sorts the rows the same way
+ *				\c sortKeys does, starting from the previous
+ *				order, and is quickest on columns for which the
+ *				data source implements
+ *				\c tableGrid:getSortValues:forColumn:.
+ *
+ *				Setting this property groups the rows at once.
+ *				After that they are grouped again by
+ *				\c reloadData, not by each edit.
+ */
+@property (nonatomic) NSUInteger groupingColumn;
+
+/**
+ * @brief		Hides the rows of the group that starts at a heading
+ *				row.
+ *
+ * @details		The group runs to the next heading at the same
+ *				level or above, as told by
+ *				\c tableGrid:levelOfGroupRow:, so nested groups
+ *				and the summary row are hidden with it. The heading
+ *				stays, with its disclosure triangle pointing right.
+ *				Clicking the triangle, or double clicking the
+ *				heading, collapses or expands the group too.
+ *
+ *				Hidden rows are skipped by the layout like filtered
+ *				rows, so \c numberOfRows, \c rectOfRow: and
+ *				\c rowAtPoint: only count the rows that are shown.
+ *				Collapsing or expanding a group doesn't sort or
+ *				filter the rows again, and takes about a word of
+ *				work for every 64 rows it hides or shows.
+ *
+ *				Groups stay collapsed when the rows are sorted,
+ *				filtered or reloaded. Groups from the data source
+ *				are remembered by the data source row of their
+ *				heading, and groups made by \c groupingColumn by
+ *				their value.
+ *
+ * @param		rowIndex	A group heading row. Other rows are ignored.
+ *
+ * @see			expandGroupRow:
+ */
+- (void)collapseGroupRow:(NSUInteger)rowIndex;
+
+/**
+ * @brief		Shows the rows of a collapsed group again, apart from
+ *				those in nested groups that are still collapsed.
+ *
+ * @param		rowIndex	A group heading row. Other rows are ignored.
+ *
+ * @see			collapseGroupRow:
+ */
+- (void)expandGroupRow:(NSUInteger)rowIndex;
+
+/**
+ * @brief		Returns whether a row is the heading of a collapsed
+ *				group.
+ */
+- (BOOL)isGroupRowCollapsed:(NSUInteger)rowIndex;
+
+/**
+ * @}
+ */
+
+#pragma mark -
+#pragma mark Aggregates
+
+/**
+ * @name		Aggregates
+ */
+/**
+ * @{
+ */
+
+/**
+ * @brief		Returns the sum, minimum, maximum, average or
+ *				count of the values in a column.
+ *
+ * @details		The first time a column is asked about, its values
+ *				are read into an aggregate tree, from
+ *				\c tableGrid:getSortValues:forColumn: if the data
+ *				source implements it. After that, edits made through
+ *				the grid, rows moved by dragging, and
+ *				\c insertRowsAtIndexes: and \c removeRowsAtIndexes:
+ *				keep it up to date, and \c reloadData starts again.
+ *				Text counts by its numeric value. Empty cells and
+ *				group rows are left out, except by
+ *				\c MBTableGridAggregateRowCount, which counts every
+ *				row that isn't a group row.
+ *
+ *				The distinct count, median and 95th percentile are
+ *				estimates from sketches, built on a background queue
+ *				the first time they're asked for. Until they're
+ *				ready, \c nil is returned, and the footer and group
+ *				summary rows are redrawn when they are. The distinct
+ *				count is usually within 1.6% of the exact count, and
+ *				the percentiles are values whose rank is within
+ *				about 1.3% of the rank asked for. Edits are added to
+ *				the sketches, which are built again once more than
+ *				1/64 of the rows have changed.
+ *
+ * @return		The value, or \c nil if there are no values to take
+ *				the minimum, maximum or average of.
+ */
+- (NSNumber *)aggregateValue:(MBTableGridAggregateFunction)function forColumn:(NSUInteger)columnIndex;
+
+/**
+ * @brief		Returns an aggregate of the rows in the group a
+ *				summary row belongs to.
+ *
+ * @details		Groups are taken from the data source, so rows
+ *				hidden by \c filters still count, except for groups
+ *				made by \c groupingColumn, which only count the rows
+ *				shown. Results are
+ *				remembered until the column changes, so this is
+ *				cheap enough to call while drawing. The estimated
+ *				statistics are only kept for whole columns, so
+ *				return \c nil here.
+ *
+ * @see			aggregateValue:forColumn:
+ */
+- (NSNumber *)aggregateValue:(MBTableGridAggregateFunction)function forColumn:(NSUInteger)columnIndex groupSummaryRow:(NSUInteger)rowIndex;
+
+/**
+ * @brief		The aggregate shown in the footer of each column,
+ *				as \c MBTableGridAggregateFunction numbers keyed
+ *				by column index.
+ *
+ * @details		Columns in this dictionary get a footer popup
+ *				listing every aggregate of the column, and choosing
+ *				one from it changes this property. Since the
+ *				aggregates are kept up to date as cells change,
+ *				drawing the footer doesn't read the column.
+ *
+ *				Only used for columns whose footer the data source
+ *				doesn't provide through
+ *				\c tableGrid:footerCellForColumn: and
+ *				\c tableGrid:footerValueForColumn:.
+ */
+@property (nonatomic, copy) NSDictionary<NSNumber *, NSNumber *> *footerAggregates;
+
+/**
+ * @brief		Gets the empty cell count, numeric range, histogram,
+ *				value counts and widest text of a column.
+ *
+ * @details		The first request reads the column's data source
+ *				rows, group rows left out, and works the statistics
+ *				out on a background queue. Requests made meanwhile
+ *				wait for the same statistics, and later ones are
+ *				answered straight away from the ones kept. Editing
+ *				a cell through the grid, \c reloadData, moving
+ *				columns and \c insertRowsAtIndexes: or
+ *				\c removeRowsAtIndexes: throw them away. Requests
+ *				made before a change get statistics that include it.
+ *
+ *				Values are counted by their text as shown, for up
+ *				to 1024 different texts, and measured in
+ *				\c defaultCellFont or the font of the column's cell.
+ *
+ * @param		columnIndex			A column in the receiver.
+ * @param		completionHandler	Called on the main thread with the
+ *									statistics, or \c nil if there
+ *									is no such column or there wasn't
+ *									enough memory. Called before
+ *									returning if the statistics are
+ *									already known.
+ */
+- (void)statisticsForColumn:(NSUInteger)columnIndex completionHandler:(void (^)(MBTableGridColumnStatistics *statistics))completionHandler;
+
 /**
  * @}
  */
@@ -454,8 +1012,31 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 @property (nonatomic) NSString *autosaveName;
 
+/**
+ * @brief		Copies the selected cells to the general pasteboard.
+ *
+ * @details		If the delegate implements
+ *				\c tableGrid:copyCellsAtColumns:rows:, it is left to
+ *				do the copying. Otherwise the formatted values are
+ *				written as tab and comma separated text.
+ */
 - (void)copy:(id)sender;
 
+/**
+ * @brief		Pastes tab or comma separated text into the grid,
+ *				starting at the first selected cell.
+ *
+ * @details		If the delegate implements
+ *				\c tableGrid:pasteCellsAtColumns:rows:, it is left to
+ *				do the pasting. Otherwise the text is parsed, each
+ *				value is converted with the column's formatter, and
+ *				the editable cells are set as a single undo step.
+ *				When a single cell is selected, the whole of the
+ *				pasted text is used, up to the edges of the grid;
+ *				otherwise it is limited to the selection.
+ */
+- (void)paste:(id)sender;
+
 /**
  * @brief		Indicates whether the footer is hidden or visible
  *
@@ -501,6 +1082,64 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
 
 @property (nonatomic) BOOL includeOnlyGroupSummaryRows;
 
+/**
+ * @brief		Whether filling continues a series instead of
+ *				copying the value.
+ *
+ * @details		When this is \c YES and the cell being filled from
+ *				holds a number or a date, each filled cell is
+ *				offset from it by the step between the source cell
+ *				and the cell just before it (in the direction
+ *				opposite to the fill). If that cell doesn't hold a
+ *				value of the same kind, numbers step by 1 and
+ *				dates by one day. The default is \c NO.
+ *
+ * @see			fillDown:
+ * @see			fillUp:
+ */
+@property (nonatomic) BOOL fillIncrementsSeries;
+
+/**
+ * @brief		The most auto-completion strings offered while
+ *				editing a cell.
+ *
+ * @details		Longer lists returned by the data source are cut
+ *				to this length. The default is 50.
+ */
+@property (nonatomic) NSUInteger maximumNumberOfAutocompleteValues;
+
+/**
+ * @brief		The journal that holds the undo state for cell
+ *				changes made through the grid.
+ *
+ * @details		Use it to set how much memory undo may use, or how
+ *				consecutive edits are coalesced. Undoing or redoing
+ *				a change in the journal only redraws the cells it
+ *				touched; other undo actions reload the grid.
+ */
+@property (nonatomic, strong, readonly) MBTableGridUndoJournal *undoJournal;
+
+/**
+ * @brief		The number of times the scroll offset has been
+ *				applied to the grid's scroll views.
+ *
+ * @details		Together with \c scrollSynchronizationTime, this
+ *				can be used to measure the per-frame overhead of
+ *				keeping the headers, footer and frozen columns in
+ *				sync with the content while scrolling.
+ *
+ * @see			scrollSynchronizationTime
+ */
+@property (nonatomic, readonly) NSUInteger scrollSynchronizationCount;
+
+/**
+ * @brief		The total time, in seconds, spent applying the
+ *				scroll offset to the grid's scroll views.
+ *
+ * @see			scrollSynchronizationCount
+ */
+@property (nonatomic, readonly) NSTimeInterval scrollSynchronizationTime;
+
 /**
  * @}
  */
@@ -794,6 +1433,30 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 - (BOOL)isFrozenColumn:(NSUInteger)column;
 
+/**
+ * @brief		Returns the range of columns drawn by the frozen views.
+ *
+ * @details		The frozen content, header and footer views only
+ *				iterate over this range when drawing. The range is
+ *				empty when frozen columns are disabled.
+ *
+ * @return		The range of frozen columns.
+ * @see			unfrozenColumnRange
+ */
+- (NSRange)frozenColumnRange;
+
+/**
+ * @brief		Returns the range of columns drawn by the main views.
+ *
+ * @details		The main content, header and footer views skip any
+ *				frozen columns, since those are covered by the
+ *				frozen views.
+ *
+ * @return		The range of unfrozen columns.
+ * @see			frozenColumnRange
+ */
+- (NSRange)unfrozenColumnRange;
+
 /**
  * @brief		Scrolls between frozen and unfrozen columns, if needed.
  *
@@ -804,6 +1467,36 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 - (BOOL)scrollForFrozenColumnsFromColumn:(NSUInteger)fromColumn right:(BOOL)right;
 
+/**
+ * @}
+ */
+
+#pragma mark -
+#pragma mark Display Lists
+/**
+ * @name		Display Lists
+ */
+/**
+ * @{
+ */
+
+/**
+ * @brief		Records what the grid would draw in a rect.
+ *
+ * @details		Each visible header, footer and content view records
+ *				the part of \c rect it covers, in the same order the
+ *				views are layered, with every command offset into
+ *				the receiver's coordinates. The result can be
+ *				replayed into a headless backend to count or
+ *				serialize the drawing for a given viewport.
+ *
+ * @param		rect		The rect to record, in the receiver's
+ *							coordinates.
+ * @return		A new display list.
+ * @see			MBTableGridDisplayList
+ */
+- (MBTableGridDisplayList *)displayListForRect:(NSRect)rect;
+
 /**
  * @}
  */
@@ -899,6 +1592,45 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
 
 @optional
 
+/**
+ * @brief		Returns whether \c tableGrid:objectValueForColumn:row:
+ *				and \c tableGrid:formatterForColumn: may be called
+ *				from background threads, several at a time.
+ *
+ * @details		When this returns \c YES, searches read values in
+ *				parallel instead of on the main thread.
+ *
+ * @param		aTableGrid		The table grid that sent the message.
+ *
+ * @see			findString:options:
+ */
+- (BOOL)tableGridSupportsConcurrentValueAccess:(MBTableGrid *)aTableGrid;
+
+/**
+ * @brief		Provides the values of a column to sort and filter
+ *				by, as numbers.
+ *
+ * @details		Implement this for columns stored as numbers or
+ *				dates, so sorting and filtering don't have to ask
+ *				for every value as an object. Text can be provided
+ *				as a precomputed rank for sorting.
+ *
+ * @param		aTableGrid		The table grid that sent the message.
+ * @param		values			Room for one value per row, indexed by
+ *								data source row. Empty values should be
+ *								set to \c NAN, and sort last.
+ * @param		columnIndex		The column being sorted by.
+ *
+ * @return		\c YES if \c values was filled in, or \c NO to have
+ *				the object values sorted instead.
+ *
+ * @see			sortKeys
+ * @see			filters
+ */
+- (BOOL)tableGrid:(MBTableGrid *)aTableGrid getSortValues:(double *)values forColumn:(NSUInteger)columnIndex;
+
+@optional
+
 /**
  *  @brief      Returns the formatter associated with the specified column.
  *
@@ -962,6 +1694,64 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
 
 @optional
 
+/**
+ *  @brief      Offer auto-completion strings based on the user
+ *				input, without blocking the main thread.
+ *
+ *  @details	The data source can compute the strings on any queue
+ *				and call \c completionHandler once, on any thread.
+ *				If the user keeps typing before then, the table grid
+ *				asks again and ignores the earlier result. This is
+ *				used instead of
+ *				\c tableGrid:autocompleteValuesForEditString:column:row:
+ *				when both are implemented.
+ *
+ *  @param      aTableGrid			The table grid that sent the message.
+ *  @param      editString			The text the user entered in the cell editor.
+ *  @param      columnIndex			A column in \c aTableGrid.
+ *  @param		rowIndex			A row in \c aTableGrid.
+ *  @param		completionHandler	The block to call with the strings to offer.
+ */
+- (void)tableGrid:(MBTableGrid *)aTableGrid autocompleteValuesForEditString:(NSString *)editString column:(NSUInteger)columnIndex row:(NSUInteger)rowIndex completionHandler:(void (^)(NSArray *completions))completionHandler;
+
+@optional
+
+/**
+ *  @brief      Returns whether the table grid should offer
+ *				auto-completion strings from the values already in a
+ *				column.
+ *
+ *  @details	When this returns \c YES, the table grid builds a
+ *				prefix index of the column's values the first time
+ *				they are needed, keeps it up to date as cells are
+ *				edited, and rebuilds it on \c reloadData. Rows that
+ *				are filtered out or collapsed are indexed too, so
+ *				changing which rows are shown doesn't rebuild it.
+ *				Matches are
+ *				found without scanning the column, so this is the
+ *				better choice for large columns.
+ *
+ *				The index is built without blocking typing: values
+ *				are read in short batches on the main thread, or on
+ *				a background queue when
+ *				\c tableGridSupportsConcurrentValueAccess: returns
+ *				\c YES. No completions are offered until it's ready.
+ *
+ *				This is only used when neither of the
+ *				\c tableGrid:autocompleteValuesForEditString:column:row:
+ *				methods is implemented. Lookups run on a background
+ *				queue.
+ *
+ *  @param      aTableGrid      The table grid that sent the message.
+ *  @param      columnIndex     A column in \c aTableGrid.
+ *
+ *  @return		\c YES to offer the column's own values as
+ *				auto-completion strings.
+ */
+- (BOOL)tableGrid:(MBTableGrid *)aTableGrid shouldIndexAutocompleteValuesForColumn:(NSUInteger)columnIndex;
+
+@optional
+
 /**
  * @brief		Returns the background color for the specified column and row.
  *
@@ -1027,6 +1817,26 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
 
 @optional
 
+/**
+ * @brief		Sets the same data object for several rows of a
+ *				given column.
+ *
+ * @details		Implement this to make filling, and undoing fills,
+ *				of many rows fast. When it isn't implemented, the
+ *				grid calls \c tableGrid:setObjectValue:forColumn:row:
+ *				once per row instead.
+ *
+ * @param		aTableGrid		The table grid that sent the message.
+ * @param		anObject		The new value for the items.
+ * @param		columnIndex		A column in \c aTableGrid.
+ * @param		rowIndexes		The rows in \c aTableGrid to change.
+ *
+ * @see			tableGrid:setObjectValue:forColumn:row:
+ */
+- (void)tableGrid:(MBTableGrid *)aTableGrid setObjectValue:(id)anObject forColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes;
+
+@optional
+
 /**
  * @brief		Returnd the width of given column.
  *
@@ -1070,6 +1880,20 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 - (BOOL)tableGrid:(MBTableGrid *)aTableGrid isGroupRow:(NSUInteger)rowIndex;
 
+/**
+ *  @brief      Returns how deeply the group that starts at the specified group row is nested.
+ *
+ * @details		Optional; if not implemented, every group is at level 0. A group runs to the next
+ *				group row at the same level or above, so collapsing it hides the groups nested in it.
+ *				Nested headings are indented by their level.
+ *
+ *  @param      aTableGrid      The table grid that sent the message.
+ *  @param		rowIndex		A group row in \c aTableGrid.
+ *
+ *  @return     The level of the group, 0 for groups that aren't nested.
+ */
+- (NSUInteger)tableGrid:(MBTableGrid *)aTableGrid levelOfGroupRow:(NSUInteger)rowIndex;
+
 /**
  *  @brief      Returns the cell for the group summary of the specified column & row.
  *
@@ -1548,6 +2372,10 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  * @brief		Called when the sort indicator button is clicked
  *				in the column header.
  *
+ * @details		If the delegate doesn't implement this, clicking
+ *				the button makes the column the first of the grid's
+ *				\c sortKeys, or reverses it if it already was.
+ *
  * @param		aTableGrid		The table grid that sent the message.
  * @param		columnIndex		The index of the column.
  *
@@ -1624,6 +2452,23 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
  */
 - (BOOL)tableGrid:(MBTableGrid *)aTableGrid shouldEditColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 
+/**
+ * @brief		Asks the delegate which of several cells in a column
+ *				can be edited.
+ *
+ * @details		This is used when many cells are changed at once,
+ *				such as when clearing the selection. If it isn't
+ *				implemented, \c tableGrid:shouldEditColumn:row: is
+ *				asked about each cell instead.
+ *
+ * @param		aTableGrid		The table grid which will edit the cells.
+ * @param		columnIndex		The column of the cells.
+ * @param		rowIndexes		The rows of the cells.
+ *
+ * @return		The subset of \c rowIndexes that can be edited.
+ */
+- (NSIndexSet *)tableGrid:(MBTableGrid *)aTableGrid editableRowsInColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes;
+
 /**
  *  @brief      Asks the delegate if the specified cell can be filled.
  *
@@ -1655,6 +2500,8 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
 /**
  *  @brief      Informs the delegate of the cells that should be copied to the clipboard.
  *
+ *  @details    If this isn't implemented, the grid copies the cells itself.
+ *
  *  @param      aTableGrid       The table grid that contains the cell.
  *  @param      columnIndexes    Column indexes of the cells being copied.
  *  @param      rowIndexes       Row indexes of the cells being copied.
@@ -1664,6 +2511,8 @@ typedef NS_ENUM(NSUInteger, MBVerticalEdge) {
 /**
  *  @brief      Informs the delegate of the cells that should be pasted from the clipboard.
  *
+ *  @details    If this isn't implemented, the grid pastes into the cells itself.
+ *
  *  @param      aTableGrid       The table grid that contains the cell.
  *  @param      columnIndexes    Column indexes of the cells being copied.
  *  @param      rowIndexes       Row indexes of the cells being copied.
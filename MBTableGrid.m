@@ -33,6 +33,20 @@
 #import "MBImageCell.h"
 #import "MBButtonCell.h"
 #import "MBPopupButtonCell.h"
+#import "MBTableGridDisplayList.h"
+#import "MBTableGridCore.h"
+#import "MBTableGridColumnEdit.h"
+#import "MBTableGridTabularText.h"
+#import "MBTableGridUndoJournal.h"
+#import "MBTableGridSelection.h"
+#import "MBTableGridCompletionIndex.h"
+#import "MBTableGridFinder.h"
+#import "MBTableGridSorter.h"
+#import "MBTableGridFilter.h"
+#import "MBTableGridAggregates.h"
+#import "MBTableGridColumnStatistics.h"
+#import "MBTableGridAutosizer.h"
+#import "MBTableGridTextMeasurer.h"
 
 #pragma mark -
 #pragma mark Constant Definitions
@@ -42,19 +56,87 @@ NSString *MBTableGridDidChangeRowSelectionNotification     = @"MBTableGridDidCha
 NSString *MBTableGridDidMoveColumnsNotification         = @"MBTableGridDidMoveColumnsNotification";
 NSString *MBTableGridDidMoveRowsNotification            = @"MBTableGridDidMoveRowsNotification";
 NSString *MBTableGridDidResizeColumnNotification		= @"MBTableGridDidResizeColumnNotification";
+NSString *MBTableGridDidChangeFindMatchesNotification	= @"MBTableGridDidChangeFindMatchesNotification";
 CGFloat MBTableHeaderMinimumColumnWidth = 30.0f;
 CGFloat MBTableGridContentViewPadding = 40.0f;
 
+extern NSString *kAutosavedColumnHiddenKey;
+
+// Column statistics count up to this many different values
+static const NSUInteger MBTableGridMaximumDistinctValues = 1024;
+
+// Autosizing measures every row up to this many, and a sample of this many beyond
+static const NSUInteger MBTableGridAutosizeMaximumRows = 10000;
+
+// Autosized columns are never made wider than this
+static const CGFloat MBTableGridMaximumAutosizedColumnWidth = 600.0f;
+
+// Room around the text of cells and headers: their padding, the grid line and the sort indicator
+static const CGFloat MBTableGridAutosizeCellPadding = 9.0f;
+static const CGFloat MBTableGridAutosizeHeaderPadding = 28.0f;
+
 #pragma mark -
 #pragma mark Drag Types
 NSString *MBTableGridColumnDataType = @"mbtablegrid.pasteboard.column";
 NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 
-@interface MBTableGrid ()
+@interface MBTableGrid () <MBTableGridUndoJournalTarget>
 
 @property (nonatomic, strong) NSUndoManager *cachedUndoManager;
 @property (nonatomic) BOOL syncronizingScroll;
+@property (nonatomic) NSPoint scrollOffset;
+@property (nonatomic) BOOL needsScrollUpdates;
+@property (nonatomic, readwrite) NSUInteger scrollSynchronizationCount;
+@property (nonatomic, readwrite) NSTimeInterval scrollSynchronizationTime;
+@property (nonatomic, assign) MBTableGridColumnLayout *columnLayout;
+@property (nonatomic, assign) MBTableGridGroupRows *groupRows;
+@property (nonatomic) BOOL groupRowsAreCached;
+@property (nonatomic, strong, readwrite) MBTableGridUndoJournal *undoJournal;
+@property (nonatomic) BOOL undoWasHandled;
 @property (nonatomic, strong) NSEvent *keyEvent;
+@property (nonatomic, strong) MBTableGridSelection *additionalSelection;
+@property (nonatomic, strong) MBTableGridSelection *cachedSelection;
+@property (nonatomic) BOOL addingSelection;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, MBTableGridCompletionIndex *> *completionIndexes;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, MBTableGridCompletionIndexBuilder *> *completionIndexBuilders;
+@property (nonatomic, copy) void (^pendingCompletionSearch)(MBTableGridCompletionIndex *completionIndex);
+@property (nonatomic) NSUInteger pendingCompletionColumn;
+@property (nonatomic, strong) NSOperationQueue *autocompleteQueue;
+@property (nonatomic) NSUInteger autocompleteGeneration;
+@property (nonatomic, strong) MBTableGridFinder *finder;
+@property (nonatomic, strong) MBTableGridAutosizer *autosizer;
+@property (nonatomic, strong) NSMutableIndexSet *hiddenColumns;
+@property (nonatomic) BOOL restoredHiddenColumns;
+@property (nonatomic, copy, readwrite) NSString *findString;
+@property (nonatomic) MBTableGridFindOptions findOptions;
+@property (nonatomic, readwrite, getter=isFinding) BOOL finding;
+@property (nonatomic, readwrite) NSUInteger numberOfFindMatches;
+@property (nonatomic, strong) NSMutableArray<NSMutableIndexSet *> *findMatches;
+@property (nonatomic, strong) NSMutableArray<NSMutableIndexSet *> *findModelMatches;
+@property (nonatomic, strong) NSData *rowPermutation;
+@property (nonatomic, strong) NSData *inverseRowPermutation;
+@property (nonatomic, assign) MBTableGridRowBitmap *visibleRows;
+@property (nonatomic) NSUInteger numberOfModelRows;
+@property (nonatomic, assign) MBTableGridGroupRows *columnGroupRows;
+@property (nonatomic, strong) NSData *groupStartPositions;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSMutableData *> *groupAggregates;
+@property (nonatomic) NSUInteger numberOfExpandedRows;
+@property (nonatomic, assign) MBTableGridGroupRows *expandedGroupRows;
+@property (nonatomic, assign) MBTableGridCollapsedRows *collapsedRows;
+@property (nonatomic, strong) NSMutableIndexSet *collapsedModelRows;
+@property (nonatomic, strong) NSMutableSet *collapsedGroupValues;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, MBTableGridColumnAggregates *> *columnAggregates;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, MBTableGridColumnAggregates *> *displayAggregates;
+@property (nonatomic, strong) NSMutableIndexSet *buildingDisplayAggregateColumns;
+@property (nonatomic, strong) MBFooterPopupButtonCell *footerAggregateCell;
+@property (nonatomic, strong) MBTableGridStatistics *cachedSelectionStatistics;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, MBTableGridColumnStatistics *> *columnStatistics;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSMutableArray *> *statisticsHandlers;
+@property (nonatomic, strong) NSMutableIndexSet *staleStatisticsColumns;
+@property (nonatomic, weak) MBTableGridSelection *selectionOfCachedStatistics;
+
+- (void)_validateSelection;
+- (void)_updateContentSize;
 
 @end
 
@@ -64,18 +146,31 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 - (void)_drawRowHeaderBackgroundInRect:(NSRect)aRect;
 - (void)_drawCornerHeaderBackgroundInRect:(NSRect)aRect;
 - (void)_drawCornerFooterBackgroundInRect:(NSRect)aRect;
+- (void)_setNeedsDisplayInColumns:(NSIndexSet *)columnIndexes rows:(NSIndexSet *)rowIndexes;
 @end
 
 @interface MBTableGrid (DataAccessors)
 - (NSString *)_headerStringForColumn:(NSUInteger)columnIndex;
 - (NSString *)_headerStringForRow:(NSUInteger)rowIndex;
 - (id)_objectValueForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+- (id)_objectValueForColumn:(NSUInteger)columnIndex modelRow:(NSUInteger)modelRowIndex;
+- (NSUInteger)_modelRowForRow:(NSUInteger)rowIndex;
+- (NSUInteger)_modelRowForPosition:(NSUInteger)position;
+- (NSUInteger)_rowForPosition:(NSUInteger)position;
+- (NSUInteger)_numberOfGroupsStartedAtPosition:(NSUInteger)position;
+- (NSUInteger)_expandedRowForRow:(NSUInteger)rowIndex;
+- (NSUInteger)_rowForExpandedRow:(NSUInteger)expandedRow;
+- (NSUInteger)_modelRowForExpandedRow:(NSUInteger)expandedRow;
+- (BOOL)_rowsAreModelRows;
+- (NSIndexSet *)_modelRowIndexes:(NSIndexSet *)rowIndexes;
+- (NSIndexSet *)_rowIndexesForModelRowIndexes:(NSIndexSet *)modelRowIndexes;
 - (NSFormatter *)_formatterForColumn:(NSUInteger)columnIndex;
 - (NSCell *)_cellForColumn:(NSUInteger)columnIndex;
 - (NSImage *)_accessoryButtonImageForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 - (void)_accessoryButtonClicked:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 - (NSArray *)_availableObjectValuesForColumn:(NSUInteger)columnIndex;
-- (NSArray *)_autocompleteValuesForEditString:(NSString *)editString column:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+- (void)_autocompleteValuesForEditString:(NSString *)editString column:(NSUInteger)columnIndex row:(NSUInteger)rowIndex completionHandler:(void (^)(NSArray *completions))completionHandler;
+- (void)_cancelAutocomplete;
 - (void)_setObjectValue:(id)value forColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex undoTitle:(NSString *)undoTitle;
 - (float)_widthForColumn:(NSUInteger)columnIndex;
 - (float)_setWidthForColumn:(NSUInteger)columnIndex;
@@ -89,11 +184,57 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 - (NSCell *)_footerCellForColumn:(NSUInteger)columnIndex;
 - (id)_footerValueForColumn:(NSUInteger)columnIndex;
 - (void)_setFooterValue:(id)value forColumn:(NSUInteger)columnIndex;
+- (NSString *)_footerTitleForAggregate:(MBTableGridAggregateFunction)function column:(NSUInteger)columnIndex;
+- (NSCell *)_footerAggregateCellForColumn:(NSUInteger)columnIndex;
 - (BOOL)_isGroupHeadingRow:(NSUInteger)rowIndex;
+- (BOOL)_isModelGroupHeadingRow:(NSUInteger)modelRowIndex;
 - (BOOL)_isGroupSummaryRow:(NSUInteger)rowIndex;
 - (BOOL)_isGroupRow:(NSUInteger)rowIndex;
+- (NSUInteger)_levelOfGroupRow:(NSUInteger)rowIndex;
+- (NSUInteger)_levelOfExpandedGroupRow:(NSUInteger)expandedRow;
+- (BOOL)_isExpandedGroupRowCollapsed:(NSUInteger)expandedRow;
+- (id)_groupValueForExpandedRow:(NSUInteger)expandedRow;
 - (MBSortDirection)_sortDirectionForColumn:(NSUInteger)columnIndex;
 - (void)_fillInColumn:(NSUInteger)column fromRow:(NSUInteger)row numberOfRowsWhenStarting:(NSUInteger)numberOfRowsWhenStartingFilling;
+- (void)_applyColumnEdit:(MBTableGridColumnEdit *)edit undoTitle:(NSString *)undoTitle;
+- (void)_applyColumnEdit:(MBTableGridColumnEdit *)edit undoTitle:(NSString *)undoTitle coalesce:(BOOL)coalesce;
+- (void)_applyModelColumnEdit:(MBTableGridColumnEdit *)edit undoTitle:(NSString *)undoTitle coalesce:(BOOL)coalesce;
+- (NSIndexSet *)_editableRowsInColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes;
+- (NSIndexSet *)_clearableRowsInColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes;
+- (BOOL)_buildCompletionIndexForColumn:(NSUInteger)columnIndex;
+- (void)_invalidateCompletionIndexes;
+- (NSIndexSet *)_valueModelRowIndexes;
+- (void)_remapFindMatches;
+- (void)_updateCompletionIndexForColumn:(NSUInteger)columnIndex previousValues:(MBTableGridColumnEdit *)previousValues;
+- (void)_updateFindMatchesInColumn:(NSUInteger)columnIndex modelRows:(NSIndexSet *)modelRowIndexes;
+- (MBTableGridColumnAggregates *)_aggregatesForColumn:(NSUInteger)columnIndex;
+- (MBTableGridColumnAggregates *)_displayAggregatesForColumn:(NSUInteger)columnIndex;
+- (NSData *)_modelRowsOfRows;
+- (MBTableGridColumnAggregates *)_builtDisplayAggregatesForColumn:(NSUInteger)columnIndex;
+- (void)_buildDisplayAggregatesForColumn:(NSUInteger)columnIndex;
+- (MBTableGridAggregate)_aggregateForColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes;
+- (void)_updateAggregatesForColumn:(NSUInteger)columnIndex modelRows:(NSIndexSet *)modelRowIndexes;
+- (void)_updateAggregatesForColumns:(NSIndexSet *)columnIndexes rows:(NSRange)rowRange;
+- (void)_setNeedsDisplayInAggregatesOfColumns:(NSIndexSet *)columnIndexes;
+- (MBTableGridColumnSketches *)_sketchesForColumn:(NSUInteger)columnIndex;
+- (NSIndexSet *)_modelGroupRowIndexes;
+- (void)_buildStatisticsForColumn:(NSUInteger)columnIndex;
+- (void)_invalidateStatisticsForColumn:(NSUInteger)columnIndex;
+- (void)_invalidateAllStatistics;
+- (void)_setNeedsDisplayInView:(NSView *)view fromColumnAtX:(CGFloat)columnX;
+- (NSIndexSet *)_autosizeRowIndexes;
+- (void)_setColumns:(NSIndexSet *)columnIndexes hidden:(BOOL)hidden;
+- (void)_restoreHiddenColumns;
+- (NSUInteger)_firstShownColumnFrom:(NSUInteger)columnIndex;
+- (NSUInteger)_lastShownColumnThrough:(NSUInteger)columnIndex;
+- (void)_applyAutosizedTextWidths:(NSDictionary<NSNumber *, NSNumber *> *)textWidths;
+- (NSUInteger)_groupForExpandedRow:(NSUInteger)expandedRow;
+- (NSRange)_positionsOfGroup:(NSUInteger)groupIndex;
+- (NSUInteger)_groupForModelRow:(NSUInteger)modelRowIndex;
+- (MBTableGridAggregate)_aggregateOfGroup:(NSUInteger)groupIndex aggregates:(MBTableGridColumnAggregates *)aggregates;
+- (NSData *)_groupAggregatesForColumn:(NSUInteger)columnIndex;
+- (void)_copyCellsAtColumns:(NSIndexSet *)columnIndexes rows:(NSIndexSet *)rowIndexes toPasteboard:(NSPasteboard *)pasteboard;
+- (void)_pasteCellsAtColumns:(NSIndexSet *)columnIndexes rows:(NSIndexSet *)rowIndexes fromPasteboard:(NSPasteboard *)pasteboard;
 @end
 
 @interface MBTableGrid (DragAndDrop)
@@ -111,6 +252,24 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 - (MBTableGridEdge)_stickyColumn;
 - (MBTableGridEdge)_stickyRow;
 - (NSUndoManager *)_undoManager;
+- (void)_updateSelectionTracking;
+- (MBTableGridColumnLayout *)_columnLayout;
+- (MBTableGridGroupRows *)_groupRows;
+- (MBTableGridGroupRows *)_expandedGroupRows;
+- (void)_reloadColumnLayout;
+- (void)_beginAddingSelectionAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+- (void)_endAddingSelection;
+- (void)_removeAdditionalSelection;
+- (NSIndexSet *)_rowIndexesExcludingGroupHeadingRows;
+- (void)_updateRowMapping;
+- (void)_groupRowsWithValues:(id)values;
+- (NSRange)_rowsOfExpandedGroupAtIndex:(size_t)index;
+- (void)_hideCollapsedGroupsFromIndex:(size_t)firstIndex toRow:(NSUInteger)endRow;
+- (void)_updateCollapsedRows;
+- (void)_updateDisplayedGroupRows;
+- (void)_setGroupRow:(NSUInteger)rowIndex collapsed:(BOOL)collapsed;
+- (void)_reloadRows;
+- (void)_rowsDidChange;
 @end
 
 @interface MBTableGridContentView (Private)
@@ -142,6 +301,30 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	columnWidths = [NSMutableDictionary dictionary];
 	columnIndexNames = [NSMutableArray array];
 	
+	self.columnLayout = MBTableGridColumnLayoutCreate();
+	self.groupRows = MBTableGridGroupRowsCreate();
+	self.expandedGroupRows = MBTableGridGroupRowsCreate();
+	self.undoJournal = [[MBTableGridUndoJournal alloc] initWithTarget:self];
+	self.completionIndexes = [NSMutableDictionary dictionary];
+	self.completionIndexBuilders = [NSMutableDictionary dictionary];
+	self.columnAggregates = [NSMutableDictionary dictionary];
+	self.displayAggregates = [NSMutableDictionary dictionary];
+	self.buildingDisplayAggregateColumns = [NSMutableIndexSet indexSet];
+	self.groupAggregates = [NSMutableDictionary dictionary];
+	self.collapsedModelRows = [NSMutableIndexSet indexSet];
+	self.collapsedGroupValues = [NSMutableSet set];
+	self.columnStatistics = [NSMutableDictionary dictionary];
+	self.statisticsHandlers = [NSMutableDictionary dictionary];
+	self.staleStatisticsColumns = [NSMutableIndexSet indexSet];
+	self.hiddenColumns = [NSMutableIndexSet indexSet];
+	_groupingColumn = NSNotFound;
+	
+	// Only the latest autocomplete query matters, so they run one at a time and superseded ones are cancelled
+	self.autocompleteQueue = [NSOperationQueue new];
+	self.autocompleteQueue.maxConcurrentOperationCount = 1;
+	self.autocompleteQueue.qualityOfService = NSQualityOfServiceUserInitiated;
+	self.maximumNumberOfAutocompleteValues = 50;
+	
 	self.includeGroupSummaryRows = YES;
 	
 	// Post frame changed notifications
@@ -248,16 +431,11 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	rowShadowView.autoresizingMask = NSViewHeightSizable;
 	[self addSubview:rowShadowView];
 	
-	// We want to synchronize the scroll views
-	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(columnHeaderViewDidScroll:) name:NSViewBoundsDidChangeNotification object:[columnHeaderScrollView contentView]];
-	
-	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(rowHeaderViewDidScroll:) name:NSViewBoundsDidChangeNotification object:[rowHeaderScrollView contentView]];
-	
-	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(columnFooterViewDidScroll:) name:NSViewBoundsDidChangeNotification object:[columnFooterScrollView contentView]];
-	
-	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(contentViewDidScroll:) name:NSViewBoundsDidChangeNotification object:[contentScrollView contentView]];
-	
-	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(frozenContentViewDidScroll:) name:NSViewBoundsDidChangeNotification object:[frozenContentScrollView contentView]];
+	// We want to synchronize the scroll views. They all funnel into a single
+	// handler, which owns the canonical scroll offset.
+	for (NSScrollView *scrollView in @[columnHeaderScrollView, rowHeaderScrollView, columnFooterScrollView, contentScrollView, frozenContentScrollView]) {
+		[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(scrollViewDidScroll:) name:NSViewBoundsDidChangeNotification object:[scrollView contentView]];
+	}
 	
 	[[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didUndoOrRedo:) name:NSUndoManagerDidUndoChangeNotification object:nil];
 	
@@ -274,7 +452,7 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	
 	shouldOverrideModifiers = NO;
 	
-	self.columnRects = [NSMutableDictionary dictionary];
+	_columnRects = [NSMutableDictionary dictionary];
 	
 	self.footerHidden = NO;
 	self.isEditable = YES;
@@ -304,7 +482,20 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 - (void)sortButtonClickedOnColumn:(NSUInteger)columnIndex {
 	if ([[self delegate] respondsToSelector:@selector(tableGrid:didSortColumn:)]) {
 		[[self delegate] tableGrid:self didSortColumn:columnIndex];
+		return;
 	}
+	
+	// Make the column the primary key, and keep the others as tie-breakers
+	MBTableGridSortKey *sortKey = [MBTableGridSortKey sortKeyWithColumn:columnIndex ascending:YES];
+	NSMutableArray<MBTableGridSortKey *> *sortKeys = [NSMutableArray arrayWithObject:sortKey];
+	for (MBTableGridSortKey *existingKey in self.sortKeys) {
+		if (existingKey.column != columnIndex) {
+			[sortKeys addObject:existingKey];
+		} else if (existingKey == self.sortKeys.firstObject) {
+			sortKeys[0] = [existingKey reversedSortKey];
+		}
+	}
+	self.sortKeys = sortKeys;
 }
 
 - (void)awakeFromNib {
@@ -313,7 +504,14 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 }
 
 - (void)dealloc {
+	[NSObject cancelPreviousPerformRequestsWithTarget:self];
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	MBTableGridColumnLayoutFree(_columnLayout);
+	MBTableGridGroupRowsFree(_groupRows);
+	MBTableGridGroupRowsFree(_columnGroupRows);
+	MBTableGridGroupRowsFree(_expandedGroupRows);
+	MBTableGridCollapsedRowsFree(_collapsedRows);
+	MBTableGridRowBitmapFree(_visibleRows);
 	//	NSLog(@"%@ dealloc", self);
 }
 
@@ -366,6 +564,14 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	[self setNeedsDisplay:YES];
 }
 
+- (void)setIncludeGroupSummaryRows:(BOOL)includeGroupSummaryRows {
+	_includeGroupSummaryRows = includeGroupSummaryRows;
+	
+	// Summary rows are part of the group rows found when the rows are mapped, so map them again
+	self.groupRowsAreCached = NO;
+	[self _reloadRows];
+}
+
 /**
  * @brief		Sets the indicator image for the specified column.
  *				This is used for indicating which direction the
@@ -494,15 +700,11 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		columnKey = [NSString stringWithFormat:@"column%lu", columnIndex];
 	}
 	
-	// Note that we only need this rect for its origin, which won't be changing, otherwise we'd need to flush the column rect cache first
+	// Note that we only need this rect for its origin, which won't be changing
 	NSRect columnRect = [self rectOfColumn:columnIndex];
 	
-	// Flush rect cache for this column because we're changing its size
-	// Note that we're doing this after calling rectOfColumn: because that would cache the rect before we change its width...
-	[self.columnRects removeAllObjects];
-	
 	// Set new width of column
-	CGFloat currentWidth = [columnWidths[columnKey] floatValue];
+	CGFloat currentWidth = [self _widthForColumn:columnIndex];
 	CGFloat oldWidth = currentWidth;
 	CGFloat offset = 0.0;
 	BOOL isFrozen = [self isFrozenColumn:columnIndex];
@@ -521,6 +723,7 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	}
 	
 	columnWidths[columnKey] = @(currentWidth);
+	MBTableGridColumnLayoutSetWidth(self.columnLayout, columnIndex, currentWidth);
 	
 	// Update views with new sizes
 	if (rightToLeft) {
@@ -538,24 +741,16 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		[frozenColumnFooterView setFrameSize:NSMakeSize(NSWidth(frozenColumnFooterView.frame) + distance, NSHeight(frozenColumnFooterView.frame))];
 	}
 	
-	NSRect rectOfResizedAndVisibleRightwardColumns = NSMakeRect(columnRect.origin.x - rowHeaderView.bounds.size.width, 0, contentView.bounds.size.width - columnRect.origin.x, NSHeight(contentView.frame));
-	[contentView setNeedsDisplayInRect:rectOfResizedAndVisibleRightwardColumns];
-	
-	NSRect rectOfResizedAndVisibleRightwardHeaders = NSMakeRect(columnRect.origin.x - rowHeaderView.bounds.size.width, 0, contentView.bounds.size.width - columnRect.origin.x, NSHeight(columnHeaderView.frame));
-	[columnHeaderView setNeedsDisplayInRect:rectOfResizedAndVisibleRightwardHeaders];
-	
-	NSRect rectOfResizedAndVisibleRightwardFooters = NSMakeRect(columnRect.origin.x - rowHeaderView.bounds.size.width, 0, contentView.bounds.size.width - columnRect.origin.x, NSHeight(columnFooterView.frame));
-	[columnFooterView setNeedsDisplayInRect:rectOfResizedAndVisibleRightwardFooters];
+	// The resized column and every visible column to its right are drawn again, at most once per coalesced update
+	CGFloat columnX = NSMinX([contentView rectOfColumn:columnIndex]);
+	[self _setNeedsDisplayInView:contentView fromColumnAtX:columnX];
+	[self _setNeedsDisplayInView:columnHeaderView fromColumnAtX:columnX];
+	[self _setNeedsDisplayInView:columnFooterView fromColumnAtX:columnX];
 	
 	if (isFrozen) {
-		NSRect rectOfResizedAndVisibleRightwardFrozenColumns = NSMakeRect(columnRect.origin.x - rowHeaderView.bounds.size.width, 0, [self frozenColumnsWidth] - columnRect.origin.x, NSHeight(frozenContentView.frame));
-		[frozenContentView setNeedsDisplayInRect:rectOfResizedAndVisibleRightwardFrozenColumns];
-		
-		NSRect rectOfResizedAndVisibleRightwardFrozenHeaders = NSMakeRect(columnRect.origin.x - rowHeaderView.bounds.size.width, 0, [self frozenColumnsWidth] - columnRect.origin.x, NSHeight(frozenColumnHeaderView.frame));
-		[frozenColumnHeaderView setNeedsDisplayInRect:rectOfResizedAndVisibleRightwardFrozenHeaders];
-		
-		NSRect rectOfResizedAndVisibleRightwardFrozenFooters = NSMakeRect(columnRect.origin.x - rowHeaderView.bounds.size.width, 0, [self frozenColumnsWidth] - columnRect.origin.x, NSHeight(frozenColumnFooterView.frame));
-		[frozenColumnFooterView setNeedsDisplayInRect:rectOfResizedAndVisibleRightwardFrozenFooters];
+		[self _setNeedsDisplayInView:frozenContentView fromColumnAtX:columnX];
+		[self _setNeedsDisplayInView:frozenColumnHeaderView fromColumnAtX:columnX];
+		[self _setNeedsDisplayInView:frozenColumnFooterView fromColumnAtX:columnX];
 	}
 	
 	// Update the shadow views' sizes
@@ -573,6 +768,147 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	return offset;
 }
 
+- (void)_setNeedsDisplayInView:(NSView *)view fromColumnAtX:(CGFloat)columnX {
+	// The views are layer-backed, where copying pixels across isn't reliable, so the moved columns are redrawn
+	NSRect visibleRect = view.visibleRect;
+	NSRect dirtyRect = NSIntersectionRect(NSMakeRect(columnX, NSMinY(visibleRect), NSMaxX(visibleRect) - columnX, NSHeight(visibleRect)), visibleRect);
+	if (!NSIsEmptyRect(dirtyRect)) {
+		[view setNeedsDisplayInRect:dirtyRect];
+	}
+}
+
+- (void)autosizeColumns:(NSIndexSet *)columnIndexes {
+	[self.autosizer cancel];
+	self.autosizer = nil;
+	
+	NSMutableIndexSet *columns = [columnIndexes mutableCopy];
+	[columns removeIndexesInRange:NSMakeRange(_numberOfColumns, NSNotFound - _numberOfColumns)];
+	if (columns.count == 0) {
+		return;
+	}
+	
+	// Columns whose statistics were worked out already know their widest text
+	NSMutableDictionary<NSNumber *, NSNumber *> *textWidths = [NSMutableDictionary dictionaryWithCapacity:columns.count];
+	NSMutableIndexSet *columnsToMeasure = [NSMutableIndexSet indexSet];
+	[columns enumerateIndexesUsingBlock:^(NSUInteger column, BOOL *stop) {
+		MBTableGridColumnStatistics *statistics = self.columnStatistics[@(column)];
+		if (statistics) {
+			textWidths[@(column)] = @(statistics.maximumTextWidth);
+		} else {
+			[columnsToMeasure addIndex:column];
+		}
+	}];
+	
+	if (columnsToMeasure.count == 0) {
+		[self _applyAutosizedTextWidths:textWidths];
+		return;
+	}
+	
+	// Fetch the formatters and fonts up front, so background threads don't have to ask for them
+	NSMutableArray *formatters = [NSMutableArray arrayWithCapacity:_numberOfColumns];
+	NSMutableArray *fonts = [NSMutableArray arrayWithCapacity:_numberOfColumns];
+	for (NSUInteger column = 0; column < _numberOfColumns; column++) {
+		BOOL isMeasured = [columnsToMeasure containsIndex:column];
+		[formatters addObject:(isMeasured ? [self _formatterForColumn:column] : nil) ?: [NSNull null]];
+		[fonts addObject:(isMeasured ? self.defaultCellFont ?: [self _cellForColumn:column].font : nil) ?: [NSNull null]];
+	}
+	
+	MBTableGridAutosizer *autosizer = [[MBTableGridAutosizer alloc] init];
+	autosizer.formatters = formatters;
+	autosizer.fonts = fonts;
+	
+	__weak MBTableGrid *weakSelf = self;
+	id<MBTableGridDataSource> dataSource = self.dataSource;
+	autosizer.valueProvider = ^id(NSUInteger columnIndex, NSUInteger rowIndex) {
+		return [dataSource tableGrid:weakSelf objectValueForColumn:columnIndex row:rowIndex];
+	};
+	autosizer.readsValuesConcurrently = [dataSource respondsToSelector:@selector(tableGridSupportsConcurrentValueAccess:)] && [dataSource tableGridSupportsConcurrentValueAccess:self];
+	
+	self.autosizer = autosizer;
+	
+	[autosizer measureColumns:columnsToMeasure rows:[self _autosizeRowIndexes] completionHandler:^(NSDictionary<NSNumber *, NSNumber *> *widthsByColumn) {
+		MBTableGrid *strongSelf = weakSelf;
+		if (!strongSelf) {
+			return;
+		}
+		
+		strongSelf.autosizer = nil;
+		[textWidths addEntriesFromDictionary:widthsByColumn];
+		[strongSelf _applyAutosizedTextWidths:textWidths];
+	}];
+}
+
+- (NSIndexSet *)_autosizeRowIndexes {
+	// Rows are measured as the data source has them, like column statistics, so filters don't change widths
+	NSUInteger numberOfModelRows = self.numberOfModelRows;
+	NSMutableIndexSet *rowIndexes = [NSMutableIndexSet indexSet];
+	
+	if (numberOfModelRows <= MBTableGridAutosizeMaximumRows) {
+		[rowIndexes addIndexesInRange:NSMakeRange(0, numberOfModelRows)];
+	} else {
+		// An even sample finds most of the wide values, and the rows on screen are added so that what's seen fits
+		double stride = (double)numberOfModelRows / MBTableGridAutosizeMaximumRows;
+		for (NSUInteger sample = 0; sample < MBTableGridAutosizeMaximumRows; sample++) {
+			[rowIndexes addIndex:(NSUInteger)(sample * stride)];
+		}
+		
+		NSRect visibleRect = contentView.visibleRect;
+		CGFloat rowHeight = contentView.cellRowHeight;
+		if (rowHeight > 0) {
+			NSUInteger firstRow = MIN((NSUInteger)MAX(floor(NSMinY(visibleRect) / rowHeight), 0), _numberOfRows);
+			NSUInteger endRow = MIN((NSUInteger)MAX(ceil(NSMaxY(visibleRect) / rowHeight), 0), _numberOfRows);
+			for (NSUInteger row = firstRow; row < endRow; row++) {
+				NSUInteger modelRow = [self _modelRowForRow:row];
+				if (modelRow != NSNotFound) {
+					[rowIndexes addIndex:modelRow];
+				}
+			}
+		}
+	}
+	
+	[rowIndexes removeIndexes:[self _modelGroupRowIndexes]];
+	return rowIndexes;
+}
+
+- (void)_applyAutosizedTextWidths:(NSDictionary<NSNumber *, NSNumber *> *)textWidths {
+	NSFont *headerFont = columnHeaderView.headerCell.defaultCellFont ?: [NSFont boldSystemFontOfSize:[NSFont systemFontSizeForControlSize:NSControlSizeSmall]];
+	MBTableGridTextMeasurer *headerMeasurer = [MBTableGridTextMeasurer measurerForFont:headerFont];
+	CGFloat minColumnWidth = MBTableHeaderMinimumColumnWidth + columnHeaderView.sortAscendingImage.size.width + 2.0f;
+	
+	NSMutableIndexSet *resizedColumns = [NSMutableIndexSet indexSet];
+	for (NSNumber *column in textWidths) {
+		NSUInteger columnIndex = column.unsignedIntegerValue;
+		if (columnIndex >= _numberOfColumns) {
+			continue;
+		}
+		
+		NSString *columnKey = columnIndex < columnIndexNames.count ? columnIndexNames[columnIndex] : nil;
+		if (!columnKey) {
+			columnKey = [NSString stringWithFormat:@"column%lu", columnIndex];
+		}
+		
+		CGFloat cellWidth = textWidths[column].doubleValue + MBTableGridAutosizeCellPadding;
+		CGFloat headerWidth = [headerMeasurer widthOfString:[self _headerStringForColumn:columnIndex]] + MBTableGridAutosizeHeaderPadding;
+		CGFloat width = MIN(MAX(MAX(cellWidth, headerWidth), minColumnWidth), MBTableGridMaximumAutosizedColumnWidth);
+		columnWidths[columnKey] = @(width);
+		[resizedColumns addIndex:columnIndex];
+	}
+	
+	// Lay out every column once, rather than once for each resized column
+	[self _reloadColumnLayout];
+	[self _updateContentSize];
+	[columnHeaderView autoSaveColumnPropertiesOfColumns:resizedColumns];
+	[self setNeedsDisplay:YES];
+	
+	if ([self.delegate respondsToSelector:@selector(tableGridDidResizeColumn:)]) {
+		[resizedColumns enumerateIndexesUsingBlock:^(NSUInteger columnIndex, BOOL *stop) {
+			NSDictionary *userInfo = @{@"columnIndex" : @(columnIndex),
+									   @"width" : @([self _widthForColumn:columnIndex])};
+			[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidResizeColumnNotification object:self userInfo:userInfo];
+		}];
+	}
+}
+
 - (void)registerForDraggedTypes:(NSArray *)pboardTypes {
 	// Add the column and row types to the array
 	NSMutableArray *types = [NSMutableArray arrayWithArray:pboardTypes];
@@ -588,6 +924,102 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	[contentView registerForDraggedTypes:types];
 }
 
+#pragma mark Hiding Columns
+
+- (void)hideColumns:(NSIndexSet *)columnIndexes {
+	[self _setColumns:columnIndexes hidden:YES];
+}
+
+- (void)unhideColumns:(NSIndexSet *)columnIndexes {
+	[self _setColumns:columnIndexes hidden:NO];
+}
+
+- (BOOL)isColumnHidden:(NSUInteger)columnIndex {
+	return [self.hiddenColumns containsIndex:columnIndex];
+}
+
+- (NSIndexSet *)hiddenColumnIndexes {
+	return [self.hiddenColumns copy];
+}
+
+- (void)_setColumns:(NSIndexSet *)columnIndexes hidden:(BOOL)hidden {
+	NSMutableIndexSet *changedColumns = [columnIndexes mutableCopy];
+	[changedColumns removeIndexesInRange:NSMakeRange(_numberOfColumns, NSNotFound - _numberOfColumns)];
+	if (hidden) {
+		[changedColumns removeIndexes:self.hiddenColumns];
+		[self.hiddenColumns addIndexes:changedColumns];
+	} else {
+		NSMutableIndexSet *shownColumns = [changedColumns mutableCopy];
+		[shownColumns removeIndexes:self.hiddenColumns];
+		[changedColumns removeIndexes:shownColumns];
+		[self.hiddenColumns removeIndexes:changedColumns];
+	}
+	
+	if (changedColumns.count == 0) {
+		return;
+	}
+	
+	// Hidden columns are columns with no width, so each one is a single update to the layout
+	[changedColumns enumerateIndexesUsingBlock:^(NSUInteger column, BOOL *stop) {
+		MBTableGridColumnLayoutSetWidth(self.columnLayout, column, hidden ? 0 : [self _widthForColumn:column]);
+	}];
+	
+	// Hidden cells can't stay selected, so the selection moves to the nearest shown column if it has to
+	NSMutableIndexSet *selectedColumns = [self.selectedColumnIndexes mutableCopy];
+	[selectedColumns removeIndexes:changedColumns];
+	if (hidden && selectedColumns.count < self.selectedColumnIndexes.count) {
+		if (selectedColumns.count == 0) {
+			NSUInteger column = [self _firstShownColumnFrom:self.selectedColumnIndexes.firstIndex];
+			if (column == NSNotFound) {
+				column = [self _lastShownColumnThrough:self.selectedColumnIndexes.firstIndex];
+			}
+			if (column != NSNotFound) {
+				[selectedColumns addIndex:column];
+			}
+		}
+		self.selectedColumnIndexes = selectedColumns;
+	}
+	
+	[self _updateContentSize];
+	[columnHeaderView updateTrackingAreas];
+	[frozenColumnHeaderView updateTrackingAreas];
+	[columnHeaderView autoSaveColumnPropertiesOfColumns:changedColumns];
+	[self setNeedsDisplay:YES];
+}
+
+- (void)_restoreHiddenColumns {
+	// Hidden columns are only read back once, as they're only saved while the grid is shown
+	if (self.restoredHiddenColumns || _numberOfColumns == 0) {
+		return;
+	}
+	self.restoredHiddenColumns = YES;
+	
+	NSDictionary *columnProperties = columnHeaderView.columnAutoSaveProperties;
+	if (!columnProperties && [self.delegate respondsToSelector:@selector(tableGridAutosavedColumnProperties:)]) {
+		columnProperties = [self.delegate tableGridAutosavedColumnProperties:self];
+	}
+	
+	for (NSUInteger column = 0; column < _numberOfColumns; column++) {
+		NSDictionary *properties = columnProperties[[NSString stringWithFormat:@"C-%lu", column]];
+		if ([properties[kAutosavedColumnHiddenKey] boolValue]) {
+			[self.hiddenColumns addIndex:column];
+		}
+	}
+}
+
+- (NSUInteger)_firstShownColumnFrom:(NSUInteger)columnIndex {
+	size_t column = MBTableGridColumnLayoutFirstShownColumnFrom(self.columnLayout, columnIndex);
+	return column == MBTableGridCoreNotFound ? NSNotFound : column;
+}
+
+- (NSUInteger)_lastShownColumnThrough:(NSUInteger)columnIndex {
+	if (columnIndex == NSNotFound) {
+		return NSNotFound;
+	}
+	size_t column = MBTableGridColumnLayoutLastShownColumnThrough(self.columnLayout, columnIndex);
+	return column == MBTableGridCoreNotFound ? NSNotFound : column;
+}
+
 #pragma mark Mouse Events
 
 - (void)setIsEditable:(BOOL)isEditable {
@@ -650,6 +1082,8 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	
 	if ([[self delegate] respondsToSelector:@selector(tableGrid:copyCellsAtColumns:rows:)]) {
 		[[self delegate] tableGrid:self copyCellsAtColumns:selectedColumns rows:selectedRows];
+	} else if (selectedColumns.count > 0 && selectedRows.count > 0) {
+		[self _copyCellsAtColumns:selectedColumns rows:selectedRows toPasteboard:[NSPasteboard generalPasteboard]];
 	}
 }
 
@@ -660,6 +1094,8 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	
 	if ([[self delegate] respondsToSelector:@selector(tableGrid:pasteCellsAtColumns:rows:)]) {
 		[[self delegate] tableGrid:self pasteCellsAtColumns:selectedColumns rows:selectedRows];
+	} else if (selectedColumns.count > 0 && selectedRows.count > 0) {
+		[self _pasteCellsAtColumns:selectedColumns rows:selectedRows fromPasteboard:[NSPasteboard generalPasteboard]];
 	}
 }
 
@@ -694,40 +1130,12 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 
 - (NSUInteger)previousNonGroupRowFromRow:(NSUInteger)row {
 	// moving up, but previous row is a group row, so go to the previous non-group row
-	BOOL isGroupRow = YES;
-	while (row > 0 && isGroupRow) {
-		isGroupRow = [self _isGroupRow:row - 1];
-		if (isGroupRow) {
-			if (row - 1 > 0) {
-				row--;
-			} else {
-				break;
-			}
-		} else if (row > 0){
-			row--;
-		}
-	}
-	return row;
+	return MBTableGridGroupRowsPreviousNonGroupRow([self _groupRows], row);
 }
 
 - (NSUInteger)nextNonGroupRowFromRow:(NSUInteger)row {
 	// moving down, but next row is a group row, so go to the next non-group row
-	BOOL isGroupRow = YES;
-	while (row + 1 < self.numberOfRows && isGroupRow) {
-		isGroupRow = [self _isGroupRow:row + 1];
-		if (isGroupRow) {
-			if (row + 1 < self.numberOfRows) {
-				row++;
-			} else {
-				break;
-			}
-		} else {
-			if (row < self.numberOfRows) {
-				row++;
-			}
-		}
-	}
-	return row;
+	return MBTableGridGroupRowsNextNonGroupRow([self _groupRows], row, self.numberOfRows);
 }
 
 - (void)moveUp:(id)sender {
@@ -823,6 +1231,8 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		}
 	}
 	
+	[self _updateSelectionTracking];
+	
 	NSRect cellRect = [self frameOfCellAtColumn:column row:firstRow];
 	cellRect = [self convertRect:cellRect toView:self.contentView];
 	if (!NSContainsRect(self.contentView.visibleRect, cellRect)) {
@@ -943,6 +1353,8 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 			}
 		}
 		
+		[self _updateSelectionTracking];
+		
 		NSRect cellRect = [self frameOfCellAtColumn:column row:lastRow + 1];
 		cellRect = [self convertRect:cellRect toView:self.contentView];
 		if (!NSContainsRect(self.contentView.visibleRect, cellRect)) {
@@ -973,8 +1385,11 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		row = [self.selectedRowIndexes lastIndex];
 	}
 	
-	if (column > 0) {
-		NSRect cellRect = [self frameOfCellAtColumn:column - 1 row:row];
+	// Hidden columns are stepped over
+	NSUInteger previousColumn = column > 0 ? [self _lastShownColumnThrough:column - 1] : NSNotFound;
+	
+	if (previousColumn != NSNotFound) {
+		NSRect cellRect = [self frameOfCellAtColumn:previousColumn row:row];
 		cellRect = [self convertRect:cellRect toView:contentScrollView.contentView];
 		
 		if (![self scrollForFrozenColumnsFromColumn:column right:NO]) {
@@ -993,12 +1408,12 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	}
 	
 	// If we're already at the first column, do nothing
-	if (column == 0) {
+	if (previousColumn == NSNotFound) {
 		return;
 	}
 	
 	// If the Shift key was not held, move the selection
-	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndex:(column - 1)];
+	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndex:previousColumn];
 	if (![self.selectedRowIndexes containsIndex:row]) {
 		self.selectedRowIndexes = [NSMutableIndexSet indexSetWithIndex:row];
 	}
@@ -1026,8 +1441,11 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	
 	NSUInteger row = [self.selectedRowIndexes firstIndex];
 	
-	if (firstColumn > 0) {
-		NSRect cellRect = [self frameOfCellAtColumn:firstColumn - 1 row:row];
+	// Hidden columns are stepped over
+	NSUInteger previousColumn = firstColumn > 0 ? [self _lastShownColumnThrough:firstColumn - 1] : NSNotFound;
+	
+	if (previousColumn != NSNotFound) {
+		NSRect cellRect = [self frameOfCellAtColumn:previousColumn row:row];
 		cellRect = [self convertRect:cellRect toView:contentScrollView.contentView];
 		
 		if (![self scrollForFrozenColumnsFromColumn:firstColumn right:NO]) {
@@ -1042,16 +1460,17 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	
 	
 	// We can't expand past the first column
-	if (stickyColumnEdge == MBTableGridRightEdge && firstColumn <= 0)
+	if (stickyColumnEdge == MBTableGridRightEdge && previousColumn == NSNotFound)
 		return;
 	
 	if (stickyColumnEdge == MBTableGridLeftEdge) {
 		// If the top edge is sticky, contract the selection
-		lastColumn--;
+		NSUInteger previousLastColumn = lastColumn > 0 ? [self _lastShownColumnThrough:lastColumn - 1] : NSNotFound;
+		lastColumn = previousLastColumn != NSNotFound && previousLastColumn >= firstColumn ? previousLastColumn : lastColumn - 1;
 	}
 	else if (stickyColumnEdge == MBTableGridRightEdge) {
 		// If the bottom edge is sticky, expand the contraction
-		firstColumn--;
+		firstColumn = previousColumn;
 	}
 	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(firstColumn, lastColumn - firstColumn + 1)];
 }
@@ -1073,20 +1492,23 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		row = [self.selectedRowIndexes lastIndex];
 	}
 	
+	// Hidden columns are stepped over
+	NSUInteger nextColumn = [self _firstShownColumnFrom:column + 1];
+	
 	// If we're already at the last column, do nothing
-	if (column >= (_numberOfColumns - 1)) {
+	if (nextColumn == NSNotFound) {
 		[self setNeedsDisplay:YES];
 		return;
 	}
 	
 	// If the Shift key was not held, move the selection
-	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndex:(column + 1)];
+	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndex:nextColumn];
 	if (![self.selectedRowIndexes containsIndex:row]) {
 		self.selectedRowIndexes = [NSMutableIndexSet indexSetWithIndex:row];
 	}
 	
-	if (column + 1 < [self numberOfColumns]) {
-		NSRect cellRect = [self frameOfCellAtColumn:column + 1 row:row];
+	if (nextColumn < [self numberOfColumns]) {
+		NSRect cellRect = [self frameOfCellAtColumn:nextColumn row:row];
 		cellRect = [self convertRect:cellRect toView:contentScrollView.contentView];
 		
 		if (![self scrollForFrozenColumnsFromColumn:column right:YES]) {
@@ -1132,24 +1554,29 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		stickyColumnEdge = MBTableGridLeftEdge;
 	}
 	
+	// Hidden columns are stepped over
+	NSUInteger nextColumn = [self _firstShownColumnFrom:lastColumn + 1];
+	
 	// We can't expand past the last column
-	if (stickyColumnEdge == MBTableGridLeftEdge && lastColumn >= (_numberOfColumns - 1))
+	if (stickyColumnEdge == MBTableGridLeftEdge && nextColumn == NSNotFound)
 		return;
 	
 	if (stickyColumnEdge == MBTableGridLeftEdge) {
 		// If the top edge is sticky, contract the selection
-		lastColumn++;
+		lastColumn = nextColumn;
 	}
 	else if (stickyColumnEdge == MBTableGridRightEdge) {
 		// If the bottom edge is sticky, expand the contraction
-		firstColumn++;
+		NSUInteger nextFirstColumn = [self _firstShownColumnFrom:firstColumn + 1];
+		firstColumn = nextFirstColumn != NSNotFound && nextFirstColumn <= lastColumn ? nextFirstColumn : firstColumn + 1;
 	}
 	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(firstColumn, lastColumn - firstColumn + 1)];
 	
 	NSUInteger row = [self.selectedRowIndexes lastIndex];
+	nextColumn = [self _firstShownColumnFrom:lastColumn + 1];
 	
-	if (lastColumn + 1 < [self numberOfColumns]) {
-		NSRect cellRect = [self frameOfCellAtColumn:lastColumn + 1 row:row];
+	if (nextColumn != NSNotFound) {
+		NSRect cellRect = [self frameOfCellAtColumn:nextColumn row:row];
 		cellRect = [self convertRect:cellRect toView:contentScrollView.contentView];
 		
 		if (![self scrollForFrozenColumnsFromColumn:lastColumn right:YES]) {
@@ -1271,20 +1698,28 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		return;
 	}
 	
-	// Clear the contents of every selected cell
-	NSUInteger column = [self.selectedColumnIndexes firstIndex];
-	while (column <= [self.selectedColumnIndexes lastIndex]) {
-		NSUInteger row = [self.selectedRowIndexes firstIndex];
-		while (row <= [self.selectedRowIndexes lastIndex]) {
-			BOOL canEdit = [self _canEditCellAtColumn:column row:row];
-			if (canEdit || [self _accessoryButtonImageForColumn:column row:row]) {
-				[self _setObjectValue:nil forColumn:column row:row undoTitle:@"Clear"];
-			}
-			row++;
-		}
-		column++;
+	if (self.selectedColumnIndexes.count == 0 || self.selectedRowIndexes.count == 0) {
+		return;
 	}
-	[self reloadData];
+	
+	NSRange columnRange = NSMakeRange(self.selectedColumnIndexes.firstIndex, self.selectedColumnIndexes.lastIndex - self.selectedColumnIndexes.firstIndex + 1);
+	NSRange rowRange = NSMakeRange(self.selectedRowIndexes.firstIndex, self.selectedRowIndexes.lastIndex - self.selectedRowIndexes.firstIndex + 1);
+	NSIndexSet *columnIndexes = [NSIndexSet indexSetWithIndexesInRange:columnRange];
+	NSIndexSet *rowIndexes = [NSIndexSet indexSetWithIndexesInRange:rowRange];
+	
+	// Clear the contents of every selected cell, a column at a time, as a single undo step
+	NSUndoManager *undoManager = [self _undoManager];
+	[undoManager beginUndoGrouping];
+	
+	[columnIndexes enumerateIndexesUsingBlock:^(NSUInteger column, BOOL *stop) {
+		NSIndexSet *clearableRows = [self _clearableRowsInColumn:column rows:rowIndexes];
+		MBTableGridColumnEdit *clear = [MBTableGridColumnEdit editWithColumn:column rows:clearableRows value:nil];
+		[self _applyColumnEdit:clear undoTitle:NSLocalizedString(@"Clear", nil)];
+	}];
+	
+	[undoManager endUndoGrouping];
+	
+	[self _setNeedsDisplayInColumns:columnIndexes rows:rowIndexes];
 }
 
 - (void)insertText:(id)aString {
@@ -1334,99 +1769,103 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	//[self reloadData];
 }
 
-- (void)syncronizeScrollView:(NSScrollView *)scrollView withChangedBoundsOrigin:(NSPoint)changedBoundsOrigin horizontal:(BOOL)horizontal {
-	
-	if (self.syncronizingScroll || (horizontal && scrollView == frozenContentScrollView)) {
-		return;
-	}
+/**
+ * @brief		Applies the canonical scroll offset to every scroll
+ *				view in a single pass.
+ *
+ * @details		Horizontal offsets go to the content, column header
+ *				and footer scroll views, and vertical offsets go to
+ *				the content, frozen content and row header scroll
+ *				views. The bounds change notifications these moves
+ *				cause are ignored, so each scroll event only moves
+ *				each pane once.
+ */
+- (void)_applyScrollOffset {
+	CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
 	
 	self.syncronizingScroll = YES;
 	
-	// Get the current origin
-	NSPoint curOffset = [[scrollView contentView] bounds].origin;
-	NSPoint newOffset = curOffset;
+	NSPoint offset = self.scrollOffset;
 	
-	if (horizontal) {
-		newOffset.x = changedBoundsOrigin.x;
-	} else {
-		newOffset.y = changedBoundsOrigin.y;
-	}
+	NSArray *horizontalScrollViews = @[contentScrollView, columnHeaderScrollView, columnFooterScrollView];
+	NSArray *verticalScrollViews = @[contentScrollView, frozenContentScrollView, rowHeaderScrollView];
 	
-	// If the synced position is different from our current position, reposition the view
-	if (!NSEqualPoints(curOffset, changedBoundsOrigin)) {
-		[[scrollView contentView] scrollToPoint:newOffset];
-		// We have to tell the NSScrollView to update its scrollers
-		[scrollView reflectScrolledClipView:[scrollView contentView]];
+	for (NSScrollView *scrollView in @[contentScrollView, frozenContentScrollView, columnHeaderScrollView, rowHeaderScrollView, columnFooterScrollView]) {
+		NSPoint curOffset = [[scrollView contentView] bounds].origin;
+		NSPoint newOffset = curOffset;
+		
+		if ([horizontalScrollViews containsObject:scrollView]) {
+			newOffset.x = offset.x;
+		}
+		if ([verticalScrollViews containsObject:scrollView]) {
+			newOffset.y = offset.y;
+		}
+		
+		// If the synced position is different from our current position, reposition the view
+		if (!NSEqualPoints(curOffset, newOffset)) {
+			[[scrollView contentView] scrollToPoint:newOffset];
+			// We have to tell the NSScrollView to update its scrollers
+			[scrollView reflectScrolledClipView:[scrollView contentView]];
+		}
 	}
 	
-	[self updateShadows];
-	
 	self.syncronizingScroll = NO;
-}
-
-- (void)columnHeaderViewDidScroll:(NSNotification *)aNotification {
-	
-	NSView *changedView = [aNotification object];
-	NSPoint changedBoundsOrigin = [changedView bounds].origin;
 	
-	[self syncronizeScrollView:contentScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
-	[self syncronizeScrollView:frozenContentScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
-	[self syncronizeScrollView:rowHeaderScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:NO];
-	[self syncronizeScrollView:columnFooterScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
+	// The shadows and cursor rects only need to catch up once per pass
+	// through the run loop, no matter how many scroll events arrive
+	if (!self.needsScrollUpdates) {
+		self.needsScrollUpdates = YES;
+		[self performSelector:@selector(_updateAfterScrolling) withObject:nil afterDelay:0 inModes:@[NSRunLoopCommonModes]];
+	}
 	
-	[self.window invalidateCursorRectsForView:self];
+	self.scrollSynchronizationCount++;
+	self.scrollSynchronizationTime += CFAbsoluteTimeGetCurrent() - startTime;
 }
 
-- (void)rowHeaderViewDidScroll:(NSNotification *)aNotification {
-	
-	NSView *changedView = [aNotification object];
-	NSPoint changedBoundsOrigin = [changedView bounds].origin;
-	
-	[self syncronizeScrollView:contentScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:NO];
-	[self syncronizeScrollView:frozenContentScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:NO];
+- (void)_updateAfterScrolling {
+	self.needsScrollUpdates = NO;
 	
+	[self updateShadows];
 	[self.window invalidateCursorRectsForView:self];
-}
-
-- (void)columnFooterViewDidScroll:(NSNotification *)aNotification {
 	
-	NSView *changedView = [aNotification object];
-	NSPoint changedBoundsOrigin = [changedView bounds].origin;
-	
-	[self syncronizeScrollView:contentScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
-	[self syncronizeScrollView:frozenContentScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
-	[self syncronizeScrollView:columnHeaderScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
-	[self syncronizeScrollView:rowHeaderScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:NO];
-	
-	[self.window invalidateCursorRectsForView:self];
+	// The visible group rows have changed, so the content cursor rects need rebuilding
+	[self.window invalidateCursorRectsForView:contentView];
+	[self.window invalidateCursorRectsForView:frozenContentView];
 }
 
-- (void)contentViewDidScroll:(NSNotification *)aNotification {
+- (void)scrollViewDidScroll:(NSNotification *)aNotification {
 	
-	NSView *changedView = [aNotification object];
-	NSPoint changedBoundsOrigin = [changedView bounds].origin;
-	
-	[self syncronizeScrollView:frozenContentScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:NO];
-	[self syncronizeScrollView:columnHeaderScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
-	[self syncronizeScrollView:rowHeaderScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:NO];
-	[self syncronizeScrollView:columnFooterScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
-	
-	[self.window invalidateCursorRectsForView:self];
-}
-
-- (void)frozenContentViewDidScroll:(NSNotification *)aNotification {
+	if (self.syncronizingScroll) {
+		return;
+	}
 	
-	NSView *changedView = [aNotification object];
+	NSClipView *changedView = [aNotification object];
 	NSPoint changedBoundsOrigin = [changedView bounds].origin;
+	NSPoint offset = self.scrollOffset;
 	
-	[self syncronizeScrollView:contentScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:NO];
-	[self syncronizeScrollView:columnHeaderScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
-	[self syncronizeScrollView:rowHeaderScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:NO];
-	[self syncronizeScrollView:columnFooterScrollView withChangedBoundsOrigin:changedBoundsOrigin horizontal:YES];
+	// Each scroll view only drives the axes it scrolls along
+	if (changedView == [contentScrollView contentView]) {
+		offset = changedBoundsOrigin;
+	} else if (changedView == [columnHeaderScrollView contentView] || changedView == [columnFooterScrollView contentView]) {
+		offset.x = changedBoundsOrigin.x;
+	} else if (changedView == [rowHeaderScrollView contentView] || changedView == [frozenContentScrollView contentView]) {
+		offset.y = changedBoundsOrigin.y;
+	}
 	
+	self.scrollOffset = offset;
+	[self _applyScrollOffset];
 }
 
 - (void)didUndoOrRedo:(NSNotification *)aNotification {
+	if (aNotification.object != [self _undoManager]) {
+		return;
+	}
+	
+	// Changes undone through the journal have already redrawn what they touched
+	if (self.undoWasHandled) {
+		self.undoWasHandled = NO;
+		return;
+	}
 	
 	[self reloadData];
 }
@@ -1538,7 +1977,7 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		NSMutableIndexSet *draggedRows = [[NSKeyedUnarchiver unarchiveObjectWithData:rowData] mutableCopy];
 		
 		BOOL canDrop = NO;
-		if ([[self dataSource] respondsToSelector:@selector(tableGrid:canMoveRows:toIndex:)]) {
+		if ([[self dataSource] respondsToSelector:@selector(tableGrid:canMoveRows:toIndex:)] && [self _rowsAreModelRows]) {
 			canDrop = [[self dataSource] tableGrid:self canMoveRows:draggedRows toIndex:dropRow];
 		}
 		
@@ -1625,6 +2064,83 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 				
 				NSIndexSet *newColumns = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(startIndex, length)];
 				
+				// Completion indexes, aggregates and statistics are kept by column index
+				[self _invalidateCompletionIndexes];
+				[self.columnAggregates removeAllObjects];
+				self.displayAggregates = [NSMutableDictionary dictionary];
+				[self.groupAggregates removeAllObjects];
+				[self _invalidateAllStatistics];
+				
+				// Sort keys, the grouping column, footer aggregates, hidden columns and find matches follow their columns
+				NSMutableArray<NSNumber *> *columnOrder = [NSMutableArray arrayWithCapacity:_numberOfColumns];
+				for (NSUInteger column = 0; column < _numberOfColumns; column++) {
+					if (![draggedColumns containsIndex:column]) {
+						[columnOrder addObject:@(column)];
+					}
+				}
+				NSMutableArray<NSNumber *> *movedColumns = [NSMutableArray arrayWithCapacity:length];
+				[draggedColumns enumerateIndexesUsingBlock:^(NSUInteger column, BOOL *stop) {
+					[movedColumns addObject:@(column)];
+				}];
+				[columnOrder insertObjects:movedColumns atIndexes:newColumns];
+				
+				if (self.sortKeys.count > 0 || self.groupingColumn != NSNotFound || self.footerAggregates.count > 0 || self.hiddenColumns.count > 0) {
+					NSMutableArray<MBTableGridSortKey *> *sortKeys = [NSMutableArray arrayWithCapacity:self.sortKeys.count];
+					for (MBTableGridSortKey *sortKey in self.sortKeys) {
+						NSUInteger column = [columnOrder indexOfObject:@(sortKey.column)];
+						if (column != NSNotFound) {
+							[sortKeys addObject:[MBTableGridSortKey sortKeyWithColumn:column ascending:sortKey.ascending]];
+						}
+					}
+					_sortKeys = [sortKeys copy];
+					
+					if (self.groupingColumn != NSNotFound) {
+						_groupingColumn = [columnOrder indexOfObject:@(self.groupingColumn)];
+					}
+					
+					NSMutableDictionary<NSNumber *, NSNumber *> *footerAggregates = [NSMutableDictionary dictionaryWithCapacity:self.footerAggregates.count];
+					[self.footerAggregates enumerateKeysAndObjectsUsingBlock:^(NSNumber *column, NSNumber *function, BOOL *stop) {
+						NSUInteger movedColumn = [columnOrder indexOfObject:column];
+						if (movedColumn != NSNotFound) {
+							footerAggregates[@(movedColumn)] = function;
+						}
+					}];
+					self.footerAggregates = footerAggregates;
+					
+					if (self.hiddenColumns.count > 0) {
+						NSMutableIndexSet *hiddenColumns = [NSMutableIndexSet indexSet];
+						[self.hiddenColumns enumerateIndexesUsingBlock:^(NSUInteger column, BOOL *stop) {
+							NSUInteger movedColumn = [columnOrder indexOfObject:@(column)];
+							if (movedColumn != NSNotFound) {
+								[hiddenColumns addIndex:movedColumn];
+							}
+						}];
+						self.hiddenColumns = hiddenColumns;
+						[self _reloadColumnLayout];
+						[self setNeedsDisplay:YES];
+					}
+				}
+				
+				// A search still running hands back matches by the old column indexes, so it starts again
+				if (self.finding) {
+					[self findString:self.findString options:self.findOptions];
+				} else if (self.findString && self.findMatches.count == columnOrder.count && self.findModelMatches.count == columnOrder.count) {
+					NSMutableArray<NSMutableIndexSet *> *findMatches = [NSMutableArray arrayWithCapacity:columnOrder.count];
+					NSMutableArray<NSMutableIndexSet *> *findModelMatches = [NSMutableArray arrayWithCapacity:columnOrder.count];
+					NSMutableArray *formatters = self.finder.formatters ? [NSMutableArray arrayWithCapacity:columnOrder.count] : nil;
+					for (NSNumber *column in columnOrder) {
+						[findMatches addObject:self.findMatches[column.unsignedIntegerValue]];
+						[findModelMatches addObject:self.findModelMatches[column.unsignedIntegerValue]];
+						if (column.unsignedIntegerValue < self.finder.formatters.count) {
+							[formatters addObject:self.finder.formatters[column.unsignedIntegerValue]];
+						}
+					}
+					self.findMatches = findMatches;
+					self.findModelMatches = findModelMatches;
+					self.finder.formatters = formatters;
+					[self setNeedsDisplay:YES];
+				}
+				
 				// Post the notification
 				[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidMoveColumnsNotification object:self userInfo:@{ @"OldColumns": draggedColumns, @"NewColumns": newColumns }];
 				
@@ -1636,8 +2152,8 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		}
 	}
 	else if (rowData) {
-		// If we're dragging a row
-		if ([[self dataSource] respondsToSelector:@selector(tableGrid:moveRows:toIndex:)]) {
+		// If we're dragging a row, which can only be put somewhere else when every row is shown in data source order
+		if ([[self dataSource] respondsToSelector:@selector(tableGrid:moveRows:toIndex:)] && [self _rowsAreModelRows]) {
 			// Get which rows are being dragged
 			NSIndexSet *draggedRows = (NSIndexSet *)[NSKeyedUnarchiver unarchiveObjectWithData:rowData];
 			
@@ -1657,6 +2173,23 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 				
 				NSMutableIndexSet *newRows = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(startIndex, length)];
 				
+				// Only the rows between the old and new positions have changed places
+				NSUInteger firstMovedRow = MIN(draggedRows.firstIndex, dropRow);
+				NSUInteger endOfMovedRows = MIN(MAX(draggedRows.lastIndex + 1, dropRow), _numberOfRows);
+				if (endOfMovedRows > firstMovedRow) {
+					NSRange movedRange = NSMakeRange(firstMovedRow, endOfMovedRows - firstMovedRow);
+					[self _updateAggregatesForColumns:nil rows:movedRange];
+					
+					// Every row is shown in data source order, so the moved rows' matches are tested again
+					if (self.finding) {
+						[self findString:self.findString options:self.findOptions];
+					} else {
+						for (NSUInteger column = 0; column < _numberOfColumns; column++) {
+							[self _updateFindMatchesInColumn:column modelRows:[NSIndexSet indexSetWithIndexesInRange:movedRange]];
+						}
+					}
+				}
+				
 				// Post the notification
 				[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidMoveRowsNotification object:self userInfo:@{ @"OldRows": draggedRows, @"NewRows": newRows }];
 				
@@ -1715,14 +2248,149 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		_numberOfColumns = 0;
 	}
 	
-	// Set number of rows
+	// Set number of rows, which filters may reduce
 	if ([[self dataSource] respondsToSelector:@selector(numberOfRowsInTableGrid:)]) {
-		_numberOfRows =  [[self dataSource] numberOfRowsInTableGrid:self];
+		self.numberOfModelRows =  [[self dataSource] numberOfRowsInTableGrid:self];
 	}
 	else {
-		_numberOfRows = 0;
+		self.numberOfModelRows = 0;
+	}
+	
+	// Work out which rows are shown, and in which order
+	MBTableGridGroupRowsRemoveAll(self.groupRows);
+	self.groupRowsAreCached = NO;
+	[self _updateRowMapping];
+	
+	[self _validateSelection];
+	
+	// Widths measured from the old data no longer apply
+	[self.autosizer cancel];
+	self.autosizer = nil;
+	
+	columnWidths = [NSMutableDictionary new];
+	
+	[self populateColumnInfo];
+	
+	// Hidden columns stay hidden, unless they're gone
+	[self.hiddenColumns removeIndexesInRange:NSMakeRange(_numberOfColumns, NSNotFound - _numberOfColumns)];
+	[self _restoreHiddenColumns];
+	[self _reloadColumnLayout];
+	
+	// Completion indexes, aggregates and statistics are built again the next time they're needed
+	[self _invalidateCompletionIndexes];
+	[self.columnAggregates removeAllObjects];
+	self.displayAggregates = [NSMutableDictionary dictionary];
+	[self _invalidateAllStatistics];
+	
+	// Matches may have moved, so search again
+	if (self.findString) {
+		[self findString:self.findString options:self.findOptions];
+	}
+	
+	[self _updateContentSize];
+	
+	// The data may have changed whether the selection can be filled
+	[self _updateSelectionTracking];
+	
+	[self setNeedsDisplay:YES];
+}
+
+- (void)insertRowsAtIndexes:(NSIndexSet *)rowIndexes {
+	[self _updateRowsWithIndexes:rowIndexes inserted:YES];
+}
+
+- (void)removeRowsAtIndexes:(NSIndexSet *)rowIndexes {
+	[self _updateRowsWithIndexes:rowIndexes inserted:NO];
+}
+
+- (void)_updateRowsWithIndexes:(NSIndexSet *)rowIndexes inserted:(BOOL)inserted {
+	if ([[self dataSource] respondsToSelector:@selector(numberOfRowsInTableGrid:)]) {
+		self.numberOfModelRows = [[self dataSource] numberOfRowsInTableGrid:self];
+	}
+	
+	// Move the rows of the aggregates rather than reading every column again. New rows are
+	// inserted in ascending order, and removed rows from the end, so each range is still
+	// where the data source said it was. Aggregates that already have the new number of rows
+	// were updated by an earlier call for the same change.
+	NSUInteger previousNumberOfModelRows = inserted ? self.numberOfModelRows - MIN(rowIndexes.count, self.numberOfModelRows) : self.numberOfModelRows + rowIndexes.count;
+	NSMutableArray<NSNumber *> *staleColumns = [NSMutableArray array];
+	[self.columnAggregates enumerateKeysAndObjectsUsingBlock:^(NSNumber *column, MBTableGridColumnAggregates *aggregates, BOOL *stop) {
+		if (aggregates.numberOfRows == self.numberOfModelRows) {
+			return;
+		}
+		__block BOOL isStale = aggregates.numberOfRows != previousNumberOfModelRows;
+		[rowIndexes enumerateRangesWithOptions:inserted ? 0 : NSEnumerationReverse usingBlock:^(NSRange range, BOOL *stopRanges) {
+			if (isStale) {
+				*stopRanges = YES;
+			} else if (inserted) {
+				isStale = ![aggregates insertRowsInRange:range];
+			} else {
+				[aggregates removeRowsInRange:range];
+			}
+		}];
+		if (isStale || aggregates.numberOfRows != self.numberOfModelRows) {
+			[staleColumns addObject:column];
+		}
+	}];
+	[self.columnAggregates removeObjectsForKeys:staleColumns];
+	self.displayAggregates = [NSMutableDictionary dictionary];
+	[self _invalidateAllStatistics];
+	
+	// Collapsed headings from the data source, and find matches, move with their rows
+	NSMutableArray<NSMutableIndexSet *> *shiftedRows = [NSMutableArray arrayWithObject:self.collapsedModelRows];
+	if (self.findString && !self.finding) {
+		[shiftedRows addObjectsFromArray:self.findModelMatches];
+	}
+	for (NSMutableIndexSet *modelRows in shiftedRows) {
+		if (modelRows.count == 0) {
+			continue;
+		}
+		[rowIndexes enumerateRangesWithOptions:inserted ? 0 : NSEnumerationReverse usingBlock:^(NSRange range, BOOL *stop) {
+			if (inserted) {
+				[modelRows shiftIndexesStartingAtIndex:range.location by:range.length];
+			} else {
+				[modelRows removeIndexesInRange:range];
+				[modelRows shiftIndexesStartingAtIndex:NSMaxRange(range) by:-(NSInteger)range.length];
+			}
+		}];
+	}
+	
+	// Completion indexes may hold removed values, or be missing new ones
+	[self _invalidateCompletionIndexes];
+	
+	MBTableGridGroupRowsRemoveAll(self.groupRows);
+	self.groupRowsAreCached = NO;
+	[self _reloadRows];
+	
+	// A search still running hands back matches by the old rows, so it starts again. Otherwise only new rows are searched.
+	if (self.finding) {
+		[self findString:self.findString options:self.findOptions];
+	} else if (self.findString && inserted) {
+		for (NSUInteger column = 0; column < _numberOfColumns; column++) {
+			[self _updateFindMatchesInColumn:column modelRows:rowIndexes];
+		}
 	}
 	
+	// Read the new rows, and the row before each change, which may have become or stopped
+	// being a group summary row
+	[rowIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+		NSRange changedRange = range;
+		if (!inserted) {
+			changedRange.location -= [rowIndexes countOfIndexesInRange:NSMakeRange(0, range.location)];
+			changedRange.length = 0;
+		}
+		if (changedRange.location > 0) {
+			changedRange.location--;
+			changedRange.length++;
+		}
+		changedRange = NSIntersectionRange(changedRange, NSMakeRange(0, self.numberOfModelRows));
+		if (changedRange.length > 0) {
+			[self _updateAggregatesForColumns:nil rows:changedRange];
+		}
+	}];
+}
+
+- (void)_validateSelection {
 	// When data are reloaded, it is possible that previous internal data refer to rows or columns that are no longer
 	// valid, so we validate them here.
 	
@@ -1772,11 +2440,17 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		[self setSelectedColumnIndexes:validatedColumnIndexes];
 	}
 	
-	columnWidths = [NSMutableDictionary new];
-	[self.columnRects removeAllObjects];
-	
-	[self populateColumnInfo];
-	
+	// Drop any disjoint ranges that refer to rows or columns that no longer exist
+	if (self.additionalSelection) {
+		NSIndexSet *additionalColumns = self.additionalSelection.columnIndexes;
+		NSIndexSet *additionalRows = self.additionalSelection.rowIndexes;
+		if (additionalColumns.lastIndex >= _numberOfColumns || additionalRows.lastIndex >= _numberOfRows) {
+			[self _removeAdditionalSelection];
+		}
+	}
+}
+
+- (void)_updateContentSize {
 	// Update the content view's size
 	NSRect contentRect = self.frame;
 	
@@ -1801,9 +2475,7 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	NSSize frozenSize = contentRect.size;
 	
 	if (self.freezeColumns && self.numberOfFrozenColumns > 0) {
-		for (NSUInteger column = 0; column < self.numberOfFrozenColumns; column++) {
-			frozenWidth += [self _widthForColumn:column];
-		}
+		frozenWidth = MBTableGridColumnLayoutOffset(self.columnLayout, self.numberOfFrozenColumns);
 	}
 	
 	frozenScrollSize.width = frozenWidth;
@@ -1872,8 +2544,6 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	contentView.groupSummaryRowIndexes = nil;
 	frozenContentView.groupHeadingRowIndexes = nil;
 	frozenContentView.groupSummaryRowIndexes = nil;
-	
-	[self setNeedsDisplay:YES];
 }
 
 - (void)updateShadows {
@@ -1936,15 +2606,25 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 }
 
 - (NSInteger)columnAtPoint:(NSPoint)aPoint {
-	NSInteger column = 0;
-	while (column < _numberOfColumns) {
-		NSRect columnFrame = [self rectOfColumn:column];
-		if (NSPointInRect(aPoint, columnFrame)) {
+	if (aPoint.y < 0 || aPoint.y >= NSHeight(self.frame)) {
+		return NSNotFound;
+	}
+	
+	// Frozen columns sit on top of the scrolling ones, so check them first
+	if (self.freezeColumns) {
+		NSPoint frozenPoint = [self convertPoint:aPoint toView:frozenContentView];
+		NSInteger column = [frozenContentView columnAtPoint:NSMakePoint(frozenPoint.x, 0)];
+		if (column != NSNotFound && [self isFrozenColumn:column]) {
 			return column;
 		}
-		column++;
 	}
-	return NSNotFound;
+	
+	NSPoint contentPoint = [self convertPoint:aPoint toView:contentView];
+	NSInteger column = [contentView columnAtPoint:NSMakePoint(contentPoint.x, 0)];
+	if (column != NSNotFound && ![self isFrozenColumn:column]) {
+		return column;
+	}
+	return NSNotFound;
 }
 
 //- (NSInteger)rowAtPoint:(NSPoint)aPoint {
@@ -1972,15 +2652,12 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 }
 
 - (NSInteger)groupHeadingRowForRow:(NSInteger)rowIndex {
-	while (rowIndex >= 0 && ![self _isGroupHeadingRow:rowIndex]) {
-		rowIndex--;
-	}
-	
 	if (rowIndex < 0) {
 		return NSNotFound;
-	} else {
-		return rowIndex;
 	}
+	
+	size_t headingRow = MBTableGridGroupRowsHeadingForRow([self _groupRows], rowIndex);
+	return headingRow == MBTableGridCoreNotFound ? NSNotFound : (NSInteger)headingRow;
 }
 
 #pragma mark Auxiliary Views
@@ -2033,14 +2710,28 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	return self.freezeColumns && column < self.numberOfFrozenColumns;
 }
 
+- (NSRange)frozenColumnRange {
+	if (!self.freezeColumns) {
+		return NSMakeRange(0, 0);
+	}
+	
+	return NSMakeRange(0, MIN(self.numberOfFrozenColumns, self.numberOfColumns));
+}
+
+- (NSRange)unfrozenColumnRange {
+	NSUInteger firstColumn = NSMaxRange([self frozenColumnRange]);
+	return NSMakeRange(firstColumn, self.numberOfColumns - firstColumn);
+}
+
 - (BOOL)scrollForFrozenColumnsFromColumn:(NSUInteger)fromColumn right:(BOOL)right {
 	if ((!right && fromColumn == 0) || (right && fromColumn >= self.numberOfColumns - 1)) {
 		return NO;
 	}
 	
-	NSUInteger toColumn = right ? fromColumn + 1 : fromColumn - 1;
+	// Hidden columns are stepped over
+	NSUInteger toColumn = right ? [self _firstShownColumnFrom:fromColumn + 1] : [self _lastShownColumnThrough:fromColumn - 1];
 	
-	if ([self isFrozenColumn:toColumn] || toColumn == 0) {
+	if (toColumn == NSNotFound || [self isFrozenColumn:toColumn] || toColumn == 0) {
 		return NO;
 	}
 	
@@ -2067,6 +2758,403 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	return wantScroll;
 }
 
+#pragma mark Display Lists
+
+- (MBTableGridDisplayList *)displayListForRect:(NSRect)rect {
+	MBTableGridDisplayList *displayList = [[MBTableGridDisplayList alloc] init];
+	
+	// Record the views in the order they are layered, so frozen columns end up on top
+	NSArray *views = @[contentView, frozenContentView, columnHeaderView, frozenColumnHeaderView, rowHeaderView, columnFooterView, frozenColumnFooterView];
+	
+	for (NSView *view in views) {
+		if ([view isHiddenOrHasHiddenAncestor]) {
+			continue;
+		}
+		
+		NSRect visibleRect = [self convertRect:[view visibleRect] fromView:view];
+		NSRect recordRect = NSIntersectionRect(visibleRect, rect);
+		if (NSIsEmptyRect(recordRect)) {
+			continue;
+		}
+		
+		displayList.origin = [self convertPoint:NSZeroPoint fromView:view];
+		[(id)view recordDisplayList:displayList inRect:[self convertRect:recordRect toView:view]];
+	}
+	
+	displayList.origin = NSZeroPoint;
+	
+	return displayList;
+}
+
+#pragma mark Finding
+
+- (void)findString:(NSString *)searchString options:(MBTableGridFindOptions)options {
+	[self.finder cancel];
+	self.finder = nil;
+	
+	BOOL hadMatches = self.numberOfFindMatches > 0;
+	self.findMatches = [NSMutableArray arrayWithCapacity:_numberOfColumns];
+	self.findModelMatches = [NSMutableArray arrayWithCapacity:_numberOfColumns];
+	for (NSUInteger column = 0; column < _numberOfColumns; column++) {
+		[self.findMatches addObject:[NSMutableIndexSet indexSet]];
+		[self.findModelMatches addObject:[NSMutableIndexSet indexSet]];
+	}
+	self.numberOfFindMatches = 0;
+	self.findString = searchString.length ? searchString : nil;
+	self.findOptions = options;
+	
+	if (hadMatches) {
+		[self setNeedsDisplay:YES];
+	}
+	
+	if (!self.findString || _numberOfColumns == 0 || _numberOfRows == 0) {
+		self.finding = NO;
+		[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidChangeFindMatchesNotification object:self userInfo:@{ @"Finished": @YES }];
+		return;
+	}
+	
+	NSStringCompareOptions compareOptions = (options & MBTableGridFindCaseInsensitive) ? NSCaseInsensitiveSearch : 0;
+	MBTableGridFinder *finder = [[MBTableGridFinder alloc] initWithSearchString:searchString compareOptions:compareOptions matchesWholeCell:(options & MBTableGridFindWholeCell) != 0];
+	
+	// Fetch the formatters up front, so background threads don't have to ask for them
+	if (!(options & MBTableGridFindRawValues)) {
+		NSMutableArray *formatters = [NSMutableArray arrayWithCapacity:_numberOfColumns];
+		for (NSUInteger column = 0; column < _numberOfColumns; column++) {
+			[formatters addObject:[self _formatterForColumn:column] ?: [NSNull null]];
+		}
+		finder.formatters = formatters;
+	}
+	
+	__weak MBTableGrid *weakSelf = self;
+	id<MBTableGridDataSource> dataSource = self.dataSource;
+	finder.valueProvider = ^id(NSUInteger columnIndex, NSUInteger rowIndex) {
+		return [dataSource tableGrid:weakSelf objectValueForColumn:columnIndex row:rowIndex];
+	};
+	finder.readsValuesConcurrently = [dataSource respondsToSelector:@selector(tableGridSupportsConcurrentValueAccess:)] && [dataSource tableGridSupportsConcurrentValueAccess:self];
+	
+	// The search runs over data source rows, so it never needs the displayed order from another thread.
+	// Rows that aren't shown are searched too, so sorting, filtering or collapsing only moves the matches.
+	NSIndexSet *rowIndexes = [self _valueModelRowIndexes];
+	
+	self.finder = finder;
+	self.finding = YES;
+	
+	[finder searchNumberOfColumns:_numberOfColumns rows:rowIndexes matchesHandler:^(NSArray<NSIndexSet *> *matchesByColumn) {
+		[weakSelf _addFindMatches:matchesByColumn];
+	} completionHandler:^{
+		weakSelf.finding = NO;
+		[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidChangeFindMatchesNotification object:weakSelf userInfo:@{ @"Finished": @YES }];
+	}];
+}
+
+- (NSIndexSet *)_valueModelRowIndexes {
+	// Group rows from the data source are left out, but rows that are filtered out or collapsed aren't
+	NSMutableIndexSet *rowIndexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, self.numberOfModelRows)];
+	[rowIndexes removeIndexes:[self _modelGroupRowIndexes]];
+	return rowIndexes;
+}
+
+- (void)_addFindMatches:(NSArray<NSIndexSet *> *)matchesByColumn {
+	NSUInteger numberOfColumns = MIN(matchesByColumn.count, self.findModelMatches.count);
+	for (NSUInteger column = 0; column < numberOfColumns; column++) {
+		// Edited cells may have been tested already
+		NSMutableIndexSet *modelMatches = [matchesByColumn[column] mutableCopy];
+		[modelMatches removeIndexes:self.findModelMatches[column]];
+		[self.findModelMatches[column] addIndexes:modelMatches];
+		
+		NSIndexSet *matches = [self _rowIndexesForModelRowIndexes:modelMatches];
+		if (matches.count == 0) {
+			continue;
+		}
+		
+		[self.findMatches[column] addIndexes:matches];
+		self.numberOfFindMatches += matches.count;
+		
+		// Only redraw the rows that gained highlights
+		[self _setNeedsDisplayInColumns:[NSIndexSet indexSetWithIndex:column] rows:matches];
+	}
+	
+	[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidChangeFindMatchesNotification object:self userInfo:@{ @"Finished": @NO }];
+}
+
+- (void)_remapFindMatches {
+	if (!self.findString) {
+		return;
+	}
+	
+	// Matches are kept by data source row, so only their displayed rows change
+	NSUInteger numberOfFindMatches = 0;
+	for (NSUInteger column = 0; column < self.findModelMatches.count && column < self.findMatches.count; column++) {
+		NSMutableIndexSet *matches = [[self _rowIndexesForModelRowIndexes:self.findModelMatches[column]] mutableCopy];
+		self.findMatches[column] = matches;
+		numberOfFindMatches += matches.count;
+	}
+	
+	if (numberOfFindMatches != self.numberOfFindMatches) {
+		self.numberOfFindMatches = numberOfFindMatches;
+		[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidChangeFindMatchesNotification object:self userInfo:@{ @"Finished": @(!self.finding) }];
+	}
+}
+
+- (void)_updateFindMatchesInColumn:(NSUInteger)columnIndex modelRows:(NSIndexSet *)modelRowIndexes {
+	if (!self.findString || !self.finder || columnIndex >= self.findMatches.count || columnIndex >= self.findModelMatches.count) {
+		return;
+	}
+	
+	// Edited cells are tested again on their own, rather than searching the whole grid
+	NSMutableIndexSet *matchingModelRows = [NSMutableIndexSet indexSet];
+	[modelRowIndexes enumerateIndexesUsingBlock:^(NSUInteger modelRowIndex, BOOL *stop) {
+		if ([self.finder matchesValue:[self _objectValueForColumn:columnIndex modelRow:modelRowIndex] column:columnIndex]) {
+			[matchingModelRows addIndex:modelRowIndex];
+		}
+	}];
+	
+	[self.findModelMatches[columnIndex] removeIndexes:modelRowIndexes];
+	[self.findModelMatches[columnIndex] addIndexes:matchingModelRows];
+	
+	NSMutableIndexSet *matches = self.findMatches[columnIndex];
+	NSUInteger previousNumberOfMatches = matches.count;
+	[matches removeIndexes:[self _rowIndexesForModelRowIndexes:modelRowIndexes]];
+	[matches addIndexes:[self _rowIndexesForModelRowIndexes:matchingModelRows]];
+	if (matches.count != previousNumberOfMatches) {
+		self.numberOfFindMatches = self.numberOfFindMatches + matches.count - previousNumberOfMatches;
+		[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidChangeFindMatchesNotification object:self userInfo:@{ @"Finished": @(!self.finding) }];
+	}
+}
+
+- (void)clearFindMatches {
+	[self findString:nil options:0];
+}
+
+- (NSIndexSet *)findMatchesInColumn:(NSUInteger)columnIndex {
+	return columnIndex < self.findMatches.count ? self.findMatches[columnIndex] : [NSIndexSet indexSet];
+}
+
+- (IBAction)findNext:(id)sender {
+	[self _selectFindMatchForward:YES];
+}
+
+- (IBAction)findPrevious:(id)sender {
+	[self _selectFindMatchForward:NO];
+}
+
+- (void)_selectFindMatchForward:(BOOL)forward {
+	if (self.numberOfFindMatches == 0) {
+		NSBeep();
+		return;
+	}
+	
+	NSInteger numberOfColumns = self.findMatches.count;
+	NSInteger step = forward ? 1 : -1;
+	
+	// Without a selection, start just before the first cell or just after the last one
+	NSInteger currentColumn = forward ? -1 : numberOfColumns;
+	NSUInteger currentRow = forward ? 0 : _numberOfRows - 1;
+	if (self.selectedColumnIndexes.count && self.selectedRowIndexes.count) {
+		currentColumn = self.selectedColumnIndexes.firstIndex;
+		currentRow = self.selectedRowIndexes.firstIndex;
+	}
+	
+	// Look further along the same row first
+	for (NSInteger candidate = currentColumn + step; candidate >= 0 && candidate < numberOfColumns; candidate += step) {
+		if ([self.findMatches[candidate] containsIndex:currentRow]) {
+			[self selectRow:currentRow column:candidate];
+			return;
+		}
+	}
+	
+	// Then the nearest row after (or before) this one, wrapping around once
+	for (NSUInteger pass = 0; pass < 2; pass++) {
+		NSUInteger bestRow = NSNotFound;
+		NSUInteger bestColumn = NSNotFound;
+		
+		for (NSInteger candidate = 0; candidate < numberOfColumns; candidate++) {
+			NSIndexSet *matches = self.findMatches[candidate];
+			NSUInteger candidateRow;
+			if (pass == 0) {
+				candidateRow = forward ? [matches indexGreaterThanIndex:currentRow] : [matches indexLessThanIndex:currentRow];
+			} else {
+				candidateRow = forward ? matches.firstIndex : matches.lastIndex;
+			}
+			
+			if (candidateRow == NSNotFound) {
+				continue;
+			}
+			
+			// Going forward the first column of the nearest row wins, going back the last one does
+			if (bestRow == NSNotFound || (forward ? candidateRow < bestRow : candidateRow >= bestRow)) {
+				bestRow = candidateRow;
+				bestColumn = candidate;
+			}
+		}
+		
+		if (bestRow != NSNotFound) {
+			[self selectRow:bestRow column:bestColumn];
+			return;
+		}
+	}
+}
+
+#pragma mark Sorting
+
+- (void)setSortKeys:(NSArray<MBTableGridSortKey *> *)sortKeys {
+	_sortKeys = [sortKeys copy];
+	[self _reloadRows];
+}
+
+#pragma mark Filtering
+
+- (void)setFilters:(NSArray<MBTableGridFilter *> *)filters {
+	_filters = [filters copy];
+	[self _reloadRows];
+}
+
+#pragma mark Grouping
+
+- (void)setGroupingColumn:(NSUInteger)groupingColumn {
+	_groupingColumn = groupingColumn;
+	
+	// Collapsed groups are remembered by value, which only means something in the same column
+	[self.collapsedGroupValues removeAllObjects];
+	
+	// Group rows from the data source are left out of the aggregates, but aren't asked about while grouping
+	if ([[self dataSource] respondsToSelector:@selector(tableGrid:isGroupRow:)]) {
+		[self.columnAggregates removeAllObjects];
+		self.displayAggregates = [NSMutableDictionary dictionary];
+		[columnFooterView setNeedsDisplay:YES];
+		[frozenColumnFooterView setNeedsDisplay:YES];
+	}
+	[self _reloadRows];
+}
+
+- (void)collapseGroupRow:(NSUInteger)rowIndex {
+	[self _setGroupRow:rowIndex collapsed:YES];
+}
+
+- (void)expandGroupRow:(NSUInteger)rowIndex {
+	[self _setGroupRow:rowIndex collapsed:NO];
+}
+
+- (BOOL)isGroupRowCollapsed:(NSUInteger)rowIndex {
+	return rowIndex < _numberOfRows && [self _isGroupHeadingRow:rowIndex] && [self _isExpandedGroupRowCollapsed:[self _expandedRowForRow:rowIndex]];
+}
+
+#pragma mark Aggregates
+
+- (NSNumber *)aggregateValue:(MBTableGridAggregateFunction)function forColumn:(NSUInteger)columnIndex {
+	MBTableGridColumnAggregates *aggregates = [self _aggregatesForColumn:columnIndex];
+	if (!aggregates) {
+		return nil;
+	}
+	
+	if (function >= MBTableGridAggregateDistinctCount) {
+		MBTableGridColumnSketches *sketches = [self _sketchesForColumn:columnIndex];
+		if (!sketches) {
+			return nil;
+		} else if (function == MBTableGridAggregateDistinctCount) {
+			return @(sketches.distinctCount);
+		}
+		double value = [sketches valueAtRank:function == MBTableGridAggregateMedian ? 0.5 : 0.95];
+		return isnan(value) ? nil : @(value);
+	}
+	
+	// Group rows from the data source are never filtered out, so there are as many as there are with every group expanded.
+	// The ones added by the grid aren't data source rows at all.
+	NSUInteger numberOfGroupRows = self.columnGroupRows ? 0 : MBTableGridGroupRowsCount([self _expandedGroupRows]);
+	return [self _valueForAggregate:aggregates.totalAggregate function:function numberOfRows:aggregates.numberOfRows - MIN(numberOfGroupRows, aggregates.numberOfRows)];
+}
+
+- (NSNumber *)aggregateValue:(MBTableGridAggregateFunction)function forColumn:(NSUInteger)columnIndex groupSummaryRow:(NSUInteger)rowIndex {
+	MBTableGridColumnAggregates *aggregates = [self _aggregatesForColumn:columnIndex];
+	if (!aggregates || rowIndex >= _numberOfRows || function >= MBTableGridAggregateDistinctCount) {
+		return nil;
+	}
+	
+	// Groups made by the grid are spread out in the data source, so their aggregates are worked out together
+	if (self.columnGroupRows) {
+		NSUInteger expandedRow = [self _expandedRowForRow:rowIndex];
+		if (MBTableGridGroupRowsKind(self.columnGroupRows, expandedRow) != MBTableGridGroupRowSummary) {
+			return nil;
+		}
+		NSUInteger groupIndex = [self _groupForExpandedRow:expandedRow];
+		const MBTableGridAggregate *groupAggregates = [self _groupAggregatesForColumn:columnIndex].bytes;
+		return [self _valueForAggregate:groupAggregates[groupIndex] function:function numberOfRows:[self _positionsOfGroup:groupIndex].length];
+	}
+	
+	// The group runs from its heading, or the first row, to the summary row, neither included
+	NSInteger headingRow = [self groupHeadingRowForRow:rowIndex];
+	NSUInteger firstModelRow = headingRow == NSNotFound ? 0 : [self _modelRowForRow:headingRow] + 1;
+	NSUInteger summaryModelRow = [self _modelRowForRow:rowIndex];
+	if (summaryModelRow < firstModelRow) {
+		return nil;
+	}
+	
+	NSRange groupRange = NSMakeRange(firstModelRow, summaryModelRow - firstModelRow);
+	return [self _valueForAggregate:[aggregates aggregateForRowsInRange:groupRange] function:function numberOfRows:groupRange.length];
+}
+
+- (NSNumber *)_valueForAggregate:(MBTableGridAggregate)aggregate function:(MBTableGridAggregateFunction)function numberOfRows:(NSUInteger)numberOfRows {
+	switch (function) {
+		case MBTableGridAggregateSum:
+			return @(aggregate.sum);
+		case MBTableGridAggregateMinimum:
+			return aggregate.count ? @(aggregate.minimum) : nil;
+		case MBTableGridAggregateMaximum:
+			return aggregate.count ? @(aggregate.maximum) : nil;
+		case MBTableGridAggregateAverage:
+			return aggregate.count ? @(aggregate.sum / aggregate.count) : nil;
+		case MBTableGridAggregateRowCount:
+			return @(numberOfRows);
+		default:
+			return @(aggregate.count);
+	}
+}
+
+- (void)setFooterAggregates:(NSDictionary<NSNumber *, NSNumber *> *)footerAggregates {
+	_footerAggregates = [footerAggregates copy];
+	[columnFooterView setNeedsDisplay:YES];
+	[frozenColumnFooterView setNeedsDisplay:YES];
+}
+
+- (NSUInteger)modelRowForRow:(NSUInteger)rowIndex {
+	return [self _modelRowForRow:rowIndex];
+}
+
+- (NSUInteger)rowForModelRow:(NSUInteger)modelRowIndex {
+	if (modelRowIndex >= self.numberOfModelRows) {
+		return modelRowIndex + _numberOfRows - MIN(_numberOfRows, self.numberOfModelRows);
+	}
+	
+	NSUInteger position = [self _positionForModelRow:modelRowIndex];
+	if (self.visibleRows) {
+		if (!MBTableGridRowBitmapIsSet(self.visibleRows, position)) {
+			return NSNotFound;
+		}
+		position = MBTableGridRowBitmapRank(self.visibleRows, position);
+	}
+	return [self _rowForExpandedRow:[self _rowForPosition:position]];
+}
+
+- (NSUInteger)_positionForModelRow:(NSUInteger)modelRowIndex {
+	NSUInteger numberOfSortedRows = self.rowPermutation.length / sizeof(NSUInteger);
+	if (modelRowIndex >= numberOfSortedRows) {
+		return modelRowIndex;
+	}
+	
+	// Only needed for undo and the like, so worked out when first asked for
+	if (!self.inverseRowPermutation) {
+		const NSUInteger *modelRows = self.rowPermutation.bytes;
+		NSMutableData *inverseRowPermutation = [NSMutableData dataWithLength:self.rowPermutation.length];
+		NSUInteger *rows = inverseRowPermutation.mutableBytes;
+		for (NSUInteger row = 0; row < numberOfSortedRows; row++) {
+			rows[modelRows[row]] = row;
+		}
+		self.inverseRowPermutation = inverseRowPermutation;
+	}
+	
+	return ((const NSUInteger *)self.inverseRowPermutation.bytes)[modelRowIndex];
+}
+
 #pragma mark - Overridden Property Accessors
 
 - (void)setSelectedColumnIndexes:(NSIndexSet *)anIndexSet {
@@ -2080,7 +3168,14 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	
 	_selectedColumnIndexes = anIndexSet;
 	
+	// A new selection replaces any disjoint ranges, unless the user is adding one
+	if (!self.addingSelection) {
+		self.additionalSelection = nil;
+	}
+	self.cachedSelection = nil;
+	
 	[self setNeedsDisplay:YES];
+	[self _updateSelectionTracking];
 	
 	// Post the notification
 	[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidChangeSelectionNotification object:self];
@@ -2098,17 +3193,90 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	
 	_selectedRowIndexes = anIndexSet;
 	
+	if (!self.addingSelection) {
+		self.additionalSelection = nil;
+	}
+	self.cachedSelection = nil;
+	
 	if (anIndexSet.count == 1) {
 		firstSelectedRow = anIndexSet.firstIndex;
 	}
 	
 	[self setNeedsDisplay:YES];
+	[self _updateSelectionTracking];
 	
 	// Post the notification
 	[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidChangeSelectionNotification object:self];
 	[[NSNotificationCenter defaultCenter] postNotificationName:MBTableGridDidChangeRowSelectionNotification object:self];
 }
 
+- (MBTableGridSelection *)selection {
+	// Rows can be added to the selected row indexes in place, so the cache is also reset when tracking is updated
+	if (!self.cachedSelection) {
+		if (self.additionalSelection) {
+			self.cachedSelection = [self.additionalSelection selectionByAddingColumnIndexes:_selectedColumnIndexes rowIndexes:_selectedRowIndexes];
+		} else {
+			self.cachedSelection = [[MBTableGridSelection alloc] initWithColumnIndexes:_selectedColumnIndexes rowIndexes:_selectedRowIndexes];
+		}
+	}
+	return self.cachedSelection;
+}
+
+- (void)statisticsForColumn:(NSUInteger)columnIndex completionHandler:(void (^)(MBTableGridColumnStatistics *statistics))completionHandler {
+	MBTableGridColumnStatistics *statistics = self.columnStatistics[@(columnIndex)];
+	if (statistics || columnIndex >= _numberOfColumns) {
+		completionHandler(statistics);
+		return;
+	}
+	
+	// Requests made while the column is being counted wait for the same statistics
+	NSMutableArray *handlers = self.statisticsHandlers[@(columnIndex)];
+	if (handlers) {
+		[handlers addObject:[completionHandler copy]];
+		return;
+	}
+	self.statisticsHandlers[@(columnIndex)] = [NSMutableArray arrayWithObject:[completionHandler copy]];
+	[self _buildStatisticsForColumn:columnIndex];
+}
+
+- (MBTableGridStatistics *)selectionStatistics {
+	MBTableGridSelection *selection = self.selection;
+	if (self.cachedSelectionStatistics && self.selectionOfCachedStatistics == selection) {
+		return self.cachedSelectionStatistics;
+	}
+	
+	// Overlapping rectangles share rows, so gather each column's rows first to count them once
+	NSMutableDictionary<NSNumber *, NSMutableIndexSet *> *rowsByColumn = [NSMutableDictionary dictionary];
+	[selection enumerateRectsUsingBlock:^(NSIndexSet *columnIndexes, NSIndexSet *rowIndexes, BOOL *stop) {
+		[columnIndexes enumerateIndexesUsingBlock:^(NSUInteger columnIndex, BOOL *stopColumns) {
+			NSMutableIndexSet *rows = rowsByColumn[@(columnIndex)];
+			if (!rows) {
+				rows = [NSMutableIndexSet indexSet];
+				rowsByColumn[@(columnIndex)] = rows;
+			}
+			[rows addIndexes:rowIndexes];
+		}];
+	}];
+	
+	// Each range of displayed rows is one query, however the rows are sorted, filtered or grouped.
+	// Columns without a tree in displayed order yet have their selected cells read instead, so
+	// selecting doesn't wait for a whole column to be read.
+	__block MBTableGridAggregate aggregate = MBTableGridAggregateEmpty();
+	[rowsByColumn enumerateKeysAndObjectsUsingBlock:^(NSNumber *column, NSMutableIndexSet *rows, BOOL *stop) {
+		MBTableGridColumnAggregates *aggregates = [self _builtDisplayAggregatesForColumn:column.unsignedIntegerValue];
+		if (aggregates) {
+			aggregate = MBTableGridAggregateCombine(aggregate, [aggregates aggregateForRowIndexes:rows]);
+		} else if (column.unsignedIntegerValue < _numberOfColumns) {
+			aggregate = MBTableGridAggregateCombine(aggregate, [self _aggregateForColumn:column.unsignedIntegerValue rows:rows]);
+			[self _buildDisplayAggregatesForColumn:column.unsignedIntegerValue];
+		}
+	}];
+	
+	self.cachedSelectionStatistics = [[MBTableGridStatistics alloc] initWithAggregate:aggregate];
+	self.selectionOfCachedStatistics = selection;
+	return self.cachedSelectionStatistics;
+}
+
 - (void)setDelegate:(id <MBTableGridDelegate> )anObject {
 	if (anObject == _delegate)
 		return;
@@ -2155,6 +3323,33 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	return YES;
 }
 
+- (void)_setNeedsDisplayInColumns:(NSIndexSet *)columnIndexes rows:(NSIndexSet *)rowIndexes {
+	if (columnIndexes.count == 0 || rowIndexes.count == 0) {
+		return;
+	}
+	
+	NSRange columnRanges[2] = {[self frozenColumnRange], [self unfrozenColumnRange]};
+	MBTableGridContentView *contentViews[2] = {frozenContentView, contentView};
+	MBTableGridFooterView *footerViews[2] = {frozenColumnFooterView, columnFooterView};
+	
+	// Only redraw the changed cells, and the footers of their columns, in each part of the grid
+	for (NSUInteger i = 0; i < 2; i++) {
+		NSUInteger firstColumn = [columnIndexes indexGreaterThanOrEqualToIndex:columnRanges[i].location];
+		NSUInteger lastColumn = [columnIndexes indexLessThanIndex:NSMaxRange(columnRanges[i])];
+		
+		if (firstColumn == NSNotFound || lastColumn == NSNotFound || firstColumn > lastColumn) {
+			continue;
+		}
+		
+		NSRect firstCell = [contentViews[i] frameOfCellAtColumn:firstColumn row:rowIndexes.firstIndex];
+		NSRect lastCell = [contentViews[i] frameOfCellAtColumn:lastColumn row:rowIndexes.lastIndex];
+		[contentViews[i] setNeedsDisplayInRect:NSUnionRect(firstCell, lastCell)];
+		
+		NSRect footerRect = NSUnionRect([footerViews[i] footerRectOfColumn:firstColumn], [footerViews[i] footerRectOfColumn:lastColumn]);
+		[footerViews[i] setNeedsDisplayInRect:footerRect];
+	}
+}
+
 - (void)_drawColumnHeaderBackgroundInRect:(NSRect)aRect {
 	if ([self needsToDrawRect:aRect]) {
 		
@@ -2302,17 +3497,156 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 }
 
 - (NSString *)_headerStringForRow:(NSUInteger)rowIndex {
+	// Rows in data source order are numbered without their group rows, counting the rows of collapsed groups,
+	// and sorted rows keep the number of their data source row
+	NSUInteger rowNumber = [self _modelRowForRow:rowIndex];
+	if (rowNumber == NSNotFound) {
+		return @"";
+	} else if (!self.rowPermutation && !self.visibleRows && !self.columnGroupRows) {
+		NSUInteger expandedRow = [self _expandedRowForRow:rowIndex];
+		rowNumber = expandedRow - MBTableGridGroupRowsCountBefore([self _expandedGroupRows], expandedRow);
+	}
+	
 	// Ask the data source
 	if ([[self dataSource] respondsToSelector:@selector(tableGrid:headerStringForRow:)]) {
-		return [[self dataSource] tableGrid:self headerStringForRow:rowIndex];
+		return [[self dataSource] tableGrid:self headerStringForRow:rowNumber];
 	}
 	
-	return [NSString localizedStringWithFormat:@"%lu", (rowIndex + 1)];
+	return [NSString localizedStringWithFormat:@"%lu", (rowNumber + 1)];
 }
 
 - (id)_objectValueForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound) {
+		return [self _objectValueForColumn:columnIndex modelRow:modelRowIndex];
+	}
+	
+	// A heading added by the grid shows the value of its group, which its first row has
+	NSUInteger expandedRow = [self _expandedRowForRow:rowIndex];
+	if (MBTableGridGroupRowsKind(self.columnGroupRows, expandedRow) == MBTableGridGroupRowHeading) {
+		id value = [self _objectValueForColumn:self.groupingColumn modelRow:[self _modelRowForExpandedRow:expandedRow + 1]];
+		return [MBTableGridTabularText stringForValue:value formatter:[self _formatterForColumn:self.groupingColumn]];
+	}
+	return nil;
+}
+
+- (NSUInteger)_modelRowForRow:(NSUInteger)rowIndex {
+	return [self _modelRowForExpandedRow:[self _expandedRowForRow:rowIndex]];
+}
+
+- (NSUInteger)_expandedRowForRow:(NSUInteger)rowIndex {
+	// Expanded rows are the rows as they would be with every group expanded
+	if (!self.collapsedRows) {
+		return rowIndex;
+	} else if (rowIndex >= _numberOfRows) {
+		return rowIndex + self.numberOfExpandedRows - MIN(_numberOfRows, self.numberOfExpandedRows);
+	}
+	return MBTableGridCollapsedRowsSelect(self.collapsedRows, rowIndex);
+}
+
+- (NSUInteger)_rowForExpandedRow:(NSUInteger)expandedRow {
+	if (!self.collapsedRows) {
+		return expandedRow;
+	} else if (expandedRow >= self.numberOfExpandedRows) {
+		return expandedRow + _numberOfRows - MIN(self.numberOfExpandedRows, _numberOfRows);
+	} else if (MBTableGridCollapsedRowsIsHidden(self.collapsedRows, expandedRow)) {
+		return NSNotFound;
+	}
+	return MBTableGridCollapsedRowsRank(self.collapsedRows, expandedRow);
+}
+
+- (NSUInteger)_modelRowForExpandedRow:(NSUInteger)expandedRow {
+	// Rows past the end map past the end, as if they had been appended
+	if (expandedRow >= self.numberOfExpandedRows) {
+		return expandedRow + self.numberOfModelRows - MIN(self.numberOfExpandedRows, self.numberOfModelRows);
+	}
+	
+	// Group rows added by the grid take up rows without taking up positions
+	NSUInteger position = expandedRow;
+	if (self.columnGroupRows) {
+		size_t numberOfGroupRowsBefore = MBTableGridGroupRowsCountBefore(self.columnGroupRows, expandedRow);
+		if (MBTableGridGroupRowsRowAtIndex(self.columnGroupRows, numberOfGroupRowsBefore) == expandedRow) {
+			return NSNotFound;
+		}
+		position -= numberOfGroupRowsBefore;
+	}
+	return [self _modelRowForPosition:position];
+}
+
+- (NSUInteger)_modelRowForPosition:(NSUInteger)position {
+	// Positions count the rows that are shown, in sorted order
+	if (self.visibleRows) {
+		position = MBTableGridRowBitmapSelect(self.visibleRows, position);
+	}
+	NSData *rowPermutation = self.rowPermutation;
+	if (!rowPermutation || position >= rowPermutation.length / sizeof(NSUInteger)) {
+		return position;
+	}
+	return ((const NSUInteger *)rowPermutation.bytes)[position];
+}
+
+- (NSUInteger)_rowForPosition:(NSUInteger)position {
+	NSData *groupStartPositions = self.groupStartPositions;
+	if (!groupStartPositions) {
+		return position;
+	}
+	
+	// Every group that has started adds its heading, and every one that has ended its summary too
+	NSUInteger numberOfStartedGroups = [self _numberOfGroupsStartedAtPosition:position];
+	return position + numberOfStartedGroups + (self.includeGroupSummaryRows && numberOfStartedGroups > 0 ? numberOfStartedGroups - 1 : 0);
+}
+
+- (NSUInteger)_numberOfGroupsStartedAtPosition:(NSUInteger)position {
+	NSData *groupStartPositions = self.groupStartPositions;
+	const NSUInteger *startPositions = groupStartPositions.bytes;
+	NSUInteger low = 0;
+	NSUInteger high = groupStartPositions.length / sizeof(NSUInteger) - MIN(groupStartPositions.length / sizeof(NSUInteger), 1);
+	while (low < high) {
+		NSUInteger middle = low + (high - low) / 2;
+		if (startPositions[middle] <= position) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+- (BOOL)_rowsAreModelRows {
+	return !self.rowPermutation && !self.visibleRows && !self.columnGroupRows && !self.collapsedRows;
+}
+
+- (NSIndexSet *)_modelRowIndexes:(NSIndexSet *)rowIndexes {
+	if ([self _rowsAreModelRows]) {
+		return rowIndexes;
+	}
+	NSMutableIndexSet *modelRowIndexes = [NSMutableIndexSet indexSet];
+	[rowIndexes enumerateIndexesUsingBlock:^(NSUInteger rowIndex, BOOL *stop) {
+		NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+		if (modelRowIndex != NSNotFound) {
+			[modelRowIndexes addIndex:modelRowIndex];
+		}
+	}];
+	return modelRowIndexes;
+}
+
+- (NSIndexSet *)_rowIndexesForModelRowIndexes:(NSIndexSet *)modelRowIndexes {
+	if ([self _rowsAreModelRows]) {
+		return modelRowIndexes;
+	}
+	NSMutableIndexSet *rowIndexes = [NSMutableIndexSet indexSet];
+	[modelRowIndexes enumerateIndexesUsingBlock:^(NSUInteger modelRowIndex, BOOL *stop) {
+		NSUInteger rowIndex = [self rowForModelRow:modelRowIndex];
+		if (rowIndex != NSNotFound) {
+			[rowIndexes addIndex:rowIndex];
+		}
+	}];
+	return rowIndexes;
+}
+
+- (id)_objectValueForColumn:(NSUInteger)columnIndex modelRow:(NSUInteger)modelRowIndex {
 	if ([[self dataSource] respondsToSelector:@selector(tableGrid:objectValueForColumn:row:)]) {
-		id value = [[self dataSource] tableGrid:self objectValueForColumn:columnIndex row:rowIndex];
+		id value = [[self dataSource] tableGrid:self objectValueForColumn:columnIndex row:modelRowIndex];
 		return value;
 	}
 	else if ([self dataSource]) {
@@ -2322,8 +3656,9 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 }
 
 - (NSImage *)_accessoryButtonImageForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:accessoryButtonImageForColumn:row:)]) {
-		return [[self dataSource] tableGrid:self accessoryButtonImageForColumn:columnIndex row:rowIndex];
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound && [[self dataSource] respondsToSelector:@selector(tableGrid:accessoryButtonImageForColumn:row:)]) {
+		return [[self dataSource] tableGrid:self accessoryButtonImageForColumn:columnIndex row:modelRowIndex];
 	}
 	return nil;
 }
@@ -2351,51 +3686,650 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	return nil;
 }
 
-- (NSArray *)_autocompleteValuesForEditString:(NSString *)editString column:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
+- (void)_autocompleteValuesForEditString:(NSString *)editString column:(NSUInteger)columnIndex row:(NSUInteger)rowIndex completionHandler:(void (^)(NSArray *completions))completionHandler {
+	[self _cancelAutocomplete];
+	
+	NSUInteger generation = self.autocompleteGeneration;
+	NSUInteger maximumCount = self.maximumNumberOfAutocompleteValues;
+	
+	// Results are always delivered on the main thread, and dropped if a newer query has started since
+	__weak MBTableGrid *weakSelf = self;
+	void (^deliver)(NSArray *) = ^(NSArray *completions) {
+		if (completions.count > maximumCount) {
+			completions = [completions subarrayWithRange:NSMakeRange(0, maximumCount)];
+		}
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (weakSelf && weakSelf.autocompleteGeneration == generation) {
+				completionHandler(completions ?: @[]);
+			}
+		});
+	};
+	
+	if ([[self dataSource] respondsToSelector:@selector(tableGrid:autocompleteValuesForEditString:column:row:completionHandler:)]) {
+		[[self dataSource] tableGrid:self autocompleteValuesForEditString:editString column:columnIndex row:[self _modelRowForRow:rowIndex] completionHandler:deliver];
+		return;
+	}
+	
 	if ([[self dataSource] respondsToSelector:@selector(tableGrid:autocompleteValuesForEditString:column:row:)]) {
-		return [[self dataSource] tableGrid:self autocompleteValuesForEditString:editString column:columnIndex row:rowIndex];
+		NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+		
+		// The data source expects to be called on the main thread, so ask it once the keystroke has been handled
+		dispatch_async(dispatch_get_main_queue(), ^{
+			if (weakSelf && weakSelf.autocompleteGeneration == generation) {
+				deliver([[weakSelf dataSource] tableGrid:weakSelf autocompleteValuesForEditString:editString column:columnIndex row:modelRowIndex]);
+			}
+		});
+		return;
 	}
-	return nil;
-}
-
+	
+	void (^search)(MBTableGridCompletionIndex *) = ^(MBTableGridCompletionIndex *completionIndex) {
+		NSBlockOperation *operation = [NSBlockOperation new];
+		__weak NSBlockOperation *weakOperation = operation;
+		[operation addExecutionBlock:^{
+			if (!weakOperation.isCancelled) {
+				deliver([completionIndex completionsForPrefix:editString maximumCount:maximumCount]);
+			}
+		}];
+		[weakSelf.autocompleteQueue addOperation:operation];
+	};
+	
+	MBTableGridCompletionIndex *completionIndex = self.completionIndexes[@(columnIndex)];
+	if (completionIndex) {
+		search(completionIndex);
+	} else if ([self _buildCompletionIndexForColumn:columnIndex]) {
+		// Nothing is offered until the index is ready, and then only the latest string is looked up
+		self.pendingCompletionSearch = search;
+		self.pendingCompletionColumn = columnIndex;
+	} else {
+		deliver(nil);
+	}
+}
+
+- (void)_cancelAutocomplete {
+	self.autocompleteGeneration++;
+	self.pendingCompletionSearch = nil;
+	[self.autocompleteQueue cancelAllOperations];
+}
+
+- (BOOL)_buildCompletionIndexForColumn:(NSUInteger)columnIndex {
+	if (self.completionIndexBuilders[@(columnIndex)]) {
+		return YES;
+	}
+	
+	if (![[self dataSource] respondsToSelector:@selector(tableGrid:shouldIndexAutocompleteValuesForColumn:)] || ![[self dataSource] tableGrid:self shouldIndexAutocompleteValuesForColumn:columnIndex]) {
+		return NO;
+	}
+	
+	MBTableGridCompletionIndexBuilder *builder = [[MBTableGridCompletionIndexBuilder alloc] init];
+	builder.formatter = [self _formatterForColumn:columnIndex];
+	
+	__weak MBTableGrid *weakSelf = self;
+	id<MBTableGridDataSource> dataSource = self.dataSource;
+	builder.valueProvider = ^id(NSUInteger rowIndex) {
+		return [dataSource tableGrid:weakSelf objectValueForColumn:columnIndex row:rowIndex];
+	};
+	builder.readsValuesConcurrently = [dataSource respondsToSelector:@selector(tableGridSupportsConcurrentValueAccess:)] && [dataSource tableGridSupportsConcurrentValueAccess:self];
+	
+	self.completionIndexBuilders[@(columnIndex)] = builder;
+	
+	// Read the column once, in the background or in short batches, then sort its distinct values in one go
+	[builder buildIndexWithRows:[self _valueModelRowIndexes] completionHandler:^(MBTableGridCompletionIndex *completionIndex) {
+		MBTableGrid *strongSelf = weakSelf;
+		if (!strongSelf) {
+			return;
+		}
+		
+		[strongSelf.completionIndexBuilders removeObjectForKey:@(columnIndex)];
+		strongSelf.completionIndexes[@(columnIndex)] = completionIndex;
+		
+		if (strongSelf.pendingCompletionSearch && strongSelf.pendingCompletionColumn == columnIndex) {
+			void (^search)(MBTableGridCompletionIndex *) = strongSelf.pendingCompletionSearch;
+			strongSelf.pendingCompletionSearch = nil;
+			search(completionIndex);
+		}
+	}];
+	
+	return YES;
+}
+
+- (void)_invalidateCompletionIndexes {
+	for (MBTableGridCompletionIndexBuilder *builder in self.completionIndexBuilders.allValues) {
+		[builder cancel];
+	}
+	[self.completionIndexBuilders removeAllObjects];
+	[self.completionIndexes removeAllObjects];
+}
+
+- (void)_updateCompletionIndexForColumn:(NSUInteger)columnIndex previousValues:(MBTableGridColumnEdit *)previousValues {
+	// An index still being built may already have read the old values, so build it again
+	MBTableGridCompletionIndexBuilder *builder = self.completionIndexBuilders[@(columnIndex)];
+	if (builder) {
+		[builder cancel];
+		[self.completionIndexBuilders removeObjectForKey:@(columnIndex)];
+		[self _buildCompletionIndexForColumn:columnIndex];
+		return;
+	}
+	
+	// Only columns that have been searched have an index to keep up to date
+	MBTableGridCompletionIndex *completionIndex = self.completionIndexes[@(columnIndex)];
+	if (!completionIndex) {
+		return;
+	}
+	
+	// Read the new values back, since the data source may not store exactly what it was given
+	NSFormatter *formatter = [self _formatterForColumn:columnIndex];
+	[previousValues enumerateValuesUsingBlock:^(id value, NSUInteger modelRowIndex, BOOL *stop) {
+		NSUInteger rowIndex = [self rowForModelRow:modelRowIndex];
+		if (rowIndex != NSNotFound && [self _isGroupRow:rowIndex]) {
+			return;
+		}
+		[completionIndex removeString:[MBTableGridTabularText stringForValue:value formatter:formatter]];
+		[completionIndex addString:[MBTableGridTabularText stringForValue:[self _objectValueForColumn:columnIndex modelRow:modelRowIndex] formatter:formatter]];
+	}];
+}
+
+- (MBTableGridColumnAggregates *)_aggregatesForColumn:(NSUInteger)columnIndex {
+	if (columnIndex >= _numberOfColumns) {
+		return nil;
+	}
+	
+	MBTableGridColumnAggregates *aggregates = self.columnAggregates[@(columnIndex)];
+	if (aggregates) {
+		return aggregates;
+	}
+	
+	NSIndexSet *modelGroupRows = [self _modelGroupRowIndexes];
+	
+	NSUInteger numberOfModelRows = self.numberOfModelRows;
+	NSMutableData *values = [NSMutableData dataWithLength:MAX(numberOfModelRows, 1) * sizeof(double)];
+	double *numericValues = values.mutableBytes;
+	
+	BOOL hasNumericValues = [[self dataSource] respondsToSelector:@selector(tableGrid:getSortValues:forColumn:)] && [[self dataSource] tableGrid:self getSortValues:numericValues forColumn:columnIndex];
+	for (NSUInteger row = 0; row < numberOfModelRows; row++) {
+		if ([modelGroupRows containsIndex:row]) {
+			numericValues[row] = NAN;
+		} else if (!hasNumericValues) {
+			numericValues[row] = [MBTableGridColumnAggregates numericValueForObject:[self _objectValueForColumn:columnIndex modelRow:row]];
+		}
+	}
+	values.length = numberOfModelRows * sizeof(double);
+	
+	aggregates = [[MBTableGridColumnAggregates alloc] initWithValues:values];
+	self.columnAggregates[@(columnIndex)] = aggregates;
+	[self.displayAggregates removeObjectForKey:@(columnIndex)];
+	[self.groupAggregates removeObjectForKey:@(columnIndex)];
+	return aggregates;
+}
+
+- (MBTableGridColumnAggregates *)_displayAggregatesForColumn:(NSUInteger)columnIndex {
+	MBTableGridColumnAggregates *aggregates = [self _aggregatesForColumn:columnIndex];
+	if (!aggregates || [self _rowsAreModelRows]) {
+		return aggregates;
+	}
+	
+	MBTableGridColumnAggregates *displayAggregates = self.displayAggregates[@(columnIndex)];
+	if (displayAggregates) {
+		return displayAggregates;
+	}
+	
+	// The same values in displayed order, built once per row mapping. Rows added by the grid, and
+	// group rows from the data source, are NaN like they are in the column's own aggregates.
+	displayAggregates = [[MBTableGridColumnAggregates alloc] initWithValues:aggregates.values rows:[self _modelRowsOfRows]];
+	self.displayAggregates[@(columnIndex)] = displayAggregates;
+	return displayAggregates;
+}
+
+- (NSData *)_modelRowsOfRows {
+	NSMutableData *rows = [NSMutableData dataWithLength:MAX(_numberOfRows, 1) * sizeof(NSUInteger)];
+	NSUInteger *modelRows = rows.mutableBytes;
+	for (NSUInteger row = 0; row < _numberOfRows; row++) {
+		modelRows[row] = [self _modelRowForRow:row];
+	}
+	rows.length = _numberOfRows * sizeof(NSUInteger);
+	return rows;
+}
+
+- (MBTableGridColumnAggregates *)_builtDisplayAggregatesForColumn:(NSUInteger)columnIndex {
+	return [self _rowsAreModelRows] ? self.columnAggregates[@(columnIndex)] : self.displayAggregates[@(columnIndex)];
+}
+
+- (void)_buildDisplayAggregatesForColumn:(NSUInteger)columnIndex {
+	if ([self.buildingDisplayAggregateColumns containsIndex:columnIndex]) {
+		return;
+	}
+	[self.buildingDisplayAggregateColumns addIndex:columnIndex];
+	
+	// The column is read once the selection has been drawn, since the data source is only asked on
+	// the main thread. Putting its values in displayed order is left to a background queue.
+	__weak MBTableGrid *weakSelf = self;
+	dispatch_async(dispatch_get_main_queue(), ^{
+		MBTableGrid *strongSelf = weakSelf;
+		MBTableGridColumnAggregates *aggregates = [strongSelf _aggregatesForColumn:columnIndex];
+		if (!aggregates || [strongSelf _rowsAreModelRows]) {
+			[strongSelf.buildingDisplayAggregateColumns removeIndex:columnIndex];
+			return;
+		}
+		
+		// Changing the row mapping replaces the dictionary, and edits change the column's aggregates
+		NSMutableDictionary *displayAggregates = strongSelf.displayAggregates;
+		NSUInteger numberOfChanges = aggregates.numberOfChanges;
+		[MBTableGridColumnAggregates buildAggregatesWithValues:aggregates.values rows:[strongSelf _modelRowsOfRows] completionHandler:^(MBTableGridColumnAggregates *builtAggregates) {
+			MBTableGrid *builtSelf = weakSelf;
+			[builtSelf.buildingDisplayAggregateColumns removeIndex:columnIndex];
+			if (builtSelf.displayAggregates == displayAggregates && !displayAggregates[@(columnIndex)] && builtSelf.columnAggregates[@(columnIndex)] == aggregates && aggregates.numberOfChanges == numberOfChanges) {
+				displayAggregates[@(columnIndex)] = builtAggregates;
+			}
+		}];
+	});
+}
+
+- (MBTableGridAggregate)_aggregateForColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes {
+	// Only the given cells are read, from the column's aggregates if it has them
+	MBTableGridColumnAggregates *aggregates = self.columnAggregates[@(columnIndex)];
+	__block MBTableGridAggregate aggregate = MBTableGridAggregateEmpty();
+	[rowIndexes enumerateIndexesUsingBlock:^(NSUInteger rowIndex, BOOL *stop) {
+		if (rowIndex >= _numberOfRows || [self _isGroupRow:rowIndex]) {
+			return;
+		}
+		NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+		double value = aggregates ? [aggregates valueForRow:modelRowIndex] : [MBTableGridColumnAggregates numericValueForObject:[self _objectValueForColumn:columnIndex modelRow:modelRowIndex]];
+		aggregate = MBTableGridAggregateAdd(aggregate, value);
+	}];
+	return aggregate;
+}
+
+- (void)_updateAggregatesForColumn:(NSUInteger)columnIndex modelRows:(NSIndexSet *)modelRowIndexes {
+	// Only columns that have been asked about have aggregates to keep up to date
+	MBTableGridColumnAggregates *aggregates = self.columnAggregates[@(columnIndex)];
+	if (!aggregates) {
+		return;
+	}
+	
+	// Read the new values back, since the data source may not store exactly what it was given
+	MBTableGridColumnSketches *sketches = aggregates.sketches;
+	MBTableGridColumnAggregates *displayAggregates = self.displayAggregates[@(columnIndex)];
+	NSMutableData *groupAggregates = self.groupAggregates[@(columnIndex)];
+	NSMutableIndexSet *changedGroups = [NSMutableIndexSet indexSet];
+	[modelRowIndexes enumerateIndexesUsingBlock:^(NSUInteger modelRowIndex, BOOL *stop) {
+		NSUInteger rowIndex = [self rowForModelRow:modelRowIndex];
+		if (rowIndex != NSNotFound && [self _isGroupRow:rowIndex]) {
+			return;
+		}
+		id value = [self _objectValueForColumn:columnIndex modelRow:modelRowIndex];
+		double numericValue = [MBTableGridColumnAggregates numericValueForObject:value];
+		[aggregates setValue:numericValue forRow:modelRowIndex];
+		if (rowIndex < displayAggregates.numberOfRows) {
+			[displayAggregates setValue:numericValue forRow:rowIndex];
+		}
+		[sketches replaceValueWithValue:numericValue hash:isnan(numericValue) ? 0 : [MBTableGridColumnSketches hashForObject:value]];
+		if (groupAggregates) {
+			NSUInteger groupIndex = [self _groupForModelRow:modelRowIndex];
+			if (groupIndex != NSNotFound) {
+				[changedGroups addIndex:groupIndex];
+			}
+		}
+	}];
+	
+	// Only the groups of the edited rows are worked out again
+	MBTableGridAggregate *aggregatesByGroup = groupAggregates.mutableBytes;
+	NSUInteger numberOfGroups = groupAggregates.length / sizeof(MBTableGridAggregate);
+	[changedGroups enumerateIndexesUsingBlock:^(NSUInteger groupIndex, BOOL *stop) {
+		if (groupIndex < numberOfGroups) {
+			aggregatesByGroup[groupIndex] = [self _aggregateOfGroup:groupIndex aggregates:aggregates];
+		}
+	}];
+	
+	[self _setNeedsDisplayInAggregatesOfColumns:[NSIndexSet indexSetWithIndex:columnIndex]];
+}
+
+- (MBTableGridColumnSketches *)_sketchesForColumn:(NSUInteger)columnIndex {
+	MBTableGridColumnAggregates *aggregates = [self _aggregatesForColumn:columnIndex];
+	// Stale sketches are still a fair estimate while new ones are built
+	if (!aggregates || (aggregates.sketches && !aggregates.sketches.stale) || aggregates.buildingSketches) {
+		return aggregates.sketches;
+	}
+	
+	// Quantiles come from the aggregate values, which are NaN for empty cells and group rows.
+	// Those are left out of the distinct count too, which hashes the sort values if the data
+	// source has them, and the cells otherwise.
+	NSData *values = aggregates.values;
+	const double *numericValues = values.bytes;
+	NSUInteger numberOfModelRows = aggregates.numberOfRows;
+	NSMutableData *hashes = [NSMutableData dataWithLength:numberOfModelRows * sizeof(uint64_t)];
+	uint64_t *hashValues = hashes.mutableBytes;
+	
+	NSMutableData *sortValues = [NSMutableData dataWithLength:MAX(self.numberOfModelRows, 1) * sizeof(double)];
+	double *sortNumericValues = sortValues.mutableBytes;
+	BOOL hasSortValues = self.numberOfModelRows == numberOfModelRows && [[self dataSource] respondsToSelector:@selector(tableGrid:getSortValues:forColumn:)] && [[self dataSource] tableGrid:self getSortValues:sortNumericValues forColumn:columnIndex];
+	
+	for (NSUInteger row = 0; row < numberOfModelRows; row++) {
+		if (isnan(numericValues[row])) {
+			hashValues[row] = 0;
+		} else if (hasSortValues) {
+			hashValues[row] = isnan(sortNumericValues[row]) ? 0 : MBTableGridHashDouble(sortNumericValues[row]);
+		} else {
+			hashValues[row] = [MBTableGridColumnSketches hashForObject:[self _objectValueForColumn:columnIndex modelRow:row]];
+		}
+	}
+	
+	aggregates.buildingSketches = YES;
+	NSUInteger numberOfChanges = aggregates.numberOfChanges;
+	__weak MBTableGrid *weakSelf = self;
+	[MBTableGridColumnSketches buildSketchesWithValues:values hashes:hashes completionHandler:^(MBTableGridColumnSketches *sketches) {
+		aggregates.buildingSketches = NO;
+		
+		// Changes made while building were missed, so the next request builds them again
+		BOOL didChange = aggregates.numberOfChanges != numberOfChanges;
+		if (!didChange) {
+			aggregates.sketches = sketches;
+		}
+		if ((sketches || didChange) && weakSelf.columnAggregates[@(columnIndex)] == aggregates) {
+			[weakSelf _setNeedsDisplayInAggregatesOfColumns:[NSIndexSet indexSetWithIndex:columnIndex]];
+		}
+	}];
+	
+	return aggregates.sketches;
+}
+
+- (NSIndexSet *)_modelGroupRowIndexes {
+	// Group rows aren't part of any group. The ones the grid adds aren't data source rows at all.
+	NSMutableIndexSet *modelGroupRows = [NSMutableIndexSet indexSet];
+	MBTableGridGroupRows *groupRows = [self _expandedGroupRows];
+	for (size_t index = 0; index < MBTableGridGroupRowsCount(groupRows); index++) {
+		NSUInteger modelRowIndex = [self _modelRowForExpandedRow:MBTableGridGroupRowsRowAtIndex(groupRows, index)];
+		if (modelRowIndex != NSNotFound) {
+			[modelGroupRows addIndex:modelRowIndex];
+		}
+	}
+	return modelGroupRows;
+}
+
+- (void)_buildStatisticsForColumn:(NSUInteger)columnIndex {
+	NSMutableArray *handlers = self.statisticsHandlers[@(columnIndex)];
+	if (columnIndex >= _numberOfColumns) {
+		[self.statisticsHandlers removeObjectForKey:@(columnIndex)];
+		for (void (^handler)(MBTableGridColumnStatistics *) in handlers) {
+			handler(nil);
+		}
+		return;
+	}
+	
+	// Data source calls stay on the main thread, and the values are only counted in the background
+	NSIndexSet *modelGroupRows = [self _modelGroupRowIndexes];
+	NSUInteger numberOfModelRows = self.numberOfModelRows;
+	NSMutableArray *values = [NSMutableArray arrayWithCapacity:numberOfModelRows - MIN(modelGroupRows.count, numberOfModelRows)];
+	for (NSUInteger row = 0; row < numberOfModelRows; row++) {
+		if (![modelGroupRows containsIndex:row]) {
+			[values addObject:[self _objectValueForColumn:columnIndex modelRow:row] ?: [NSNull null]];
+		}
+	}
+	
+	NSFont *font = self.defaultCellFont ?: [self _cellForColumn:columnIndex].font;
+	__weak MBTableGrid *weakSelf = self;
+	[MBTableGridColumnStatistics buildStatisticsWithValues:values formatter:[self _formatterForColumn:columnIndex] font:font maximumDistinctValues:MBTableGridMaximumDistinctValues completionHandler:^(MBTableGridColumnStatistics *statistics) {
+		MBTableGrid *strongSelf = weakSelf;
+		if (!strongSelf) {
+			return;
+		}
+		
+		// Changes made while counting were missed, so count again for the same requests
+		if ([strongSelf.staleStatisticsColumns containsIndex:columnIndex]) {
+			[strongSelf.staleStatisticsColumns removeIndex:columnIndex];
+			[strongSelf _buildStatisticsForColumn:columnIndex];
+			return;
+		}
+		
+		[strongSelf.statisticsHandlers removeObjectForKey:@(columnIndex)];
+		if (statistics) {
+			strongSelf.columnStatistics[@(columnIndex)] = statistics;
+		}
+		for (void (^handler)(MBTableGridColumnStatistics *) in handlers) {
+			handler(statistics);
+		}
+	}];
+}
+
+- (void)_invalidateStatisticsForColumn:(NSUInteger)columnIndex {
+	[self.columnStatistics removeObjectForKey:@(columnIndex)];
+	if (self.statisticsHandlers[@(columnIndex)]) {
+		[self.staleStatisticsColumns addIndex:columnIndex];
+	}
+}
+
+- (void)_invalidateAllStatistics {
+	[self.columnStatistics removeAllObjects];
+	for (NSNumber *column in self.statisticsHandlers) {
+		[self.staleStatisticsColumns addIndex:column.unsignedIntegerValue];
+	}
+}
+
+- (NSUInteger)_groupForExpandedRow:(NSUInteger)expandedRow {
+	// Each group has a heading, and a summary if they're shown
+	size_t index = MBTableGridGroupRowsCountBefore(self.columnGroupRows, expandedRow + 1) - 1;
+	return self.includeGroupSummaryRows ? index / 2 : index;
+}
+
+- (NSRange)_positionsOfGroup:(NSUInteger)groupIndex {
+	const NSUInteger *startPositions = self.groupStartPositions.bytes;
+	return NSMakeRange(startPositions[groupIndex], startPositions[groupIndex + 1] - startPositions[groupIndex]);
+}
+
+- (NSData *)_groupAggregatesForColumn:(NSUInteger)columnIndex {
+	NSData *groupAggregates = self.groupAggregates[@(columnIndex)];
+	if (groupAggregates) {
+		return groupAggregates;
+	}
+	
+	MBTableGridColumnAggregates *aggregates = [self _aggregatesForColumn:columnIndex];
+	if (!aggregates) {
+		return nil;
+	}
+	
+	// The rows of a group are spread out in the data source, so every group is worked out in one pass
+	// over the column. Edits only work out their own groups again.
+	NSUInteger numberOfGroups = self.groupStartPositions.length / sizeof(NSUInteger) - 1;
+	NSMutableData *data = [NSMutableData dataWithLength:MAX(numberOfGroups, 1) * sizeof(MBTableGridAggregate)];
+	MBTableGridAggregate *aggregatesByGroup = data.mutableBytes;
+	for (NSUInteger groupIndex = 0; groupIndex < numberOfGroups; groupIndex++) {
+		aggregatesByGroup[groupIndex] = [self _aggregateOfGroup:groupIndex aggregates:aggregates];
+	}
+	
+	self.groupAggregates[@(columnIndex)] = data;
+	return data;
+}
+
+- (MBTableGridAggregate)_aggregateOfGroup:(NSUInteger)groupIndex aggregates:(MBTableGridColumnAggregates *)aggregates {
+	NSRange positions = [self _positionsOfGroup:groupIndex];
+	MBTableGridAggregate aggregate = MBTableGridAggregateEmpty();
+	for (NSUInteger position = positions.location; position < NSMaxRange(positions); position++) {
+		aggregate = MBTableGridAggregateAdd(aggregate, [aggregates valueForRow:[self _modelRowForPosition:position]]);
+	}
+	return aggregate;
+}
+
+- (NSUInteger)_groupForModelRow:(NSUInteger)modelRowIndex {
+	if (!self.groupStartPositions || modelRowIndex >= self.numberOfModelRows) {
+		return NSNotFound;
+	}
+	
+	// Positions only count the rows that are shown
+	NSUInteger position = [self _positionForModelRow:modelRowIndex];
+	if (self.visibleRows) {
+		if (!MBTableGridRowBitmapIsSet(self.visibleRows, position)) {
+			return NSNotFound;
+		}
+		position = MBTableGridRowBitmapRank(self.visibleRows, position);
+	}
+	NSUInteger numberOfStartedGroups = [self _numberOfGroupsStartedAtPosition:position];
+	return numberOfStartedGroups > 0 ? numberOfStartedGroups - 1 : NSNotFound;
+}
+
+- (void)_updateAggregatesForColumns:(NSIndexSet *)columnIndexes rows:(NSRange)rowRange {
+	// Moved rows are read again as a block, and group rows may have moved with them
+	NSMutableIndexSet *updatedColumns = [NSMutableIndexSet indexSet];
+	NSMutableData *values = [NSMutableData dataWithLength:MAX(rowRange.length, 1) * sizeof(double)];
+	double *numericValues = values.mutableBytes;
+	
+	[self.columnAggregates enumerateKeysAndObjectsUsingBlock:^(NSNumber *column, MBTableGridColumnAggregates *aggregates, BOOL *stop) {
+		if (columnIndexes && ![columnIndexes containsIndex:column.unsignedIntegerValue]) {
+			return;
+		}
+		for (NSUInteger index = 0; index < rowRange.length; index++) {
+			NSUInteger modelRowIndex = rowRange.location + index;
+			BOOL isGroupRow = [self _isModelGroupHeadingRow:modelRowIndex] || (self.includeGroupSummaryRows && self.groupingColumn >= _numberOfColumns && (modelRowIndex + 1 == self.numberOfModelRows || (modelRowIndex > 0 && [self _isModelGroupHeadingRow:modelRowIndex + 1])));
+			numericValues[index] = isGroupRow ? NAN : [MBTableGridColumnAggregates numericValueForObject:[self _objectValueForColumn:column.unsignedIntegerValue modelRow:modelRowIndex]];
+		}
+		[aggregates setValues:numericValues inRange:rowRange];
+		[self.displayAggregates removeObjectForKey:column];
+		[self.groupAggregates removeObjectForKey:column];
+		[updatedColumns addIndex:column.unsignedIntegerValue];
+	}];
+	
+	[self _setNeedsDisplayInAggregatesOfColumns:updatedColumns];
+}
+
+- (void)_setNeedsDisplayInAggregatesOfColumns:(NSIndexSet *)columnIndexes {
+	if (columnIndexes.count == 0) {
+		return;
+	}
+	
+	// The selected cells may have changed too
+	self.cachedSelectionStatistics = nil;
+	
+	// Summary rows and the footer may show the aggregates
+	NSMutableIndexSet *summaryRows = [NSMutableIndexSet indexSet];
+	MBTableGridGroupRows *groupRows = [self _groupRows];
+	for (size_t index = 0; index < MBTableGridGroupRowsCount(groupRows); index++) {
+		if (MBTableGridGroupRowsKindAtIndex(groupRows, index) == MBTableGridGroupRowSummary) {
+			[summaryRows addIndex:MBTableGridGroupRowsRowAtIndex(groupRows, index)];
+		}
+	}
+	if (summaryRows.count > 0) {
+		[self _setNeedsDisplayInColumns:columnIndexes rows:summaryRows];
+	}
+	[columnIndexes enumerateIndexesUsingBlock:^(NSUInteger columnIndex, BOOL *stop) {
+		MBTableGridFooterView *footerView = NSLocationInRange(columnIndex, [self frozenColumnRange]) ? frozenColumnFooterView : columnFooterView;
+		[footerView setNeedsDisplayInRect:[footerView footerRectOfColumn:columnIndex]];
+	}];
+}
+
 - (id)_backgroundColorForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:backgroundColorForColumn:row:)]) {
-		return [[self dataSource] tableGrid:self backgroundColorForColumn:columnIndex row:rowIndex];
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound && [[self dataSource] respondsToSelector:@selector(tableGrid:backgroundColorForColumn:row:)]) {
+		return [[self dataSource] tableGrid:self backgroundColorForColumn:columnIndex row:modelRowIndex];
 	}
 	return nil;
 }
 
 - (id)_frozenBackgroundColorForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:frozenBackgroundColorForColumn:row:)]) {
-		return [[self dataSource] tableGrid:self frozenBackgroundColorForColumn:columnIndex row:rowIndex];
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound && [[self dataSource] respondsToSelector:@selector(tableGrid:frozenBackgroundColorForColumn:row:)]) {
+		return [[self dataSource] tableGrid:self frozenBackgroundColorForColumn:columnIndex row:modelRowIndex];
 	}
 	return nil;
 }
 
 - (id)_groupSummaryBackgroundColorForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:groupSummaryBackgroundColorForColumn:row:)]) {
-		return [[self dataSource] tableGrid:self groupSummaryBackgroundColorForColumn:columnIndex row:rowIndex];
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound && [[self dataSource] respondsToSelector:@selector(tableGrid:groupSummaryBackgroundColorForColumn:row:)]) {
+		return [[self dataSource] tableGrid:self groupSummaryBackgroundColorForColumn:columnIndex row:modelRowIndex];
 	}
 	return nil;
 }
 
 - (id)_textColorForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:textColorForColumn:row:)]) {
-		return [[self dataSource] tableGrid:self textColorForColumn:columnIndex row:rowIndex];
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound && [[self dataSource] respondsToSelector:@selector(tableGrid:textColorForColumn:row:)]) {
+		return [[self dataSource] tableGrid:self textColorForColumn:columnIndex row:modelRowIndex];
 	}
 	return nil;
 }
 
 - (void)_setObjectValue:(id)value forColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex undoTitle:(NSString *)undoTitle {
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:setObjectValue:forColumn:row:)]) {
-		
-		NSUndoManager *undoManager = [self _undoManager];
-		id oldValue = [self _objectValueForColumn:columnIndex row:rowIndex];
-		
-		[[undoManager prepareWithInvocationTarget:self] _setObjectValue:oldValue forColumn:columnIndex row:rowIndex undoTitle:undoTitle];
-		undoManager.actionName = undoTitle;
-		
-		[[self dataSource] tableGrid:self setObjectValue:value forColumn:columnIndex row:rowIndex];
+	// Single cell changes, such as typing, can be coalesced with the previous one
+	MBTableGridColumnEdit *edit = [MBTableGridColumnEdit editWithColumn:columnIndex rows:[NSIndexSet indexSetWithIndex:rowIndex] value:value];
+	[self _applyColumnEdit:edit undoTitle:undoTitle coalesce:YES];
+}
+
+- (void)_applyColumnEdit:(MBTableGridColumnEdit *)edit undoTitle:(NSString *)undoTitle {
+	[self _applyColumnEdit:edit undoTitle:undoTitle coalesce:NO];
+}
+
+- (void)_applyColumnEdit:(MBTableGridColumnEdit *)edit undoTitle:(NSString *)undoTitle coalesce:(BOOL)coalesce {
+	if ([self _rowsAreModelRows] || edit.count == 0) {
+		[self _applyModelColumnEdit:edit undoTitle:undoTitle coalesce:coalesce];
+		return;
+	}
+	
+	// Edits are made to displayed rows, but the data source and the undo journal work in data source rows,
+	// which don't change when the grid is sorted again
+	NSUInteger count = edit.count;
+	NSUInteger *modelRows = malloc(count * sizeof(NSUInteger));
+	NSUInteger *indexes = malloc(count * sizeof(NSUInteger));
+	__block NSUInteger index = 0;
+	[edit.rowIndexes enumerateIndexesUsingBlock:^(NSUInteger rowIndex, BOOL *stop) {
+		modelRows[index] = [self _modelRowForRow:rowIndex];
+		indexes[index] = index;
+		index++;
+	}];
+	
+	// The edit has to be built in ascending row order
+	qsort_b(indexes, count, sizeof(NSUInteger), ^int(const void *a, const void *b) {
+		NSUInteger row = modelRows[*(const NSUInteger *)a];
+		NSUInteger otherRow = modelRows[*(const NSUInteger *)b];
+		return row < otherRow ? -1 : row > otherRow;
+	});
+	
+	MBTableGridColumnEdit *modelEdit = [[MBTableGridColumnEdit alloc] initWithColumn:edit.column];
+	for (index = 0; index < count; index++) {
+		[modelEdit addValue:[edit valueAtIndex:indexes[index]] forRow:modelRows[indexes[index]]];
+	}
+	
+	free(indexes);
+	free(modelRows);
+	
+	[self _applyModelColumnEdit:modelEdit undoTitle:undoTitle coalesce:coalesce];
+}
+
+- (void)_applyModelColumnEdit:(MBTableGridColumnEdit *)edit undoTitle:(NSString *)undoTitle coalesce:(BOOL)coalesce {
+	if (![[self dataSource] respondsToSelector:@selector(tableGrid:setObjectValue:forColumn:row:)] || edit.count == 0) {
+		return;
+	}
+	
+	NSUInteger column = edit.column;
+	
+	// Keep the previous values of all the rows as a single undo entry, rather than one per row
+	MBTableGridColumnEdit *previousValues = [[MBTableGridColumnEdit alloc] initWithColumn:column];
+	[edit.rowIndexes enumerateIndexesUsingBlock:^(NSUInteger rowIndex, BOOL *stop) {
+		[previousValues addValue:[self _objectValueForColumn:column modelRow:rowIndex] forRow:rowIndex];
+	}];
+	
+	[self.undoJournal registerPreviousValues:previousValues actionName:undoTitle undoManager:[self _undoManager] coalesce:coalesce];
+	
+	BOOL canSetRows = [[self dataSource] respondsToSelector:@selector(tableGrid:setObjectValue:forColumn:rows:)];
+	
+	if (canSetRows && edit.numberOfDistinctValues < edit.count) {
+		[edit enumerateRowsByValueUsingBlock:^(id value, NSIndexSet *rowIndexes, BOOL *stop) {
+			if (rowIndexes.count > 1) {
+				[[self dataSource] tableGrid:self setObjectValue:value forColumn:column rows:rowIndexes];
+			} else {
+				[[self dataSource] tableGrid:self setObjectValue:value forColumn:column row:rowIndexes.firstIndex];
+			}
+		}];
+	} else {
+		[edit enumerateValuesUsingBlock:^(id value, NSUInteger rowIndex, BOOL *stop) {
+			[[self dataSource] tableGrid:self setObjectValue:value forColumn:column row:rowIndex];
+		}];
+	}
+	
+	[self _updateCompletionIndexForColumn:column previousValues:previousValues];
+	[self _updateAggregatesForColumn:column modelRows:edit.rowIndexes];
+	[self _updateFindMatchesInColumn:column modelRows:edit.rowIndexes];
+	[self _invalidateStatisticsForColumn:column];
+	
+	// Rows are grouped by their values, so changed rows may belong to other groups now
+	if (column == self.groupingColumn) {
+		[self _reloadRows];
 	}
 }
 
@@ -2441,28 +4375,169 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 }
 
 - (BOOL)_canEditCellAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
-	// Can't edit if the data source doesn't implement the method
-	if (![[self dataSource] respondsToSelector:@selector(tableGrid:setObjectValue:forColumn:row:)]) {
+	// Can't edit if the data source doesn't implement the method, or there's no data source row
+	if (![[self dataSource] respondsToSelector:@selector(tableGrid:setObjectValue:forColumn:row:)] || [self _modelRowForRow:rowIndex] == NSNotFound) {
 		return NO;
 	}
 	
 	// Ask the delegate if the cell is editable
 	if ([[self delegate] respondsToSelector:@selector(tableGrid:shouldEditColumn:row:)]) {
-		return [[self delegate] tableGrid:self shouldEditColumn:columnIndex row:rowIndex];
+		return [[self delegate] tableGrid:self shouldEditColumn:columnIndex row:[self _modelRowForRow:rowIndex]];
 	}
 	
 	return YES;
 }
 
-- (BOOL)_canFillCellAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
+- (void)_copyCellsAtColumns:(NSIndexSet *)columnIndexes rows:(NSIndexSet *)rowIndexes toPasteboard:(NSPasteboard *)pasteboard {
+	NSMutableArray *formatters = [NSMutableArray arrayWithCapacity:columnIndexes.count];
+	[columnIndexes enumerateIndexesUsingBlock:^(NSUInteger columnIndex, BOOL *stop) {
+		[formatters addObject:[self _formatterForColumn:columnIndex] ?: [NSNull null]];
+	}];
+	
+	// The data source is only asked for values here, on the main thread; formatting happens concurrently
+	NSMutableArray *values = [NSMutableArray arrayWithCapacity:columnIndexes.count * rowIndexes.count];
+	[rowIndexes enumerateIndexesUsingBlock:^(NSUInteger rowIndex, BOOL *stopRows) {
+		[columnIndexes enumerateIndexesUsingBlock:^(NSUInteger columnIndex, BOOL *stopColumns) {
+			[values addObject:[self _objectValueForColumn:columnIndex row:rowIndex] ?: [NSNull null]];
+		}];
+	}];
+	
+	NSData *tsvData = [MBTableGridTabularText UTF8DataWithValues:values numberOfColumns:columnIndexes.count formatters:formatters format:MBTableGridTextFormatTSV];
+	NSData *csvData = [MBTableGridTabularText UTF8DataWithValues:values numberOfColumns:columnIndexes.count formatters:formatters format:MBTableGridTextFormatCSV];
+	
+	[pasteboard clearContents];
+	[pasteboard declareTypes:@[NSPasteboardTypeTabularText, MBTableGridCSVPasteboardType, NSPasteboardTypeString] owner:nil];
+	[pasteboard setData:tsvData forType:NSPasteboardTypeTabularText];
+	[pasteboard setData:csvData forType:MBTableGridCSVPasteboardType];
+	[pasteboard setData:tsvData forType:NSPasteboardTypeString];
+}
+
+- (void)_pasteCellsAtColumns:(NSIndexSet *)columnIndexes rows:(NSIndexSet *)rowIndexes fromPasteboard:(NSPasteboard *)pasteboard {
+	MBTableGridTextFormat format = MBTableGridTextFormatTSV;
+	NSData *data = [pasteboard dataForType:NSPasteboardTypeTabularText];
+	
+	if (!data.length) {
+		data = [pasteboard dataForType:MBTableGridCSVPasteboardType];
+		format = MBTableGridTextFormatCSV;
+	}
+	
+	if (!data.length) {
+		data = [pasteboard dataForType:NSPasteboardTypeString];
+		format = MBTableGridTextFormatTSV;
+	}
+	
+	NSArray<NSArray<NSString *> *> *pastedRows = [MBTableGridTabularText rowsWithUTF8Data:data format:format];
+	
+	if (pastedRows.count == 0) {
+		return;
+	}
+	
+	NSUInteger firstColumn = columnIndexes.firstIndex;
+	NSUInteger firstRow = rowIndexes.firstIndex;
+	NSUInteger numberOfPastedColumns = 0;
+	for (NSArray *fields in pastedRows) {
+		numberOfPastedColumns = MAX(numberOfPastedColumns, fields.count);
+	}
+	NSUInteger numberOfPastedRows = pastedRows.count;
+	
+	// A single selected cell takes all of the pasted text, otherwise it's limited to the selection
+	if (columnIndexes.count > 1 || rowIndexes.count > 1) {
+		numberOfPastedColumns = MIN(numberOfPastedColumns, columnIndexes.lastIndex - firstColumn + 1);
+		numberOfPastedRows = MIN(numberOfPastedRows, rowIndexes.lastIndex - firstRow + 1);
+	}
+	numberOfPastedColumns = MIN(numberOfPastedColumns, _numberOfColumns - firstColumn);
+	numberOfPastedRows = MIN(numberOfPastedRows, _numberOfRows - firstRow);
+	
+	NSIndexSet *pastedColumnIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(firstColumn, numberOfPastedColumns)];
+	NSIndexSet *pastedRowIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(firstRow, numberOfPastedRows)];
+	MBTableGridGroupRows *groupRows = [self _groupRows];
+	
+	NSUndoManager *undoManager = [self _undoManager];
+	[undoManager beginUndoGrouping];
+	
+	[pastedColumnIndexes enumerateIndexesUsingBlock:^(NSUInteger column, BOOL *stop) {
+		NSUInteger columnOffset = column - firstColumn;
+		NSIndexSet *editableRows = [self _editableRowsInColumn:column rows:pastedRowIndexes];
+		NSFormatter *formatter = [self _formatterForColumn:column];
+		MBTableGridColumnEdit *paste = [[MBTableGridColumnEdit alloc] initWithColumn:column];
+		
+		[editableRows enumerateIndexesUsingBlock:^(NSUInteger row, BOOL *stopRows) {
+			NSArray<NSString *> *fields = pastedRows[row - firstRow];
+			if (columnOffset >= fields.count || MBTableGridGroupRowsKind(groupRows, row) != 0) {
+				return;
+			}
+			
+			NSString *string = fields[columnOffset];
+			id value = string;
+			
+			// Leave cells alone when their text isn't valid for the column
+			if (!formatter || [formatter getObjectValue:&value forString:string errorDescription:nil]) {
+				[paste addValue:value forRow:row];
+			}
+		}];
+		
+		[self _applyColumnEdit:paste undoTitle:NSLocalizedString(@"Paste", nil)];
+	}];
+	
+	[undoManager endUndoGrouping];
+	
+	[self _setNeedsDisplayInColumns:pastedColumnIndexes rows:pastedRowIndexes];
+}
+
+- (NSIndexSet *)_editableRowsInColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes {
 	// Can't edit if the data source doesn't implement the method
 	if (![[self dataSource] respondsToSelector:@selector(tableGrid:setObjectValue:forColumn:row:)]) {
+		return [NSIndexSet indexSet];
+	}
+	
+	// Group rows added by the grid have no cells to edit
+	if (self.columnGroupRows) {
+		rowIndexes = [rowIndexes indexesPassingTest:^BOOL(NSUInteger rowIndex, BOOL *stop) {
+			return [self _modelRowForRow:rowIndex] != NSNotFound;
+		}];
+	}
+	
+	// Ask the delegate about the whole range at once if it can answer that way
+	if ([[self delegate] respondsToSelector:@selector(tableGrid:editableRowsInColumn:rows:)]) {
+		NSIndexSet *editableRows = [[self delegate] tableGrid:self editableRowsInColumn:columnIndex rows:[self _modelRowIndexes:rowIndexes]];
+		return editableRows ? [self _rowIndexesForModelRowIndexes:editableRows] : [NSIndexSet indexSet];
+	}
+	
+	if (![[self delegate] respondsToSelector:@selector(tableGrid:shouldEditColumn:row:)]) {
+		return rowIndexes;
+	}
+	
+	return [rowIndexes indexesPassingTest:^BOOL(NSUInteger rowIndex, BOOL *stop) {
+		return [[self delegate] tableGrid:self shouldEditColumn:columnIndex row:[self _modelRowForRow:rowIndex]];
+	}];
+}
+
+- (NSIndexSet *)_clearableRowsInColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes {
+	NSIndexSet *editableRows = [self _editableRowsInColumn:columnIndex rows:rowIndexes];
+	
+	if (editableRows.count == rowIndexes.count || ![[self dataSource] respondsToSelector:@selector(tableGrid:accessoryButtonImageForColumn:row:)]) {
+		return editableRows;
+	}
+	
+	// Cells with an accessory button can be cleared even when they can't be edited
+	NSMutableIndexSet *clearableRows = [editableRows mutableCopy];
+	[rowIndexes enumerateIndexesUsingBlock:^(NSUInteger rowIndex, BOOL *stop) {
+		if (![editableRows containsIndex:rowIndex] && [self _accessoryButtonImageForColumn:columnIndex row:rowIndex]) {
+			[clearableRows addIndex:rowIndex];
+		}
+	}];
+	return clearableRows;
+}
+
+- (BOOL)_canFillCellAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
+	// Can't edit if the data source doesn't implement the method, or there's no data source row
+	if (![[self dataSource] respondsToSelector:@selector(tableGrid:setObjectValue:forColumn:row:)] || [self _modelRowForRow:rowIndex] == NSNotFound) {
 		return NO;
 	}
 	
 	// Ask the delegate if the cell is fillable
 	if ([[self delegate] respondsToSelector:@selector(tableGrid:shouldFillColumn:row:)]) {
-		return [[self delegate] tableGrid:self shouldFillColumn:columnIndex row:rowIndex];
+		return [[self delegate] tableGrid:self shouldFillColumn:columnIndex row:[self _modelRowForRow:rowIndex]];
 	}
 	
 	return YES;
@@ -2472,19 +4547,34 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	
 	NSInteger numberOfRows = self.numberOfRows;
 	BOOL addedRows = numberOfRows > numberOfRowsWhenStartingFilling;
-	NSMutableIndexSet *addedRowIndexes = nil;
+	NSRange addedRowRange = NSMakeRange(numberOfRowsWhenStartingFilling, 0);
+	NSIndexSet *addedRowIndexes = nil;
 	
 	if (addedRows) {
-		addedRowIndexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(numberOfRowsWhenStartingFilling, numberOfRows - numberOfRowsWhenStartingFilling)];
+		addedRowRange.length = numberOfRows - numberOfRowsWhenStartingFilling;
+		addedRowIndexes = [NSIndexSet indexSetWithIndexesInRange:addedRowRange];
 	}
 	
-	[[[self _undoManager] prepareWithInvocationTarget:self] _undoFillInColumn:column filledRows:self.selectedRowIndexes addedRows:addedRowIndexes];
+	// The undo state is just two ranges, since the filled rows are always contiguous. It goes through
+	// the journal, so trimming the fill's group removes it along with the filled values.
+	NSRange filledRowRange = NSMakeRange(self.selectedRowIndexes.firstIndex, self.selectedRowIndexes.lastIndex - self.selectedRowIndexes.firstIndex + 1);
+	__weak MBTableGrid *weakSelf = self;
+	[self.undoJournal registerUndoWithUndoManager:[self _undoManager] handler:^{
+		[weakSelf _undoFillInColumn:column filledRowRange:filledRowRange addedRowRange:addedRowRange];
+	}];
 	
 	id value = [self _objectValueForColumn:column row:row];
+	MBTableGridColumnEdit *fill = nil;
 	
-	[self.selectedRowIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
-		[self _setObjectValue:[value copy] forColumn:column row:idx undoTitle:NSLocalizedString(@"Fill", nil)];
-	}];
+	if (self.fillIncrementsSeries) {
+		fill = [self _seriesFillInColumn:column fromRow:row value:value rows:self.selectedRowIndexes];
+	}
+	
+	if (!fill) {
+		fill = [MBTableGridColumnEdit editWithColumn:column rows:self.selectedRowIndexes value:value];
+	}
+	
+	[self _applyColumnEdit:fill undoTitle:NSLocalizedString(@"Fill", nil)];
 	
 	// If rows were added, tell the delegate
 	if (addedRows && [self.delegate respondsToSelector:@selector(tableGrid:didAddRows:)]) {
@@ -2492,46 +4582,138 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	}
 }
 
-- (void)_undoFillInColumn:(NSUInteger)column filledRows:(NSMutableIndexSet *)filledRowIndexes addedRows:(NSIndexSet *)addedRowIndexes {
+- (MBTableGridColumnEdit *)_seriesFillInColumn:(NSUInteger)column fromRow:(NSUInteger)row value:(id)value rows:(NSIndexSet *)rowIndexes {
+	// Booleans are numbers too, but they're copied rather than counted up
+	BOOL isDate = [value isKindOfClass:[NSDate class]];
+	if (!isDate && (![value isKindOfClass:[NSNumber class]] || CFGetTypeID((__bridge CFTypeRef)value) == CFBooleanGetTypeID())) {
+		return nil;
+	}
+	
+	double base = isDate ? [value timeIntervalSinceReferenceDate] : [value doubleValue];
+	
+	// The step is the change per row going down
+	double step = isDate ? 86400.0 : 1.0;
+	
+	// Continue the series from the cell just before the source, if it holds the same kind of value
+	NSUInteger seedRow = NSNotFound;
+	if (row == rowIndexes.firstIndex && row > 0) {
+		seedRow = row - 1;
+	} else if (row == rowIndexes.lastIndex && row + 1 < self.numberOfRows) {
+		seedRow = row + 1;
+	}
+	
+	if (seedRow != NSNotFound && ![rowIndexes containsIndex:seedRow]) {
+		id seed = [self _objectValueForColumn:column row:seedRow];
+		double direction = row > seedRow ? 1.0 : -1.0;
+		if (isDate && [seed isKindOfClass:[NSDate class]]) {
+			step = (base - [seed timeIntervalSinceReferenceDate]) * direction;
+		} else if (!isDate && [seed isKindOfClass:[NSNumber class]]) {
+			step = (base - [seed doubleValue]) * direction;
+		}
+	}
+	
+	NSUInteger count = rowIndexes.count;
+	NSUInteger *rows = malloc(count * sizeof(NSUInteger));
+	double *series = malloc(count * sizeof(double));
+	[rowIndexes getIndexes:rows maxCount:count inIndexRange:nil];
+	
+	// Work out the whole series in one tight loop, which the compiler can vectorise
+	double origin = (double)row;
+	for (NSUInteger i = 0; i < count; i++) {
+		series[i] = base + ((double)rows[i] - origin) * step;
+	}
 	
-	[[[self _undoManager] prepareWithInvocationTarget:self] _redoFillInColumn:column filledRows:filledRowIndexes addedRows:addedRowIndexes];
+	// Keep whole numbers whole, unless the source was a floating point number
+	BOOL isIntegral = NO;
+	if (!isDate) {
+		const char *type = [value objCType];
+		isIntegral = strcmp(type, @encode(double)) != 0 && strcmp(type, @encode(float)) != 0 && floor(base) == base && floor(step) == step;
+	}
 	
-	if (addedRowIndexes && [self.dataSource respondsToSelector:@selector(tableGrid:removeRows:)]) {
-		[self.dataSource tableGrid:self removeRows:addedRowIndexes];
+	MBTableGridColumnEdit *fill = [[MBTableGridColumnEdit alloc] initWithColumn:column];
+	for (NSUInteger i = 0; i < count; i++) {
+		id seriesValue = nil;
+		if (isDate) {
+			seriesValue = [NSDate dateWithTimeIntervalSinceReferenceDate:series[i]];
+		} else if (isIntegral) {
+			seriesValue = @((long long)series[i]);
+		} else {
+			seriesValue = @(series[i]);
+		}
+		[fill addValue:seriesValue forRow:rows[i]];
 	}
 	
+	free(rows);
+	free(series);
+	
+	return fill;
+}
+
+- (void)_undoFillInColumn:(NSUInteger)column filledRowRange:(NSRange)filledRowRange addedRowRange:(NSRange)addedRowRange {
+	
+	__weak MBTableGrid *weakSelf = self;
+	[self.undoJournal registerUndoWithUndoManager:[self _undoManager] handler:^{
+		[weakSelf _redoFillInColumn:column filledRowRange:filledRowRange addedRowRange:addedRowRange];
+	}];
+	
+	if (addedRowRange.length > 0 && [self.dataSource respondsToSelector:@selector(tableGrid:removeRows:)]) {
+		[self.dataSource tableGrid:self removeRows:[NSIndexSet indexSetWithIndexesInRange:addedRowRange]];
+		[self removeRowsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:addedRowRange]];
+	}
+	
+	self.undoWasHandled = YES;
 	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndex:column];
-	self.selectedRowIndexes = [NSMutableIndexSet indexSetWithIndex:filledRowIndexes.firstIndex];
+	self.selectedRowIndexes = [NSMutableIndexSet indexSetWithIndex:filledRowRange.location];
 }
 
-- (void)_redoFillInColumn:(NSUInteger)column filledRows:(NSMutableIndexSet *)filledRowIndexes addedRows:(NSIndexSet *)addedRowIndexes {
+- (void)_redoFillInColumn:(NSUInteger)column filledRowRange:(NSRange)filledRowRange addedRowRange:(NSRange)addedRowRange {
 	
-	[[[self _undoManager] prepareWithInvocationTarget:self] _undoFillInColumn:column filledRows:filledRowIndexes addedRows:addedRowIndexes];
+	__weak MBTableGrid *weakSelf = self;
+	[self.undoJournal registerUndoWithUndoManager:[self _undoManager] handler:^{
+		[weakSelf _undoFillInColumn:column filledRowRange:filledRowRange addedRowRange:addedRowRange];
+	}];
 	
-	if (addedRowIndexes && [self.dataSource respondsToSelector:@selector(tableGrid:addRows:)]) {
-		[self.dataSource tableGrid:self addRows:addedRowIndexes.count];
+	if (addedRowRange.length > 0 && [self.dataSource respondsToSelector:@selector(tableGrid:addRows:)]) {
+		[self.dataSource tableGrid:self addRows:addedRowRange.length];
+		[self insertRowsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:addedRowRange]];
 	}
 	
+	self.undoWasHandled = YES;
 	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndex:column];
-	self.selectedRowIndexes = filledRowIndexes;
+	self.selectedRowIndexes = [NSMutableIndexSet indexSetWithIndexesInRange:filledRowRange];
+}
+
+#pragma mark MBTableGridUndoJournalTarget
+
+- (void)undoJournal:(MBTableGridUndoJournal *)journal applyEdit:(MBTableGridColumnEdit *)edit actionName:(NSString *)actionName {
+	[self _applyModelColumnEdit:edit undoTitle:actionName coalesce:NO];
+	[self _setNeedsDisplayInColumns:[NSIndexSet indexSetWithIndex:edit.column] rows:[self _rowIndexesForModelRowIndexes:edit.rowIndexes]];
+	self.undoWasHandled = YES;
 }
 
 - (void)_userDidEnterInvalidStringInColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex errorDescription:(NSString *)errorDescription {
 	if ([[self delegate] respondsToSelector:@selector(tableGrid:userDidEnterInvalidStringInColumn:row:errorDescription:)]) {
-		[[self delegate] tableGrid:self userDidEnterInvalidStringInColumn:columnIndex row:rowIndex errorDescription:errorDescription];
+		[[self delegate] tableGrid:self userDidEnterInvalidStringInColumn:columnIndex row:[self _modelRowForRow:rowIndex] errorDescription:errorDescription];
 	}
 }
 
 - (void)_accessoryButtonClicked:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
 	if ([[self delegate] respondsToSelector:@selector(tableGrid:accessoryButtonClicked:row:)]) {
-		[[self delegate] tableGrid:self accessoryButtonClicked:columnIndex row:rowIndex];
+		[[self delegate] tableGrid:self accessoryButtonClicked:columnIndex row:[self _modelRowForRow:rowIndex]];
 	}
 }
 
 - (BOOL)_isGroupHeadingRow:(NSUInteger)rowIndex {
-	// Ask the data source if the cell is a group (heading) row
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:isGroupRow:)]) {
-		return [[self dataSource] tableGrid:self isGroupRow:rowIndex];
+	if (self.columnGroupRows) {
+		return MBTableGridGroupRowsKind(self.columnGroupRows, [self _expandedRowForRow:rowIndex]) == MBTableGridGroupRowHeading;
+	}
+	return [self _isModelGroupHeadingRow:[self _modelRowForRow:rowIndex]];
+}
+
+- (BOOL)_isModelGroupHeadingRow:(NSUInteger)modelRowIndex {
+	// Ask the data source if the cell is a group (heading) row, unless the grid makes the groups itself
+	if (self.groupingColumn >= _numberOfColumns && [[self dataSource] respondsToSelector:@selector(tableGrid:isGroupRow:)]) {
+		return [[self dataSource] tableGrid:self isGroupRow:modelRowIndex];
 	}
 	
 	return NO;
@@ -2540,33 +4722,74 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 - (BOOL)_isGroupSummaryRow:(NSUInteger)rowIndex {
 	if (!self.includeGroupSummaryRows) {
 		return NO;
-	} else if (rowIndex == [[self dataSource] numberOfRowsInTableGrid:self] - 1) {
+	} else if (self.columnGroupRows) {
+		return MBTableGridGroupRowsKind(self.columnGroupRows, [self _expandedRowForRow:rowIndex]) == MBTableGridGroupRowSummary;
+	}
+	
+	// A summary ends its group, so it's the last row, or the one before a heading, with every group expanded
+	NSUInteger expandedRow = [self _expandedRowForRow:rowIndex];
+	if (expandedRow == self.numberOfExpandedRows - 1) {
 		return YES;
-	} else {
-		return rowIndex > 0 && [self _isGroupHeadingRow:rowIndex + 1];
 	}
+	return expandedRow > 0 && [self _isModelGroupHeadingRow:[self _modelRowForExpandedRow:expandedRow + 1]];
 }
 
 - (BOOL)_isGroupRow:(NSUInteger)rowIndex {
 	return [self _isGroupHeadingRow:rowIndex] || [self _isGroupSummaryRow:rowIndex];
 }
 
+- (NSUInteger)_levelOfGroupRow:(NSUInteger)rowIndex {
+	return [self _levelOfExpandedGroupRow:[self _expandedRowForRow:rowIndex]];
+}
+
+- (NSUInteger)_levelOfExpandedGroupRow:(NSUInteger)expandedRow {
+	// Groups the grid makes aren't nested
+	if (!self.columnGroupRows && [[self dataSource] respondsToSelector:@selector(tableGrid:levelOfGroupRow:)]) {
+		return [[self dataSource] tableGrid:self levelOfGroupRow:[self _modelRowForExpandedRow:expandedRow]];
+	}
+	return 0;
+}
+
+- (BOOL)_isExpandedGroupRowCollapsed:(NSUInteger)expandedRow {
+	if (self.columnGroupRows) {
+		return self.collapsedGroupValues.count > 0 && [self.collapsedGroupValues containsObject:[self _groupValueForExpandedRow:expandedRow]];
+	}
+	return [self.collapsedModelRows containsIndex:[self _modelRowForExpandedRow:expandedRow]];
+}
+
+- (id)_groupValueForExpandedRow:(NSUInteger)expandedRow {
+	// Every row of a group has the same value, so the first one stands for it. Empty values are grouped together.
+	id value = [self _objectValueForColumn:self.groupingColumn modelRow:[self _modelRowForExpandedRow:expandedRow + 1]];
+	if (!value || ([value isKindOfClass:[NSString class]] && [value length] == 0)) {
+		return [NSNull null];
+	}
+	return value;
+}
+
 - (NSCell *)_groupSummaryCellForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:groupSummaryCellForColumn:row:)]) {
-		return [[self dataSource] tableGrid:self groupSummaryCellForColumn:columnIndex row:rowIndex];
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound && [[self dataSource] respondsToSelector:@selector(tableGrid:groupSummaryCellForColumn:row:)]) {
+		return [[self dataSource] tableGrid:self groupSummaryCellForColumn:columnIndex row:modelRowIndex];
 	}
 	return nil;
 }
 
 - (void)_updateGroupSummaryCell:(NSCell *)cell forColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:updateGroupSummaryCell:forColumn:row:)]) {
-		[[self dataSource] tableGrid:self updateGroupSummaryCell:cell forColumn:columnIndex row:rowIndex];
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound && [[self dataSource] respondsToSelector:@selector(tableGrid:updateGroupSummaryCell:forColumn:row:)]) {
+		[[self dataSource] tableGrid:self updateGroupSummaryCell:cell forColumn:columnIndex row:modelRowIndex];
 	}
 }
 
 - (id)_groupSummaryValueForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
+	// Summaries of the groups the grid makes show the footer aggregate of their column
+	if (self.columnGroupRows) {
+		NSNumber *function = self.footerAggregates[@(columnIndex)];
+		return function ? [self aggregateValue:function.unsignedIntegerValue forColumn:columnIndex groupSummaryRow:rowIndex] : nil;
+	}
+	
 	if ([[self dataSource] respondsToSelector:@selector(tableGrid:groupSummaryValueForColumn:row:)]) {
-		id value = [[self dataSource] tableGrid:self groupSummaryValueForColumn:columnIndex row:rowIndex];
+		id value = [[self dataSource] tableGrid:self groupSummaryValueForColumn:columnIndex row:[self _modelRowForRow:rowIndex]];
 		return value;
 	}
 	return nil;
@@ -2575,8 +4798,9 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 - (NSColor *)_tagColorForRow:(NSUInteger)rowIndex {
 	NSColor *returnColor = nil;
 	// Ask the delegate if the cell is a group row
-	if ([[self dataSource] respondsToSelector:@selector(tableGrid:tagColorForRow:)]) {
-		returnColor = [[self dataSource] tableGrid:self tagColorForRow:rowIndex];
+	NSUInteger modelRowIndex = [self _modelRowForRow:rowIndex];
+	if (modelRowIndex != NSNotFound && [[self dataSource] respondsToSelector:@selector(tableGrid:tagColorForRow:)]) {
+		returnColor = [[self dataSource] tableGrid:self tagColorForRow:modelRowIndex];
 	}
 	
 	return returnColor;
@@ -2584,12 +4808,19 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 }
 
 - (MBSortDirection)_sortDirectionForColumn:(NSUInteger)columnIndex {
+	// Columns the grid sorts by itself show their own direction
+	for (MBTableGridSortKey *sortKey in self.sortKeys) {
+		if (sortKey.column == columnIndex) {
+			return sortKey.ascending ? MBSortAscending : MBSortDescending;
+		}
+	}
+	
 	// Ask the delegate if the cell is fillable
 	if ([[self dataSource] respondsToSelector:@selector(tableGrid:sortDirectionForColumn:)]) {
 		return [[self dataSource] tableGrid:self sortDirectionForColumn:columnIndex];
 	}
 	
-	return NO;
+	return MBSortNone;
 }
 
 
@@ -2599,6 +4830,9 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	if ([[self dataSource] respondsToSelector:@selector(tableGrid:footerCellForColumn:)]) {
 		return [[self dataSource] tableGrid:self footerCellForColumn:columnIndex];
 	}
+	if (self.footerAggregates[@(columnIndex)]) {
+		return [self _footerAggregateCellForColumn:columnIndex];
+	}
 	return nil;
 }
 
@@ -2607,15 +4841,94 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 		id value = [[self dataSource] tableGrid:self footerValueForColumn:columnIndex];
 		return value;
 	}
+	NSNumber *function = self.footerAggregates[@(columnIndex)];
+	if (function) {
+		return [self _footerTitleForAggregate:function.unsignedIntegerValue column:columnIndex];
+	}
 	return nil;
 }
 
 - (void)_setFooterValue:(id)value forColumn:(NSUInteger)columnIndex {
 	if ([[self dataSource] respondsToSelector:@selector(tableGrid:setFooterValue:forColumn:)]) {
 		[[self dataSource] tableGrid:self setFooterValue:value forColumn:columnIndex];
+	} else if (self.footerAggregates[@(columnIndex)] && [value isKindOfClass:[NSNumber class]]) {
+		NSMutableDictionary<NSNumber *, NSNumber *> *footerAggregates = [self.footerAggregates mutableCopy];
+		footerAggregates[@(columnIndex)] = value;
+		self.footerAggregates = footerAggregates;
 	}
 }
 
+- (NSString *)_footerTitleForAggregate:(MBTableGridAggregateFunction)function column:(NSUInteger)columnIndex {
+	NSString *name = nil;
+	switch (function) {
+		case MBTableGridAggregateSum:
+			name = NSLocalizedString(@"Total", nil);
+			break;
+		case MBTableGridAggregateMinimum:
+			name = NSLocalizedString(@"Minimum", nil);
+			break;
+		case MBTableGridAggregateMaximum:
+			name = NSLocalizedString(@"Maximum", nil);
+			break;
+		case MBTableGridAggregateAverage:
+			name = NSLocalizedString(@"Average", nil);
+			break;
+		case MBTableGridAggregateRowCount:
+			name = NSLocalizedString(@"Rows", nil);
+			break;
+		case MBTableGridAggregateDistinctCount:
+			name = NSLocalizedString(@"Distinct", nil);
+			break;
+		case MBTableGridAggregateMedian:
+			name = NSLocalizedString(@"Median", nil);
+			break;
+		case MBTableGridAggregatePercentile95:
+			name = NSLocalizedString(@"95th Percentile", nil);
+			break;
+		default:
+			name = NSLocalizedString(@"Count", nil);
+			break;
+	}
+	
+	NSNumber *value = [self aggregateValue:function forColumn:columnIndex];
+	if (!value) {
+		return name;
+	}
+	
+	// Counts are plain numbers, and the rest look like the column's cells
+	BOOL isCount = function == MBTableGridAggregateCount || function == MBTableGridAggregateRowCount || function == MBTableGridAggregateDistinctCount;
+	NSFormatter *formatter = isCount ? nil : [self _formatterForColumn:columnIndex];
+	NSString *formattedValue = formatter ? [formatter stringForObjectValue:value] : [NSNumberFormatter localizedStringFromNumber:value numberStyle:NSNumberFormatterDecimalStyle];
+	
+	// Estimates say so
+	if (function >= MBTableGridAggregateDistinctCount) {
+		formattedValue = [@"≈" stringByAppendingString:formattedValue];
+	}
+	return [NSString stringWithFormat:@"%@: %@", name, formattedValue];
+}
+
+- (NSCell *)_footerAggregateCellForColumn:(NSUInteger)columnIndex {
+	if (!self.footerAggregateCell) {
+		MBFooterPopupButtonCell *cell = [[MBFooterPopupButtonCell alloc] initTextCell:@""];
+		cell.bordered = NO;
+		cell.controlSize = NSControlSizeSmall;
+		cell.font = [NSFont systemFontOfSize:[NSFont systemFontSizeForControlSize:NSControlSizeSmall]];
+		cell.menu = [NSMenu new];
+		cell.menu.font = cell.font;
+		self.footerAggregateCell = cell;
+	}
+	
+	// The aggregates are already up to date, so the menu only needs new titles
+	NSMenu *menu = self.footerAggregateCell.menu;
+	[menu removeAllItems];
+	for (MBTableGridAggregateFunction function = MBTableGridAggregateSum; function <= MBTableGridAggregatePercentile95; function++) {
+		NSMenuItem *item = [menu addItemWithTitle:[self _footerTitleForAggregate:function column:columnIndex] action:nil keyEquivalent:@""];
+		item.representedObject = @(function);
+	}
+	
+	return self.footerAggregateCell;
+}
+
 @end
 
 @implementation MBTableGrid (PrivateAccessors)
@@ -2649,6 +4962,476 @@ NSString *MBTableGridRowDataType = @"mbtablegrid.pasteboard.row";
 	return self.cachedUndoManager;
 }
 
+- (void)_updateSelectionTracking {
+	self.cachedSelection = nil;
+	[contentView updateSelectionTracking];
+	[frozenContentView updateSelectionTracking];
+}
+
+- (MBTableGridColumnLayout *)_columnLayout {
+	return self.columnLayout;
+}
+
+- (void)_beginAddingSelectionAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
+	// Keep the current rectangle and start a new one at the clicked cell
+	if (_selectedColumnIndexes.count && _selectedRowIndexes.count) {
+		self.additionalSelection = self.additionalSelection ? [self.additionalSelection selectionByAddingColumnIndexes:_selectedColumnIndexes rowIndexes:_selectedRowIndexes] : [[MBTableGridSelection alloc] initWithColumnIndexes:_selectedColumnIndexes rowIndexes:_selectedRowIndexes];
+	}
+	
+	self.addingSelection = YES;
+	self.selectedColumnIndexes = [NSIndexSet indexSetWithIndex:columnIndex];
+	self.selectedRowIndexes = [NSMutableIndexSet indexSetWithIndex:rowIndex];
+	self.cachedSelection = nil;
+	[self setNeedsDisplay:YES];
+}
+
+- (void)_endAddingSelection {
+	self.addingSelection = NO;
+}
+
+- (void)_removeAdditionalSelection {
+	if (self.additionalSelection) {
+		self.additionalSelection = nil;
+		self.cachedSelection = nil;
+		[self setNeedsDisplay:YES];
+	}
+}
+
+- (NSIndexSet *)_rowIndexesExcludingGroupHeadingRows {
+	// Start from every row and punch out the headings, rather than testing each row
+	NSMutableIndexSet *rowIndexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, _numberOfRows)];
+	MBTableGridGroupRows *groupRows = [self _groupRows];
+	size_t numberOfGroupRows = MBTableGridGroupRowsCount(groupRows);
+	for (size_t index = 0; index < numberOfGroupRows; index++) {
+		if (MBTableGridGroupRowsKindAtIndex(groupRows, index) == MBTableGridGroupRowHeading) {
+			[rowIndexes removeIndex:MBTableGridGroupRowsRowAtIndex(groupRows, index)];
+		}
+	}
+	return rowIndexes;
+}
+
+- (void)_reloadColumnLayout {
+	double *widths = malloc(MAX(_numberOfColumns, 1) * sizeof(double));
+	for (NSUInteger column = 0; column < _numberOfColumns; column++) {
+		widths[column] = [self.hiddenColumns containsIndex:column] ? 0 : [self _widthForColumn:column];
+	}
+	MBTableGridColumnLayoutSetWidths(self.columnLayout, widths, _numberOfColumns);
+	free(widths);
+}
+
+- (MBTableGridGroupRows *)_groupRows {
+	// Made from the group rows found when the rows were mapped, or from the group start positions,
+	// so the data source isn't asked about every row again
+	if (!self.groupRowsAreCached) {
+		[self _updateDisplayedGroupRows];
+	}
+	return self.groupRows;
+}
+
+- (MBTableGridGroupRows *)_expandedGroupRows {
+	// Until a group is collapsed, every row is displayed
+	return self.collapsedRows ? self.expandedGroupRows : [self _groupRows];
+}
+
+- (void)_updateRowMapping {
+	NSUInteger numberOfModelRows = self.numberOfModelRows;
+	
+	self.inverseRowPermutation = nil;
+	MBTableGridRowBitmapFree(self.visibleRows);
+	self.visibleRows = NULL;
+	MBTableGridCollapsedRowsFree(self.collapsedRows);
+	self.collapsedRows = NULL;
+	MBTableGridGroupRowsFree(self.columnGroupRows);
+	self.columnGroupRows = NULL;
+	self.groupStartPositions = nil;
+	[self.groupAggregates removeAllObjects];
+	self.displayAggregates = [NSMutableDictionary dictionary];
+	_numberOfRows = numberOfModelRows;
+	
+	BOOL groupsByColumn = self.groupingColumn < _numberOfColumns;
+	
+	// Find the group rows by data source row, since neither sorting nor filtering moves or hides them.
+	// The data source is asked about each row once here, and the cached group rows are made from these.
+	MBTableGridGroupRows *modelGroupRows = MBTableGridGroupRowsCreate();
+	if (!groupsByColumn && [[self dataSource] respondsToSelector:@selector(tableGrid:isGroupRow:)]) {
+		BOOL nextIsHeading = numberOfModelRows > 0 && [self _isModelGroupHeadingRow:0];
+		for (NSUInteger row = 0; row < numberOfModelRows; row++) {
+			BOOL isHeading = nextIsHeading;
+			nextIsHeading = row + 1 < numberOfModelRows && [self _isModelGroupHeadingRow:row + 1];
+			if (isHeading) {
+				MBTableGridGroupRowsAdd(modelGroupRows, row, MBTableGridGroupRowHeading);
+			} else if (self.includeGroupSummaryRows && (row == numberOfModelRows - 1 || (row > 0 && nextIsHeading))) {
+				MBTableGridGroupRowsAdd(modelGroupRows, row, MBTableGridGroupRowSummary);
+			}
+		}
+	}
+	size_t numberOfGroupRows = MBTableGridGroupRowsCount(modelGroupRows);
+	
+	if (self.sortKeys.count == 0 && self.filters.count == 0 && !groupsByColumn && self.collapsedModelRows.count == 0) {
+		self.rowPermutation = nil;
+		
+		// Every row is displayed, so the group rows are by displayed row already
+		MBTableGridGroupRowsRemoveAll(self.expandedGroupRows);
+		for (size_t index = 0; index < numberOfGroupRows; index++) {
+			MBTableGridGroupRowsAdd(self.expandedGroupRows, MBTableGridGroupRowsRowAtIndex(modelGroupRows, index), MBTableGridGroupRowsKindAtIndex(modelGroupRows, index));
+		}
+		self.numberOfExpandedRows = _numberOfRows;
+		[self _updateDisplayedGroupRows];
+		
+		MBTableGridGroupRowsFree(modelGroupRows);
+		return;
+	}
+	
+	NSMutableDictionary<NSNumber *, id> *columnValues = [NSMutableDictionary dictionary];
+	
+	// The rows between each pair of group rows are sorted on their own
+	if ((self.sortKeys.count > 0 || groupsByColumn) && numberOfModelRows > 1) {
+		NSMutableArray<NSValue *> *segments = [NSMutableArray array];
+		NSUInteger segmentStart = 0;
+		for (size_t index = 0; index < numberOfGroupRows; index++) {
+			NSUInteger groupRow = MBTableGridGroupRowsRowAtIndex(modelGroupRows, index);
+			if (groupRow > segmentStart) {
+				[segments addObject:[NSValue valueWithRange:NSMakeRange(segmentStart, groupRow - segmentStart)]];
+			}
+			segmentStart = groupRow + 1;
+		}
+		if (segmentStart < numberOfModelRows) {
+			[segments addObject:[NSValue valueWithRange:NSMakeRange(segmentStart, numberOfModelRows - segmentStart)]];
+		}
+		
+		// Groups are runs of equal values, so the grouping column is sorted by first, in the direction of its own key if it has one
+		NSMutableArray<MBTableGridSortKey *> *sortKeys = [self.sortKeys mutableCopy] ?: [NSMutableArray array];
+		if (groupsByColumn) {
+			MBTableGridSortKey *groupingKey = [MBTableGridSortKey sortKeyWithColumn:self.groupingColumn ascending:YES];
+			for (MBTableGridSortKey *sortKey in self.sortKeys) {
+				if (sortKey.column == self.groupingColumn) {
+					groupingKey = sortKey;
+					[sortKeys removeObjectIdenticalTo:sortKey];
+					break;
+				}
+			}
+			[sortKeys insertObject:groupingKey atIndex:0];
+		}
+		
+		MBTableGridSorter *sorter = [[MBTableGridSorter alloc] initWithNumberOfRows:numberOfModelRows];
+		for (MBTableGridSortKey *sortKey in sortKeys) {
+			if (sortKey.column >= _numberOfColumns) {
+				continue;
+			}
+			id values = [self _valuesForColumn:sortKey.column groupRows:modelGroupRows cache:columnValues];
+			if ([values isKindOfClass:[NSData class]]) {
+				[sorter addKeyWithNumericValues:values ascending:sortKey.ascending];
+			} else {
+				[sorter addKeyWithObjectValues:values ascending:sortKey.ascending];
+			}
+		}
+		
+		// Start from the previous order, which is usually close
+		self.rowPermutation = [sorter permutationForSegments:segments previousPermutation:self.rowPermutation];
+	} else {
+		self.rowPermutation = nil;
+	}
+	
+	// Every filter narrows down the same bitmap of data source rows
+	if (self.filters.count > 0) {
+		MBTableGridRowBitmap *matchingRows = MBTableGridRowBitmapCreate(numberOfModelRows);
+		MBTableGridRowBitmap *filterRows = MBTableGridRowBitmapCreate(numberOfModelRows);
+		
+		for (MBTableGridFilter *filter in self.filters) {
+			if (filter.column >= _numberOfColumns) {
+				continue;
+			}
+			id values = [self _valuesForColumn:filter.column groupRows:modelGroupRows cache:columnValues];
+			if ([values isKindOfClass:[NSData class]] && filter.canEvaluateNumericValues) {
+				[filter evaluateNumericValues:[values bytes] intoBitmap:filterRows];
+			} else {
+				if ([values isKindOfClass:[NSData class]]) {
+					values = [self _objectValuesForColumn:filter.column groupRows:modelGroupRows];
+				}
+				[filter evaluateObjectValues:values formatter:[self _formatterForColumn:filter.column] intoBitmap:filterRows];
+			}
+			MBTableGridRowBitmapIntersect(matchingRows, filterRows, filter.inverted);
+		}
+		
+		for (size_t index = 0; index < numberOfGroupRows; index++) {
+			MBTableGridRowBitmapSet(matchingRows, MBTableGridGroupRowsRowAtIndex(modelGroupRows, index));
+		}
+		
+		// Rank and select work on displayed positions, so carry the bits over to the sorted order
+		if (self.rowPermutation) {
+			const NSUInteger *modelRows = self.rowPermutation.bytes;
+			uint64_t *words = MBTableGridRowBitmapWords(filterRows);
+			for (NSUInteger word = 0; word * 64 < numberOfModelRows; word++) {
+				uint64_t bits = 0;
+				for (NSUInteger position = word * 64; position < MIN(word * 64 + 64, numberOfModelRows); position++) {
+					bits |= (uint64_t)MBTableGridRowBitmapIsSet(matchingRows, modelRows[position]) << (position % 64);
+				}
+				words[word] = bits;
+			}
+			MBTableGridRowBitmapFree(matchingRows);
+			matchingRows = filterRows;
+		} else {
+			MBTableGridRowBitmapFree(filterRows);
+		}
+		
+		MBTableGridRowBitmapUpdateRanks(matchingRows);
+		self.visibleRows = matchingRows;
+		_numberOfRows = MBTableGridRowBitmapSetCount(matchingRows);
+	}
+	
+	if (groupsByColumn) {
+		[self _groupRowsWithValues:[self _valuesForColumn:self.groupingColumn groupRows:modelGroupRows cache:columnValues]];
+	}
+	
+	// Group rows are already known, so fill them in by row as if every group were expanded
+	MBTableGridGroupRowsRemoveAll(self.expandedGroupRows);
+	for (size_t index = 0; index < numberOfGroupRows; index++) {
+		size_t row = MBTableGridGroupRowsRowAtIndex(modelGroupRows, index);
+		if (self.visibleRows) {
+			row = MBTableGridRowBitmapRank(self.visibleRows, row);
+		}
+		MBTableGridGroupRowsAdd(self.expandedGroupRows, row, MBTableGridGroupRowsKindAtIndex(modelGroupRows, index));
+	}
+	size_t numberOfColumnGroupRows = self.columnGroupRows ? MBTableGridGroupRowsCount(self.columnGroupRows) : 0;
+	for (size_t index = 0; index < numberOfColumnGroupRows; index++) {
+		MBTableGridGroupRowsAdd(self.expandedGroupRows, MBTableGridGroupRowsRowAtIndex(self.columnGroupRows, index), MBTableGridGroupRowsKindAtIndex(self.columnGroupRows, index));
+	}
+	self.numberOfExpandedRows = _numberOfRows;
+	
+	// Then hide the rows of collapsed groups, and fill in the cache by displayed row
+	[self _updateCollapsedRows];
+	[self _updateDisplayedGroupRows];
+	
+	MBTableGridGroupRowsFree(modelGroupRows);
+}
+
+- (id)_valuesForColumn:(NSUInteger)columnIndex groupRows:(MBTableGridGroupRows *)modelGroupRows cache:(NSMutableDictionary<NSNumber *, id> *)cache {
+	id values = cache[@(columnIndex)];
+	if (values) {
+		return values;
+	}
+	
+	// Numbers straight from the data source avoid reading every value as an object
+	if ([[self dataSource] respondsToSelector:@selector(tableGrid:getSortValues:forColumn:)]) {
+		NSMutableData *numericValues = [NSMutableData dataWithLength:MAX(self.numberOfModelRows, 1) * sizeof(double)];
+		if ([[self dataSource] tableGrid:self getSortValues:numericValues.mutableBytes forColumn:columnIndex]) {
+			values = numericValues;
+		}
+	}
+	
+	if (!values) {
+		values = [self _objectValuesForColumn:columnIndex groupRows:modelGroupRows];
+	}
+	
+	cache[@(columnIndex)] = values;
+	return values;
+}
+
+- (NSArray *)_objectValuesForColumn:(NSUInteger)columnIndex groupRows:(MBTableGridGroupRows *)modelGroupRows {
+	// Data source calls stay on the main thread, and only sorting and filtering are done in parallel
+	NSUInteger numberOfModelRows = self.numberOfModelRows;
+	NSMutableArray *values = [NSMutableArray arrayWithCapacity:numberOfModelRows];
+	for (NSUInteger row = 0; row < numberOfModelRows; row++) {
+		id value = MBTableGridGroupRowsKind(modelGroupRows, row) ? nil : [self _objectValueForColumn:columnIndex modelRow:row];
+		[values addObject:value ?: [NSNull null]];
+	}
+	return values;
+}
+
+- (void)_groupRowsWithValues:(id)values {
+	NSUInteger numberOfModelRows = self.numberOfModelRows;
+	const double *numericValues = [values isKindOfClass:[NSData class]] ? [values bytes] : NULL;
+	NSArray *objectValues = numericValues ? nil : values;
+	const NSUInteger *modelRows = self.rowPermutation.bytes;
+	NSUInteger numberOfSortedRows = self.rowPermutation.length / sizeof(NSUInteger);
+	
+	MBTableGridGroupRows *columnGroupRows = MBTableGridGroupRowsCreate();
+	NSMutableData *groupStartPositions = [NSMutableData data];
+	NSUInteger position = 0;
+	NSUInteger previousModelRow = NSNotFound;
+	
+	// Sorting put equal values next to each other, so a group starts wherever the value changes
+	for (NSUInteger sortedRow = 0; sortedRow < numberOfModelRows; sortedRow++) {
+		if (self.visibleRows && !MBTableGridRowBitmapIsSet(self.visibleRows, sortedRow)) {
+			continue;
+		}
+		NSUInteger modelRow = sortedRow < numberOfSortedRows ? modelRows[sortedRow] : sortedRow;
+		
+		BOOL startsGroup = previousModelRow == NSNotFound;
+		if (!startsGroup && numericValues) {
+			double value = numericValues[modelRow];
+			double previousValue = numericValues[previousModelRow];
+			startsGroup = value != previousValue && !(isnan(value) && isnan(previousValue));
+		} else if (!startsGroup) {
+			id value = objectValues[modelRow];
+			id previousValue = objectValues[previousModelRow];
+			BOOL isEmpty = value == [NSNull null] || ([value isKindOfClass:[NSString class]] && [value length] == 0);
+			BOOL previousIsEmpty = previousValue == [NSNull null] || ([previousValue isKindOfClass:[NSString class]] && [previousValue length] == 0);
+			startsGroup = isEmpty != previousIsEmpty || (!isEmpty && ![value isEqual:previousValue]);
+		}
+		
+		if (startsGroup) {
+			NSUInteger numberOfGroups = groupStartPositions.length / sizeof(NSUInteger);
+			if (numberOfGroups > 0 && self.includeGroupSummaryRows) {
+				MBTableGridGroupRowsAdd(columnGroupRows, position + MBTableGridGroupRowsCount(columnGroupRows), MBTableGridGroupRowSummary);
+			}
+			MBTableGridGroupRowsAdd(columnGroupRows, position + MBTableGridGroupRowsCount(columnGroupRows), MBTableGridGroupRowHeading);
+			[groupStartPositions appendBytes:&position length:sizeof(NSUInteger)];
+		}
+		previousModelRow = modelRow;
+		position++;
+	}
+	
+	if (position > 0 && self.includeGroupSummaryRows) {
+		MBTableGridGroupRowsAdd(columnGroupRows, position + MBTableGridGroupRowsCount(columnGroupRows), MBTableGridGroupRowSummary);
+	}
+	
+	// The last group ends where the positions do
+	[groupStartPositions appendBytes:&position length:sizeof(NSUInteger)];
+	
+	self.columnGroupRows = columnGroupRows;
+	self.groupStartPositions = groupStartPositions;
+	_numberOfRows = position + MBTableGridGroupRowsCount(columnGroupRows);
+}
+
+- (NSRange)_rowsOfExpandedGroupAtIndex:(size_t)index {
+	// A group runs to the next heading at its own level or above, or to the last row
+	MBTableGridGroupRows *groupRows = self.expandedGroupRows;
+	NSUInteger headingRow = MBTableGridGroupRowsRowAtIndex(groupRows, index);
+	NSUInteger level = [self _levelOfExpandedGroupRow:headingRow];
+	NSUInteger endRow = self.numberOfExpandedRows;
+	size_t numberOfGroupRows = MBTableGridGroupRowsCount(groupRows);
+	
+	// Without levels every heading is at level 0, so there's no need to ask about each one
+	BOOL hasLevels = !self.columnGroupRows && [[self dataSource] respondsToSelector:@selector(tableGrid:levelOfGroupRow:)];
+	for (size_t next = index + 1; next < numberOfGroupRows; next++) {
+		if (MBTableGridGroupRowsKindAtIndex(groupRows, next) != MBTableGridGroupRowHeading) {
+			continue;
+		}
+		NSUInteger row = MBTableGridGroupRowsRowAtIndex(groupRows, next);
+		if (!hasLevels || [self _levelOfExpandedGroupRow:row] <= level) {
+			endRow = row;
+			break;
+		}
+	}
+	return NSMakeRange(headingRow + 1, endRow - headingRow - 1);
+}
+
+- (void)_hideCollapsedGroupsFromIndex:(size_t)firstIndex toRow:(NSUInteger)endRow {
+	// Groups nested in a collapsed one are hidden with it, so they're skipped rather than asked about
+	MBTableGridGroupRows *groupRows = self.expandedGroupRows;
+	size_t numberOfGroupRows = MBTableGridGroupRowsCount(groupRows);
+	for (size_t index = firstIndex; index < numberOfGroupRows; index++) {
+		NSUInteger row = MBTableGridGroupRowsRowAtIndex(groupRows, index);
+		if (row >= endRow) {
+			break;
+		} else if (MBTableGridGroupRowsKindAtIndex(groupRows, index) != MBTableGridGroupRowHeading || ![self _isExpandedGroupRowCollapsed:row]) {
+			continue;
+		}
+		NSRange groupRange = [self _rowsOfExpandedGroupAtIndex:index];
+		MBTableGridCollapsedRowsSetHidden(self.collapsedRows, groupRange.location, groupRange.length, true);
+		index = MBTableGridGroupRowsCountBefore(groupRows, NSMaxRange(groupRange)) - 1;
+	}
+}
+
+- (void)_updateCollapsedRows {
+	MBTableGridCollapsedRowsFree(self.collapsedRows);
+	self.collapsedRows = NULL;
+	if (self.collapsedModelRows.count == 0 && self.collapsedGroupValues.count == 0) {
+		return;
+	}
+	
+	self.collapsedRows = MBTableGridCollapsedRowsCreate(self.numberOfExpandedRows);
+	[self _hideCollapsedGroupsFromIndex:0 toRow:self.numberOfExpandedRows];
+	
+	// Collapsed groups may have been filtered out or removed, leaving nothing hidden
+	if (MBTableGridCollapsedRowsVisibleCount(self.collapsedRows) == self.numberOfExpandedRows) {
+		MBTableGridCollapsedRowsFree(self.collapsedRows);
+		self.collapsedRows = NULL;
+	}
+}
+
+- (void)_updateDisplayedGroupRows {
+	// Group rows in collapsed groups aren't displayed, and the ones after them move up
+	MBTableGridCollapsedRows *collapsedRows = self.collapsedRows;
+	_numberOfRows = collapsedRows ? MBTableGridCollapsedRowsVisibleCount(collapsedRows) : self.numberOfExpandedRows;
+	
+	MBTableGridGroupRowsRemoveAll(self.groupRows);
+	size_t numberOfGroupRows = MBTableGridGroupRowsCount(self.expandedGroupRows);
+	for (size_t index = 0; index < numberOfGroupRows; index++) {
+		size_t row = MBTableGridGroupRowsRowAtIndex(self.expandedGroupRows, index);
+		if (collapsedRows) {
+			if (MBTableGridCollapsedRowsIsHidden(collapsedRows, row)) {
+				continue;
+			}
+			row = MBTableGridCollapsedRowsRank(collapsedRows, row);
+		}
+		MBTableGridGroupRowsAdd(self.groupRows, row, MBTableGridGroupRowsKindAtIndex(self.expandedGroupRows, index));
+	}
+	self.groupRowsAreCached = YES;
+}
+
+- (void)_setGroupRow:(NSUInteger)rowIndex collapsed:(BOOL)collapsed {
+	if (rowIndex >= _numberOfRows || ![self _isGroupHeadingRow:rowIndex] || [self isGroupRowCollapsed:rowIndex] == collapsed) {
+		return;
+	}
+	
+	NSUInteger expandedRow = [self _expandedRowForRow:rowIndex];
+	if (self.columnGroupRows) {
+		id value = [self _groupValueForExpandedRow:expandedRow];
+		if (collapsed) {
+			[self.collapsedGroupValues addObject:value];
+		} else {
+			[self.collapsedGroupValues removeObject:value];
+		}
+	} else if (collapsed) {
+		[self.collapsedModelRows addIndex:[self _modelRowForExpandedRow:expandedRow]];
+	} else {
+		[self.collapsedModelRows removeIndex:[self _modelRowForExpandedRow:expandedRow]];
+	}
+	
+	// Until now every row was displayed
+	if (!self.collapsedRows) {
+		self.collapsedRows = MBTableGridCollapsedRowsCreate(self.numberOfExpandedRows);
+	}
+	
+	// Only the rows of the group are hidden or shown, without sorting or filtering again.
+	// Nested groups that are still collapsed stay hidden when it's expanded.
+	size_t index = MBTableGridGroupRowsCountBefore(self.expandedGroupRows, expandedRow);
+	NSRange groupRange = [self _rowsOfExpandedGroupAtIndex:index];
+	MBTableGridCollapsedRowsSetHidden(self.collapsedRows, groupRange.location, groupRange.length, collapsed);
+	if (!collapsed) {
+		[self _hideCollapsedGroupsFromIndex:index + 1 toRow:NSMaxRange(groupRange)];
+	}
+	if (MBTableGridCollapsedRowsVisibleCount(self.collapsedRows) == self.numberOfExpandedRows) {
+		MBTableGridCollapsedRowsFree(self.collapsedRows);
+		self.collapsedRows = NULL;
+	}
+	
+	[self _updateDisplayedGroupRows];
+	[self _rowsDidChange];
+}
+
+- (void)_reloadRows {
+	[self _updateRowMapping];
+	[self _rowsDidChange];
+}
+
+- (void)_rowsDidChange {
+	[self _validateSelection];
+	
+	// Completion indexes hold the values of every row, and matches are kept by data source row
+	[self _remapFindMatches];
+	
+	[self _updateContentSize];
+	[self _updateSelectionTracking];
+	
+	[columnHeaderView setNeedsDisplay:YES];
+	[frozenColumnHeaderView setNeedsDisplay:YES];
+	[rowHeaderView setNeedsDisplay:YES];
+	[self setNeedsDisplay:YES];
+}
+
 @end
 
 @implementation MBTableGrid (DragAndDrop)
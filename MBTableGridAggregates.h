@@ -0,0 +1,177 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "MBTableGridCore.h"
+#import "MBTableGridSketches.h"
+
+/**
+ * @brief		\c MBTableGridColumnAggregates keeps the sum,
+ *				extremes and count of a column up to date as its
+ *				cells change.
+ *
+ * @details		Values are kept as numbers in an aggregate tree,
+ *				so an edit costs O(log n) rather than a pass over
+ *				the column. Aggregates of ranges, such as groups,
+ *				are remembered until the next change, and the
+ *				total is always O(1).
+ */
+@interface MBTableGridColumnAggregates : NSObject
+
+/**
+ * @brief		Creates the aggregates of a column.
+ *
+ * @param		values		One \c double per row, with NaN for cells
+ *							to leave out.
+ */
+- (instancetype)initWithValues:(NSData *)values;
+
+/**
+ * @brief		Creates the aggregates of a column's values in
+ *				another order, such as the order they're shown in.
+ *
+ * @param		values		One \c double per row of the column.
+ * @param		rows		One \c NSUInteger per row, with the row of
+ *							\c values it holds, or \c NSNotFound for
+ *							a row to leave out.
+ */
+- (instancetype)initWithValues:(NSData *)values rows:(NSData *)rows;
+
+/**
+ * @brief		Creates the same aggregates as
+ *				\c initWithValues:rows: on a background queue.
+ *
+ * @param		completionHandler	Called on the main queue with the
+ *									aggregates.
+ */
++ (void)buildAggregatesWithValues:(NSData *)values rows:(NSData *)rows completionHandler:(void (^)(MBTableGridColumnAggregates *aggregates))completionHandler;
+
+@property (nonatomic, readonly) NSUInteger numberOfRows;
+
+- (void)setValue:(double)value forRow:(NSUInteger)rowIndex;
+
+/**
+ * @brief		Replaces the values of a range of rows, such as
+ *				the rows moved by a drag.
+ *
+ * @details		Unlike \c setValue:forRow:, whose new value is
+ *				given to the \c sketches by the caller, the rows
+ *				count towards the sketches going stale.
+ */
+- (void)setValues:(const double *)values inRange:(NSRange)range;
+
+/**
+ * @brief		Makes room for rows inserted at \c range, which
+ *				are empty until their values are set with
+ *				\c setValues:inRange:, and count towards the
+ *				sketches going stale then.
+ *
+ * @return		\c NO if there wasn't enough memory, in which case
+ *				the receiver should be discarded.
+ */
+- (BOOL)insertRowsInRange:(NSRange)range;
+
+/**
+ * @brief		Removes rows, moving the rows after them down.
+ */
+- (void)removeRowsInRange:(NSRange)range;
+
+/**
+ * @brief		Returns the aggregate of a range of rows.
+ */
+- (MBTableGridAggregate)aggregateForRowsInRange:(NSRange)range;
+
+/**
+ * @brief		Returns the aggregate of any set of rows, in
+ *				O(log n) per range of rows.
+ *
+ * @details		Unlike \c aggregateForRowsInRange:, the result
+ *				isn't remembered, since sets like the selection
+ *				rarely come back.
+ */
+- (MBTableGridAggregate)aggregateForRowIndexes:(NSIndexSet *)rowIndexes;
+
+- (double)valueForRow:(NSUInteger)rowIndex;
+
+/**
+ * @brief		The aggregate of every row.
+ */
+@property (nonatomic, readonly) MBTableGridAggregate totalAggregate;
+
+/**
+ * @brief		A copy of the value of every row.
+ */
+@property (nonatomic, readonly) NSData *values;
+
+/**
+ * @brief		Goes up each time any value changes or rows are
+ *				inserted or removed.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfChanges;
+
+/**
+ * @brief		The column's approximate statistics, once they
+ *				have been built.
+ */
+@property (nonatomic, strong) MBTableGridColumnSketches *sketches;
+@property (nonatomic, getter=isBuildingSketches) BOOL buildingSketches;
+
+/**
+ * @brief		Returns the number a cell value counts as: numbers
+ *				as they are, text by its numeric value and dates in
+ *				seconds since the reference date. Empty cells and
+ *				anything else are NaN.
+ */
++ (double)numericValueForObject:(id)value;
+
+@end
+
+/**
+ * @brief		\c MBTableGridStatistics holds the sum, extremes,
+ *				count and average of a set of cells.
+ */
+@interface MBTableGridStatistics : NSObject
+
+- (instancetype)initWithAggregate:(MBTableGridAggregate)aggregate;
+
+@property (nonatomic, readonly) double sum;
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * @brief		The smallest value, or NaN if there are none.
+ */
+@property (nonatomic, readonly) double minimum;
+
+/**
+ * @brief		The largest value, or NaN if there are none.
+ */
+@property (nonatomic, readonly) double maximum;
+
+/**
+ * @brief		The average value, or NaN if there are none.
+ */
+@property (nonatomic, readonly) double average;
+
+@end
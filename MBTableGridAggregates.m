@@ -0,0 +1,199 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridAggregates.h"
+
+@interface MBTableGridColumnAggregates ()
+
+@property (nonatomic, assign) MBTableGridAggregateTree *tree;
+@property (nonatomic, strong) NSMutableDictionary<NSValue *, NSValue *> *rangeAggregates;
+@property (nonatomic, readwrite) NSUInteger numberOfChanges;
+
+@end
+
+@implementation MBTableGridColumnAggregates
+
+- (instancetype)initWithValues:(NSData *)values {
+	if (self = [super init]) {
+		_tree = MBTableGridAggregateTreeCreate(values.bytes, values.length / sizeof(double));
+		_rangeAggregates = [NSMutableDictionary dictionary];
+	}
+	return self;
+}
+
+- (instancetype)initWithValues:(NSData *)values rows:(NSData *)rows {
+	const double *sourceValues = values.bytes;
+	NSUInteger numberOfSourceRows = values.length / sizeof(double);
+	const NSUInteger *sourceRows = rows.bytes;
+	NSUInteger numberOfRows = rows.length / sizeof(NSUInteger);
+	
+	NSMutableData *orderedValues = [NSMutableData dataWithLength:MAX(numberOfRows, 1) * sizeof(double)];
+	double *numericValues = orderedValues.mutableBytes;
+	for (NSUInteger row = 0; row < numberOfRows; row++) {
+		numericValues[row] = sourceRows[row] < numberOfSourceRows ? sourceValues[sourceRows[row]] : NAN;
+	}
+	orderedValues.length = numberOfRows * sizeof(double);
+	return [self initWithValues:orderedValues];
+}
+
++ (void)buildAggregatesWithValues:(NSData *)values rows:(NSData *)rows completionHandler:(void (^)(MBTableGridColumnAggregates *aggregates))completionHandler {
+	dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+		MBTableGridColumnAggregates *aggregates = [[MBTableGridColumnAggregates alloc] initWithValues:values rows:rows];
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completionHandler(aggregates);
+		});
+	});
+}
+
+- (void)dealloc {
+	MBTableGridAggregateTreeFree(_tree);
+}
+
+- (NSUInteger)numberOfRows {
+	return self.tree ? MBTableGridAggregateTreeCount(self.tree) : 0;
+}
+
+- (void)setValue:(double)value forRow:(NSUInteger)rowIndex {
+	// The sketches are given edited values one by one
+	[self _setValues:&value inRange:NSMakeRange(rowIndex, 1)];
+}
+
+- (void)setValues:(const double *)values inRange:(NSRange)range {
+	[self _setValues:values inRange:range];
+	[self.sketches changeValues:range.length];
+}
+
+- (void)_setValues:(const double *)values inRange:(NSRange)range {
+	if (!self.tree || range.length == 0) {
+		return;
+	}
+	MBTableGridAggregateTreeSetValues(self.tree, range.location, values, range.length);
+	self.numberOfChanges++;
+	
+	// Any remembered range could include the changed rows, and working one out again is only O(log n)
+	[self.rangeAggregates removeAllObjects];
+}
+
+- (BOOL)insertRowsInRange:(NSRange)range {
+	if (!self.tree) {
+		return NO;
+	}
+	if (range.length == 0) {
+		return YES;
+	}
+	
+	double *values = malloc(range.length * sizeof(double));
+	if (!values) {
+		return NO;
+	}
+	for (NSUInteger index = 0; index < range.length; index++) {
+		values[index] = NAN;
+	}
+	BOOL didInsert = MBTableGridAggregateTreeInsertValues(self.tree, range.location, values, range.length);
+	free(values);
+	self.numberOfChanges++;
+	
+	[self.rangeAggregates removeAllObjects];
+	return didInsert;
+}
+
+- (void)removeRowsInRange:(NSRange)range {
+	if (!self.tree || range.length == 0) {
+		return;
+	}
+	MBTableGridAggregateTreeRemoveValues(self.tree, range.location, range.length);
+	self.numberOfChanges++;
+	[self.rangeAggregates removeAllObjects];
+	[self.sketches changeValues:range.length];
+}
+
+- (MBTableGridAggregate)aggregateForRowsInRange:(NSRange)range {
+	if (!self.tree) {
+		return MBTableGridAggregateEmpty();
+	}
+	
+	NSValue *key = [NSValue valueWithRange:range];
+	MBTableGridAggregate aggregate;
+	NSValue *rangeAggregate = self.rangeAggregates[key];
+	if (rangeAggregate) {
+		[rangeAggregate getValue:&aggregate];
+		return aggregate;
+	}
+	
+	aggregate = MBTableGridAggregateTreeQuery(self.tree, range.location, range.length);
+	self.rangeAggregates[key] = [NSValue valueWithBytes:&aggregate objCType:@encode(MBTableGridAggregate)];
+	return aggregate;
+}
+
+- (MBTableGridAggregate)aggregateForRowIndexes:(NSIndexSet *)rowIndexes {
+	__block MBTableGridAggregate aggregate = MBTableGridAggregateEmpty();
+	if (!self.tree) {
+		return aggregate;
+	}
+	[rowIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+		aggregate = MBTableGridAggregateCombine(aggregate, MBTableGridAggregateTreeQuery(self.tree, range.location, range.length));
+	}];
+	return aggregate;
+}
+
+- (double)valueForRow:(NSUInteger)rowIndex {
+	return self.tree ? MBTableGridAggregateTreeValue(self.tree, rowIndex) : NAN;
+}
+
+- (MBTableGridAggregate)totalAggregate {
+	return self.tree ? MBTableGridAggregateTreeTotal(self.tree) : MBTableGridAggregateEmpty();
+}
+
+- (NSData *)values {
+	return self.tree ? [NSData dataWithBytes:MBTableGridAggregateTreeValues(self.tree) length:MBTableGridAggregateTreeCount(self.tree) * sizeof(double)] : [NSData data];
+}
+
++ (double)numericValueForObject:(id)value {
+	if ([value isKindOfClass:[NSNumber class]]) {
+		return [value doubleValue];
+	} else if ([value isKindOfClass:[NSString class]]) {
+		return [value length] > 0 ? [value doubleValue] : NAN;
+	} else if ([value isKindOfClass:[NSDate class]]) {
+		return [value timeIntervalSinceReferenceDate];
+	}
+	return NAN;
+}
+
+@end
+
+@implementation MBTableGridStatistics
+
+- (instancetype)initWithAggregate:(MBTableGridAggregate)aggregate {
+	if (self = [super init]) {
+		_sum = aggregate.sum;
+		_count = aggregate.count;
+		_minimum = aggregate.count ? aggregate.minimum : NAN;
+		_maximum = aggregate.count ? aggregate.maximum : NAN;
+		_average = aggregate.count ? aggregate.sum / aggregate.count : NAN;
+	}
+	return self;
+}
+
+@end
@@ -0,0 +1,95 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Cocoa/Cocoa.h>
+
+/**
+ * @brief		\c MBTableGridAutosizer works out how wide columns
+ *				have to be to show the text of their cells.
+ *
+ * @details		Each column is split into chunks of rows that are
+ *				measured in parallel on a background queue, with
+ *				\c MBTableGridTextMeasurer. The widest text of each
+ *				column is handed back on the main thread once every
+ *				chunk has been measured.
+ *
+ *				Cell values come from \c valueProvider. Unless
+ *				\c readsValuesConcurrently is set, values are read
+ *				on the main thread in short batches, between which
+ *				the run loop keeps going. Only the measuring then
+ *				happens in the background.
+ */
+@interface MBTableGridAutosizer : NSObject
+
+/**
+ * @brief		Returns the value of a cell.
+ */
+@property (nonatomic, copy) id (^valueProvider)(NSUInteger columnIndex, NSUInteger rowIndex);
+
+/**
+ * @brief		The formatter for each column, or \c NSNull to
+ *				measure a column's raw values.
+ *
+ * @details		When values are read concurrently, each thread
+ *				formats with its own copies.
+ */
+@property (nonatomic, copy) NSArray *formatters;
+
+/**
+ * @brief		The font for each column's cells, or \c NSNull for
+ *				the system font.
+ */
+@property (nonatomic, copy) NSArray *fonts;
+
+/**
+ * @brief		Whether \c valueProvider can be called from any
+ *				thread. The default is \c NO.
+ */
+@property (nonatomic) BOOL readsValuesConcurrently;
+
+/**
+ * @brief		Whether \c cancel was called.
+ */
+@property (atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+/**
+ * @brief		Measures the given rows of the given columns.
+ *
+ * @param		columnIndexes		The columns to measure.
+ * @param		rowIndexes			The rows to measure.
+ * @param		completionHandler	Called on the main thread with the
+ *									width of the widest text of each
+ *									column, unless the autosizer was
+ *									cancelled.
+ */
+- (void)measureColumns:(NSIndexSet *)columnIndexes rows:(NSIndexSet *)rowIndexes completionHandler:(void (^)(NSDictionary<NSNumber *, NSNumber *> *widthsByColumn))completionHandler;
+
+/**
+ * @brief		Stops measuring. The completion handler isn't
+ *				called.
+ */
+- (void)cancel;
+
+@end
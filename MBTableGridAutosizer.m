@@ -0,0 +1,195 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridAutosizer.h"
+#import "MBTableGridTextMeasurer.h"
+#import "MBTableGridTabularText.h"
+
+// Rows of one column measured together as one unit of work
+static const NSUInteger MBTableGridAutosizerRowsPerChunk = 4096;
+
+// How long values are read on the main thread before the run loop gets a turn
+static const NSTimeInterval MBTableGridAutosizerReadInterval = 0.008;
+
+@interface MBTableGridAutosizer ()
+
+@property (atomic, readwrite, getter=isCancelled) BOOL cancelled;
+
+@property (nonatomic) NSUInteger numberOfRows;
+@property (nonatomic) NSUInteger numberOfRowChunks;
+@property (nonatomic, strong) NSData *columnData;
+@property (nonatomic, strong) NSData *rowData;
+@property (nonatomic, strong) NSMutableData *chunkWidths;
+@property (nonatomic, strong) NSArray<MBTableGridTextMeasurer *> *measurers;
+@property (nonatomic, strong) dispatch_group_t group;
+
+@end
+
+@implementation MBTableGridAutosizer
+
+- (void)cancel {
+	self.cancelled = YES;
+}
+
+- (void)measureColumns:(NSIndexSet *)columnIndexes rows:(NSIndexSet *)rowIndexes completionHandler:(void (^)(NSDictionary<NSNumber *, NSNumber *> *widthsByColumn))completionHandler {
+	NSUInteger numberOfColumns = columnIndexes.count;
+	self.numberOfRows = rowIndexes.count;
+	self.numberOfRowChunks = (self.numberOfRows + MBTableGridAutosizerRowsPerChunk - 1) / MBTableGridAutosizerRowsPerChunk;
+	self.group = dispatch_group_create();
+	
+	// Keep the columns and rows in flat buffers, so a chunk is just a column and a range of rows
+	NSMutableData *columnData = [NSMutableData dataWithLength:MAX(numberOfColumns, 1) * sizeof(NSUInteger)];
+	[columnIndexes getIndexes:columnData.mutableBytes maxCount:numberOfColumns inIndexRange:nil];
+	self.columnData = columnData;
+	
+	NSMutableData *rowData = [NSMutableData dataWithLength:MAX(self.numberOfRows, 1) * sizeof(NSUInteger)];
+	[rowIndexes getIndexes:rowData.mutableBytes maxCount:self.numberOfRows inIndexRange:nil];
+	self.rowData = rowData;
+	
+	// Each chunk writes only its own width, so they need no locking
+	NSUInteger numberOfChunks = numberOfColumns * self.numberOfRowChunks;
+	self.chunkWidths = [NSMutableData dataWithLength:MAX(numberOfChunks, 1) * sizeof(CGFloat)];
+	
+	// Look up each column's measurer once, rather than for every chunk
+	NSMutableArray<MBTableGridTextMeasurer *> *measurers = [NSMutableArray arrayWithCapacity:numberOfColumns];
+	for (NSUInteger index = 0; index < numberOfColumns; index++) {
+		NSUInteger column = ((const NSUInteger *)columnData.bytes)[index];
+		NSFont *font = column < self.fonts.count ? self.fonts[column] : nil;
+		[measurers addObject:[MBTableGridTextMeasurer measurerForFont:(id)font == [NSNull null] ? nil : font]];
+	}
+	self.measurers = measurers;
+	
+	dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+	
+	if (self.readsValuesConcurrently) {
+		// Formatters aren't thread-safe, so each worker formats with its own copies
+		NSArray<NSArray *> *formatterCopies = [MBTableGridTabularText formatterCopiesForWorkers:self.formatters];
+		dispatch_group_async(self.group, queue, ^{
+			[MBTableGridTabularText applyChunks:numberOfChunks formatterCopies:formatterCopies queue:queue block:^(NSUInteger chunk, NSArray *formatters) {
+				if (!self.cancelled) {
+					[self _measureChunk:chunk strings:[self _stringsInChunk:chunk formatters:formatters]];
+				}
+			}];
+		});
+		[self _notifyCompletion:completionHandler];
+	} else {
+		[self _readChunksFromChunk:0 numberOfChunks:numberOfChunks completionHandler:completionHandler];
+	}
+}
+
+- (void)_readChunksFromChunk:(NSUInteger)firstChunk numberOfChunks:(NSUInteger)numberOfChunks completionHandler:(void (^)(NSDictionary<NSNumber *, NSNumber *> *widthsByColumn))completionHandler {
+	if (self.cancelled) {
+		return;
+	}
+	
+	// Read as many chunks as fit in a short interval, then measure them in the background while reading goes on
+	NSMutableArray<NSArray<NSString *> *> *chunkStrings = [NSMutableArray array];
+	NSDate *start = [NSDate date];
+	NSUInteger chunk = firstChunk;
+	while (chunk < numberOfChunks && (chunkStrings.count == 0 || -[start timeIntervalSinceNow] < MBTableGridAutosizerReadInterval)) {
+		[chunkStrings addObject:[self _stringsInChunk:chunk formatters:self.formatters]];
+		chunk++;
+	}
+	
+	if (chunkStrings.count > 0) {
+		dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+		dispatch_group_async(self.group, queue, ^{
+			dispatch_apply(chunkStrings.count, queue, ^(size_t index) {
+				if (!self.cancelled) {
+					[self _measureChunk:firstChunk + index strings:chunkStrings[index]];
+				}
+			});
+		});
+	}
+	
+	if (chunk < numberOfChunks) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self _readChunksFromChunk:chunk numberOfChunks:numberOfChunks completionHandler:completionHandler];
+		});
+	} else {
+		[self _notifyCompletion:completionHandler];
+	}
+}
+
+- (void)_notifyCompletion:(void (^)(NSDictionary<NSNumber *, NSNumber *> *widthsByColumn))completionHandler {
+	dispatch_group_notify(self.group, dispatch_get_main_queue(), ^{
+		if (self.cancelled || !completionHandler) {
+			return;
+		}
+		
+		// Every chunk has been measured, so the widest of each column's chunks is its width
+		const NSUInteger *columns = self.columnData.bytes;
+		const CGFloat *chunkWidths = self.chunkWidths.bytes;
+		NSUInteger numberOfColumns = self.measurers.count;
+		NSMutableDictionary<NSNumber *, NSNumber *> *widthsByColumn = [NSMutableDictionary dictionaryWithCapacity:numberOfColumns];
+		for (NSUInteger index = 0; index < numberOfColumns; index++) {
+			CGFloat width = 0;
+			for (NSUInteger rowChunk = 0; rowChunk < self.numberOfRowChunks; rowChunk++) {
+				width = MAX(width, chunkWidths[index * self.numberOfRowChunks + rowChunk]);
+			}
+			widthsByColumn[@(columns[index])] = @(width);
+		}
+		completionHandler(widthsByColumn);
+	});
+}
+
+#pragma mark -
+#pragma mark Chunks
+
+- (NSRange)_rowRangeOfChunk:(NSUInteger)chunk {
+	NSUInteger location = (chunk % self.numberOfRowChunks) * MBTableGridAutosizerRowsPerChunk;
+	return NSMakeRange(location, MIN(MBTableGridAutosizerRowsPerChunk, self.numberOfRows - location));
+}
+
+- (NSArray<NSString *> *)_stringsInChunk:(NSUInteger)chunk formatters:(NSArray *)formatters {
+	NSRange range = [self _rowRangeOfChunk:chunk];
+	const NSUInteger *rows = (const NSUInteger *)self.rowData.bytes + range.location;
+	NSUInteger column = ((const NSUInteger *)self.columnData.bytes)[chunk / self.numberOfRowChunks];
+	NSFormatter *formatter = column < formatters.count ? formatters[column] : nil;
+	if ((id)formatter == [NSNull null]) {
+		formatter = nil;
+	}
+	
+	NSMutableArray<NSString *> *strings = [NSMutableArray arrayWithCapacity:range.length];
+	for (NSUInteger i = 0; i < range.length; i++) {
+		id value = self.valueProvider(column, rows[i]);
+		[strings addObject:[MBTableGridTabularText stringForValue:value formatter:formatter]];
+	}
+	
+	return strings;
+}
+
+- (void)_measureChunk:(NSUInteger)chunk strings:(NSArray<NSString *> *)strings {
+	MBTableGridTextMeasurer *measurer = self.measurers[chunk / self.numberOfRowChunks];
+	CGFloat width = 0;
+	for (NSString *string in strings) {
+		if (string.length > 0) {
+			width = MAX(width, [measurer widthOfString:string]);
+		}
+	}
+	((CGFloat *)self.chunkWidths.mutableBytes)[chunk] = width;
+}
+
+@end
@@ -43,6 +43,12 @@
 @property (nonatomic, strong) NSImage *accessoryButtonImage;
 @property (nonatomic) BOOL editWithPopupMenu;
 @property (nonatomic) BOOL isGroupRow;
+
+/**
+ * @brief		The space left before the text, such as for the
+ *				disclosure triangle of a group heading.
+ */
+@property (nonatomic) CGFloat indentation;
 @property (nonatomic) BOOL isLastColumn;
 
 - (void)drawWithFrame:(NSRect)cellFrame inView:(NSView *)controlView withBackgroundColor:(NSColor *)backgroundColor  textColor:(NSColor *)textColor;
@@ -101,6 +101,8 @@
 
 	static CGFloat TEXT_PADDING = 4;
 	cellFrame = NSInsetRect(cellFrame, TEXT_PADDING, 0);
+	cellFrame.origin.x += self.indentation;
+	cellFrame.size.width -= self.indentation;
 	if (self.isGroupRow) {
 		cellFrame.origin.y -= 1;
 	} else {
@@ -0,0 +1,109 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief		\c MBTableGridColumnEdit holds the values to store
+ *				in a set of rows of a single column.
+ *
+ * @details		Each distinct value is stored once, and every row
+ *				refers to its value through a packed 32-bit index,
+ *				so an edit covering many rows with few distinct
+ *				values stays small. Values are shared by identity,
+ *				or by equality for strings, so rows get back the
+ *				same kind of object they were given; values that
+ *				conform to \c NSCopying are copied. Edits are used
+ *				both to apply bulk changes and, holding the previous
+ *				values, as the single undo record for those changes.
+ *
+ *				Rows must be added in ascending order.
+ */
+@interface MBTableGridColumnEdit : NSObject
+
+/**
+ * @brief		Creates an empty edit for a column.
+ */
+- (instancetype)initWithColumn:(NSUInteger)columnIndex;
+
+/**
+ * @brief		Creates an edit that stores the same value in
+ *				every row of \c rowIndexes.
+ */
++ (instancetype)editWithColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes value:(id)value;
+
+/**
+ * @brief		The column the edit applies to.
+ */
+@property (nonatomic, readonly) NSUInteger column;
+
+/**
+ * @brief		The rows the edit applies to.
+ */
+@property (nonatomic, readonly) NSIndexSet *rowIndexes;
+
+/**
+ * @brief		The number of rows in the edit.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * @brief		The number of distinct values in the edit.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfDistinctValues;
+
+/**
+ * @brief		The approximate number of bytes used by the edit,
+ *				including the strings and data it holds.
+ */
+@property (nonatomic, readonly) NSUInteger estimatedMemoryCost;
+
+/**
+ * @brief		Adds the value for a row. \c nil is allowed.
+ */
+- (void)addValue:(id)value forRow:(NSUInteger)rowIndex;
+
+/**
+ * @brief		Returns the value for the row at \c index in
+ *				\c rowIndexes, or \c nil.
+ */
+- (id)valueAtIndex:(NSUInteger)index;
+
+/**
+ * @brief		Calls \c block once for each distinct value, with
+ *				all the rows that take that value.
+ *
+ * @details		The value passed to the block is \c nil for rows
+ *				that were added with a \c nil value.
+ */
+- (void)enumerateRowsByValueUsingBlock:(void (^)(id value, NSIndexSet *rowIndexes, BOOL *stop))block;
+
+/**
+ * @brief		Calls \c block once for each row, in ascending
+ *				order.
+ */
+- (void)enumerateValuesUsingBlock:(void (^)(id value, NSUInteger rowIndex, BOOL *stop))block;
+
+@end
@@ -0,0 +1,181 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridColumnEdit.h"
+
+@interface MBTableGridColumnEdit ()
+
+@property (nonatomic, strong) NSMutableIndexSet *rows;
+@property (nonatomic, strong) NSMutableData *valueIndexes;
+@property (nonatomic, strong) NSMutableArray *values;
+@property (nonatomic, strong) NSMapTable *indexesByValue;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *indexesByString;
+
+@end
+
+@implementation MBTableGridColumnEdit
+
+- (instancetype)initWithColumn:(NSUInteger)columnIndex {
+	if (self = [super init]) {
+		_column = columnIndex;
+		_rows = [NSMutableIndexSet indexSet];
+		_valueIndexes = [NSMutableData data];
+		_values = [NSMutableArray array];
+		_indexesByValue = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory capacity:0];
+		_indexesByString = [NSMutableDictionary dictionary];
+	}
+	return self;
+}
+
++ (instancetype)editWithColumn:(NSUInteger)columnIndex rows:(NSIndexSet *)rowIndexes value:(id)value {
+	MBTableGridColumnEdit *edit = [[self alloc] initWithColumn:columnIndex];
+	
+	// Every row refers to the first value, so the index buffer is just zeroes
+	[edit _indexOfValue:value];
+	[edit.rows addIndexes:rowIndexes];
+	edit.valueIndexes.length = rowIndexes.count * sizeof(uint32_t);
+	return edit;
+}
+
+- (NSNumber *)_indexOfValue:(id)value {
+	id key = value ?: [NSNull null];
+	NSNumber *index = [self.indexesByValue objectForKey:key];
+	if (index) {
+		return index;
+	}
+	
+	// Copy mutable values so that later changes to them don't reach the edit
+	if ([key conformsToProtocol:@protocol(NSCopying)]) {
+		key = [key copy];
+	}
+	
+	// Strings that compare equal format the same whatever their class, so they
+	// share a slot. Any other value shares only with itself, so that @YES and
+	// @1, or an NSDecimalNumber and an equal NSNumber, keep their own types.
+	BOOL isString = [key isKindOfClass:[NSString class]];
+	if (isString) {
+		index = self.indexesByString[key];
+	}
+	if (!index) {
+		index = @(self.values.count);
+		[self.values addObject:key];
+		[self.indexesByValue setObject:index forKey:key];
+		if (isString) {
+			self.indexesByString[key] = index;
+		}
+	}
+	return index;
+}
+
+- (NSIndexSet *)rowIndexes {
+	return self.rows;
+}
+
+- (NSUInteger)count {
+	return self.rows.count;
+}
+
+- (NSUInteger)numberOfDistinctValues {
+	return self.values.count;
+}
+
+- (NSUInteger)estimatedMemoryCost {
+	// An object and map table slot per distinct value, plus the packed indexes
+	NSUInteger cost = 64 + self.valueIndexes.length + self.values.count * 48;
+	
+	for (id value in self.values) {
+		if ([value isKindOfClass:[NSString class]]) {
+			cost += [value length] * sizeof(unichar);
+		} else if ([value isKindOfClass:[NSData class]]) {
+			cost += [value length];
+		}
+	}
+	
+	// Contiguous rows are stored as ranges
+	__block NSUInteger numberOfRanges = 0;
+	[self.rows enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+		numberOfRanges++;
+	}];
+	
+	return cost + numberOfRanges * sizeof(NSRange);
+}
+
+- (void)addValue:(id)value forRow:(NSUInteger)rowIndex {
+	NSAssert(self.rows.count == 0 || rowIndex > self.rows.lastIndex, @"Rows must be added in ascending order");
+	
+	uint32_t valueIndex = (uint32_t)[self _indexOfValue:value].unsignedIntegerValue;
+	[self.valueIndexes appendBytes:&valueIndex length:sizeof(uint32_t)];
+	[self.rows addIndex:rowIndex];
+}
+
+- (id)valueAtIndex:(NSUInteger)index {
+	const uint32_t *valueIndexes = self.valueIndexes.bytes;
+	id value = self.values[valueIndexes[index]];
+	return value == [NSNull null] ? nil : value;
+}
+
+- (void)enumerateRowsByValueUsingBlock:(void (^)(id value, NSIndexSet *rowIndexes, BOOL *stop))block {
+	NSUInteger numberOfValues = self.values.count;
+	if (numberOfValues == 0) {
+		return;
+	}
+	
+	BOOL stop = NO;
+	
+	if (numberOfValues == 1) {
+		id value = self.values[0];
+		block(value == [NSNull null] ? nil : value, self.rows, &stop);
+		return;
+	}
+	
+	// Bucket the rows by value in a single pass over the packed indexes
+	NSMutableArray<NSMutableIndexSet *> *rowsByValue = [NSMutableArray arrayWithCapacity:numberOfValues];
+	for (NSUInteger i = 0; i < numberOfValues; i++) {
+		[rowsByValue addObject:[NSMutableIndexSet indexSet]];
+	}
+	
+	const uint32_t *valueIndexes = self.valueIndexes.bytes;
+	__block NSUInteger position = 0;
+	[self.rows enumerateIndexesUsingBlock:^(NSUInteger rowIndex, BOOL *stopRows) {
+		[rowsByValue[valueIndexes[position++]] addIndex:rowIndex];
+	}];
+	
+	for (NSUInteger i = 0; i < numberOfValues && !stop; i++) {
+		id value = self.values[i];
+		block(value == [NSNull null] ? nil : value, rowsByValue[i], &stop);
+	}
+}
+
+- (void)enumerateValuesUsingBlock:(void (^)(id value, NSUInteger rowIndex, BOOL *stop))block {
+	const uint32_t *valueIndexes = self.valueIndexes.bytes;
+	NSArray *values = self.values;
+	__block NSUInteger position = 0;
+	[self.rows enumerateIndexesUsingBlock:^(NSUInteger rowIndex, BOOL *stop) {
+		id value = values[valueIndexes[position++]];
+		block(value == [NSNull null] ? nil : value, rowIndex, stop);
+	}];
+}
+
+@end
@@ -0,0 +1,122 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Cocoa/Cocoa.h>
+
+/**
+ * @brief		\c MBTableGridColumnStatistics summarises the cells
+ *				of a column: how many are empty, the range and
+ *				spread of their numeric values, how often each
+ *				value occurs and how wide the widest is.
+ *
+ * @details		Autosizing, filter value lists and type-ahead all
+ *				need these, and would otherwise each read the whole
+ *				column through the data source. Statistics are
+ *				worked out once on a background queue, in parallel
+ *				chunks that are merged, and don't change after that.
+ *				\c MBTableGrid keeps them until the column is edited
+ *				or reloaded.
+ */
+@interface MBTableGridColumnStatistics : NSObject
+
+/**
+ * @brief		Works out statistics on a background queue.
+ *
+ * @param		values		The cells to count, with \c NSNull for
+ *							empty cells.
+ * @param		formatter	The formatter cells are shown with, or
+ *							\c nil. It is copied before this returns,
+ *							once for each background thread.
+ * @param		font		The font to measure the text of cells in.
+ * @param		maximumDistinctValues	The most values to count in
+ *										\c valueCounts.
+ * @param		completionHandler	Called on the main queue with the
+ *									statistics.
+ */
++ (void)buildStatisticsWithValues:(NSArray *)values formatter:(NSFormatter *)formatter font:(NSFont *)font maximumDistinctValues:(NSUInteger)maximumDistinctValues completionHandler:(void (^)(MBTableGridColumnStatistics *statistics))completionHandler;
+
+/**
+ * @brief		The number of cells, empty ones included.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfValues;
+
+/**
+ * @brief		The number of empty cells: \c nil, \c NSNull or an
+ *				empty string.
+ */
+@property (nonatomic, readonly) NSUInteger nullCount;
+
+/**
+ * @brief		The smallest numeric value, or NaN if there are
+ *				none. Cells count the same way as in the grid's
+ *				aggregates.
+ */
+@property (nonatomic, readonly) double minimum;
+
+/**
+ * @brief		The largest numeric value, or NaN if there are
+ *				none.
+ */
+@property (nonatomic, readonly) double maximum;
+
+/**
+ * @brief		The number of numeric values in each of a number of
+ *				equally wide bins from \c minimum to \c maximum.
+ *				Empty if there are no numeric values.
+ */
+@property (nonatomic, readonly) NSArray<NSNumber *> *histogram;
+
+/**
+ * @brief		The number of cells with each text, as shown, for
+ *				up to \c maximumDistinctValues different texts.
+ *				Empty cells aren't counted.
+ *
+ * @details		Counts are exact when \c hasAllDistinctValues is
+ *				set. Otherwise the column has more texts than this
+ *				holds, and they are summarized with the Misra-Gries
+ *				algorithm: every text in more than 1 of every
+ *				\c maximumDistinctValues + 1 cells is kept, and
+ *				each count is too low by at most that many cells.
+ */
+@property (nonatomic, readonly) NSDictionary<NSString *, NSNumber *> *valueCounts;
+
+/**
+ * @brief		Whether \c valueCounts holds every different text
+ *				in the column.
+ */
+@property (nonatomic, readonly) BOOL hasAllDistinctValues;
+
+/**
+ * @brief		The width of the widest text, as shown, in the font
+ *				the statistics were built with.
+ */
+@property (nonatomic, readonly) CGFloat maximumTextWidth;
+
+/**
+ * @brief		The text in \c valueCounts, most frequent first.
+ */
+- (NSArray<NSString *> *)valuesByFrequency;
+
+@end
@@ -0,0 +1,219 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridColumnStatistics.h"
+#import "MBTableGridAggregates.h"
+#import "MBTableGridTabularText.h"
+#import "MBTableGridTextMeasurer.h"
+
+// Cells are counted in parallel chunks of this size, then merged
+static const NSUInteger MBTableGridColumnStatisticsChunkLength = 65536;
+
+// The number of bins in the histogram
+static const NSUInteger MBTableGridColumnStatisticsNumberOfBins = 32;
+
+typedef struct {
+	NSUInteger nullCount;
+	double minimum;
+	double maximum;
+	CGFloat maximumTextWidth;
+	BOOL didOverflow;
+} MBTableGridColumnStatisticsChunk;
+
+@interface MBTableGridColumnStatistics ()
+
+@property (nonatomic, readwrite) NSUInteger numberOfValues;
+@property (nonatomic, readwrite) NSUInteger nullCount;
+@property (nonatomic, readwrite) double minimum;
+@property (nonatomic, readwrite) double maximum;
+@property (nonatomic, strong, readwrite) NSArray<NSNumber *> *histogram;
+@property (nonatomic, strong, readwrite) NSDictionary<NSString *, NSNumber *> *valueCounts;
+@property (nonatomic, readwrite) BOOL hasAllDistinctValues;
+@property (nonatomic, readwrite) CGFloat maximumTextWidth;
+
+@end
+
+// Takes amount off every count, dropping the texts that reach zero
+static void MBTableGridReduceValueCounts(NSMutableDictionary<NSString *, NSNumber *> *counts, NSUInteger amount) {
+	for (NSString *string in counts.allKeys) {
+		NSUInteger valueCount = counts[string].unsignedIntegerValue;
+		if (valueCount > amount) {
+			counts[string] = @(valueCount - amount);
+		} else {
+			[counts removeObjectForKey:string];
+		}
+	}
+}
+
+@implementation MBTableGridColumnStatistics
+
++ (void)buildStatisticsWithValues:(NSArray *)values formatter:(NSFormatter *)formatter font:(NSFont *)font maximumDistinctValues:(NSUInteger)maximumDistinctValues completionHandler:(void (^)(MBTableGridColumnStatistics *statistics))completionHandler {
+	// Formatters aren't thread-safe, so each worker gets its own copy, made here on the caller's thread
+	NSArray<NSArray *> *formatterCopies = [MBTableGridTabularText formatterCopiesForWorkers:@[formatter ?: [NSNull null]]];
+	
+	dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+		NSUInteger count = values.count;
+		NSUInteger numberOfChunks = MAX((count + MBTableGridColumnStatisticsChunkLength - 1) / MBTableGridColumnStatisticsChunkLength, 1);
+		MBTableGridTextMeasurer *measurer = [MBTableGridTextMeasurer measurerForFont:font];
+		
+		MBTableGridColumnStatisticsChunk *chunks = calloc(numberOfChunks, sizeof(MBTableGridColumnStatisticsChunk));
+		double *numericValues = malloc(MAX(count, 1) * sizeof(double));
+		NSUInteger *bins = calloc(numberOfChunks * MBTableGridColumnStatisticsNumberOfBins, sizeof(NSUInteger));
+		NSMutableArray<NSMutableDictionary<NSString *, NSNumber *> *> *chunkCounts = [NSMutableArray arrayWithCapacity:numberOfChunks];
+		for (NSUInteger chunk = 0; chunk < numberOfChunks; chunk++) {
+			[chunkCounts addObject:[NSMutableDictionary dictionary]];
+		}
+		
+		if (!chunks || !numericValues || !bins) {
+			free(chunks);
+			free(numericValues);
+			free(bins);
+			dispatch_async(dispatch_get_main_queue(), ^{
+				completionHandler(nil);
+			});
+			return;
+		}
+		
+		[MBTableGridTabularText applyChunks:numberOfChunks formatterCopies:formatterCopies queue:dispatch_get_global_queue(QOS_CLASS_UTILITY, 0) block:^(NSUInteger chunk, NSArray *workerFormatters) {
+			id workerFormatter = workerFormatters.firstObject;
+			NSFormatter *chunkFormatter = workerFormatter == [NSNull null] ? nil : workerFormatter;
+			NSUInteger start = chunk * MBTableGridColumnStatisticsChunkLength;
+			NSUInteger end = MIN(start + MBTableGridColumnStatisticsChunkLength, count);
+			MBTableGridColumnStatisticsChunk *chunkStatistics = &chunks[chunk];
+			NSMutableDictionary<NSString *, NSNumber *> *counts = chunkCounts[chunk];
+			chunkStatistics->minimum = NAN;
+			chunkStatistics->maximum = NAN;
+			
+			for (NSUInteger row = start; row < end; row++) @autoreleasepool {
+				id value = values[row];
+				numericValues[row] = [MBTableGridColumnAggregates numericValueForObject:value];
+				if (!isnan(numericValues[row])) {
+					chunkStatistics->minimum = isnan(chunkStatistics->minimum) ? numericValues[row] : MIN(chunkStatistics->minimum, numericValues[row]);
+					chunkStatistics->maximum = isnan(chunkStatistics->maximum) ? numericValues[row] : MAX(chunkStatistics->maximum, numericValues[row]);
+				}
+				
+				NSString *string = [MBTableGridTabularText stringForValue:value formatter:chunkFormatter];
+				if (string.length == 0) {
+					chunkStatistics->nullCount++;
+					continue;
+				}
+				
+				// Once the chunk has as many texts as are kept, a new text and one of each kept
+				// text cancel out (Misra-Gries), so that frequent texts are kept wherever they start
+				NSNumber *valueCount = counts[string];
+				if (valueCount) {
+					counts[string] = @(valueCount.unsignedIntegerValue + 1);
+				} else if (counts.count < maximumDistinctValues) {
+					counts[string] = @1;
+				} else {
+					chunkStatistics->didOverflow = YES;
+					MBTableGridReduceValueCounts(counts, 1);
+				}
+				
+				chunkStatistics->maximumTextWidth = MAX(chunkStatistics->maximumTextWidth, [measurer widthOfString:string]);
+			}
+		}];
+		
+		MBTableGridColumnStatistics *statistics = [[MBTableGridColumnStatistics alloc] init];
+		statistics.numberOfValues = count;
+		statistics.minimum = NAN;
+		statistics.maximum = NAN;
+		
+		BOOL didOverflow = NO;
+		NSMutableDictionary<NSString *, NSNumber *> *valueCounts = chunkCounts[0];
+		for (NSUInteger chunk = 0; chunk < numberOfChunks; chunk++) {
+			MBTableGridColumnStatisticsChunk chunkStatistics = chunks[chunk];
+			statistics.nullCount += chunkStatistics.nullCount;
+			statistics.maximumTextWidth = MAX(statistics.maximumTextWidth, chunkStatistics.maximumTextWidth);
+			if (!isnan(chunkStatistics.minimum)) {
+				statistics.minimum = isnan(statistics.minimum) ? chunkStatistics.minimum : MIN(statistics.minimum, chunkStatistics.minimum);
+				statistics.maximum = isnan(statistics.maximum) ? chunkStatistics.maximum : MAX(statistics.maximum, chunkStatistics.maximum);
+			}
+			didOverflow = didOverflow || chunkStatistics.didOverflow;
+			if (chunk > 0) {
+				[chunkCounts[chunk] enumerateKeysAndObjectsUsingBlock:^(NSString *string, NSNumber *valueCount, BOOL *stop) {
+					valueCounts[string] = @(valueCounts[string].unsignedIntegerValue + valueCount.unsignedIntegerValue);
+				}];
+			}
+		}
+		
+		// Chunks may each have kept different texts. Taking the count of the first text that
+		// doesn't fit off all of them merges the summaries with the same guarantee.
+		if (valueCounts.count > maximumDistinctValues) {
+			didOverflow = YES;
+			NSArray<NSString *> *strings = [valueCounts keysSortedByValueUsingComparator:^NSComparisonResult(NSNumber *count1, NSNumber *count2) {
+				return [count2 compare:count1];
+			}];
+			MBTableGridReduceValueCounts(valueCounts, valueCounts[strings[maximumDistinctValues]].unsignedIntegerValue);
+		}
+		statistics.valueCounts = [valueCounts copy];
+		statistics.hasAllDistinctValues = !didOverflow;
+		
+		// The range is only known now, so the values are binned in a second pass
+		if (!isnan(statistics.minimum)) {
+			double minimum = statistics.minimum;
+			double binWidth = (statistics.maximum - minimum) / MBTableGridColumnStatisticsNumberOfBins;
+			dispatch_apply(numberOfChunks, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^(size_t chunk) {
+				NSUInteger *chunkBins = &bins[chunk * MBTableGridColumnStatisticsNumberOfBins];
+				NSUInteger end = MIN((chunk + 1) * MBTableGridColumnStatisticsChunkLength, count);
+				for (NSUInteger row = chunk * MBTableGridColumnStatisticsChunkLength; row < end; row++) {
+					if (isnan(numericValues[row])) {
+						continue;
+					}
+					NSUInteger bin = binWidth > 0 ? (NSUInteger)((numericValues[row] - minimum) / binWidth) : 0;
+					chunkBins[MIN(bin, MBTableGridColumnStatisticsNumberOfBins - 1)]++;
+				}
+			});
+			
+			NSMutableArray<NSNumber *> *histogram = [NSMutableArray arrayWithCapacity:MBTableGridColumnStatisticsNumberOfBins];
+			for (NSUInteger bin = 0; bin < MBTableGridColumnStatisticsNumberOfBins; bin++) {
+				NSUInteger binCount = 0;
+				for (NSUInteger chunk = 0; chunk < numberOfChunks; chunk++) {
+					binCount += bins[chunk * MBTableGridColumnStatisticsNumberOfBins + bin];
+				}
+				[histogram addObject:@(binCount)];
+			}
+			statistics.histogram = histogram;
+		} else {
+			statistics.histogram = @[];
+		}
+		
+		free(chunks);
+		free(numericValues);
+		free(bins);
+		
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completionHandler(statistics);
+		});
+	});
+}
+
+- (NSArray<NSString *> *)valuesByFrequency {
+	return [self.valueCounts keysSortedByValueUsingComparator:^NSComparisonResult(NSNumber *count1, NSNumber *count2) {
+		return [count2 compare:count1];
+	}];
+}
+
+@end
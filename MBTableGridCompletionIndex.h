@@ -0,0 +1,132 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief		\c MBTableGridCompletionIndex keeps the distinct
+ *				string values of a column in a form that can be
+ *				searched by prefix.
+ *
+ * @details		Values are case folded and kept in a sorted array,
+ *				so all values with a given prefix are next to each
+ *				other. Finding them is a binary search followed by
+ *				a walk over the matches, which is O(log n + N) for
+ *				N matches, however many rows the column has.
+ *
+ *				Each distinct value keeps a count of the cells that
+ *				hold it, so that values can be added and removed as
+ *				cells change without rescanning the column.
+ *
+ *				The index can be searched from a background queue
+ *				while it is being changed on the main thread.
+ */
+@interface MBTableGridCompletionIndex : NSObject
+
+/**
+ * @brief		Creates an index from all the values of a column.
+ *
+ * @details		Sorting once is faster than adding the strings one
+ *				by one. Values that are not strings are ignored.
+ */
+- (instancetype)initWithStrings:(NSArray<NSString *> *)strings;
+
+/**
+ * @brief		The number of distinct values in the index.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ * @brief		Adds a value from a cell.
+ */
+- (void)addString:(NSString *)string;
+
+/**
+ * @brief		Removes a value that a cell no longer holds.
+ */
+- (void)removeString:(NSString *)string;
+
+/**
+ * @brief		Returns up to \c maximumCount values that start
+ *				with \c prefix, ignoring case, in sorted order.
+ *
+ * @details		Values are returned as they were first entered.
+ */
+- (NSArray<NSString *> *)completionsForPrefix:(NSString *)prefix maximumCount:(NSUInteger)maximumCount;
+
+@end
+
+/**
+ * @brief		\c MBTableGridCompletionIndexBuilder reads the values
+ *				of a column and builds an \c MBTableGridCompletionIndex
+ *				from them without holding up the main thread.
+ *
+ * @details		Cell values come from \c valueProvider. Unless
+ *				\c readsValuesConcurrently is set, values are read
+ *				and formatted on the main thread in short batches,
+ *				between which the run loop keeps going. Only the
+ *				index is then built in the background.
+ */
+@interface MBTableGridCompletionIndexBuilder : NSObject
+
+/**
+ * @brief		Returns the value of a cell in the column.
+ */
+@property (nonatomic, copy) id (^valueProvider)(NSUInteger rowIndex);
+
+/**
+ * @brief		The formatter for the column, or \c nil to index
+ *				its raw values.
+ */
+@property (nonatomic, strong) NSFormatter *formatter;
+
+/**
+ * @brief		Whether \c valueProvider can be called from any
+ *				thread. The default is \c NO.
+ */
+@property (nonatomic) BOOL readsValuesConcurrently;
+
+/**
+ * @brief		Whether \c cancel was called.
+ */
+@property (atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+/**
+ * @brief		Builds an index from the values of the given rows.
+ *
+ * @param		rowIndexes			The rows to index.
+ * @param		completionHandler	Called on the main thread with the
+ *									index, unless the builder was
+ *									cancelled first.
+ */
+- (void)buildIndexWithRows:(NSIndexSet *)rowIndexes completionHandler:(void (^)(MBTableGridCompletionIndex *completionIndex))completionHandler;
+
+/**
+ * @brief		Stops building. The completion handler won't be
+ *				called.
+ */
+- (void)cancel;
+
+@end
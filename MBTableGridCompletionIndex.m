@@ -0,0 +1,261 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridCompletionIndex.h"
+#import "MBTableGridTabularText.h"
+
+// Rows read between checks of how long reading has taken
+static const NSUInteger MBTableGridCompletionIndexRowsPerBatch = 256;
+
+// How long values are read on the main thread before the run loop gets a turn
+static const NSTimeInterval MBTableGridCompletionIndexReadInterval = 0.008;
+
+@interface MBTableGridCompletionEntry : NSObject
+
+@property (nonatomic, copy) NSString *string;
+@property (nonatomic) NSUInteger count;
+
+@end
+
+@implementation MBTableGridCompletionEntry
+@end
+
+@interface MBTableGridCompletionIndex ()
+
+// Case folded keys, sorted by UTF-16 code unit so that a prefix is always a contiguous range
+@property (nonatomic, strong) NSMutableArray<NSString *> *sortedKeys;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, MBTableGridCompletionEntry *> *entries;
+
+@end
+
+@implementation MBTableGridCompletionIndex
+
+static NSString *MBTableGridCompletionKey(NSString *string) {
+	return [string stringByFoldingWithOptions:NSCaseInsensitiveSearch locale:nil];
+}
+
+static NSComparisonResult MBTableGridCompareKeys(NSString *key, NSString *otherKey) {
+	return [key compare:otherKey options:NSLiteralSearch];
+}
+
+- (instancetype)init {
+	return [self initWithStrings:@[]];
+}
+
+- (instancetype)initWithStrings:(NSArray<NSString *> *)strings {
+	if (self = [super init]) {
+		_entries = [NSMutableDictionary dictionaryWithCapacity:strings.count];
+		
+		for (NSString *string in strings) {
+			if (![string isKindOfClass:[NSString class]] || string.length == 0) {
+				continue;
+			}
+			
+			NSString *key = MBTableGridCompletionKey(string);
+			MBTableGridCompletionEntry *entry = _entries[key];
+			if (!entry) {
+				entry = [MBTableGridCompletionEntry new];
+				entry.string = string;
+				_entries[key] = entry;
+			}
+			entry.count++;
+		}
+		
+		_sortedKeys = [[_entries.allKeys sortedArrayUsingComparator:^NSComparisonResult(NSString *key, NSString *otherKey) {
+			return MBTableGridCompareKeys(key, otherKey);
+		}] mutableCopy];
+	}
+	return self;
+}
+
+- (NSUInteger)count {
+	@synchronized (self) {
+		return self.sortedKeys.count;
+	}
+}
+
+- (NSUInteger)_indexOfFirstKeyNotBefore:(NSString *)key {
+	NSUInteger low = 0;
+	NSUInteger high = self.sortedKeys.count;
+	while (low < high) {
+		NSUInteger middle = low + (high - low) / 2;
+		if (MBTableGridCompareKeys(self.sortedKeys[middle], key) == NSOrderedAscending) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+- (void)addString:(NSString *)string {
+	if (![string isKindOfClass:[NSString class]] || string.length == 0) {
+		return;
+	}
+	
+	NSString *key = MBTableGridCompletionKey(string);
+	@synchronized (self) {
+		MBTableGridCompletionEntry *entry = self.entries[key];
+		if (!entry) {
+			entry = [MBTableGridCompletionEntry new];
+			entry.string = string;
+			self.entries[key] = entry;
+			[self.sortedKeys insertObject:key atIndex:[self _indexOfFirstKeyNotBefore:key]];
+		}
+		entry.count++;
+	}
+}
+
+- (void)removeString:(NSString *)string {
+	if (![string isKindOfClass:[NSString class]] || string.length == 0) {
+		return;
+	}
+	
+	NSString *key = MBTableGridCompletionKey(string);
+	@synchronized (self) {
+		MBTableGridCompletionEntry *entry = self.entries[key];
+		if (!entry) {
+			return;
+		}
+		
+		if (--entry.count == 0) {
+			[self.entries removeObjectForKey:key];
+			[self.sortedKeys removeObjectAtIndex:[self _indexOfFirstKeyNotBefore:key]];
+		}
+	}
+}
+
+- (NSArray<NSString *> *)completionsForPrefix:(NSString *)prefix maximumCount:(NSUInteger)maximumCount {
+	if (prefix.length == 0 || maximumCount == 0) {
+		return @[];
+	}
+	
+	NSString *prefixKey = MBTableGridCompletionKey(prefix);
+	NSMutableArray<NSString *> *completions = [NSMutableArray array];
+	
+	@synchronized (self) {
+		NSUInteger numberOfKeys = self.sortedKeys.count;
+		for (NSUInteger index = [self _indexOfFirstKeyNotBefore:prefixKey]; index < numberOfKeys && completions.count < maximumCount; index++) {
+			NSString *key = self.sortedKeys[index];
+			if (![key hasPrefix:prefixKey]) {
+				break;
+			}
+			[completions addObject:self.entries[key].string];
+		}
+	}
+	
+	return completions;
+}
+
+@end
+
+@interface MBTableGridCompletionIndexBuilder ()
+
+@property (atomic, readwrite, getter=isCancelled) BOOL cancelled;
+
+@property (nonatomic) NSUInteger numberOfRows;
+@property (nonatomic, strong) NSData *rowData;
+@property (nonatomic, strong) NSMutableArray<NSString *> *strings;
+
+@end
+
+@implementation MBTableGridCompletionIndexBuilder
+
+- (void)cancel {
+	self.cancelled = YES;
+}
+
+- (void)buildIndexWithRows:(NSIndexSet *)rowIndexes completionHandler:(void (^)(MBTableGridCompletionIndex *completionIndex))completionHandler {
+	self.numberOfRows = rowIndexes.count;
+	self.strings = [NSMutableArray arrayWithCapacity:self.numberOfRows];
+	
+	// Keep the rows in a flat buffer, so reading can stop and pick up again anywhere
+	NSMutableData *rowData = [NSMutableData dataWithLength:MAX(self.numberOfRows, 1) * sizeof(NSUInteger)];
+	[rowIndexes getIndexes:rowData.mutableBytes maxCount:self.numberOfRows inIndexRange:nil];
+	self.rowData = rowData;
+	
+	if (self.readsValuesConcurrently) {
+		// The main thread keeps drawing with the formatter, so the background thread formats with a copy
+		self.formatter = [self.formatter copy];
+		dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+			[self _readRowsFromIndex:0 endIndex:self.numberOfRows];
+			[self _buildIndexWithCompletionHandler:completionHandler];
+		});
+	} else {
+		[self _readRowsFromIndex:0 completionHandler:completionHandler];
+	}
+}
+
+- (void)_readRowsFromIndex:(NSUInteger)firstIndex completionHandler:(void (^)(MBTableGridCompletionIndex *completionIndex))completionHandler {
+	if (self.cancelled) {
+		return;
+	}
+	
+	// Read for a short interval, then let the run loop go on before reading more
+	NSDate *start = [NSDate date];
+	NSUInteger index = firstIndex;
+	while (index < self.numberOfRows && (index == firstIndex || -[start timeIntervalSinceNow] < MBTableGridCompletionIndexReadInterval)) {
+		NSUInteger endIndex = MIN(index + MBTableGridCompletionIndexRowsPerBatch, self.numberOfRows);
+		[self _readRowsFromIndex:index endIndex:endIndex];
+		index = endIndex;
+	}
+	
+	if (index < self.numberOfRows) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self _readRowsFromIndex:index completionHandler:completionHandler];
+		});
+	} else {
+		dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+			[self _buildIndexWithCompletionHandler:completionHandler];
+		});
+	}
+}
+
+- (void)_readRowsFromIndex:(NSUInteger)firstIndex endIndex:(NSUInteger)endIndex {
+	const NSUInteger *rows = self.rowData.bytes;
+	for (NSUInteger index = firstIndex; index < endIndex && !self.cancelled; index++) {
+		@autoreleasepool {
+			[self.strings addObject:[MBTableGridTabularText stringForValue:self.valueProvider(rows[index]) formatter:self.formatter]];
+		}
+	}
+}
+
+- (void)_buildIndexWithCompletionHandler:(void (^)(MBTableGridCompletionIndex *completionIndex))completionHandler {
+	if (self.cancelled) {
+		return;
+	}
+	
+	MBTableGridCompletionIndex *completionIndex = [[MBTableGridCompletionIndex alloc] initWithStrings:self.strings];
+	self.strings = nil;
+	
+	dispatch_async(dispatch_get_main_queue(), ^{
+		if (!self.cancelled && completionHandler) {
+			completionHandler(completionIndex);
+		}
+	});
+}
+
+@end
+
@@ -38,7 +38,7 @@ typedef NS_ENUM(NSUInteger, MBTableGridTrackingPart)
     MBTableGridTrackingPartFillBottom
 };
 
-@class MBTableGrid, MBTableGridCell;
+@class MBTableGrid, MBTableGridCell, MBTableGridDisplayList;
 
 /**
  * @brief		\c MBTableGridContentView provides the actual display
@@ -214,4 +214,26 @@ typedef NS_ENUM(NSUInteger, MBTableGridTrackingPart)
 
 - (void)cacheGroupRows;
 
+/**
+ * @brief		Rebuilds the fill tracking areas and cursor rects.
+ *
+ * @details		Call this when the selection or the fill eligibility
+ *				of the selected cell changes. Drawing no longer
+ *				rebuilds them, so they are only recreated when
+ *				something they depend on has actually changed.
+ */
+- (void)updateSelectionTracking;
+
+/**
+ * @brief		Records the commands needed to draw \c rect into
+ *				a display list, without drawing anything.
+ * @details		Cells are set up the same way \c drawRect: sets
+ *				them up, and find matches and every selected
+ *				range are highlighted as they are on screen.
+ * @param		displayList	The display list to record into.
+ * @param		rect		The rect to record, in the receiver's
+ *							coordinates.
+ */
+- (void)recordDisplayList:(MBTableGridDisplayList *)displayList inRect:(NSRect)rect;
+
 @end
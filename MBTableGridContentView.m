@@ -32,10 +32,14 @@
 #import "MBImageCell.h"
 #import "MBLevelIndicatorCell.h"
 #import "MBAutoCompleteWindow.h"
+#import "MBTableGridDisplayList.h"
+#import "MBTableGridCore.h"
+#import "MBTableGridSelection.h"
 
 #define kGRAB_HANDLE_HALF_SIDE_LENGTH 3.0f
 #define kGRAB_HANDLE_SIDE_LENGTH 6.0f
 #define kCELL_EDIT_HORIZONTAL_PADDING 4.0f
+#define kGROUP_ROW_INDENTATION 16.0f
 
 NSString * const MBTableGridTrackingPartKey = @"part";
 
@@ -46,7 +50,8 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 - (NSImage *)_accessoryButtonImageForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 - (void)_accessoryButtonClicked:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 - (NSArray *)_availableObjectValuesForColumn:(NSUInteger)columnIndex;
-- (NSArray *)_autocompleteValuesForEditString:(NSString *)editString column:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+- (void)_autocompleteValuesForEditString:(NSString *)editString column:(NSUInteger)columnIndex row:(NSUInteger)rowIndex completionHandler:(void (^)(NSArray *completions))completionHandler;
+- (void)_cancelAutocomplete;
 - (void)_setObjectValue:(id)value forColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex undoTitle:(NSString *)undoTitle;
 - (BOOL)_canEditCellAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 - (BOOL)_canFillCellAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
@@ -66,9 +71,16 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 - (BOOL)_isGroupHeadingRow:(NSUInteger)rowIndex;
 - (BOOL)_isGroupSummaryRow:(NSUInteger)rowIndex;
 - (BOOL)_isGroupRow:(NSUInteger)rowIndex;
+- (NSUInteger)_levelOfGroupRow:(NSUInteger)rowIndex;
 - (NSCell *)_groupSummaryCellForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 - (void)_updateGroupSummaryCell:(NSCell *)cell forColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 - (id)_groupSummaryValueForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+- (MBTableGridColumnLayout *)_columnLayout;
+- (NSUInteger)_firstShownColumnFrom:(NSUInteger)columnIndex;
+- (MBTableGridGroupRows *)_groupRows;
+- (void)_beginAddingSelectionAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+- (void)_endAddingSelection;
+- (void)_removeAdditionalSelection;
 @end
 
 @interface MBTableGridContentView (Cursors)
@@ -93,7 +105,23 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 @property (nonatomic, readonly) BOOL frozen;
 @property (nonatomic, strong) MBAutoCompleteWindow *autoCompleteWindow;
 @property (nonatomic) NSInteger completionsCount;
+@property (nonatomic, copy) NSString *completedString;
+@property (nonatomic, copy) NSArray *completions;
 @property (nonatomic) NSInteger fieldEditorLength;
+@property (nonatomic) BOOL fillEligibilityIsValid;
+@property (nonatomic) BOOL canFillSelection;
+
+- (NSRect)_disclosureRectOfGroupRow:(NSUInteger)rowIndex;
+- (void)_drawDisclosureTriangleInRect:(NSRect)rect collapsed:(BOOL)collapsed;
+- (NSRect)_frameOfGroupHeadingRow:(NSUInteger)rowIndex;
+- (void)_prepareGroupHeadingCellForRow:(NSUInteger)rowIndex frame:(NSRect)rowFrame disclosureRect:(NSRect)disclosureRect;
+- (NSCell *)_cellAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+- (BOOL)_drawsCell:(NSCell *)cell atColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+- (void)_prepareCell:(NSCell *)cell atColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex lastColumn:(NSUInteger)lastColumn backgroundColor:(NSColor **)backgroundColor textColor:(NSColor **)textColor;
+- (NSColor *)_findHighlightColor;
+- (void)_enumerateFindMatchRectsInColumns:(NSRange)columnRange rows:(NSRange)rowRange usingBlock:(void (^)(NSRect rect))block;
+- (void)_enumerateAdditionalSelectionRectsInRect:(NSRect)rect usingBlock:(void (^)(NSRect rect))block;
+- (NSColor *)_selectionColorIsDisabled:(BOOL *)disabled;
 
 @end
 
@@ -183,17 +211,16 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 	if (!_groupHeadingRowIndexes || !_groupSummaryRowIndexes) {
         _groupHeadingRowIndexes = [NSMutableDictionary dictionary];
 		_groupSummaryRowIndexes = [NSMutableDictionary dictionary];
-		NSUInteger numberOfRows = [self tableGrid].numberOfRows;
-		NSUInteger row = 0;
-		while (row < numberOfRows) {
-            if ([[self tableGrid] _isGroupHeadingRow:row]) {
-                NSRect groupRowRect = [self rectOfRow:row];
-                _groupHeadingRowIndexes[@(row)] = [NSValue valueWithRect:groupRowRect];
-            } else if ([[self tableGrid] _isGroupSummaryRow:row]) {
-				NSRect groupRowRect = [self rectOfRow:row];
+		MBTableGridGroupRows *groupRows = [[self tableGrid] _groupRows];
+		size_t count = MBTableGridGroupRowsCount(groupRows);
+		for (size_t index = 0; index < count; index++) {
+			NSUInteger row = MBTableGridGroupRowsRowAtIndex(groupRows, index);
+			NSRect groupRowRect = [self rectOfRow:row];
+			if (MBTableGridGroupRowsKindAtIndex(groupRows, index) == MBTableGridGroupRowHeading) {
+				_groupHeadingRowIndexes[@(row)] = [NSValue valueWithRect:groupRowRect];
+			} else {
 				_groupSummaryRowIndexes[@(row)] = [NSValue valueWithRect:groupRowRect];
 			}
-			row++;
 		}
 	}
 }
@@ -224,40 +251,13 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 		return;
 	}
 	
-	NSUInteger firstColumn = NSNotFound;
-	NSUInteger lastColumn = numberOfColumns - 1;
-	NSUInteger firstRow = NSNotFound;
-	NSUInteger lastRow = numberOfRows - 1;
-	
-	// Find the columns to draw
-	NSUInteger column = 0;
-	while (column < numberOfColumns) {
-		NSRect columnRect = [self rectOfColumn:column];
-		if (firstColumn == NSNotFound && NSMinX(rect) >= NSMinX(columnRect) && NSMinX(rect) <= NSMaxX(columnRect)) {
-			firstColumn = column;
-		} else if (firstColumn != NSNotFound && NSMaxX(rect) >= NSMinX(columnRect) && NSMaxX(rect) <= NSMaxX(columnRect)) {
-			lastColumn = column;
-			break;
-		}
-		column++;
-	}
+	NSUInteger firstColumn, lastColumn, firstRow, lastRow;
+	[self _getFirstColumn:&firstColumn lastColumn:&lastColumn firstRow:&firstRow lastRow:&lastRow inRect:rect];
+	NSUInteger column, row;
 	
 	// Cache group rows
 	
 	[self cacheGroupRows];
-	
-	// Find the rows to draw
-	NSUInteger row = 0;
-	while (row < numberOfRows) {
-		NSRect rowRect = [self rectOfRow:row];
-		if (firstRow == NSNotFound && NSMinY(rect) >= rowRect.origin.x && NSMinY(rect) <= NSMaxY(rowRect)) {
-			firstRow = row;
-		} else if (firstRow != NSNotFound && NSMaxY(rect) >= NSMinY(rowRect) && NSMaxY(rect) <= NSMaxY(rowRect)) {
-			lastRow = row;
-			break;
-		}
-		row++;
-	}
     
     NSRect selectionInsetRect = NSZeroRect;
     NSBezierPath *selectionPath = nil;
@@ -272,206 +272,66 @@ NSString * const MBTableGridTrackingPartKey = @"part";
         [selectionPath fill];
     }
 	
-	NSRect lastColumnRect = [self rectOfColumn:numberOfColumns - 1];
-
 	row = firstRow;
 	while (row <= lastRow) {
 
 		NSValue *rowRectValue = _groupHeadingRowIndexes[@(row)];
 		if (rowRectValue) {
-			NSRect rowFrame = [self rectOfRow:row];
-			rowFrame.size.width = NSMaxX(lastColumnRect);
-            if ([NSApplication sharedApplication].userInterfaceLayoutDirection == NSUserInterfaceLayoutDirectionLeftToRight && self != [self tableGrid].frozenContentView) {
-//                rowFrame.size.width -= MBTableGridContentViewPadding + 10;
-			} else if ([self tableGrid].frozenContentView) {
-				rowFrame.size.width += NSWidth([self rectOfColumn:numberOfColumns - 1]);
-			}
-			id objectValue = [[self tableGrid] _objectValueForColumn:0 row:row];
-			_defaultCell.font = _groupRowFont;
-			_defaultCell.textColor = _groupRowTextColor;
-			_defaultCell.objectValue = objectValue;
-			_defaultCell.isGroupRow = YES;
+			NSRect rowFrame = [self _frameOfGroupHeadingRow:row];
+			NSRect disclosureRect = [self _disclosureRectOfGroupRow:row];
+			[self _prepareGroupHeadingCellForRow:row frame:rowFrame disclosureRect:disclosureRect];
 			[_defaultCell drawWithFrame:rowFrame inView:self withBackgroundColor:_groupRowColor textColor:[NSColor labelColor]];
+			[self _drawDisclosureTriangleInRect:disclosureRect collapsed:[[self tableGrid] isGroupRowCollapsed:row]];
 			
-		} else {
+		} else if (firstColumn != NSNotFound) {
 			
 			_defaultCell.isGroupRow = NO;
+			_defaultCell.indentation = 0;
 			
 			column = firstColumn;
 			while (column <= lastColumn) {
 				NSRect cellFrame = [self frameOfCellAtColumn:column row:row];
-                NSCell *_cell = nil;
-                BOOL isGroupSummary = self.groupSummaryRowIndexes[@(row)] != nil;
-				
-                if (isGroupSummary) {
-                    _cell = [[self tableGrid] _groupSummaryCellForColumn:column row:row];
-					_cell.font = [NSFont boldSystemFontOfSize:_defaultCell.font.pointSize];
-                } else {
-                    _cell = [[self tableGrid] _cellForColumn:column];
-					if (_defaultCellFont) {
-						_cell.font = _defaultCellFont;
-					}
-                }
-				
-				// If we need to draw then check if we're a popup button. This may be a bit of
-				// a hack, but it seems to clear up the problem with the popup button clearing
-				// if you don't select a value. It's the editedRow and editedColumn bits that
-				// cause the problem. However, if you remove the row and column condition, then
-				// if you type into a text field, the text doesn't get cleared first before you
-				// start typing. So this seems to make both conditions work.
+				NSCell *_cell = [self _cellAtColumn:column row:row];
 				
-				// checking for class MBPopupButtonCell causes a severe performance problem.
-
-//				if ([self needsToDrawRect:cellFrame] && (!(row == editedRow && column == editedColumn))) {
-									
-				if ([self needsToDrawRect:cellFrame] && (!(row == editedRow && column == editedColumn) || ((row == editedRow && column == editedColumn) && [_cell isKindOfClass:[MBPopupButtonCell class]]))) {
-					
+				if ([self needsToDrawRect:cellFrame] && [self _drawsCell:_cell atColumn:column row:row]) {
 					NSColor *backgroundColor = nil;
-					
-					BOOL isFrozenColumn = [[self tableGrid] isFrozenColumn:column];
-                    if (isFrozenColumn) {
-                        backgroundColor = [[self tableGrid] _frozenBackgroundColorForColumn:column row:row] ?: [NSColor windowBackgroundColor];
-                    } else if (isGroupSummary) {
-                        backgroundColor = [[self tableGrid] _groupSummaryBackgroundColorForColumn:column row:row] ?: [NSColor controlBackgroundColor];
-					} else {
-						backgroundColor = [[self tableGrid] _backgroundColorForColumn:column row:row] ?: [NSColor controlBackgroundColor];
-					}
-                    
-					if (!_cell) {
-						_cell = _defaultCell;
-					}
-					
-					[_cell setFormatter:nil]; // An exception is raised if the formatter is not set to nil before changing at runtime
-					[_cell setFormatter:[[self tableGrid] _formatterForColumn:column]];
-					
-					id objectValue = nil;
-					isFrozenColumn = self != [self tableGrid].frozenContentView && isFrozenColumn;
-					
-                    if (isGroupSummary) {
-                        objectValue = [[self tableGrid] _groupSummaryValueForColumn:column row:row];
-                    } else if (isFilling && [selectedColumns containsIndex:column] && [selectedRows containsIndex:row]) {
-						objectValue = [[self tableGrid] _objectValueForColumn:mouseDownColumn row:mouseDownRow];
-					} else {
-						objectValue = [[self tableGrid] _objectValueForColumn:column row:row];
-					}
-					
-                    if (isFrozenColumn) {
-                        [_cell setObjectValue:nil];
-                    } else if ([_cell isKindOfClass:[MBPopupButtonCell class]]) {
-						[_cell setObjectValue:objectValue];
-					} else {
-						if ([_cell isKindOfClass:[MBImageCell class]] && ![objectValue isKindOfClass:[NSImage class]]) {
-							[_cell setObjectValue:nil];
-						} else {
-							[_cell setObjectValue:objectValue];
-						}
-					}
-					
-					NSColor *darkLightTextColor = nil;
-					BOOL isLight = NO;
-					if ([self isLightColour:backgroundColor]) {
-						darkLightTextColor = [NSColor blackColor];
-						isLight = YES;
-					} else {
-						darkLightTextColor = [NSColor whiteColor];
-						isLight = NO;
-					}
+					NSColor *textColor = nil;
+					[self _prepareCell:_cell atColumn:column row:row lastColumn:lastColumn backgroundColor:&backgroundColor textColor:&textColor];
 					
 					if ([_cell isKindOfClass:[MBPopupButtonCell class]]) {
-						
-						MBPopupButtonCell *cell = (MBPopupButtonCell *)_cell;
-						
-						NSColor *textColor = [[self tableGrid] _textColorForColumn:column row:row] ?: darkLightTextColor;
-						
-						[cell setTextColor:textColor];
-						
-						if (isLight) {
-							cell.arrowImage = [NSImage imageNamed:@"popup-indicator"];
-						} else {
-							cell.arrowImage = [NSImage imageNamed:@"popup-indicator-white"];
-						}
-						
-						[cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor textColor:textColor];// Draw background color
-						
+						[(MBPopupButtonCell *)_cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor textColor:textColor];// Draw background color
 					} else if ([_cell isKindOfClass:[MBImageCell class]]) {
-						
-						MBImageCell *cell = (MBImageCell *)_cell;
-						
-						cell.accessoryButtonImage = [[self tableGrid] _accessoryButtonImageForColumn:column row:row];
-						
-						[cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor];// Draw background color
-						
+						[(MBImageCell *)_cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor];// Draw background color
 					} else if ([_cell isKindOfClass:[MBLevelIndicatorCell class]]) {
-						
-						MBLevelIndicatorCell *cell = (MBLevelIndicatorCell *)_cell;
-						
-						cell.target = self;
-						cell.action = @selector(updateLevelIndicator:);
-						
-						[cell drawWithFrame:cellFrame inView:[self tableGrid] withBackgroundColor:backgroundColor];// Draw background color
-						
+						[(MBLevelIndicatorCell *)_cell drawWithFrame:cellFrame inView:[self tableGrid] withBackgroundColor:backgroundColor];// Draw background color
 					} else if ([_cell isKindOfClass:[MBButtonCell class]]) {
-						
-						MBButtonCell *cell = (MBButtonCell *)_cell;
-
-						[cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor];// Draw background color
-					
+						[(MBButtonCell *)_cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor];// Draw background color
 					} else {
-						
-						MBTableGridCell *cell = (MBTableGridCell *)_cell;
-						
-						NSColor *textColor = [[self tableGrid] _textColorForColumn:column row:row] ?: darkLightTextColor;
-						
-						[cell setTextColor:textColor];
-						
-                        if (isGroupSummary) {
-                            if (cell.objectValue != nil) {
-                                cell.title = cell.objectValue;
-                            }
-							if (column == lastColumn) {
-								cell.isLastColumn = YES;
-							} else {
-								cell.isLastColumn = NO;
-							}
-                            
-                            [[self tableGrid] _updateGroupSummaryCell:cell forColumn:column row:row];
-							
-                        } else {
-                            cell.accessoryButtonImage = [[self tableGrid] _accessoryButtonImageForColumn:column row:row];
-                        }
-                        
-                        if (cell.font == nil) {
-                            cell.font = [NSFont systemFontOfSize:[NSFont systemFontSize]];
-                        }
-                        
-						[cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor textColor:textColor];// Draw background color
-						
+						[(MBTableGridCell *)_cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor textColor:textColor];// Draw background color
 					}
 				}
-				column++;
+				column = [[self tableGrid] _firstShownColumnFrom:column + 1];
 			}
 		}
 		row++;
 	}
 	
+	if (firstColumn != NSNotFound && firstRow != NSNotFound) {
+		[[[self _findHighlightColor] colorWithAlphaComponent:0.4] set];
+		[self _enumerateFindMatchRectsInColumns:NSMakeRange(firstColumn, lastColumn - firstColumn + 1) rows:NSMakeRange(firstRow, lastRow - firstRow + 1) usingBlock:^(NSRect matchRect) {
+			NSRectFillUsingOperation(matchRect, NSCompositingOperationSourceOver);
+		}];
+	}
+	
 	// Draw the selection rectangle
 	if([selectedColumns count] && [selectedRows count] && [self tableGrid].numberOfColumns > 0 && [self tableGrid].numberOfRows > 0) {
-		NSColor *selectionColor = [NSColor alternateSelectedControlColor];
-		
-		// If the view is not the first responder, then use a gray selection color
-		NSResponder *firstResponder = [[self window] firstResponder];
-		BOOL disabled = (![[firstResponder class] isSubclassOfClass:[NSView class]] || ![(NSView *)firstResponder isDescendantOf:[self tableGrid]] || ![[self window] isKeyWindow]);
+		BOOL disabled = NO;
+		NSColor *selectionColor = [self _selectionColorIsDisabled:&disabled];
 		
-		if (disabled) {
-			selectionColor = [[selectionColor colorUsingColorSpaceName:NSDeviceWhiteColorSpace] colorUsingColorSpaceName:NSDeviceRGBColorSpace];
-        } else if (isFilling) {
-			if (@available(macOS 10.13, *)) {
-				selectionColor = [NSColor colorNamed:@"fill-background"];
-			} else {
-				// Fallback on earlier versions
-				selectionColor = [NSColor colorWithCalibratedRed:0.996 green:0.827 blue:0.176 alpha:1.000];
-			}
-        }
+		[[selectionColor colorWithAlphaComponent:0.2f] set];
+		[self _enumerateAdditionalSelectionRectsInRect:rect usingBlock:^(NSRect selectionRect) {
+			NSRectFillUsingOperation(selectionRect, NSCompositingOperationSourceOver);
+		}];
 		
 		[selectionColor set];
 		[selectionPath setLineWidth: 1.0];
@@ -480,17 +340,16 @@ NSString * const MBTableGridTrackingPartKey = @"part";
         [[selectionColor colorWithAlphaComponent:0.2f] set];
         [selectionPath fill];
         
-		if (disabled || [selectedColumns count] > 1) {
+		if (disabled) {
 			grabHandleRect = NSZeroRect;
+		} else {
+			grabHandleRect = [self _grabHandleRectForSelectionRect:selectionInsetRect];
 		}
-        else if (shouldDrawFillPart != MBTableGridTrackingPartNone) {
+		
+		if (!NSIsEmptyRect(grabHandleRect)) {
             // Draw grab handle
-            grabHandleRect = NSMakeRect(NSMidX(selectionInsetRect) - kGRAB_HANDLE_HALF_SIDE_LENGTH - 2, (shouldDrawFillPart == MBTableGridTrackingPartFillTop ? NSMinY(selectionInsetRect) : NSMaxY(selectionInsetRect)) - kGRAB_HANDLE_HALF_SIDE_LENGTH - 2, kGRAB_HANDLE_SIDE_LENGTH + 4, kGRAB_HANDLE_SIDE_LENGTH + 4);
 			[grabHandleImage drawInRect:grabHandleRect fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0];
         }
-		
-        // Inavlidate cursors so we use the correct cursor for the selection in the right place
-        [[self window] invalidateCursorRectsForView:self];
 	}
 	
 	// Draw the column drop indicator
@@ -551,8 +410,287 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 		[borderPath setLineWidth:2.0];
 		[borderPath stroke];
 	}
-    
-    [self updateTrackingAreas];
+}
+
+- (NSRect)_frameOfGroupHeadingRow:(NSUInteger)rowIndex
+{
+	NSUInteger numberOfColumns = [self tableGrid].numberOfColumns;
+	NSRect rowFrame = [self rectOfRow:rowIndex];
+	rowFrame.size.width = NSMaxX([self rectOfColumn:numberOfColumns - 1]);
+	if ([NSApplication sharedApplication].userInterfaceLayoutDirection == NSUserInterfaceLayoutDirectionLeftToRight && self != [self tableGrid].frozenContentView) {
+//		rowFrame.size.width -= MBTableGridContentViewPadding + 10;
+	} else if ([self tableGrid].frozenContentView) {
+		rowFrame.size.width += NSWidth([self rectOfColumn:numberOfColumns - 1]);
+	}
+	return rowFrame;
+}
+
+- (void)_prepareGroupHeadingCellForRow:(NSUInteger)rowIndex frame:(NSRect)rowFrame disclosureRect:(NSRect)disclosureRect
+{
+	// Headings span the row, so no column's formatter applies to them
+	[_defaultCell setFormatter:nil];
+	_defaultCell.font = _groupRowFont;
+	_defaultCell.textColor = _groupRowTextColor;
+	_defaultCell.objectValue = [[self tableGrid] _objectValueForColumn:0 row:rowIndex];
+	_defaultCell.isGroupRow = YES;
+	_defaultCell.indentation = NSMaxX(disclosureRect) - NSMinX(rowFrame);
+}
+
+- (NSCell *)_cellAtColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex
+{
+	NSCell *cell = nil;
+	if (self.groupSummaryRowIndexes[@(rowIndex)]) {
+		cell = [[self tableGrid] _groupSummaryCellForColumn:columnIndex row:rowIndex];
+		cell.font = [NSFont boldSystemFontOfSize:_defaultCell.font.pointSize];
+	} else {
+		cell = [[self tableGrid] _cellForColumn:columnIndex];
+		if (_defaultCellFont) {
+			cell.font = _defaultCellFont;
+		}
+	}
+	return cell ?: _defaultCell;
+}
+
+- (BOOL)_drawsCell:(NSCell *)cell atColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex
+{
+	// If we need to draw then check if we're a popup button. This may be a bit of
+	// a hack, but it seems to clear up the problem with the popup button clearing
+	// if you don't select a value. It's the editedRow and editedColumn bits that
+	// cause the problem. However, if you remove the row and column condition, then
+	// if you type into a text field, the text doesn't get cleared first before you
+	// start typing. So this seems to make both conditions work.
+	
+	// checking for class MBPopupButtonCell causes a severe performance problem.
+	return !(rowIndex == editedRow && columnIndex == editedColumn) || [cell isKindOfClass:[MBPopupButtonCell class]];
+}
+
+/**
+ * @brief		Sets up a cell to draw the value at a column and
+ *				row, for both \c drawRect: and display lists.
+ */
+- (void)_prepareCell:(NSCell *)cell atColumn:(NSUInteger)column row:(NSUInteger)row lastColumn:(NSUInteger)lastColumn backgroundColor:(NSColor **)backgroundColor textColor:(NSColor **)textColor
+{
+	BOOL isGroupSummary = self.groupSummaryRowIndexes[@(row)] != nil;
+	NSIndexSet *selectedColumns = [[self tableGrid] selectedColumnIndexes];
+	NSIndexSet *selectedRows = [[self tableGrid] selectedRowIndexes];
+	
+	if ([[self tableGrid] isFrozenColumn:column]) {
+		*backgroundColor = [[self tableGrid] _frozenBackgroundColorForColumn:column row:row] ?: [NSColor windowBackgroundColor];
+	} else if (isGroupSummary) {
+		*backgroundColor = [[self tableGrid] _groupSummaryBackgroundColorForColumn:column row:row] ?: [NSColor controlBackgroundColor];
+	} else {
+		*backgroundColor = [[self tableGrid] _backgroundColorForColumn:column row:row] ?: [NSColor controlBackgroundColor];
+	}
+	
+	[cell setFormatter:nil]; // An exception is raised if the formatter is not set to nil before changing at runtime
+	[cell setFormatter:[[self tableGrid] _formatterForColumn:column]];
+	
+	id objectValue = nil;
+	if (isGroupSummary) {
+		objectValue = [[self tableGrid] _groupSummaryValueForColumn:column row:row];
+	} else if (isFilling && [selectedColumns containsIndex:column] && [selectedRows containsIndex:row]) {
+		objectValue = [[self tableGrid] _objectValueForColumn:mouseDownColumn row:mouseDownRow];
+	} else {
+		objectValue = [[self tableGrid] _objectValueForColumn:column row:row];
+	}
+	
+	if ([cell isKindOfClass:[MBImageCell class]] && ![objectValue isKindOfClass:[NSImage class]]) {
+		[cell setObjectValue:nil];
+	} else {
+		[cell setObjectValue:objectValue];
+	}
+	
+	BOOL isLight = [self isLightColour:*backgroundColor];
+	NSColor *darkLightTextColor = isLight ? [NSColor blackColor] : [NSColor whiteColor];
+	*textColor = nil;
+	
+	if ([cell isKindOfClass:[MBPopupButtonCell class]]) {
+		MBPopupButtonCell *popupCell = (MBPopupButtonCell *)cell;
+		*textColor = [[self tableGrid] _textColorForColumn:column row:row] ?: darkLightTextColor;
+		[popupCell setTextColor:*textColor];
+		popupCell.arrowImage = [NSImage imageNamed:isLight ? @"popup-indicator" : @"popup-indicator-white"];
+	} else if ([cell isKindOfClass:[MBImageCell class]]) {
+		((MBImageCell *)cell).accessoryButtonImage = [[self tableGrid] _accessoryButtonImageForColumn:column row:row];
+	} else if ([cell isKindOfClass:[MBLevelIndicatorCell class]]) {
+		cell.target = self;
+		cell.action = @selector(updateLevelIndicator:);
+	} else if (![cell isKindOfClass:[MBButtonCell class]]) {
+		MBTableGridCell *textCell = (MBTableGridCell *)cell;
+		*textColor = [[self tableGrid] _textColorForColumn:column row:row] ?: darkLightTextColor;
+		[textCell setTextColor:*textColor];
+		
+		if (isGroupSummary) {
+			if (textCell.objectValue != nil) {
+				textCell.title = textCell.objectValue;
+			}
+			textCell.isLastColumn = column == lastColumn;
+			[[self tableGrid] _updateGroupSummaryCell:textCell forColumn:column row:row];
+		} else {
+			textCell.accessoryButtonImage = [[self tableGrid] _accessoryButtonImageForColumn:column row:row];
+		}
+		
+		if (textCell.font == nil) {
+			textCell.font = [NSFont systemFontOfSize:[NSFont systemFontSize]];
+		}
+	}
+}
+
+/**
+ * @brief		Finds the range of cells that intersect a rect.
+ *
+ * @details		The frozen view only covers the frozen columns, and
+ *				the main view skips them, since they are hidden
+ *				beneath the frozen view anyway. \c firstColumn is
+ *				\c NSNotFound if no columns intersect the rect.
+ */
+- (void)_getFirstColumn:(NSUInteger *)firstColumn lastColumn:(NSUInteger *)lastColumn firstRow:(NSUInteger *)firstRow lastRow:(NSUInteger *)lastRow inRect:(NSRect)rect
+{
+	NSRange columnRange = self.frozen ? [[self tableGrid] frozenColumnRange] : [[self tableGrid] unfrozenColumnRange];
+	NSUInteger numberOfRows = [self tableGrid].numberOfRows;
+	
+	MBTableGridColumnLayout *layout = [[self tableGrid] _columnLayout];
+	
+	*firstColumn = NSNotFound;
+	*lastColumn = NSMaxRange(columnRange) - 1;
+	
+	// Find the columns to draw
+	if (columnRange.length > 0 && NSMaxRange(columnRange) <= MBTableGridColumnLayoutCount(layout)) {
+		CGFloat rangeMinX = MBTableGridColumnLayoutOffset(layout, columnRange.location);
+		CGFloat rangeMaxX = MBTableGridColumnLayoutOffset(layout, NSMaxRange(columnRange));
+		
+		if (NSMinX(rect) < rangeMaxX && NSMaxX(rect) > rangeMinX) {
+			size_t column = MBTableGridColumnLayoutColumnAtOffset(layout, MAX(NSMinX(rect), rangeMinX));
+			*firstColumn = column == MBTableGridCoreNotFound ? columnRange.location : MAX(column, columnRange.location);
+			*firstColumn = [[self tableGrid] _firstShownColumnFrom:*firstColumn];
+			
+			// A rect ending exactly on a column boundary doesn't reach into the next column
+			column = MBTableGridColumnLayoutColumnAtOffset(layout, NSMaxX(rect));
+			if (column != MBTableGridCoreNotFound && column < NSMaxRange(columnRange)) {
+				if (column > *firstColumn && MBTableGridColumnLayoutOffset(layout, column) >= NSMaxX(rect)) {
+					column = MBTableGridColumnLayoutLastShownColumnThrough(layout, column - 1);
+				}
+				*lastColumn = MAX(column, *firstColumn);
+			}
+		}
+	}
+	
+	// Rows all have the same height, so the rows to draw can be calculated directly
+	size_t startRow, endRow;
+	if (MBTableGridCoreRowsInSpan(NSMinY(rect), NSMaxY(rect), self.cellRowHeight, numberOfRows, &startRow, &endRow)) {
+		*firstRow = startRow;
+		*lastRow = endRow;
+	} else {
+		*firstRow = NSNotFound;
+		*lastRow = 0;
+	}
+}
+
+- (void)recordDisplayList:(MBTableGridDisplayList *)displayList inRect:(NSRect)rect
+{
+	NSUInteger numberOfColumns = [self tableGrid].numberOfColumns;
+	NSUInteger numberOfRows = [self tableGrid].numberOfRows;
+	
+	[displayList fillRect:rect color:MBDisplayColorFromColor([NSColor controlBackgroundColor])];
+	
+	if (numberOfRows == 0 || numberOfColumns == 0) {
+		return;
+	}
+	
+	NSUInteger firstColumn, lastColumn, firstRow, lastRow;
+	[self _getFirstColumn:&firstColumn lastColumn:&lastColumn firstRow:&firstRow lastRow:&lastRow inRect:rect];
+	
+	[self cacheGroupRows];
+	
+	NSColor *borderColor = nil;
+	if (@available(macOS 10.13, *)) {
+		borderColor = [NSColor colorNamed:@"grid-line"];
+	} else {
+		borderColor = [NSColor gridColor];
+	}
+	MBDisplayColor gridLineColor = MBDisplayColorFromColor(borderColor);
+	MBDisplayColor defaultTextColor = MBDisplayColorFromColor([NSColor labelColor]);
+	
+	for (NSUInteger row = firstRow; row != NSNotFound && row <= lastRow; row++) {
+		
+		if (_groupHeadingRowIndexes[@(row)]) {
+			NSRect rowFrame = [self _frameOfGroupHeadingRow:row];
+			NSRect disclosureRect = [self _disclosureRectOfGroupRow:row];
+			[self _prepareGroupHeadingCellForRow:row frame:rowFrame disclosureRect:disclosureRect];
+			rowFrame = NSIntersectionRect(rowFrame, rect);
+			NSRect titleRect = rowFrame;
+			titleRect.origin.x = NSMaxX(disclosureRect);
+			titleRect.size.width = MAX(NSMaxX(rowFrame) - NSMinX(titleRect), 0);
+			NSString *disclosure = [[self tableGrid] isGroupRowCollapsed:row] ? @"\u25B8" : @"\u25BE";
+			[displayList fillRect:rowFrame color:MBDisplayColorFromColor(_groupRowColor)];
+			[displayList drawText:disclosure inRect:disclosureRect color:MBDisplayColorFromColor(_groupRowTextColor)];
+			[displayList drawText:_defaultCell.stringValue inRect:titleRect color:MBDisplayColorFromColor(_groupRowTextColor)];
+			continue;
+		}
+		
+		if (firstColumn == NSNotFound) {
+			continue;
+		}
+		
+		_defaultCell.isGroupRow = NO;
+		_defaultCell.indentation = 0;
+		
+		BOOL isGroupSummary = self.groupSummaryRowIndexes[@(row)] != nil;
+		
+		for (NSUInteger column = firstColumn; column <= lastColumn; column = [[self tableGrid] _firstShownColumnFrom:column + 1]) {
+			NSRect cellFrame = [self frameOfCellAtColumn:column row:row];
+			NSCell *cell = [self _cellAtColumn:column row:row];
+			
+			if ([self _drawsCell:cell atColumn:column row:row]) {
+				NSColor *backgroundColor = nil;
+				NSColor *textColor = nil;
+				[self _prepareCell:cell atColumn:column row:row lastColumn:lastColumn backgroundColor:&backgroundColor textColor:&textColor];
+				
+				[displayList fillRect:cellFrame color:MBDisplayColorFromColor(backgroundColor)];
+				
+				id objectValue = cell.objectValue;
+				if ([objectValue isKindOfClass:[NSImage class]]) {
+					[displayList drawImageNamed:[(NSImage *)objectValue name] inRect:cellFrame];
+				} else if (objectValue) {
+					[displayList drawText:cell.stringValue inRect:NSInsetRect(cellFrame, kCELL_EDIT_HORIZONTAL_PADDING, 0) color:textColor ? MBDisplayColorFromColor(textColor) : defaultTextColor];
+				}
+			}
+			
+			NSImage *accessoryButtonImage = isGroupSummary ? nil : [[self tableGrid] _accessoryButtonImageForColumn:column row:row];
+			if (accessoryButtonImage) {
+				NSRect accessoryRect = NSMakeRect(NSMaxX(cellFrame) - accessoryButtonImage.size.width - 2, NSMinY(cellFrame), accessoryButtonImage.size.width, NSHeight(cellFrame));
+				[displayList drawImageNamed:accessoryButtonImage.name inRect:accessoryRect];
+			}
+			
+			// The right and bottom grid lines
+			[displayList strokeLineFromPoint:NSMakePoint(NSMaxX(cellFrame) - 0.5, NSMinY(cellFrame)) toPoint:NSMakePoint(NSMaxX(cellFrame) - 0.5, NSMaxY(cellFrame)) width:1.0 color:gridLineColor];
+			[displayList strokeLineFromPoint:NSMakePoint(NSMinX(cellFrame), NSMaxY(cellFrame) - 0.5) toPoint:NSMakePoint(NSMaxX(cellFrame), NSMaxY(cellFrame) - 0.5) width:1.0 color:gridLineColor];
+		}
+	}
+	
+	if (firstColumn != NSNotFound && firstRow != NSNotFound) {
+		MBDisplayColor highlightColor = MBDisplayColorFromColor([[self _findHighlightColor] colorWithAlphaComponent:0.4]);
+		[self _enumerateFindMatchRectsInColumns:NSMakeRange(firstColumn, lastColumn - firstColumn + 1) rows:NSMakeRange(firstRow, lastRow - firstRow + 1) usingBlock:^(NSRect matchRect) {
+			[displayList fillRect:matchRect color:highlightColor];
+		}];
+	}
+	
+	// The selection rectangle
+	NSIndexSet *selectedColumns = [[self tableGrid] selectedColumnIndexes];
+	NSIndexSet *selectedRows = [[self tableGrid] selectedRowIndexes];
+	if ([selectedColumns count] && [selectedRows count]) {
+		BOOL disabled = NO;
+		NSColor *selectionColor = [self _selectionColorIsDisabled:&disabled];
+		MBDisplayColor selectionFillColor = MBDisplayColorFromColor([selectionColor colorWithAlphaComponent:0.2f]);
+		[self _enumerateAdditionalSelectionRectsInRect:rect usingBlock:^(NSRect selectionRect) {
+			[displayList fillRect:selectionRect color:selectionFillColor];
+		}];
+		
+		NSRect selectionInsetRect = NSInsetRect(self.selectionRect, 1, 1);
+		if (NSIntersectsRect(selectionInsetRect, rect)) {
+			[displayList fillRect:selectionInsetRect color:selectionFillColor];
+			[displayList strokeRect:selectionInsetRect width:1.0 color:MBDisplayColorFromColor(selectionColor)];
+		}
+	}
 }
 
 - (void)updateCell:(id)sender {
@@ -611,17 +749,18 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 	}
 	
 	if (_groupHeadingRowIndexes[@(mouseDownRow)] || _groupSummaryRowIndexes[@(mouseDownRow)]) {
+		// Clicking a heading's disclosure triangle, or double clicking the heading, collapses or expands its group
+		if (_groupHeadingRowIndexes[@(mouseDownRow)] && (theEvent.clickCount == 2 || NSPointInRect(mouseLocationInContentView, [self _disclosureRectOfGroupRow:mouseDownRow]))) {
+			if ([[self tableGrid] isGroupRowCollapsed:mouseDownRow]) {
+				[[self tableGrid] expandGroupRow:mouseDownRow];
+			} else {
+				[[self tableGrid] collapseGroupRow:mouseDownRow];
+			}
+		}
 		mouseDownRow = NSNotFound;
 		return;
 	}
     
-    // If the column wasn't found, probably need to flush the cached column rects
-    if (mouseDownColumn == NSNotFound) {
-        [[self tableGrid].columnRects removeAllObjects];
-        
-        mouseDownColumn = [self columnAtPoint:mouseLocationInContentView];
-    }
-    
 	NSCell *cell = [[self tableGrid] _cellForColumn:mouseDownColumn];
 	BOOL cellEditsOnFirstClick = ([cell respondsToSelector:@selector(editOnFirstClick)] && [(id<MBTableGridEditable>)cell editOnFirstClick]);
     isFilling = NO;
@@ -637,6 +776,7 @@ NSString * const MBTableGridTrackingPartKey = @"part";
         
         if (isFilling) {
             numberOfRowsWhenStartingFilling = [self tableGrid].numberOfRows;
+            [[self window] invalidateCursorRectsForView:self];
             
             if (mouseDownRow == selectedRow - 1 || mouseDownRow == selectedRow + 1) {
                 mouseDownRow = selectedRow;
@@ -661,50 +801,37 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 				[self editSelectedCell:self text:nil];
 			}
 			
+		// Start another range when the user holds the command key
+		} else if (([theEvent modifierFlags] & NSEventModifierFlagCommand) && [self tableGrid].allowsMultipleSelection && !isFilling && mouseDownColumn != NSNotFound && mouseDownRow != NSNotFound) {
+			[[self tableGrid] _beginAddingSelectionAtColumn:mouseDownColumn row:mouseDownRow];
+			[[self tableGrid] _setStickyColumn:MBTableGridLeftEdge row:MBTableGridTopEdge];
+			
 		// Expand a selection when the user holds the shift key
 		} else if (([theEvent modifierFlags] & NSEventModifierFlagShift) && [self tableGrid].allowsMultipleSelection && !isFilling) {
 			// If the shift key was held down, extend the selection
-			NSUInteger stickyColumn = [[self tableGrid].selectedColumnIndexes firstIndex];
-			NSUInteger stickyRow = [[self tableGrid].selectedRowIndexes firstIndex];
-			
-			MBTableGridEdge stickyColumnEdge = [[self tableGrid] _stickyColumn];
-			MBTableGridEdge stickyRowEdge = [[self tableGrid] _stickyRow];
-			
-			// Compensate for sticky edges
-			if (stickyColumnEdge == MBTableGridRightEdge) {
-				stickyColumn = [[self tableGrid].selectedColumnIndexes lastIndex];
-			}
-			if (stickyRowEdge == MBTableGridBottomEdge) {
-				stickyRow = [[self tableGrid].selectedRowIndexes lastIndex];
-			}
+			MBTableGridCoreSelection selection;
+			selection.firstColumn = [[self tableGrid].selectedColumnIndexes firstIndex];
+			selection.lastColumn = [[self tableGrid].selectedColumnIndexes lastIndex];
+			selection.firstRow = [[self tableGrid].selectedRowIndexes firstIndex];
+			selection.lastRow = [[self tableGrid].selectedRowIndexes lastIndex];
+			selection.stickyColumnEdge = [[self tableGrid] _stickyColumn] == MBTableGridRightEdge ? MBTableGridCoreRightEdge : MBTableGridCoreLeftEdge;
+			selection.stickyRowEdge = [[self tableGrid] _stickyRow] == MBTableGridBottomEdge ? MBTableGridCoreBottomEdge : MBTableGridCoreTopEdge;
 			
-			NSRange selectionColumnRange = NSMakeRange(stickyColumn, mouseDownColumn-stickyColumn+1);
-			NSRange selectionRowRange = NSMakeRange(stickyRow, mouseDownRow-stickyRow+1);
-			
-			if (mouseDownColumn < stickyColumn) {
-				selectionColumnRange = NSMakeRange(mouseDownColumn, stickyColumn-mouseDownColumn+1);
-				stickyColumnEdge = MBTableGridRightEdge;
-			} else {
-				stickyColumnEdge = MBTableGridLeftEdge;
-			}
-			
-			if (mouseDownRow < stickyRow) {
-				selectionRowRange = NSMakeRange(mouseDownRow, stickyRow-mouseDownRow+1);
-				stickyRowEdge = MBTableGridBottomEdge;
-			} else {
-				stickyRowEdge = MBTableGridTopEdge;
-			}
+			selection = MBTableGridCoreSelectionExtendToCell(selection, mouseDownColumn, mouseDownRow);
 			
 			// Select the proper cells
-			[self tableGrid].selectedColumnIndexes = [NSIndexSet indexSetWithIndexesInRange:selectionColumnRange];
-			[self tableGrid].selectedRowIndexes = [NSMutableIndexSet indexSetWithIndexesInRange:selectionRowRange];
+			[self tableGrid].selectedColumnIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(selection.firstColumn, selection.lastColumn - selection.firstColumn + 1)];
+			[self tableGrid].selectedRowIndexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(selection.firstRow, selection.lastRow - selection.firstRow + 1)];
 			
 			// Set the sticky edges
+			MBTableGridEdge stickyColumnEdge = selection.stickyColumnEdge == MBTableGridCoreRightEdge ? MBTableGridRightEdge : MBTableGridLeftEdge;
+			MBTableGridEdge stickyRowEdge = selection.stickyRowEdge == MBTableGridCoreBottomEdge ? MBTableGridBottomEdge : MBTableGridTopEdge;
 			[[self tableGrid] _setStickyColumn:stickyColumnEdge row:stickyRowEdge];
 			// First click on a cell without shift key modifier
 		} else {
 			// No modifier keys, so change the selection
 			if (mouseDownColumn != NSNotFound) {
+				[[self tableGrid] _removeAdditionalSelection];
 				[self tableGrid].selectedColumnIndexes = [NSIndexSet indexSetWithIndex:mouseDownColumn];
 				if (![[self tableGrid].selectedRowIndexes containsIndex:mouseDownRow] || (self.tableGrid.selectedRowIndexes.count > 1 && mouseDownRow != NSNotFound)) {
 					[self tableGrid].selectedRowIndexes = [NSMutableIndexSet indexSetWithIndex:mouseDownRow];
@@ -754,7 +881,7 @@ NSString * const MBTableGridTrackingPartKey = @"part";
                 row = [self rowAtPoint:loc];
             }
             
-            [self resetCursorRects];
+            [[self window] invalidateCursorRectsForView:self];
         }
         
         // While filling, if dragging upwards, remove any rows added during the fill operation
@@ -769,7 +896,7 @@ NSString * const MBTableGridTrackingPartKey = @"part";
             
             [[self tableGrid].dataSource tableGrid:[self tableGrid] removeRows:rowIndexes];
             
-            [self resetCursorRects];
+            [[self window] invalidateCursorRectsForView:self];
         }
 		
 		MBTableGridEdge columnEdge = MBTableGridLeftEdge;
@@ -832,8 +959,11 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 		isFilling = NO;
         
         [[self tableGrid] setNeedsDisplay:YES];
+        [[self window] invalidateCursorRectsForView:self];
 	}
 	
+	[[self tableGrid] _endAddingSelection];
+	
 	mouseDownColumn = NSNotFound;
 	mouseDownRow = NSNotFound;
 }
@@ -848,6 +978,7 @@ NSString * const MBTableGridTrackingPartKey = @"part";
         
         shouldDrawFillPart = part;
         [self setNeedsDisplay:YES];
+        [[self window] invalidateCursorRectsForView:self];
     }
 }
 
@@ -858,6 +989,7 @@ NSString * const MBTableGridTrackingPartKey = @"part";
         
         shouldDrawFillPart = MBTableGridTrackingPartNone;
         [self setNeedsDisplay:YES];
+        [[self window] invalidateCursorRectsForView:self];
     }
 }
 
@@ -897,16 +1029,19 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 	if (!isFilling) {
 		[self addCursorRect:selectionRect cursor:[NSCursor arrowCursor]];
 		
-        [_groupHeadingRowIndexes enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-            NSRect rectOfRow = [self rectOfRow:[key integerValue]];
-            [self addCursorRect:rectOfRow cursor:[NSCursor arrowCursor]];
-        }];
-		[_groupSummaryRowIndexes enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-			NSRect rectOfRow = [self rectOfRow:[key integerValue]];
-			[self addCursorRect:rectOfRow cursor:[NSCursor arrowCursor]];
-		}];
+		// Only the group rows that are on screen need a cursor rect
+		NSRect visibleRect = [self visibleRect];
+		NSUInteger numberOfRows = [self tableGrid].numberOfRows;
+		NSUInteger firstVisibleRow = MAX(NSMinY(visibleRect), 0) / self.cellRowHeight;
+		NSUInteger lastVisibleRow = MIN((NSUInteger)(NSMaxY(visibleRect) / self.cellRowHeight), numberOfRows - 1);
 		
-		[self addCursorRect:grabHandleRect cursor:[self _cellFillCursor]];
+		for (NSUInteger row = firstVisibleRow; numberOfRows > 0 && row <= lastVisibleRow; row++) {
+			if (_groupHeadingRowIndexes[@(row)] || _groupSummaryRowIndexes[@(row)]) {
+				[self addCursorRect:[self rectOfRow:row] cursor:[NSCursor arrowCursor]];
+			}
+		}
+		
+		[self addCursorRect:[self _grabHandleRectForSelectionRect:NSInsetRect(selectionRect, 1, 1)] cursor:[self _cellFillCursor]];
 		
 		[self addCursorRect:[self visibleRect] cursor:[self _cellSelectionCursor]];
 
@@ -928,9 +1063,14 @@ NSString * const MBTableGridTrackingPartKey = @"part";
     
     if (selectedColumns.count == 1) {
         
-        BOOL canFill = [[self tableGrid] _canFillCellAtColumn:[selectedColumns firstIndex] row:[selectedRows firstIndex]];
+        // Asking the delegate is relatively expensive, so only do it when
+        // the selection has changed since we last asked
+        if (!self.fillEligibilityIsValid) {
+            self.canFillSelection = [[self tableGrid] _canFillCellAtColumn:[selectedColumns firstIndex] row:[selectedRows firstIndex]];
+            self.fillEligibilityIsValid = YES;
+        }
         
-        if (canFill) {
+        if (self.canFillSelection) {
             
             NSRect fillTrackingRect = [self rectOfColumn:[selectedColumns firstIndex]];
             fillTrackingRect.size.height = self.frame.size.height;
@@ -944,6 +1084,99 @@ NSString * const MBTableGridTrackingPartKey = @"part";
     }
 }
 
+- (void)updateSelectionTracking {
+	self.fillEligibilityIsValid = NO;
+	
+	[self updateTrackingAreas];
+	
+	// Invalidate cursors so we use the correct cursor for the selection in the right place
+	[[self window] invalidateCursorRectsForView:self];
+}
+
+- (NSColor *)_findHighlightColor {
+	if (@available(macOS 10.13, *)) {
+		return [NSColor findHighlightColor];
+	} else {
+		return [NSColor yellowColor];
+	}
+}
+
+- (void)_enumerateFindMatchRectsInColumns:(NSRange)columnRange rows:(NSRange)rowRange usingBlock:(void (^)(NSRect rect))block {
+	if ([self tableGrid].numberOfFindMatches == 0) {
+		return;
+	}
+	
+	for (NSUInteger column = [[self tableGrid] _firstShownColumnFrom:columnRange.location]; column < NSMaxRange(columnRange); column = [[self tableGrid] _firstShownColumnFrom:column + 1]) {
+		NSIndexSet *matches = [[self tableGrid] findMatchesInColumn:column];
+		[matches enumerateIndexesInRange:rowRange options:0 usingBlock:^(NSUInteger row, BOOL *stop) {
+			block(NSInsetRect([self frameOfCellAtColumn:column row:row], 1, 1));
+		}];
+	}
+}
+
+/**
+ * @brief		Returns the colour the selection is drawn in.
+ * @details		The selection is grey when the grid isn't focused,
+ *				and takes the fill colour while filling.
+ */
+- (NSColor *)_selectionColorIsDisabled:(BOOL *)disabled {
+	NSColor *selectionColor = [NSColor alternateSelectedControlColor];
+	
+	// If the view is not the first responder, then use a gray selection color
+	NSResponder *firstResponder = [[self window] firstResponder];
+	*disabled = (![[firstResponder class] isSubclassOfClass:[NSView class]] || ![(NSView *)firstResponder isDescendantOf:[self tableGrid]] || ![[self window] isKeyWindow]);
+	
+	if (*disabled) {
+		selectionColor = [[selectionColor colorUsingColorSpaceName:NSDeviceWhiteColorSpace] colorUsingColorSpaceName:NSDeviceRGBColorSpace];
+	} else if (isFilling) {
+		if (@available(macOS 10.13, *)) {
+			selectionColor = [NSColor colorNamed:@"fill-background"];
+		} else {
+			// Fallback on earlier versions
+			selectionColor = [NSColor colorWithCalibratedRed:0.996 green:0.827 blue:0.176 alpha:1.000];
+		}
+	}
+	return selectionColor;
+}
+
+- (void)_enumerateAdditionalSelectionRectsInRect:(NSRect)rect usingBlock:(void (^)(NSRect rect))block {
+	MBTableGridSelection *selection = [self tableGrid].selection;
+	NSUInteger numberOfRects = selection.numberOfRects;
+	if (numberOfRects < 2) {
+		return;
+	}
+	
+	// The last rectangle is the active one, which gets the outlined selection path
+	__block NSUInteger rectIndex = 0;
+	[selection enumerateRectsUsingBlock:^(NSIndexSet *columnIndexes, NSIndexSet *rowIndexes, BOOL *stop) {
+		if (++rectIndex == numberOfRects) {
+			*stop = YES;
+			return;
+		}
+		
+		[columnIndexes enumerateRangesUsingBlock:^(NSRange columnRange, BOOL *stopColumns) {
+			[rowIndexes enumerateRangesUsingBlock:^(NSRange rowRange, BOOL *stopRows) {
+				NSRect topLeft = [self frameOfCellAtColumn:columnRange.location row:rowRange.location];
+				NSRect bottomRight = [self frameOfCellAtColumn:NSMaxRange(columnRange) - 1 row:NSMaxRange(rowRange) - 1];
+				NSRect rangeRect = NSUnionRect(topLeft, bottomRight);
+				
+				if (NSIntersectsRect(rangeRect, rect)) {
+					block(NSInsetRect(rangeRect, 1, 1));
+				}
+			}];
+		}];
+	}];
+}
+
+- (NSRect)_grabHandleRectForSelectionRect:(NSRect)selectionInsetRect {
+	if ([[self tableGrid].selectedColumnIndexes count] != 1 || shouldDrawFillPart == MBTableGridTrackingPartNone) {
+		return NSZeroRect;
+	}
+	
+	CGFloat y = (shouldDrawFillPart == MBTableGridTrackingPartFillTop ? NSMinY(selectionInsetRect) : NSMaxY(selectionInsetRect));
+	return NSMakeRect(NSMidX(selectionInsetRect) - kGRAB_HANDLE_HALF_SIDE_LENGTH - 2, y - kGRAB_HANDLE_HALF_SIDE_LENGTH - 2, kGRAB_HANDLE_SIDE_LENGTH + 4, kGRAB_HANDLE_SIDE_LENGTH + 4);
+}
+
 #pragma mark -
 #pragma mark Notifications
 
@@ -1055,6 +1288,10 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 	}
 	
 	
+	[[self tableGrid] _cancelAutocomplete];
+	self.completedString = nil;
+	self.completions = nil;
+	
 	if (self.autoCompleteWindow) {
 		[self.window removeChildWindow:self.autoCompleteWindow];
 		[self.autoCompleteWindow close];
@@ -1066,12 +1303,30 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 }
 
 - (void)showCompletionsForTextView:(NSTextView *)textView;
+{
+	if (editedRow == NSNotFound) {
+		return;
+	}
+	
+	// Completions arrive later, so the keystroke is never held up. Results for an earlier string are dropped.
+	NSString *editString = [textView.string copy];
+	NSInteger column = editedColumn;
+	NSInteger row = editedRow;
+	
+	[[self tableGrid] _autocompleteValuesForEditString:editString column:column row:row completionHandler:^(NSArray *completions) {
+		if (self->editedColumn == column && self->editedRow == row) {
+			[self _showCompletions:completions forEditString:editString];
+		}
+	}];
+}
+
+- (void)_showCompletions:(NSArray *)completions forEditString:(NSString *)editString
 {
     if (!isCompleting && editedRow != NSNotFound) {
         isCompleting = YES;
-//        [textView complete:self];
 		
-		NSArray *completions = [[self tableGrid] _autocompleteValuesForEditString:textView.string column:editedColumn row:editedRow];
+		self.completedString = editString;
+		self.completions = completions;
 		self.completionsCount = completions.count;
 		if (completions.count == 0) {
 			isCompleting = NO;
@@ -1103,7 +1358,9 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 			self.autoCompleteWindow.level = NSPopUpMenuWindowLevel;
 		}
 		
-		[self.autoCompleteWindow setFrame:windowRect display:YES animate:NO];
+		if (!NSEqualRects(self.autoCompleteWindow.frame, windowRect)) {
+			[self.autoCompleteWindow setFrame:windowRect display:YES animate:NO];
+		}
 		self.autoCompleteWindow.completions = completions;
 		
 		isCompleting = NO;
@@ -1133,8 +1390,9 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 {
     *index = -1;
 		
+    // Only offer what the last query found, rather than waiting for a new one
     NSString *string = textView.string;
-    NSArray *completions = [[self tableGrid] _autocompleteValuesForEditString:string column:editedColumn row:editedRow];
+    NSArray *completions = [string isEqualToString:self.completedString] ? self.completions : @[];
     
     if (string.length && completions.count && [string isEqualToString:[completions firstObject]]) {
         *index = 0;
@@ -1376,42 +1634,25 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 
 - (NSRect)rectOfColumn:(NSUInteger)columnIndex
 {
-	NSRect rect = NSZeroRect;
-	BOOL foundRect = NO;
 	NSInteger numberOfColumns = [self tableGrid].numberOfColumns;
 	
-	if (columnIndex < numberOfColumns) {
-		NSValue *cachedRectValue = [self tableGrid].columnRects[@(columnIndex)];
-		if (cachedRectValue) {
-			rect = [cachedRectValue rectValue];
-			foundRect = YES;
-		}
+	if (numberOfColumns == 0) {
+		return NSZeroRect;
 	}
 	
-	if (!foundRect && numberOfColumns > 0) {
-		float width = [[self tableGrid] _widthForColumn:columnIndex];
-		
-		rect = NSMakeRect(0, 0, width, MAX([self.enclosingScrollView.documentView frame].size.height, self.tableGrid.frame.size.height));
-		//rect.origin.x += 60.0 * columnIndex;
-		
-		NSUInteger i = 0;
-		while(i < columnIndex) {
-			float headerWidth = [[self tableGrid] _widthForColumn:i];
-			rect.origin.x += headerWidth;
-			i++;
-		}
+	MBTableGridColumnLayout *layout = [[self tableGrid] _columnLayout];
 	
-		[self tableGrid].columnRects[@(columnIndex)] = [NSValue valueWithRect:rect];
-
-	}
-	return rect;
+	// Columns past the end (such as the one used to size the document view) use the default width
+	CGFloat width = columnIndex < MBTableGridColumnLayoutCount(layout) ? MBTableGridColumnLayoutWidth(layout, columnIndex) : [[self tableGrid] _widthForColumn:columnIndex];
+	CGFloat height = MAX([self.enclosingScrollView.documentView frame].size.height, self.tableGrid.frame.size.height);
+	
+	return NSMakeRect(MBTableGridColumnLayoutOffset(layout, columnIndex), 0, width, height);
 }
 
 - (NSRect)rectOfRow:(NSUInteger)rowIndex
 {
-	NSInteger numberOfColumns = [self tableGrid].numberOfColumns;
-	NSRect lastColRect = [self rectOfColumn:numberOfColumns - 1];
-	NSRect rect = NSMakeRect(0, 0, NSMaxX(lastColRect), self.cellRowHeight);
+	CGFloat width = MBTableGridColumnLayoutTotalWidth([[self tableGrid] _columnLayout]);
+	NSRect rect = NSMakeRect(0, 0, width, self.cellRowHeight);
 	rect.origin.y += self.cellRowHeight * rowIndex;
 	return rect;
 }
@@ -1425,28 +1666,31 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 
 - (NSInteger)columnAtPoint:(NSPoint)aPoint
 {
-	NSInteger column = 0;
-	while(column < [self tableGrid].numberOfColumns) {
-		NSRect columnFrame = [self rectOfColumn:column];
-		if(NSPointInRect(aPoint, columnFrame)) {
-			return column;
-		}
-		column++;
+	CGFloat height = MAX([self.enclosingScrollView.documentView frame].size.height, self.tableGrid.frame.size.height);
+	if (aPoint.y < 0 || aPoint.y >= height) {
+		return NSNotFound;
 	}
-	return NSNotFound;
+	
+	size_t column = MBTableGridColumnLayoutColumnAtOffset([[self tableGrid] _columnLayout], aPoint.x);
+	return column == MBTableGridCoreNotFound ? NSNotFound : (NSInteger)column;
 }
 
 - (NSInteger)rowAtPoint:(NSPoint)aPoint
 {
-	NSInteger row = 0;
-	while(row < [self tableGrid].numberOfRows) {
-		NSRect rowFrame = [self rectOfRow:row];
-		if(NSPointInRect(aPoint, rowFrame)) {
-			return row;
-		}
-		row++;
+	if (aPoint.x < 0 || aPoint.x >= MBTableGridColumnLayoutTotalWidth([[self tableGrid] _columnLayout])) {
+		return NSNotFound;
 	}
-	return NSNotFound;
+	
+	size_t row = MBTableGridCoreRowAtOffset(aPoint.y, self.cellRowHeight, [self tableGrid].numberOfRows);
+	return row == MBTableGridCoreNotFound ? NSNotFound : (NSInteger)row;
+}
+
+- (NSRect)_disclosureRectOfGroupRow:(NSUInteger)rowIndex
+{
+	// Nested headings are indented by their level, with the triangle in front of the title
+	NSRect rowRect = [self rectOfRow:rowIndex];
+	CGFloat indentation = [[self tableGrid] _levelOfGroupRow:rowIndex] * kGROUP_ROW_INDENTATION;
+	return NSMakeRect(NSMinX(rowRect) + indentation, NSMinY(rowRect), kGROUP_ROW_INDENTATION, NSHeight(rowRect));
 }
 
 - (BOOL)isLightColour:(NSColor *)colour {
@@ -1475,6 +1719,24 @@ NSString * const MBTableGridTrackingPartKey = @"part";
 	return (colorBrightness >= .5f);
 }
 
+- (void)_drawDisclosureTriangleInRect:(NSRect)rect collapsed:(BOOL)collapsed {
+	// Points right while the group is collapsed, and down while it's expanded
+	NSPoint center = NSMakePoint(NSMidX(rect), NSMidY(rect));
+	NSBezierPath *triangle = [NSBezierPath bezierPath];
+	if (collapsed) {
+		[triangle moveToPoint:NSMakePoint(center.x - 3, center.y - 4)];
+		[triangle lineToPoint:NSMakePoint(center.x + 4, center.y)];
+		[triangle lineToPoint:NSMakePoint(center.x - 3, center.y + 4)];
+	} else {
+		[triangle moveToPoint:NSMakePoint(center.x - 4, center.y - 3)];
+		[triangle lineToPoint:NSMakePoint(center.x + 4, center.y - 3)];
+		[triangle lineToPoint:NSMakePoint(center.x, center.y + 4)];
+	}
+	[triangle closePath];
+	[[NSColor secondaryLabelColor] set];
+	[triangle fill];
+}
+
 
 @end
 
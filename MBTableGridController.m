@@ -399,34 +399,9 @@ NSString * const ColumnText4 = @"text4";
 - (id)valueForTableGrid:(MBTableGrid *)aTableGrid groupSummaryColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
 {
     NSUInteger footerItem = [[NSUserDefaults standardUserDefaults] integerForKey:[self footerDefaultsKeyForColumn:columnIndex]];
-    NSUInteger headingIndex = [aTableGrid groupHeadingRowForRow:rowIndex];
+    MBTableGridAggregateFunction function = footerItem < MBTableGridAggregateCount ? footerItem : MBTableGridAggregateCount;
     
-    if (headingIndex == NSNotFound) {
-        return nil;
-    }
-    
-    NSRange range = NSMakeRange(headingIndex + 1, rowIndex - headingIndex - 1);
-    NSArray *column = [columns[columnIndex] subarrayWithRange:range];
-    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"self != ''"];
-    NSArray *group = [column filteredArrayUsingPredicate:predicate];
-    
-    switch (footerItem) {
-        case 0:
-            return [group valueForKeyPath:@"@sum.floatValue"];
-            break;
-        case 1:
-            return [group valueForKeyPath:@"@min.floatValue"];
-            break;
-        case 2:
-            return [group valueForKeyPath:@"@max.floatValue"];
-            break;
-        case 3:
-            return [group valueForKeyPath:@"@avg.floatValue"];
-            break;
-        default:
-            return [group valueForKeyPath:@"@count"];
-            break;
-    }
+    return [aTableGrid aggregateValue:function forColumn:columnIndex groupSummaryRow:rowIndex];
 }
 
 - (NSCell *)tableGrid:(MBTableGrid *)aTableGrid groupSummaryCellForColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
@@ -468,7 +443,7 @@ NSString * const ColumnText4 = @"text4";
             return nil;
         }
         
-        if (footerItem == 4) {
+        if (footerItem >= MBTableGridAggregateCount) {
             value = [NSString stringWithFormat:@"%li", [value integerValue]];
         } else {
             value = [self formattedPrefix:nil value:value forTableGrid:aTableGrid column:columnIndex];
@@ -528,17 +503,22 @@ NSString * const ColumnText4 = @"text4";
         // All others: a popup of Total, Average, etc
         cell = self.footerPopupCell;
         
-        NSPredicate *predicate = [NSPredicate predicateWithFormat:@"self != ''"];
-        NSArray *column = [columns[columnIndex] filteredArrayUsingPredicate:predicate];
-        
         // Rebuild the menu with dynamic values
         [cell.menu removeAllItems];
         
-        [self addItemToMenu:cell.menu withTitle:[self formattedPrefix:@"Total" value:[column valueForKeyPath:@"@sum.floatValue"] forTableGrid:aTableGrid column:columnIndex]];
-        [self addItemToMenu:cell.menu withTitle:[self formattedPrefix:@"Minimum" value:[column valueForKeyPath:@"@min.floatValue"] forTableGrid:aTableGrid column:columnIndex]];
-        [self addItemToMenu:cell.menu withTitle:[self formattedPrefix:@"Maximum" value:[column valueForKeyPath:@"@max.floatValue"] forTableGrid:aTableGrid column:columnIndex]];
-        [self addItemToMenu:cell.menu withTitle:[self formattedPrefix:@"Average" value:[column valueForKeyPath:@"@avg.floatValue"] forTableGrid:aTableGrid column:columnIndex]];
-        [self addItemToMenu:cell.menu withTitle:[NSString stringWithFormat:@"Count: %li", [[column valueForKeyPath:@"@count"] integerValue]]];
+        [self addItemToMenu:cell.menu withTitle:[self formattedPrefix:@"Total" value:[aTableGrid aggregateValue:MBTableGridAggregateSum forColumn:columnIndex] forTableGrid:aTableGrid column:columnIndex]];
+        [self addItemToMenu:cell.menu withTitle:[self formattedPrefix:@"Minimum" value:[aTableGrid aggregateValue:MBTableGridAggregateMinimum forColumn:columnIndex] forTableGrid:aTableGrid column:columnIndex]];
+        [self addItemToMenu:cell.menu withTitle:[self formattedPrefix:@"Maximum" value:[aTableGrid aggregateValue:MBTableGridAggregateMaximum forColumn:columnIndex] forTableGrid:aTableGrid column:columnIndex]];
+        [self addItemToMenu:cell.menu withTitle:[self formattedPrefix:@"Average" value:[aTableGrid aggregateValue:MBTableGridAggregateAverage forColumn:columnIndex] forTableGrid:aTableGrid column:columnIndex]];
+        [self addItemToMenu:cell.menu withTitle:[NSString stringWithFormat:@"Count: %li", [[aTableGrid aggregateValue:MBTableGridAggregateCount forColumn:columnIndex] integerValue]]];
+        
+        // Estimates, which appear once the grid has sketched the column
+        NSNumber *distinctCount = [aTableGrid aggregateValue:MBTableGridAggregateDistinctCount forColumn:columnIndex];
+        NSNumber *median = [aTableGrid aggregateValue:MBTableGridAggregateMedian forColumn:columnIndex];
+        NSNumber *percentile = [aTableGrid aggregateValue:MBTableGridAggregatePercentile95 forColumn:columnIndex];
+        [self addItemToMenu:cell.menu withTitle:distinctCount ? [NSString stringWithFormat:@"Distinct: ≈%li", distinctCount.integerValue] : @"Distinct"];
+        [self addItemToMenu:cell.menu withTitle:median ? [self formattedPrefix:@"Median" value:median forTableGrid:aTableGrid column:columnIndex] : @"Median"];
+        [self addItemToMenu:cell.menu withTitle:percentile ? [self formattedPrefix:@"95th Percentile" value:percentile forTableGrid:aTableGrid column:columnIndex] : @"95th Percentile"];
     }
     
     return cell;
@@ -550,21 +530,18 @@ NSString * const ColumnText4 = @"text4";
         return nil;
     }
     
-    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"self != ''"];
-    NSArray *column = [columns[columnIndex] filteredArrayUsingPredicate:predicate];
-    
     id value = nil;
     NSString *columnIdentifier = self.columnIdentifiers[columnIndex];
     
     if (columnIdentifier == ColumnDate || columnIdentifier == ColumnPopup || columnIdentifier == ColumnCheckbox) {
         // Date, popup & checkbox: just showing the count
-        value = [NSString stringWithFormat:@"Count: %li", [[column valueForKeyPath:@"@count"] integerValue]];
+        value = [NSString stringWithFormat:@"Count: %li", [[aTableGrid aggregateValue:MBTableGridAggregateCount forColumn:columnIndex] integerValue]];
     } else if (columnIdentifier == ColumnImage) {
         // Image: nothing to show
         value = nil;
     } else if (columnIdentifier == ColumnRating) {
         // Rating: average as a rating
-        value = [column valueForKeyPath:@"@avg.floatValue"];
+        value = [aTableGrid aggregateValue:MBTableGridAggregateAverage forColumn:columnIndex];
     } else {
         // All others: a popup of Total, Average, etc
         NSCell *cell = [self tableGrid:aTableGrid footerCellForColumn:columnIndex];
@@ -822,6 +799,8 @@ NSString * const ColumnText4 = @"text4";
 
 - (BOOL)tableGrid:(MBTableGrid *)aTableGrid addRows:(NSUInteger)numberOfRows shouldReload:(BOOL)shouldReload;
 {
+    NSUInteger firstNewRow = [columns.firstObject count];
+    
     for (NSUInteger row = 0; row < numberOfRows; row++) {
         for (NSMutableArray *column in columns) {
             // Add a blank item to each row
@@ -829,10 +808,8 @@ NSString * const ColumnText4 = @"text4";
         }
     }
     
-    [aTableGrid.columnRects removeAllObjects];
-    
     if (shouldReload) {
-        [aTableGrid reloadData];
+        [aTableGrid insertRowsAtIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(firstNewRow, numberOfRows)]];
     }
     
     return YES;
@@ -844,7 +821,7 @@ NSString * const ColumnText4 = @"text4";
         [column removeObjectsAtIndexes:rowIndexes];
     }
     
-    [aTableGrid reloadData];
+    [aTableGrid removeRowsAtIndexes:rowIndexes];
     
     return YES;
 }
@@ -0,0 +1,1282 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "MBTableGridCore.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#pragma mark -
+#pragma mark Column Layout
+
+struct MBTableGridColumnLayout {
+	size_t count;
+	size_t capacity;
+	double *widths;
+	double *tree;		// 1-based Fenwick tree of the widths
+	size_t *shownTree;	// 1-based Fenwick tree counting the columns with a width
+	size_t shownCount;
+};
+
+static bool MBTableGridColumnLayoutReserve(MBTableGridColumnLayout *layout, size_t count) {
+	if (count <= layout->capacity) {
+		return true;
+	}
+	
+	size_t capacity = layout->capacity ? layout->capacity : 16;
+	while (capacity < count) {
+		capacity *= 2;
+	}
+	
+	double *widths = realloc(layout->widths, capacity * sizeof(double));
+	if (!widths) {
+		return false;
+	}
+	layout->widths = widths;
+	
+	double *tree = realloc(layout->tree, (capacity + 1) * sizeof(double));
+	if (!tree) {
+		return false;
+	}
+	layout->tree = tree;
+	
+	size_t *shownTree = realloc(layout->shownTree, (capacity + 1) * sizeof(size_t));
+	if (!shownTree) {
+		return false;
+	}
+	layout->shownTree = shownTree;
+	
+	layout->capacity = capacity;
+	return true;
+}
+
+MBTableGridColumnLayout *MBTableGridColumnLayoutCreate(void) {
+	return calloc(1, sizeof(MBTableGridColumnLayout));
+}
+
+void MBTableGridColumnLayoutFree(MBTableGridColumnLayout *layout) {
+	if (!layout) {
+		return;
+	}
+	free(layout->widths);
+	free(layout->tree);
+	free(layout->shownTree);
+	free(layout);
+}
+
+void MBTableGridColumnLayoutSetWidths(MBTableGridColumnLayout *layout, const double *widths, size_t count) {
+	if (!MBTableGridColumnLayoutReserve(layout, count)) {
+		return;
+	}
+	
+	layout->count = count;
+	if (count > 0) {
+		memcpy(layout->widths, widths, count * sizeof(double));
+	}
+	
+	// Build the trees in O(n) by pushing each node into its parent
+	layout->tree[0] = 0;
+	layout->shownTree[0] = 0;
+	layout->shownCount = 0;
+	for (size_t i = 1; i <= count; i++) {
+		layout->tree[i] = widths[i - 1];
+		layout->shownTree[i] = widths[i - 1] > 0;
+		layout->shownCount += widths[i - 1] > 0;
+	}
+	for (size_t i = 1; i <= count; i++) {
+		size_t parent = i + (i & (~i + 1));
+		if (parent <= count) {
+			layout->tree[parent] += layout->tree[i];
+			layout->shownTree[parent] += layout->shownTree[i];
+		}
+	}
+}
+
+size_t MBTableGridColumnLayoutCount(const MBTableGridColumnLayout *layout) {
+	return layout->count;
+}
+
+double MBTableGridColumnLayoutWidth(const MBTableGridColumnLayout *layout, size_t column) {
+	if (column >= layout->count) {
+		return 0;
+	}
+	return layout->widths[column];
+}
+
+void MBTableGridColumnLayoutSetWidth(MBTableGridColumnLayout *layout, size_t column, double width) {
+	if (column >= layout->count) {
+		return;
+	}
+	
+	double delta = width - layout->widths[column];
+	bool wasShown = layout->widths[column] > 0;
+	bool isShown = width > 0;
+	layout->widths[column] = width;
+	
+	for (size_t i = column + 1; i <= layout->count; i += i & (~i + 1)) {
+		layout->tree[i] += delta;
+	}
+	
+	// Hiding or showing the column changes the count too
+	if (wasShown != isShown) {
+		for (size_t i = column + 1; i <= layout->count; i += i & (~i + 1)) {
+			layout->shownTree[i] = isShown ? layout->shownTree[i] + 1 : layout->shownTree[i] - 1;
+		}
+		layout->shownCount = isShown ? layout->shownCount + 1 : layout->shownCount - 1;
+	}
+}
+
+double MBTableGridColumnLayoutOffset(const MBTableGridColumnLayout *layout, size_t column) {
+	if (column > layout->count) {
+		column = layout->count;
+	}
+	
+	double offset = 0;
+	for (size_t i = column; i > 0; i -= i & (~i + 1)) {
+		offset += layout->tree[i];
+	}
+	return offset;
+}
+
+double MBTableGridColumnLayoutTotalWidth(const MBTableGridColumnLayout *layout) {
+	return MBTableGridColumnLayoutOffset(layout, layout->count);
+}
+
+size_t MBTableGridColumnLayoutColumnAtOffset(const MBTableGridColumnLayout *layout, double offset) {
+	if (offset < 0 || layout->count == 0) {
+		return MBTableGridCoreNotFound;
+	}
+	
+	// Walk down the tree to find how many columns end at or before the offset
+	size_t position = 0;
+	double remaining = offset;
+	size_t step = 1;
+	while ((step << 1) <= layout->count) {
+		step <<= 1;
+	}
+	
+	for (; step > 0; step >>= 1) {
+		size_t next = position + step;
+		if (next <= layout->count && layout->tree[next] <= remaining) {
+			position = next;
+			remaining -= layout->tree[next];
+		}
+	}
+	
+	return position < layout->count ? position : MBTableGridCoreNotFound;
+}
+
+size_t MBTableGridColumnLayoutShownCount(const MBTableGridColumnLayout *layout) {
+	return layout->shownCount;
+}
+
+// The number of shown columns before a column
+static size_t MBTableGridColumnLayoutShownCountBefore(const MBTableGridColumnLayout *layout, size_t column) {
+	size_t count = 0;
+	for (size_t i = column; i > 0; i -= i & (~i + 1)) {
+		count += layout->shownTree[i];
+	}
+	return count;
+}
+
+// The shown column that has rank shown columns before it
+static size_t MBTableGridColumnLayoutShownColumnWithRank(const MBTableGridColumnLayout *layout, size_t rank) {
+	size_t position = 0;
+	size_t step = 1;
+	while ((step << 1) <= layout->count) {
+		step <<= 1;
+	}
+	
+	for (; step > 0; step >>= 1) {
+		size_t next = position + step;
+		if (next <= layout->count && layout->shownTree[next] <= rank) {
+			position = next;
+			rank -= layout->shownTree[next];
+		}
+	}
+	
+	return position;
+}
+
+size_t MBTableGridColumnLayoutFirstShownColumnFrom(const MBTableGridColumnLayout *layout, size_t column) {
+	if (column >= layout->count) {
+		return MBTableGridCoreNotFound;
+	}
+	
+	size_t rank = MBTableGridColumnLayoutShownCountBefore(layout, column);
+	return rank < layout->shownCount ? MBTableGridColumnLayoutShownColumnWithRank(layout, rank) : MBTableGridCoreNotFound;
+}
+
+size_t MBTableGridColumnLayoutLastShownColumnThrough(const MBTableGridColumnLayout *layout, size_t column) {
+	if (layout->count == 0 || column == MBTableGridCoreNotFound) {
+		return MBTableGridCoreNotFound;
+	}
+	
+	size_t rank = MBTableGridColumnLayoutShownCountBefore(layout, column < layout->count ? column + 1 : layout->count);
+	return rank > 0 ? MBTableGridColumnLayoutShownColumnWithRank(layout, rank - 1) : MBTableGridCoreNotFound;
+}
+
+#pragma mark -
+#pragma mark Row Layout
+
+size_t MBTableGridCoreRowAtOffset(double offset, double rowHeight, size_t numberOfRows) {
+	if (offset < 0 || rowHeight <= 0) {
+		return MBTableGridCoreNotFound;
+	}
+	
+	size_t row = (size_t)floor(offset / rowHeight);
+	return row < numberOfRows ? row : MBTableGridCoreNotFound;
+}
+
+bool MBTableGridCoreRowsInSpan(double minOffset, double maxOffset, double rowHeight, size_t numberOfRows, size_t *firstRow, size_t *lastRow) {
+	if (rowHeight <= 0 || numberOfRows == 0 || maxOffset <= 0 || maxOffset <= minOffset) {
+		return false;
+	}
+	
+	double start = floor(fmax(minOffset, 0) / rowHeight);
+	double end = ceil(maxOffset / rowHeight);
+	
+	if (start >= numberOfRows) {
+		return false;
+	}
+	
+	*firstRow = (size_t)start;
+	*lastRow = end >= numberOfRows ? numberOfRows - 1 : (size_t)end - 1;
+	return true;
+}
+
+#pragma mark -
+#pragma mark Group Rows
+
+struct MBTableGridGroupRows {
+	size_t count;
+	size_t capacity;
+	size_t *rows;
+	unsigned char *kinds;
+};
+
+MBTableGridGroupRows *MBTableGridGroupRowsCreate(void) {
+	return calloc(1, sizeof(MBTableGridGroupRows));
+}
+
+void MBTableGridGroupRowsFree(MBTableGridGroupRows *groupRows) {
+	if (!groupRows) {
+		return;
+	}
+	free(groupRows->rows);
+	free(groupRows->kinds);
+	free(groupRows);
+}
+
+void MBTableGridGroupRowsRemoveAll(MBTableGridGroupRows *groupRows) {
+	groupRows->count = 0;
+}
+
+void MBTableGridGroupRowsAdd(MBTableGridGroupRows *groupRows, size_t row, MBTableGridGroupRowKind kind) {
+	if (groupRows->count == groupRows->capacity) {
+		size_t capacity = groupRows->capacity ? groupRows->capacity * 2 : 16;
+		size_t *rows = realloc(groupRows->rows, capacity * sizeof(size_t));
+		if (!rows) {
+			return;
+		}
+		groupRows->rows = rows;
+		
+		unsigned char *kinds = realloc(groupRows->kinds, capacity);
+		if (!kinds) {
+			return;
+		}
+		groupRows->kinds = kinds;
+		
+		groupRows->capacity = capacity;
+	}
+	
+	groupRows->rows[groupRows->count] = row;
+	groupRows->kinds[groupRows->count] = (unsigned char)kind;
+	groupRows->count++;
+}
+
+size_t MBTableGridGroupRowsCount(const MBTableGridGroupRows *groupRows) {
+	return groupRows->count;
+}
+
+size_t MBTableGridGroupRowsRowAtIndex(const MBTableGridGroupRows *groupRows, size_t index) {
+	return index < groupRows->count ? groupRows->rows[index] : MBTableGridCoreNotFound;
+}
+
+MBTableGridGroupRowKind MBTableGridGroupRowsKindAtIndex(const MBTableGridGroupRows *groupRows, size_t index) {
+	return index < groupRows->count ? (MBTableGridGroupRowKind)groupRows->kinds[index] : 0;
+}
+
+size_t MBTableGridGroupRowsCountBefore(const MBTableGridGroupRows *groupRows, size_t row) {
+	// Lower bound: the index of the first group row >= row
+	size_t low = 0;
+	size_t high = groupRows->count;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (groupRows->rows[middle] < row) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+int MBTableGridGroupRowsKind(const MBTableGridGroupRows *groupRows, size_t row) {
+	size_t index = MBTableGridGroupRowsCountBefore(groupRows, row);
+	if (index < groupRows->count && groupRows->rows[index] == row) {
+		return groupRows->kinds[index];
+	}
+	return 0;
+}
+
+size_t MBTableGridGroupRowsPreviousNonGroupRow(const MBTableGridGroupRows *groupRows, size_t row) {
+	if (row == 0) {
+		return 0;
+	}
+	
+	// Step over any run of consecutive group rows directly above
+	size_t candidate = row - 1;
+	size_t index = MBTableGridGroupRowsCountBefore(groupRows, row);
+	while (index > 0 && groupRows->rows[index - 1] == candidate) {
+		if (candidate == 0) {
+			return row;
+		}
+		candidate--;
+		index--;
+	}
+	return candidate;
+}
+
+size_t MBTableGridGroupRowsNextNonGroupRow(const MBTableGridGroupRows *groupRows, size_t row, size_t numberOfRows) {
+	if (row + 1 >= numberOfRows) {
+		return row;
+	}
+	
+	// Step over any run of consecutive group rows directly below
+	size_t candidate = row + 1;
+	size_t index = MBTableGridGroupRowsCountBefore(groupRows, candidate);
+	while (index < groupRows->count && groupRows->rows[index] == candidate) {
+		if (candidate + 1 >= numberOfRows) {
+			return row;
+		}
+		candidate++;
+		index++;
+	}
+	return candidate;
+}
+
+size_t MBTableGridGroupRowsHeadingForRow(const MBTableGridGroupRows *groupRows, size_t row) {
+	size_t index = MBTableGridGroupRowsCountBefore(groupRows, row + 1);
+	while (index > 0) {
+		index--;
+		if (groupRows->kinds[index] == MBTableGridGroupRowHeading) {
+			return groupRows->rows[index];
+		}
+	}
+	return MBTableGridCoreNotFound;
+}
+
+#pragma mark -
+#pragma mark Selection
+
+MBTableGridCoreSelection MBTableGridCoreSelectionExtendToCell(MBTableGridCoreSelection selection, size_t column, size_t row) {
+	// Compensate for sticky edges
+	size_t stickyColumn = selection.stickyColumnEdge == MBTableGridCoreRightEdge ? selection.lastColumn : selection.firstColumn;
+	size_t stickyRow = selection.stickyRowEdge == MBTableGridCoreBottomEdge ? selection.lastRow : selection.firstRow;
+	
+	MBTableGridCoreSelection extended;
+	
+	if (column < stickyColumn) {
+		extended.firstColumn = column;
+		extended.lastColumn = stickyColumn;
+		extended.stickyColumnEdge = MBTableGridCoreRightEdge;
+	} else {
+		extended.firstColumn = stickyColumn;
+		extended.lastColumn = column;
+		extended.stickyColumnEdge = MBTableGridCoreLeftEdge;
+	}
+	
+	if (row < stickyRow) {
+		extended.firstRow = row;
+		extended.lastRow = stickyRow;
+		extended.stickyRowEdge = MBTableGridCoreBottomEdge;
+	} else {
+		extended.firstRow = stickyRow;
+		extended.lastRow = row;
+		extended.stickyRowEdge = MBTableGridCoreTopEdge;
+	}
+	
+	return extended;
+}
+
+#pragma mark -
+#pragma mark Sorting
+
+// Rows are sorted with insertion sort in runs of this length before merging
+#define MBTableGridCoreSortRunLength 32
+
+static inline int MBTableGridCoreCompareRows(size_t row, size_t otherRow, const MBTableGridCoreSortKey *keys, size_t numberOfKeys) {
+	for (size_t index = 0; index < numberOfKeys; index++) {
+		double value = keys[index].values[row];
+		double otherValue = keys[index].values[otherRow];
+		
+		int order = 0;
+		if (value < otherValue) {
+			order = -1;
+		} else if (value > otherValue) {
+			order = 1;
+		} else if (isnan(value) != isnan(otherValue)) {
+			// Empty values go last whichever way the key is sorted
+			return isnan(value) ? 1 : -1;
+		}
+		
+		if (order != 0) {
+			return keys[index].descending ? -order : order;
+		}
+	}
+	
+	return row < otherRow ? -1 : (row > otherRow ? 1 : 0);
+}
+
+void MBTableGridCoreMergeSortedRows(size_t *rows, size_t *scratch, size_t leftCount, size_t count, const MBTableGridCoreSortKey *keys, size_t numberOfKeys) {
+	if (leftCount == 0 || leftCount >= count) {
+		return;
+	}
+	
+	// Nothing to do if the runs are already in order
+	if (MBTableGridCoreCompareRows(rows[leftCount - 1], rows[leftCount], keys, numberOfKeys) <= 0) {
+		return;
+	}
+	
+	memcpy(scratch, rows, leftCount * sizeof(size_t));
+	
+	size_t left = 0;
+	size_t right = leftCount;
+	size_t merged = 0;
+	while (left < leftCount && right < count) {
+		if (MBTableGridCoreCompareRows(rows[right], scratch[left], keys, numberOfKeys) < 0) {
+			rows[merged++] = rows[right++];
+		} else {
+			rows[merged++] = scratch[left++];
+		}
+	}
+	while (left < leftCount) {
+		rows[merged++] = scratch[left++];
+	}
+}
+
+void MBTableGridCoreSortRows(size_t *rows, size_t *scratch, size_t count, const MBTableGridCoreSortKey *keys, size_t numberOfKeys) {
+	for (size_t start = 0; start < count; start += MBTableGridCoreSortRunLength) {
+		size_t end = start + MBTableGridCoreSortRunLength < count ? start + MBTableGridCoreSortRunLength : count;
+		for (size_t index = start + 1; index < end; index++) {
+			size_t row = rows[index];
+			size_t position = index;
+			while (position > start && MBTableGridCoreCompareRows(rows[position - 1], row, keys, numberOfKeys) > 0) {
+				rows[position] = rows[position - 1];
+				position--;
+			}
+			rows[position] = row;
+		}
+	}
+	
+	for (size_t width = MBTableGridCoreSortRunLength; width < count; width *= 2) {
+		for (size_t start = 0; start + width < count; start += 2 * width) {
+			size_t end = start + 2 * width < count ? start + 2 * width : count;
+			MBTableGridCoreMergeSortedRows(rows + start, scratch, width, end - start, keys, numberOfKeys);
+		}
+	}
+}
+
+#pragma mark -
+#pragma mark Row Bitmaps
+
+struct MBTableGridRowBitmap {
+	size_t count;
+	size_t numberOfWords;
+	uint64_t *words;
+	size_t *ranks;
+};
+
+MBTableGridRowBitmap *MBTableGridRowBitmapCreate(size_t count) {
+	MBTableGridRowBitmap *bitmap = calloc(1, sizeof(MBTableGridRowBitmap));
+	if (!bitmap) {
+		return NULL;
+	}
+	
+	bitmap->count = count;
+	bitmap->numberOfWords = (count + 63) / 64;
+	bitmap->words = malloc((bitmap->numberOfWords + 1) * sizeof(uint64_t));
+	bitmap->ranks = calloc(bitmap->numberOfWords + 1, sizeof(size_t));
+	if (!bitmap->words || !bitmap->ranks) {
+		MBTableGridRowBitmapFree(bitmap);
+		return NULL;
+	}
+	
+	memset(bitmap->words, 0xff, bitmap->numberOfWords * sizeof(uint64_t));
+	if (count % 64) {
+		bitmap->words[bitmap->numberOfWords - 1] = (UINT64_C(1) << (count % 64)) - 1;
+	}
+	MBTableGridRowBitmapUpdateRanks(bitmap);
+	
+	return bitmap;
+}
+
+void MBTableGridRowBitmapFree(MBTableGridRowBitmap *bitmap) {
+	if (!bitmap) {
+		return;
+	}
+	free(bitmap->words);
+	free(bitmap->ranks);
+	free(bitmap);
+}
+
+size_t MBTableGridRowBitmapCount(const MBTableGridRowBitmap *bitmap) {
+	return bitmap->count;
+}
+
+uint64_t *MBTableGridRowBitmapWords(MBTableGridRowBitmap *bitmap) {
+	return bitmap->words;
+}
+
+bool MBTableGridRowBitmapIsSet(const MBTableGridRowBitmap *bitmap, size_t row) {
+	return row < bitmap->count && (bitmap->words[row / 64] >> (row % 64)) & 1;
+}
+
+void MBTableGridRowBitmapSet(MBTableGridRowBitmap *bitmap, size_t row) {
+	if (row < bitmap->count) {
+		bitmap->words[row / 64] |= UINT64_C(1) << (row % 64);
+	}
+}
+
+void MBTableGridRowBitmapSetValuesInRange(MBTableGridRowBitmap *bitmap, const double *values, double minimum, double maximum) {
+	size_t count = bitmap->count;
+	for (size_t word = 0; word < bitmap->numberOfWords; word++) {
+		const double *wordValues = values + word * 64;
+		size_t length = count - word * 64 < 64 ? count - word * 64 : 64;
+		uint64_t bits = 0;
+		// Comparisons with NaN are false, so empty values drop out without a branch
+		for (size_t bit = 0; bit < length; bit++) {
+			bits |= (uint64_t)(wordValues[bit] >= minimum && wordValues[bit] <= maximum) << bit;
+		}
+		bitmap->words[word] = bits;
+	}
+}
+
+void MBTableGridRowBitmapSetEmptyValues(MBTableGridRowBitmap *bitmap, const double *values) {
+	size_t count = bitmap->count;
+	for (size_t word = 0; word < bitmap->numberOfWords; word++) {
+		const double *wordValues = values + word * 64;
+		size_t length = count - word * 64 < 64 ? count - word * 64 : 64;
+		uint64_t bits = 0;
+		for (size_t bit = 0; bit < length; bit++) {
+			bits |= (uint64_t)(wordValues[bit] != wordValues[bit]) << bit;
+		}
+		bitmap->words[word] = bits;
+	}
+}
+
+void MBTableGridRowBitmapIntersect(MBTableGridRowBitmap *bitmap, const MBTableGridRowBitmap *other, bool invert) {
+	uint64_t mask = invert ? ~UINT64_C(0) : 0;
+	size_t numberOfWords = bitmap->numberOfWords < other->numberOfWords ? bitmap->numberOfWords : other->numberOfWords;
+	for (size_t word = 0; word < numberOfWords; word++) {
+		bitmap->words[word] &= other->words[word] ^ mask;
+	}
+	for (size_t word = numberOfWords; word < bitmap->numberOfWords; word++) {
+		bitmap->words[word] &= mask;
+	}
+}
+
+void MBTableGridRowBitmapUpdateRanks(MBTableGridRowBitmap *bitmap) {
+	size_t rank = 0;
+	for (size_t word = 0; word < bitmap->numberOfWords; word++) {
+		bitmap->ranks[word] = rank;
+		rank += (size_t)__builtin_popcountll(bitmap->words[word]);
+	}
+	bitmap->ranks[bitmap->numberOfWords] = rank;
+}
+
+size_t MBTableGridRowBitmapSetCount(const MBTableGridRowBitmap *bitmap) {
+	return bitmap->ranks[bitmap->numberOfWords];
+}
+
+size_t MBTableGridRowBitmapRank(const MBTableGridRowBitmap *bitmap, size_t row) {
+	if (row >= bitmap->count) {
+		return MBTableGridRowBitmapSetCount(bitmap);
+	}
+	uint64_t below = (UINT64_C(1) << (row % 64)) - 1;
+	return bitmap->ranks[row / 64] + (size_t)__builtin_popcountll(bitmap->words[row / 64] & below);
+}
+
+size_t MBTableGridRowBitmapSelect(const MBTableGridRowBitmap *bitmap, size_t index) {
+	if (index >= MBTableGridRowBitmapSetCount(bitmap)) {
+		return MBTableGridCoreNotFound;
+	}
+	
+	// The last word with fewer set bits before it than index
+	size_t low = 0;
+	size_t high = bitmap->numberOfWords;
+	while (high - low > 1) {
+		size_t middle = low + (high - low) / 2;
+		if (bitmap->ranks[middle] <= index) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	
+	uint64_t bits = bitmap->words[low];
+	for (size_t remaining = index - bitmap->ranks[low]; remaining > 0; remaining--) {
+		bits &= bits - 1;
+	}
+	return low * 64 + (size_t)__builtin_ctzll(bits);
+}
+
+#pragma mark -
+#pragma mark Collapsed Rows
+
+struct MBTableGridCollapsedRows {
+	size_t count;
+	size_t numberOfWords;
+	size_t numberOfHiddenRows;
+	uint64_t *words;
+	// Fenwick tree of hidden rows per word, from index 1
+	size_t *tree;
+};
+
+MBTableGridCollapsedRows *MBTableGridCollapsedRowsCreate(size_t count) {
+	MBTableGridCollapsedRows *collapsedRows = calloc(1, sizeof(MBTableGridCollapsedRows));
+	if (!collapsedRows) {
+		return NULL;
+	}
+	
+	collapsedRows->count = count;
+	collapsedRows->numberOfWords = (count + 63) / 64;
+	collapsedRows->words = calloc(collapsedRows->numberOfWords + 1, sizeof(uint64_t));
+	collapsedRows->tree = calloc(collapsedRows->numberOfWords + 1, sizeof(size_t));
+	if (!collapsedRows->words || !collapsedRows->tree) {
+		MBTableGridCollapsedRowsFree(collapsedRows);
+		return NULL;
+	}
+	
+	return collapsedRows;
+}
+
+void MBTableGridCollapsedRowsFree(MBTableGridCollapsedRows *collapsedRows) {
+	if (!collapsedRows) {
+		return;
+	}
+	free(collapsedRows->words);
+	free(collapsedRows->tree);
+	free(collapsedRows);
+}
+
+size_t MBTableGridCollapsedRowsCount(const MBTableGridCollapsedRows *collapsedRows) {
+	return collapsedRows->count;
+}
+
+static size_t MBTableGridCollapsedRowsHiddenBeforeWord(const MBTableGridCollapsedRows *collapsedRows, size_t word) {
+	size_t hidden = 0;
+	for (size_t index = word; index > 0; index -= index & (~index + 1)) {
+		hidden += collapsedRows->tree[index];
+	}
+	return hidden;
+}
+
+void MBTableGridCollapsedRowsSetHidden(MBTableGridCollapsedRows *collapsedRows, size_t first, size_t count, bool hidden) {
+	if (first >= collapsedRows->count) {
+		return;
+	}
+	size_t end = count < collapsedRows->count - first ? first + count : collapsedRows->count;
+	
+	for (size_t word = first / 64; word * 64 < end; word++) {
+		size_t start = word * 64 > first ? 0 : first % 64;
+		size_t stop = (word + 1) * 64 < end ? 64 : end - word * 64;
+		uint64_t mask = (stop == 64 ? ~UINT64_C(0) : (UINT64_C(1) << stop) - 1) & ~((UINT64_C(1) << start) - 1);
+		
+		uint64_t bits = collapsedRows->words[word];
+		uint64_t newBits = hidden ? bits | mask : bits & ~mask;
+		if (newBits == bits) {
+			continue;
+		}
+		collapsedRows->words[word] = newBits;
+		
+		// Unsigned arithmetic wraps, so showing rows subtracts
+		size_t delta = (size_t)__builtin_popcountll(newBits) - (size_t)__builtin_popcountll(bits);
+		collapsedRows->numberOfHiddenRows += delta;
+		for (size_t index = word + 1; index <= collapsedRows->numberOfWords; index += index & (~index + 1)) {
+			collapsedRows->tree[index] += delta;
+		}
+	}
+}
+
+bool MBTableGridCollapsedRowsIsHidden(const MBTableGridCollapsedRows *collapsedRows, size_t row) {
+	return row < collapsedRows->count && (collapsedRows->words[row / 64] >> (row % 64)) & 1;
+}
+
+size_t MBTableGridCollapsedRowsVisibleCount(const MBTableGridCollapsedRows *collapsedRows) {
+	return collapsedRows->count - collapsedRows->numberOfHiddenRows;
+}
+
+size_t MBTableGridCollapsedRowsRank(const MBTableGridCollapsedRows *collapsedRows, size_t row) {
+	if (row >= collapsedRows->count) {
+		return MBTableGridCollapsedRowsVisibleCount(collapsedRows);
+	}
+	uint64_t below = (UINT64_C(1) << (row % 64)) - 1;
+	size_t hidden = MBTableGridCollapsedRowsHiddenBeforeWord(collapsedRows, row / 64) + (size_t)__builtin_popcountll(collapsedRows->words[row / 64] & below);
+	return row - hidden;
+}
+
+size_t MBTableGridCollapsedRowsSelect(const MBTableGridCollapsedRows *collapsedRows, size_t index) {
+	if (index >= MBTableGridCollapsedRowsVisibleCount(collapsedRows)) {
+		return MBTableGridCoreNotFound;
+	}
+	
+	// Walk down the tree to the last word with at most index rows shown before it. The last
+	// word counts its padding as shown, which can only make it look fuller than it is.
+	size_t word = 0;
+	size_t shown = 0;
+	size_t step = 1;
+	while (step * 2 <= collapsedRows->numberOfWords) {
+		step *= 2;
+	}
+	for (; step > 0; step /= 2) {
+		size_t next = word + step;
+		if (next <= collapsedRows->numberOfWords && shown + step * 64 - collapsedRows->tree[next] <= index) {
+			word = next;
+			shown += step * 64 - collapsedRows->tree[next];
+		}
+	}
+	
+	uint64_t bits = ~collapsedRows->words[word];
+	for (size_t remaining = index - shown; remaining > 0; remaining--) {
+		bits &= bits - 1;
+	}
+	return word * 64 + (size_t)__builtin_ctzll(bits);
+}
+
+#pragma mark -
+#pragma mark Aggregates
+
+#define MBTableGridAggregateBlockLength 64
+
+struct MBTableGridAggregateTree {
+	size_t count;
+	size_t numberOfLeaves;
+	double *values;
+	// nodes[1] is the root, and the blocks are nodes[numberOfLeaves...]
+	MBTableGridAggregate *nodes;
+};
+
+MBTableGridAggregate MBTableGridAggregateEmpty(void) {
+	MBTableGridAggregate aggregate = { 0, INFINITY, -INFINITY, 0 };
+	return aggregate;
+}
+
+MBTableGridAggregate MBTableGridAggregateCombine(MBTableGridAggregate aggregate, MBTableGridAggregate other) {
+	aggregate.sum += other.sum;
+	aggregate.minimum = other.minimum < aggregate.minimum ? other.minimum : aggregate.minimum;
+	aggregate.maximum = other.maximum > aggregate.maximum ? other.maximum : aggregate.maximum;
+	aggregate.count += other.count;
+	return aggregate;
+}
+
+MBTableGridAggregate MBTableGridAggregateAdd(MBTableGridAggregate aggregate, double value) {
+	if (value != value) {
+		return aggregate;
+	}
+	aggregate.sum += value;
+	aggregate.minimum = value < aggregate.minimum ? value : aggregate.minimum;
+	aggregate.maximum = value > aggregate.maximum ? value : aggregate.maximum;
+	aggregate.count++;
+	return aggregate;
+}
+
+static MBTableGridAggregate MBTableGridAggregateOfValues(const double *values, size_t count) {
+	MBTableGridAggregate aggregate = MBTableGridAggregateEmpty();
+	for (size_t index = 0; index < count; index++) {
+		aggregate = MBTableGridAggregateAdd(aggregate, values[index]);
+	}
+	return aggregate;
+}
+
+static void MBTableGridAggregateTreeUpdateBlock(MBTableGridAggregateTree *tree, size_t block) {
+	size_t start = block * MBTableGridAggregateBlockLength;
+	if (start >= tree->count) {
+		tree->nodes[tree->numberOfLeaves + block] = MBTableGridAggregateEmpty();
+		return;
+	}
+	size_t length = tree->count - start < MBTableGridAggregateBlockLength ? tree->count - start : MBTableGridAggregateBlockLength;
+	tree->nodes[tree->numberOfLeaves + block] = MBTableGridAggregateOfValues(tree->values + start, length);
+}
+
+static void MBTableGridAggregateTreeRebuild(MBTableGridAggregateTree *tree) {
+	for (size_t block = 0; block < tree->numberOfLeaves; block++) {
+		MBTableGridAggregateTreeUpdateBlock(tree, block);
+	}
+	for (size_t node = tree->numberOfLeaves - 1; node > 0; node--) {
+		tree->nodes[node] = MBTableGridAggregateCombine(tree->nodes[2 * node], tree->nodes[2 * node + 1]);
+	}
+	tree->nodes[0] = MBTableGridAggregateEmpty();
+}
+
+MBTableGridAggregateTree *MBTableGridAggregateTreeCreate(const double *values, size_t count) {
+	MBTableGridAggregateTree *tree = calloc(1, sizeof(MBTableGridAggregateTree));
+	if (!tree) {
+		return NULL;
+	}
+	
+	size_t numberOfBlocks = (count + MBTableGridAggregateBlockLength - 1) / MBTableGridAggregateBlockLength;
+	size_t numberOfLeaves = 1;
+	while (numberOfLeaves < numberOfBlocks) {
+		numberOfLeaves *= 2;
+	}
+	
+	tree->count = count;
+	tree->numberOfLeaves = numberOfLeaves;
+	// The values have room for every leaf, so rows can be inserted without reallocating until the tree is full
+	tree->values = malloc(numberOfLeaves * MBTableGridAggregateBlockLength * sizeof(double));
+	tree->nodes = malloc(2 * numberOfLeaves * sizeof(MBTableGridAggregate));
+	if (!tree->values || !tree->nodes) {
+		MBTableGridAggregateTreeFree(tree);
+		return NULL;
+	}
+	
+	if (count) {
+		memcpy(tree->values, values, count * sizeof(double));
+	}
+	MBTableGridAggregateTreeRebuild(tree);
+	
+	return tree;
+}
+
+void MBTableGridAggregateTreeFree(MBTableGridAggregateTree *tree) {
+	if (!tree) {
+		return;
+	}
+	free(tree->values);
+	free(tree->nodes);
+	free(tree);
+}
+
+size_t MBTableGridAggregateTreeCount(const MBTableGridAggregateTree *tree) {
+	return tree->count;
+}
+
+double MBTableGridAggregateTreeValue(const MBTableGridAggregateTree *tree, size_t row) {
+	return row < tree->count ? tree->values[row] : NAN;
+}
+
+static void MBTableGridAggregateTreeUpdateAncestors(MBTableGridAggregateTree *tree, size_t firstBlock, size_t lastBlock) {
+	size_t first = (tree->numberOfLeaves + firstBlock) / 2;
+	size_t last = (tree->numberOfLeaves + lastBlock) / 2;
+	while (first > 0) {
+		for (size_t node = first; node <= last; node++) {
+			tree->nodes[node] = MBTableGridAggregateCombine(tree->nodes[2 * node], tree->nodes[2 * node + 1]);
+		}
+		first /= 2;
+		last /= 2;
+	}
+}
+
+static void MBTableGridAggregateTreeUpdateBlocks(MBTableGridAggregateTree *tree, size_t firstBlock, size_t lastBlock) {
+	for (size_t block = firstBlock; block <= lastBlock; block++) {
+		MBTableGridAggregateTreeUpdateBlock(tree, block);
+	}
+	MBTableGridAggregateTreeUpdateAncestors(tree, firstBlock, lastBlock);
+}
+
+void MBTableGridAggregateTreeSetValue(MBTableGridAggregateTree *tree, size_t row, double value) {
+	MBTableGridAggregateTreeSetValues(tree, row, &value, 1);
+}
+
+void MBTableGridAggregateTreeSetValues(MBTableGridAggregateTree *tree, size_t row, const double *values, size_t count) {
+	if (row >= tree->count || count == 0) {
+		return;
+	}
+	if (count > tree->count - row) {
+		count = tree->count - row;
+	}
+	
+	memcpy(tree->values + row, values, count * sizeof(double));
+	MBTableGridAggregateTreeUpdateBlocks(tree, row / MBTableGridAggregateBlockLength, (row + count - 1) / MBTableGridAggregateBlockLength);
+}
+
+bool MBTableGridAggregateTreeInsertValues(MBTableGridAggregateTree *tree, size_t row, const double *values, size_t count) {
+	if (row > tree->count) {
+		row = tree->count;
+	}
+	if (count == 0) {
+		return true;
+	}
+	
+	// Double the leaves until the rows fit, which is the only time the whole tree is built again
+	size_t newCount = tree->count + count;
+	size_t numberOfLeaves = tree->numberOfLeaves;
+	while (numberOfLeaves * MBTableGridAggregateBlockLength < newCount) {
+		numberOfLeaves *= 2;
+	}
+	if (numberOfLeaves != tree->numberOfLeaves) {
+		double *grownValues = realloc(tree->values, numberOfLeaves * MBTableGridAggregateBlockLength * sizeof(double));
+		if (!grownValues) {
+			return false;
+		}
+		tree->values = grownValues;
+		MBTableGridAggregate *grownNodes = realloc(tree->nodes, 2 * numberOfLeaves * sizeof(MBTableGridAggregate));
+		if (!grownNodes) {
+			return false;
+		}
+		tree->nodes = grownNodes;
+	}
+	
+	memmove(tree->values + row + count, tree->values + row, (tree->count - row) * sizeof(double));
+	memcpy(tree->values + row, values, count * sizeof(double));
+	tree->count = newCount;
+	
+	if (numberOfLeaves != tree->numberOfLeaves) {
+		tree->numberOfLeaves = numberOfLeaves;
+		MBTableGridAggregateTreeRebuild(tree);
+	} else {
+		MBTableGridAggregateTreeUpdateBlocks(tree, row / MBTableGridAggregateBlockLength, (newCount - 1) / MBTableGridAggregateBlockLength);
+	}
+	return true;
+}
+
+void MBTableGridAggregateTreeRemoveValues(MBTableGridAggregateTree *tree, size_t row, size_t count) {
+	if (row >= tree->count || count == 0) {
+		return;
+	}
+	if (count > tree->count - row) {
+		count = tree->count - row;
+	}
+	
+	// The blocks after the removed rows shift down, and the ones left empty at the end are cleared
+	size_t oldCount = tree->count;
+	memmove(tree->values + row, tree->values + row + count, (oldCount - row - count) * sizeof(double));
+	tree->count -= count;
+	MBTableGridAggregateTreeUpdateBlocks(tree, row / MBTableGridAggregateBlockLength, (oldCount - 1) / MBTableGridAggregateBlockLength);
+}
+
+MBTableGridAggregate MBTableGridAggregateTreeQuery(const MBTableGridAggregateTree *tree, size_t row, size_t count) {
+	if (row >= tree->count || count == 0) {
+		return MBTableGridAggregateEmpty();
+	}
+	if (count > tree->count - row) {
+		count = tree->count - row;
+	}
+	
+	size_t end = row + count;
+	size_t firstBlock = (row + MBTableGridAggregateBlockLength - 1) / MBTableGridAggregateBlockLength;
+	size_t endBlock = end / MBTableGridAggregateBlockLength;
+	
+	// Within a single block, just add up the values
+	if (firstBlock >= endBlock) {
+		return MBTableGridAggregateOfValues(tree->values + row, count);
+	}
+	
+	// Partial blocks at either end, and whole blocks from the tree in between
+	MBTableGridAggregate aggregate = MBTableGridAggregateOfValues(tree->values + row, firstBlock * MBTableGridAggregateBlockLength - row);
+	aggregate = MBTableGridAggregateCombine(aggregate, MBTableGridAggregateOfValues(tree->values + endBlock * MBTableGridAggregateBlockLength, end - endBlock * MBTableGridAggregateBlockLength));
+	
+	for (size_t left = firstBlock + tree->numberOfLeaves, right = endBlock + tree->numberOfLeaves; left < right; left /= 2, right /= 2) {
+		if (left & 1) {
+			aggregate = MBTableGridAggregateCombine(aggregate, tree->nodes[left++]);
+		}
+		if (right & 1) {
+			aggregate = MBTableGridAggregateCombine(aggregate, tree->nodes[--right]);
+		}
+	}
+	
+	return aggregate;
+}
+
+MBTableGridAggregate MBTableGridAggregateTreeTotal(const MBTableGridAggregateTree *tree) {
+	return tree->numberOfLeaves > 0 && tree->count > 0 ? tree->nodes[1] : MBTableGridAggregateEmpty();
+}
+
+const double *MBTableGridAggregateTreeValues(const MBTableGridAggregateTree *tree) {
+	return tree->values;
+}
+
+#pragma mark -
+#pragma mark Sketches
+
+static uint64_t MBTableGridHashMix(uint64_t hash) {
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebULL;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+uint64_t MBTableGridHashBytes(const void *bytes, size_t length) {
+	// FNV-1a, with its low bits mixed into the high ones that pick the register
+	const uint8_t *data = bytes;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t index = 0; index < length; index++) {
+		hash ^= data[index];
+		hash *= 0x100000001b3ULL;
+	}
+	return MBTableGridHashMix(hash);
+}
+
+uint64_t MBTableGridHashDouble(double value) {
+	if (value == 0) {
+		value = 0;
+	}
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return MBTableGridHashMix(bits + 0x9e3779b97f4a7c15ULL);
+}
+
+void MBTableGridDistinctCountInit(MBTableGridDistinctCount *sketch) {
+	memset(sketch->registers, 0, sizeof(sketch->registers));
+}
+
+void MBTableGridDistinctCountAdd(MBTableGridDistinctCount *sketch, uint64_t hash) {
+	// The top 12 bits pick the register, which keeps the longest run of leading zeros in the rest
+	size_t index = (size_t)(hash >> 52);
+	uint8_t rank = (uint8_t)__builtin_clzll((hash << 12) | (1ULL << 11)) + 1;
+	if (rank > sketch->registers[index]) {
+		sketch->registers[index] = rank;
+	}
+}
+
+void MBTableGridDistinctCountMerge(MBTableGridDistinctCount *sketch, const MBTableGridDistinctCount *other) {
+	for (size_t index = 0; index < MBTableGridDistinctCountRegisters; index++) {
+		if (other->registers[index] > sketch->registers[index]) {
+			sketch->registers[index] = other->registers[index];
+		}
+	}
+}
+
+double MBTableGridDistinctCountEstimate(const MBTableGridDistinctCount *sketch) {
+	double registers = MBTableGridDistinctCountRegisters;
+	double sum = 0;
+	size_t emptyRegisters = 0;
+	for (size_t index = 0; index < MBTableGridDistinctCountRegisters; index++) {
+		sum += ldexp(1.0, -sketch->registers[index]);
+		emptyRegisters += sketch->registers[index] == 0;
+	}
+	
+	double estimate = 0.7213 / (1.0 + 1.079 / registers) * registers * registers / sum;
+	
+	// Small counts leave registers empty, and counting those is more accurate
+	if (estimate <= 2.5 * registers && emptyRegisters > 0) {
+		estimate = registers * log(registers / emptyRegisters);
+	}
+	return estimate;
+}
+
+#define MBTableGridQuantilesCapacity 200
+#define MBTableGridQuantilesMinimumCapacity 8
+#define MBTableGridQuantilesMaximumLevels 64
+
+struct MBTableGridQuantiles {
+	size_t count;
+	size_t numberOfLevels;
+	size_t numberOfItems;
+	size_t capacity;
+	double *items[MBTableGridQuantilesMaximumLevels];
+	size_t lengths[MBTableGridQuantilesMaximumLevels];
+	size_t allocated[MBTableGridQuantilesMaximumLevels];
+	uint64_t random;
+};
+
+typedef struct {
+	double value;
+	uint64_t weight;
+} MBTableGridQuantilesItem;
+
+static size_t MBTableGridQuantilesLevelCapacity(const MBTableGridQuantiles *sketch, size_t level) {
+	double capacity = ceil(MBTableGridQuantilesCapacity * pow(2.0 / 3.0, (double)(sketch->numberOfLevels - 1 - level)));
+	return capacity < MBTableGridQuantilesMinimumCapacity ? MBTableGridQuantilesMinimumCapacity : (size_t)capacity;
+}
+
+static void MBTableGridQuantilesUpdateCapacity(MBTableGridQuantiles *sketch) {
+	sketch->capacity = 0;
+	for (size_t level = 0; level < sketch->numberOfLevels; level++) {
+		sketch->capacity += MBTableGridQuantilesLevelCapacity(sketch, level);
+	}
+}
+
+static bool MBTableGridQuantilesReserve(MBTableGridQuantiles *sketch, size_t level, size_t length) {
+	if (length <= sketch->allocated[level]) {
+		return true;
+	}
+	size_t allocated = sketch->allocated[level] ? sketch->allocated[level] : MBTableGridQuantilesMinimumCapacity;
+	while (allocated < length) {
+		allocated *= 2;
+	}
+	double *items = realloc(sketch->items[level], allocated * sizeof(double));
+	if (!items) {
+		return false;
+	}
+	sketch->items[level] = items;
+	sketch->allocated[level] = allocated;
+	return true;
+}
+
+static int MBTableGridQuantilesCompareValues(const void *a, const void *b) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+static bool MBTableGridQuantilesCompress(MBTableGridQuantiles *sketch) {
+	while (sketch->numberOfItems > sketch->capacity) {
+		// Compact the lowest level that is full, starting a new level above the top if need be
+		size_t level = 0;
+		while (level < sketch->numberOfLevels - 1 && sketch->lengths[level] < MBTableGridQuantilesLevelCapacity(sketch, level)) {
+			level++;
+		}
+		if (level == sketch->numberOfLevels - 1) {
+			if (sketch->numberOfLevels == MBTableGridQuantilesMaximumLevels) {
+				return true;
+			}
+			sketch->numberOfLevels++;
+			MBTableGridQuantilesUpdateCapacity(sketch);
+		}
+		
+		size_t length = sketch->lengths[level];
+		size_t promoted = length / 2;
+		if (!MBTableGridQuantilesReserve(sketch, level + 1, sketch->lengths[level + 1] + promoted)) {
+			return false;
+		}
+		
+		// An odd value out stays behind, and every other one of the rest moves up a level
+		double *items = sketch->items[level];
+		qsort(items, length, sizeof(double), MBTableGridQuantilesCompareValues);
+		sketch->random ^= sketch->random << 13;
+		sketch->random ^= sketch->random >> 7;
+		sketch->random ^= sketch->random << 17;
+		size_t start = (length & 1) + (sketch->random & 1);
+		double *promotedItems = sketch->items[level + 1] + sketch->lengths[level + 1];
+		for (size_t index = 0; index < promoted; index++) {
+			promotedItems[index] = items[start + 2 * index];
+		}
+		sketch->lengths[level + 1] += promoted;
+		sketch->lengths[level] = length & 1;
+		sketch->numberOfItems -= length - (length & 1) - promoted;
+	}
+	return true;
+}
+
+MBTableGridQuantiles *MBTableGridQuantilesCreate(void) {
+	MBTableGridQuantiles *sketch = calloc(1, sizeof(MBTableGridQuantiles));
+	if (!sketch) {
+		return NULL;
+	}
+	sketch->numberOfLevels = 1;
+	sketch->random = 0x9e3779b97f4a7c15ULL;
+	MBTableGridQuantilesUpdateCapacity(sketch);
+	return sketch;
+}
+
+void MBTableGridQuantilesFree(MBTableGridQuantiles *sketch) {
+	if (!sketch) {
+		return;
+	}
+	for (size_t level = 0; level < MBTableGridQuantilesMaximumLevels; level++) {
+		free(sketch->items[level]);
+	}
+	free(sketch);
+}
+
+void MBTableGridQuantilesAdd(MBTableGridQuantiles *sketch, double value) {
+	if (value != value || !MBTableGridQuantilesReserve(sketch, 0, sketch->lengths[0] + 1)) {
+		return;
+	}
+	sketch->items[0][sketch->lengths[0]++] = value;
+	sketch->numberOfItems++;
+	sketch->count++;
+	MBTableGridQuantilesCompress(sketch);
+}
+
+bool MBTableGridQuantilesMerge(MBTableGridQuantiles *sketch, const MBTableGridQuantiles *other) {
+	if (other->numberOfLevels > sketch->numberOfLevels) {
+		sketch->numberOfLevels = other->numberOfLevels;
+		MBTableGridQuantilesUpdateCapacity(sketch);
+	}
+	for (size_t level = 0; level < other->numberOfLevels; level++) {
+		if (other->lengths[level] == 0) {
+			continue;
+		}
+		if (!MBTableGridQuantilesReserve(sketch, level, sketch->lengths[level] + other->lengths[level])) {
+			return false;
+		}
+		memcpy(sketch->items[level] + sketch->lengths[level], other->items[level], other->lengths[level] * sizeof(double));
+		sketch->lengths[level] += other->lengths[level];
+		sketch->numberOfItems += other->lengths[level];
+	}
+	sketch->count += other->count;
+	return MBTableGridQuantilesCompress(sketch);
+}
+
+size_t MBTableGridQuantilesCount(const MBTableGridQuantiles *sketch) {
+	return sketch->count;
+}
+
+static int MBTableGridQuantilesCompareItems(const void *a, const void *b) {
+	return MBTableGridQuantilesCompareValues(&((const MBTableGridQuantilesItem *)a)->value, &((const MBTableGridQuantilesItem *)b)->value);
+}
+
+double MBTableGridQuantilesValue(const MBTableGridQuantiles *sketch, double rank) {
+	if (sketch->numberOfItems == 0) {
+		return NAN;
+	}
+	MBTableGridQuantilesItem *items = malloc(sketch->numberOfItems * sizeof(MBTableGridQuantilesItem));
+	if (!items) {
+		return NAN;
+	}
+	
+	// Each value stands for as many values as its level is worth
+	size_t numberOfItems = 0;
+	uint64_t totalWeight = 0;
+	for (size_t level = 0; level < sketch->numberOfLevels; level++) {
+		for (size_t index = 0; index < sketch->lengths[level]; index++) {
+			items[numberOfItems].value = sketch->items[level][index];
+			items[numberOfItems].weight = 1ULL << level;
+			numberOfItems++;
+		}
+		totalWeight += (uint64_t)sketch->lengths[level] << level;
+	}
+	qsort(items, numberOfItems, sizeof(MBTableGridQuantilesItem), MBTableGridQuantilesCompareItems);
+	
+	double targetWeight = (rank < 0 ? 0 : rank > 1 ? 1 : rank) * (double)totalWeight;
+	uint64_t weight = 0;
+	double value = items[numberOfItems - 1].value;
+	for (size_t index = 0; index < numberOfItems; index++) {
+		weight += items[index].weight;
+		if ((double)weight >= targetWeight) {
+			value = items[index].value;
+			break;
+		}
+	}
+	free(items);
+	return value;
+}
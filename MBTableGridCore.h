@@ -0,0 +1,570 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file		MBTableGridCore.h
+ *
+ * @brief		Platform independent layout, group row, selection,
+ *				sorting, filtering, aggregation and statistics
+ *				logic for \c MBTableGrid.
+ *
+ * @details		Everything in here is plain C with no AppKit or
+ *				Foundation dependency, so it can be built and
+ *				exercised headlessly. \c MBTableGrid and
+ *				\c MBTableGridContentView are thin adapters on top.
+ */
+
+#ifndef MBTableGridCore_h
+#define MBTableGridCore_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief		Returned when no column or row can be found.
+ */
+#define MBTableGridCoreNotFound ((size_t)-1)
+
+#pragma mark -
+#pragma mark Column Layout
+
+/**
+ * @brief		The widths and offsets of every column.
+ *
+ * @details		Offsets are kept in a Fenwick tree, so finding the
+ *				offset of a column, finding the column at an offset
+ *				and changing a single width are all O(log n),
+ *				rather than summing every width to the left.
+ *
+ *				Hidden columns are columns with no width. A second
+ *				tree counts the columns that are shown, so the
+ *				nearest shown column is also found in O(log n), no
+ *				matter how many hidden columns lie in between.
+ */
+typedef struct MBTableGridColumnLayout MBTableGridColumnLayout;
+
+MBTableGridColumnLayout *MBTableGridColumnLayoutCreate(void);
+void MBTableGridColumnLayoutFree(MBTableGridColumnLayout *layout);
+
+/**
+ * @brief		Replaces every width in the layout in O(n).
+ */
+void MBTableGridColumnLayoutSetWidths(MBTableGridColumnLayout *layout, const double *widths, size_t count);
+
+size_t MBTableGridColumnLayoutCount(const MBTableGridColumnLayout *layout);
+double MBTableGridColumnLayoutWidth(const MBTableGridColumnLayout *layout, size_t column);
+
+/**
+ * @brief		Changes the width of a single column in O(log n).
+ */
+void MBTableGridColumnLayoutSetWidth(MBTableGridColumnLayout *layout, size_t column, double width);
+
+/**
+ * @brief		Returns the x offset of the left edge of a column.
+ *
+ * @details		Passing the column count returns the total width.
+ */
+double MBTableGridColumnLayoutOffset(const MBTableGridColumnLayout *layout, size_t column);
+
+double MBTableGridColumnLayoutTotalWidth(const MBTableGridColumnLayout *layout);
+
+/**
+ * @brief		Returns the column containing an x offset, or
+ *				\c MBTableGridCoreNotFound if it lies outside every
+ *				column. Columns with no width are never returned.
+ */
+size_t MBTableGridColumnLayoutColumnAtOffset(const MBTableGridColumnLayout *layout, double offset);
+
+/**
+ * @brief		Returns the number of columns with a width.
+ */
+size_t MBTableGridColumnLayoutShownCount(const MBTableGridColumnLayout *layout);
+
+/**
+ * @brief		Returns the first column with a width at or after
+ *				\c column, or \c MBTableGridCoreNotFound.
+ */
+size_t MBTableGridColumnLayoutFirstShownColumnFrom(const MBTableGridColumnLayout *layout, size_t column);
+
+/**
+ * @brief		Returns the last column with a width at or before
+ *				\c column, or \c MBTableGridCoreNotFound.
+ */
+size_t MBTableGridColumnLayoutLastShownColumnThrough(const MBTableGridColumnLayout *layout, size_t column);
+
+#pragma mark -
+#pragma mark Row Layout
+
+/**
+ * @brief		Returns the row containing a y offset when every
+ *				row has the same height, or \c MBTableGridCoreNotFound.
+ */
+size_t MBTableGridCoreRowAtOffset(double offset, double rowHeight, size_t numberOfRows);
+
+/**
+ * @brief		Returns the rows intersecting the span from
+ *				\c minOffset to \c maxOffset. Returns \c false if
+ *				there are none.
+ */
+bool MBTableGridCoreRowsInSpan(double minOffset, double maxOffset, double rowHeight, size_t numberOfRows, size_t *firstRow, size_t *lastRow);
+
+#pragma mark -
+#pragma mark Group Rows
+
+typedef enum {
+	MBTableGridGroupRowHeading = 1,
+	MBTableGridGroupRowSummary = 2
+} MBTableGridGroupRowKind;
+
+/**
+ * @brief		A sorted index of the group heading and summary rows.
+ *
+ * @details		Rows must be added in ascending order, which is how
+ *				a single pass over the data source produces them.
+ *				Lookups are binary searches.
+ */
+typedef struct MBTableGridGroupRows MBTableGridGroupRows;
+
+MBTableGridGroupRows *MBTableGridGroupRowsCreate(void);
+void MBTableGridGroupRowsFree(MBTableGridGroupRows *groupRows);
+void MBTableGridGroupRowsRemoveAll(MBTableGridGroupRows *groupRows);
+void MBTableGridGroupRowsAdd(MBTableGridGroupRows *groupRows, size_t row, MBTableGridGroupRowKind kind);
+
+size_t MBTableGridGroupRowsCount(const MBTableGridGroupRows *groupRows);
+size_t MBTableGridGroupRowsRowAtIndex(const MBTableGridGroupRows *groupRows, size_t index);
+MBTableGridGroupRowKind MBTableGridGroupRowsKindAtIndex(const MBTableGridGroupRows *groupRows, size_t index);
+
+/**
+ * @brief		Returns the kind of a row, or 0 if it is not a
+ *				group row.
+ */
+int MBTableGridGroupRowsKind(const MBTableGridGroupRows *groupRows, size_t row);
+
+/**
+ * @brief		Returns the number of group rows before \c row.
+ */
+size_t MBTableGridGroupRowsCountBefore(const MBTableGridGroupRows *groupRows, size_t row);
+
+/**
+ * @brief		Returns the nearest non-group row above \c row, or
+ *				\c row itself if there is none.
+ */
+size_t MBTableGridGroupRowsPreviousNonGroupRow(const MBTableGridGroupRows *groupRows, size_t row);
+
+/**
+ * @brief		Returns the nearest non-group row below \c row, or
+ *				\c row itself if there is none.
+ */
+size_t MBTableGridGroupRowsNextNonGroupRow(const MBTableGridGroupRows *groupRows, size_t row, size_t numberOfRows);
+
+/**
+ * @brief		Returns the group heading at or above \c row, or
+ *				\c MBTableGridCoreNotFound.
+ */
+size_t MBTableGridGroupRowsHeadingForRow(const MBTableGridGroupRows *groupRows, size_t row);
+
+#pragma mark -
+#pragma mark Selection
+
+typedef enum {
+	MBTableGridCoreLeftEdge = 0,
+	MBTableGridCoreRightEdge,
+	MBTableGridCoreTopEdge,
+	MBTableGridCoreBottomEdge
+} MBTableGridCoreEdge;
+
+/**
+ * @brief		A rectangular selection with the edges that stay
+ *				put when it is extended.
+ */
+typedef struct {
+	size_t firstColumn;
+	size_t lastColumn;
+	size_t firstRow;
+	size_t lastRow;
+	MBTableGridCoreEdge stickyColumnEdge;
+	MBTableGridCoreEdge stickyRowEdge;
+} MBTableGridCoreSelection;
+
+/**
+ * @brief		Extends a selection to include a cell, keeping the
+ *				sticky corner fixed, as when shift-clicking.
+ */
+MBTableGridCoreSelection MBTableGridCoreSelectionExtendToCell(MBTableGridCoreSelection selection, size_t column, size_t row);
+
+#pragma mark -
+#pragma mark Sorting
+
+/**
+ * @brief		One column of values to sort rows by.
+ *
+ * @details		\c values holds a value for every row, indexed by
+ *				row. Empty values should be NaN, which sorts after
+ *				everything else in either direction.
+ */
+typedef struct {
+	const double *values;
+	bool descending;
+} MBTableGridCoreSortKey;
+
+/**
+ * @brief		Sorts \c rows by \c keys, in order.
+ *
+ * @details		Rows with equal keys are ordered by row number, so
+ *				the result doesn't depend on the order \c rows
+ *				started in. Runs that are already in order are left
+ *				alone, so sorting a previous result again after a
+ *				few changes is close to O(n).
+ *
+ *				\c scratch must have room for \c count rows.
+ */
+void MBTableGridCoreSortRows(size_t *rows, size_t *scratch, size_t count, const MBTableGridCoreSortKey *keys, size_t numberOfKeys);
+
+/**
+ * @brief		Merges the sorted runs \c rows[0, leftCount) and
+ *				\c rows[leftCount, count) into one.
+ *
+ * @details		\c scratch must have room for \c leftCount rows.
+ */
+void MBTableGridCoreMergeSortedRows(size_t *rows, size_t *scratch, size_t leftCount, size_t count, const MBTableGridCoreSortKey *keys, size_t numberOfKeys);
+
+#pragma mark -
+#pragma mark Row Bitmaps
+
+/**
+ * @brief		One bit per row, with rank and select.
+ *
+ * @details		Bits are kept in 64 row words, and the number of
+ *				set bits before each word is kept alongside them
+ *				once \c MBTableGridRowBitmapUpdateRanks has been
+ *				called. Rank is then O(1) and select O(log n),
+ *				which is what maps displayed rows to filtered rows.
+ *
+ *				The predicate functions overwrite every bit, in
+ *				branch free loops the compiler can vectorize, and
+ *				are combined with \c MBTableGridRowBitmapIntersect.
+ */
+typedef struct MBTableGridRowBitmap MBTableGridRowBitmap;
+
+/**
+ * @brief		Creates a bitmap with every bit set.
+ */
+MBTableGridRowBitmap *MBTableGridRowBitmapCreate(size_t count);
+void MBTableGridRowBitmapFree(MBTableGridRowBitmap *bitmap);
+
+size_t MBTableGridRowBitmapCount(const MBTableGridRowBitmap *bitmap);
+
+/**
+ * @brief		The bits, 64 rows to a word, with row 0 in the
+ *				lowest bit. Bits past the last row must stay clear.
+ *
+ * @details		Threads may write to different words at once.
+ */
+uint64_t *MBTableGridRowBitmapWords(MBTableGridRowBitmap *bitmap);
+
+bool MBTableGridRowBitmapIsSet(const MBTableGridRowBitmap *bitmap, size_t row);
+void MBTableGridRowBitmapSet(MBTableGridRowBitmap *bitmap, size_t row);
+
+/**
+ * @brief		Sets the bits of the rows whose value lies between
+ *				\c minimum and \c maximum inclusive, and clears
+ *				the rest. NaN values never match.
+ */
+void MBTableGridRowBitmapSetValuesInRange(MBTableGridRowBitmap *bitmap, const double *values, double minimum, double maximum);
+
+/**
+ * @brief		Sets the bits of the rows whose value is NaN, and
+ *				clears the rest.
+ */
+void MBTableGridRowBitmapSetEmptyValues(MBTableGridRowBitmap *bitmap, const double *values);
+
+/**
+ * @brief		Clears the bits of \c bitmap that aren't set in
+ *				\c other, or that are set if \c invert is true.
+ */
+void MBTableGridRowBitmapIntersect(MBTableGridRowBitmap *bitmap, const MBTableGridRowBitmap *other, bool invert);
+
+/**
+ * @brief		Counts the set bits ahead of each word. Must be
+ *				called after the bits change and before rank,
+ *				select or the set count are used.
+ */
+void MBTableGridRowBitmapUpdateRanks(MBTableGridRowBitmap *bitmap);
+
+size_t MBTableGridRowBitmapSetCount(const MBTableGridRowBitmap *bitmap);
+
+/**
+ * @brief		Returns the number of set bits before \c row.
+ */
+size_t MBTableGridRowBitmapRank(const MBTableGridRowBitmap *bitmap, size_t row);
+
+/**
+ * @brief		Returns the row of the set bit with \c index set
+ *				bits before it, or \c MBTableGridCoreNotFound.
+ */
+size_t MBTableGridRowBitmapSelect(const MBTableGridRowBitmap *bitmap, size_t index);
+
+#pragma mark -
+#pragma mark Collapsed Rows
+
+/**
+ * @brief		The rows hidden under collapsed group headings.
+ *
+ * @details		Hidden rows are kept as bits in 64 row words, with
+ *				a Fenwick tree over the number of hidden rows in
+ *				each word. Hiding or showing a range changes each
+ *				word once and walks one path of the tree per word,
+ *				so collapsing a large group costs about a word per
+ *				64 rows. Rank and select both take O(log n), which
+ *				is what maps displayed rows to the rows underneath.
+ */
+typedef struct MBTableGridCollapsedRows MBTableGridCollapsedRows;
+
+/**
+ * @brief		Creates a set of rows with none of them hidden.
+ */
+MBTableGridCollapsedRows *MBTableGridCollapsedRowsCreate(size_t count);
+void MBTableGridCollapsedRowsFree(MBTableGridCollapsedRows *collapsedRows);
+
+size_t MBTableGridCollapsedRowsCount(const MBTableGridCollapsedRows *collapsedRows);
+
+/**
+ * @brief		Hides or shows \c count rows from \c first.
+ *				Rows past the end are ignored.
+ */
+void MBTableGridCollapsedRowsSetHidden(MBTableGridCollapsedRows *collapsedRows, size_t first, size_t count, bool hidden);
+
+bool MBTableGridCollapsedRowsIsHidden(const MBTableGridCollapsedRows *collapsedRows, size_t row);
+size_t MBTableGridCollapsedRowsVisibleCount(const MBTableGridCollapsedRows *collapsedRows);
+
+/**
+ * @brief		Returns the number of rows shown before \c row.
+ */
+size_t MBTableGridCollapsedRowsRank(const MBTableGridCollapsedRows *collapsedRows, size_t row);
+
+/**
+ * @brief		Returns the row shown with \c index shown rows
+ *				before it, or \c MBTableGridCoreNotFound.
+ */
+size_t MBTableGridCollapsedRowsSelect(const MBTableGridCollapsedRows *collapsedRows, size_t index);
+
+#pragma mark -
+#pragma mark Aggregates
+
+/**
+ * @brief		The sum, extremes and count of a set of values.
+ *
+ * @details		An empty aggregate has a count of 0, a sum of 0,
+ *				and a minimum and maximum of positive and negative
+ *				infinity.
+ */
+typedef struct {
+	double sum;
+	double minimum;
+	double maximum;
+	size_t count;
+} MBTableGridAggregate;
+
+MBTableGridAggregate MBTableGridAggregateEmpty(void);
+MBTableGridAggregate MBTableGridAggregateCombine(MBTableGridAggregate aggregate, MBTableGridAggregate other);
+
+/**
+ * @brief		Returns \c aggregate with \c value added, unless it
+ *				is NaN.
+ */
+MBTableGridAggregate MBTableGridAggregateAdd(MBTableGridAggregate aggregate, double value);
+
+/**
+ * @brief		The values of a column, with the aggregate of any
+ *				range of rows.
+ *
+ * @details		Rows are grouped in blocks of 64, and the blocks'
+ *				aggregates kept in a segment tree. Changing a value
+ *				and aggregating a range are both O(log n), and the
+ *				total is O(1). The tree holds one node per block
+ *				rather than per row, so it adds little to the
+ *				memory of the values themselves.
+ *
+ *				NaN values are left out of every aggregate.
+ */
+typedef struct MBTableGridAggregateTree MBTableGridAggregateTree;
+
+/**
+ * @brief		Creates a tree from \c count values in O(n).
+ */
+MBTableGridAggregateTree *MBTableGridAggregateTreeCreate(const double *values, size_t count);
+void MBTableGridAggregateTreeFree(MBTableGridAggregateTree *tree);
+
+size_t MBTableGridAggregateTreeCount(const MBTableGridAggregateTree *tree);
+double MBTableGridAggregateTreeValue(const MBTableGridAggregateTree *tree, size_t row);
+
+/**
+ * @brief		Changes the value of a single row.
+ */
+void MBTableGridAggregateTreeSetValue(MBTableGridAggregateTree *tree, size_t row, double value);
+
+/**
+ * @brief		Replaces the values of \c count rows from \c row,
+ *				updating each block they touch once.
+ */
+void MBTableGridAggregateTreeSetValues(MBTableGridAggregateTree *tree, size_t row, const double *values, size_t count);
+
+/**
+ * @brief		Inserts \c count values before \c row.
+ *
+ * @details		The rows after \c row move up, which is a copy of
+ *				the values after it and an update of their blocks,
+ *				rather than reading the column again. The tree
+ *				doubles when it is full.
+ *
+ * @return		\c false if there wasn't enough memory, in which
+ *				case the tree is unchanged.
+ */
+bool MBTableGridAggregateTreeInsertValues(MBTableGridAggregateTree *tree, size_t row, const double *values, size_t count);
+
+/**
+ * @brief		Removes \c count rows from \c row, moving the
+ *				rows after them down.
+ */
+void MBTableGridAggregateTreeRemoveValues(MBTableGridAggregateTree *tree, size_t row, size_t count);
+
+/**
+ * @brief		Returns the aggregate of \c count rows from \c row.
+ */
+MBTableGridAggregate MBTableGridAggregateTreeQuery(const MBTableGridAggregateTree *tree, size_t row, size_t count);
+
+/**
+ * @brief		Returns the aggregate of every row.
+ */
+MBTableGridAggregate MBTableGridAggregateTreeTotal(const MBTableGridAggregateTree *tree);
+
+/**
+ * @brief		The values of every row, which stay valid until
+ *				the tree next changes.
+ */
+const double *MBTableGridAggregateTreeValues(const MBTableGridAggregateTree *tree);
+
+#pragma mark -
+#pragma mark Sketches
+
+/**
+ * @brief		Returns a 64 bit hash of \c length bytes, for
+ *				\c MBTableGridDistinctCountAdd.
+ */
+uint64_t MBTableGridHashBytes(const void *bytes, size_t length);
+
+/**
+ * @brief		Returns a 64 bit hash of a number, with 0 and -0
+ *				hashing alike.
+ */
+uint64_t MBTableGridHashDouble(double value);
+
+#define MBTableGridDistinctCountRegisters 4096
+
+/**
+ * @brief		A HyperLogLog sketch, which estimates how many
+ *				distinct values have been added to it.
+ *
+ * @details		The sketch is 4096 one byte registers, whatever the
+ *				number of values. The standard error of an estimate
+ *				is 1.04 / sqrt(4096), about 1.6%, so two estimates
+ *				in three are within 1.6% of the exact count and 99%
+ *				are within 5%. Counts below about 10,000 are taken
+ *				from the number of empty registers instead, and are
+ *				closer still.
+ *
+ *				Adding a value already added changes nothing, and
+ *				merging the sketches of two sets of values gives the
+ *				sketch of both, so a column can be sketched in
+ *				chunks. Values can't be removed.
+ */
+typedef struct {
+	uint8_t registers[MBTableGridDistinctCountRegisters];
+} MBTableGridDistinctCount;
+
+void MBTableGridDistinctCountInit(MBTableGridDistinctCount *sketch);
+void MBTableGridDistinctCountAdd(MBTableGridDistinctCount *sketch, uint64_t hash);
+void MBTableGridDistinctCountMerge(MBTableGridDistinctCount *sketch, const MBTableGridDistinctCount *other);
+double MBTableGridDistinctCountEstimate(const MBTableGridDistinctCount *sketch);
+
+/**
+ * @brief		A KLL sketch, which estimates quantiles such as
+ *				the median of the values added to it.
+ *
+ * @details		Values are kept in levels, each worth twice as
+ *				much as the one below. When a level is full, it is
+ *				sorted and every other value is promoted, starting
+ *				from a random one of the first two. Levels hold at
+ *				most 200 values, shrinking by a third for each level
+ *				further down to no fewer than 8, so a sketch of any
+ *				number of values needs a few kilobytes.
+ *
+ *				The rank of an estimated quantile is within about
+ *				1.3% of the rank asked for with 99% confidence: the
+ *				estimated median of 10M values is a value whose rank
+ *				is between about 4.87M and 5.13M.
+ *				Sketches of two sets of values merge into a sketch
+ *				of both with the same error. Values can't be
+ *				removed.
+ */
+typedef struct MBTableGridQuantiles MBTableGridQuantiles;
+
+MBTableGridQuantiles *MBTableGridQuantilesCreate(void);
+void MBTableGridQuantilesFree(MBTableGridQuantiles *sketch);
+
+/**
+ * @brief		Adds a value. NaN values are ignored.
+ */
+void MBTableGridQuantilesAdd(MBTableGridQuantiles *sketch, double value);
+
+/**
+ * @brief		Adds the values of \c other to \c sketch.
+ *
+ * @return		\c false if there wasn't enough memory.
+ */
+bool MBTableGridQuantilesMerge(MBTableGridQuantiles *sketch, const MBTableGridQuantiles *other);
+
+/**
+ * @brief		The number of values added.
+ */
+size_t MBTableGridQuantilesCount(const MBTableGridQuantiles *sketch);
+
+/**
+ * @brief		Returns an estimate of the value with \c rank, from
+ *				0 for the minimum to 1 for the maximum, or NaN if
+ *				no values have been added.
+ */
+double MBTableGridQuantilesValue(const MBTableGridQuantiles *sketch, double rank);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBTableGridCore_h */
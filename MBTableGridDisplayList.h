@@ -0,0 +1,198 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class MBTableGridDisplayList;
+
+/**
+ * @brief		The kinds of drawing command that can be stored
+ *				in an \c MBTableGridDisplayList.
+ */
+typedef NS_ENUM(uint8_t, MBDisplayCommandType) {
+	MBDisplayCommandFillRect = 0,
+	MBDisplayCommandStrokeLine,
+	MBDisplayCommandText,
+	MBDisplayCommandImage,
+	MBDisplayCommandTypeCount
+};
+
+/**
+ * @brief		A device independent RGBA colour, so that display
+ *				lists can be replayed without AppKit.
+ */
+typedef struct {
+	CGFloat red;
+	CGFloat green;
+	CGFloat blue;
+	CGFloat alpha;
+} MBDisplayColor;
+
+NS_INLINE MBDisplayColor MBDisplayColorMake(CGFloat red, CGFloat green, CGFloat blue, CGFloat alpha) {
+	MBDisplayColor color = {red, green, blue, alpha};
+	return color;
+}
+
+/**
+ * @brief		A single recorded drawing command.
+ *
+ * @details		Commands are fixed size and stored contiguously.
+ *				Text runs and image names are kept in a shared
+ *				string table and referenced by \c stringIndex.
+ *				For lines, \c rect.origin is the start point and
+ *				\c rect.size is the offset to the end point.
+ */
+typedef struct {
+	MBDisplayCommandType type;
+	uint32_t stringIndex;
+	NSRect rect;
+	CGFloat lineWidth;
+	MBDisplayColor color;
+} MBDisplayCommand;
+
+/**
+ * @brief		A backend replays the commands of a display list.
+ */
+@protocol MBTableGridDisplayListBackend <NSObject>
+
+- (void)fillRect:(NSRect)rect color:(MBDisplayColor)color;
+- (void)strokeLineFromPoint:(NSPoint)startPoint toPoint:(NSPoint)endPoint width:(CGFloat)lineWidth color:(MBDisplayColor)color;
+- (void)drawText:(NSString *)text inRect:(NSRect)rect color:(MBDisplayColor)color;
+- (void)drawImageNamed:(NSString *)imageName inRect:(NSRect)rect;
+
+@optional
+- (void)beginDisplayList:(MBTableGridDisplayList *)displayList;
+- (void)endDisplayList:(MBTableGridDisplayList *)displayList;
+
+@end
+
+/**
+ * @brief		\c MBTableGridDisplayList records the drawing
+ *				commands for part of a grid into a compact buffer.
+ *
+ * @details		The content, header and footer views can record
+ *				what they would draw for a given rect, which a
+ *				backend then replays. This only depends on
+ *				Foundation, so the headless backends below can be
+ *				used for frame cost benchmarks and for golden
+ *				tests of what a viewport draws.
+ */
+@interface MBTableGridDisplayList : NSObject
+
+/**
+ * @brief		The offset added to every recorded command.
+ *
+ * @details		Views set this to their position in the grid, so
+ *				that a single display list can hold the commands
+ *				of several views in grid coordinates.
+ */
+@property (nonatomic) NSPoint origin;
+
+/**
+ * @brief		The number of commands in the receiver.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+- (void)fillRect:(NSRect)rect color:(MBDisplayColor)color;
+- (void)strokeLineFromPoint:(NSPoint)startPoint toPoint:(NSPoint)endPoint width:(CGFloat)lineWidth color:(MBDisplayColor)color;
+- (void)strokeRect:(NSRect)rect width:(CGFloat)lineWidth color:(MBDisplayColor)color;
+- (void)drawText:(NSString *)text inRect:(NSRect)rect color:(MBDisplayColor)color;
+- (void)drawImageNamed:(NSString *)imageName inRect:(NSRect)rect;
+
+/**
+ * @brief		Returns the command at a given index.
+ */
+- (MBDisplayCommand)commandAtIndex:(NSUInteger)index;
+
+/**
+ * @brief		Returns the string referenced by a text or image
+ *				command.
+ */
+- (NSString *)stringForCommand:(MBDisplayCommand)command;
+
+/**
+ * @brief		Removes all commands, keeping the allocated buffer.
+ */
+- (void)removeAllCommands;
+
+/**
+ * @brief		Replays every command, in order, into \c backend.
+ */
+- (void)replayWithBackend:(id<MBTableGridDisplayListBackend>)backend;
+
+@end
+
+/**
+ * @brief		A headless backend that counts commands by type.
+ */
+@interface MBTableGridCountingBackend : NSObject <MBTableGridDisplayListBackend>
+
+@property (nonatomic, readonly) NSUInteger fillCount;
+@property (nonatomic, readonly) NSUInteger lineCount;
+@property (nonatomic, readonly) NSUInteger textCount;
+@property (nonatomic, readonly) NSUInteger imageCount;
+@property (nonatomic, readonly) NSUInteger totalCount;
+
+- (void)reset;
+
+@end
+
+/**
+ * @brief		A headless backend that serializes commands to text.
+ *
+ * @details		Each command is written as one line, with
+ *				coordinates rounded to two decimal places, so the
+ *				output is stable enough to compare against a
+ *				stored golden file.
+ */
+@interface MBTableGridSerializingBackend : NSObject <MBTableGridDisplayListBackend>
+
+@property (nonatomic, readonly) NSString *serializedString;
+
+- (void)reset;
+
+@end
+
+#if __has_include(<AppKit/AppKit.h>)
+#import <AppKit/AppKit.h>
+
+/**
+ * @brief		Converts an \c NSColor to a device independent colour.
+ */
+APPKIT_EXTERN MBDisplayColor MBDisplayColorFromColor(NSColor *color);
+
+/**
+ * @brief		A backend that replays commands into the current
+ *				graphics context.
+ */
+@interface MBTableGridAppKitBackend : NSObject <MBTableGridDisplayListBackend>
+
+/**
+ * @brief		The font used for text runs.
+ */
+@property (nonatomic, strong) NSFont *font;
+
+@end
+#endif
@@ -0,0 +1,307 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridDisplayList.h"
+
+@interface MBTableGridDisplayList ()
+
+@property (nonatomic, strong) NSMutableData *commands;
+@property (nonatomic, strong) NSMutableArray<NSString *> *strings;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *stringIndexes;
+
+@end
+
+@implementation MBTableGridDisplayList
+
+- (instancetype)init {
+	if (self = [super init]) {
+		_commands = [NSMutableData data];
+		_strings = [NSMutableArray array];
+		_stringIndexes = [NSMutableDictionary dictionary];
+		_origin = NSZeroPoint;
+	}
+	return self;
+}
+
+- (NSUInteger)count {
+	return self.commands.length / sizeof(MBDisplayCommand);
+}
+
+#pragma mark -
+#pragma mark Recording
+
+- (uint32_t)_indexOfString:(NSString *)string {
+	// Cell text repeats a lot, so each distinct string is only stored once
+	NSNumber *index = self.stringIndexes[string];
+	if (!index) {
+		index = @(self.strings.count);
+		[self.strings addObject:string];
+		self.stringIndexes[string] = index;
+	}
+	return (uint32_t)index.unsignedIntegerValue;
+}
+
+- (void)_addCommandOfType:(MBDisplayCommandType)type rect:(NSRect)rect lineWidth:(CGFloat)lineWidth color:(MBDisplayColor)color string:(NSString *)string {
+	MBDisplayCommand command;
+	command.type = type;
+	command.stringIndex = string ? [self _indexOfString:string] : UINT32_MAX;
+	command.rect = rect;
+	command.rect.origin.x += self.origin.x;
+	command.rect.origin.y += self.origin.y;
+	command.lineWidth = lineWidth;
+	command.color = color;
+	[self.commands appendBytes:&command length:sizeof(MBDisplayCommand)];
+}
+
+- (void)fillRect:(NSRect)rect color:(MBDisplayColor)color {
+	[self _addCommandOfType:MBDisplayCommandFillRect rect:rect lineWidth:0 color:color string:nil];
+}
+
+- (void)strokeLineFromPoint:(NSPoint)startPoint toPoint:(NSPoint)endPoint width:(CGFloat)lineWidth color:(MBDisplayColor)color {
+	NSRect rect = NSMakeRect(startPoint.x, startPoint.y, endPoint.x - startPoint.x, endPoint.y - startPoint.y);
+	[self _addCommandOfType:MBDisplayCommandStrokeLine rect:rect lineWidth:lineWidth color:color string:nil];
+}
+
+- (void)strokeRect:(NSRect)rect width:(CGFloat)lineWidth color:(MBDisplayColor)color {
+	[self strokeLineFromPoint:NSMakePoint(NSMinX(rect), NSMinY(rect)) toPoint:NSMakePoint(NSMaxX(rect), NSMinY(rect)) width:lineWidth color:color];
+	[self strokeLineFromPoint:NSMakePoint(NSMaxX(rect), NSMinY(rect)) toPoint:NSMakePoint(NSMaxX(rect), NSMaxY(rect)) width:lineWidth color:color];
+	[self strokeLineFromPoint:NSMakePoint(NSMaxX(rect), NSMaxY(rect)) toPoint:NSMakePoint(NSMinX(rect), NSMaxY(rect)) width:lineWidth color:color];
+	[self strokeLineFromPoint:NSMakePoint(NSMinX(rect), NSMaxY(rect)) toPoint:NSMakePoint(NSMinX(rect), NSMinY(rect)) width:lineWidth color:color];
+}
+
+- (void)drawText:(NSString *)text inRect:(NSRect)rect color:(MBDisplayColor)color {
+	if (text.length == 0) {
+		return;
+	}
+	[self _addCommandOfType:MBDisplayCommandText rect:rect lineWidth:0 color:color string:text];
+}
+
+- (void)drawImageNamed:(NSString *)imageName inRect:(NSRect)rect {
+	[self _addCommandOfType:MBDisplayCommandImage rect:rect lineWidth:0 color:MBDisplayColorMake(0, 0, 0, 1) string:imageName ?: @""];
+}
+
+#pragma mark -
+#pragma mark Accessing Commands
+
+- (MBDisplayCommand)commandAtIndex:(NSUInteger)index {
+	NSAssert(index < self.count, @"Display list command index %lu is out of bounds", (unsigned long)index);
+	const MBDisplayCommand *commands = self.commands.bytes;
+	return commands[index];
+}
+
+- (NSString *)stringForCommand:(MBDisplayCommand)command {
+	if (command.stringIndex >= self.strings.count) {
+		return nil;
+	}
+	return self.strings[command.stringIndex];
+}
+
+- (void)removeAllCommands {
+	self.commands.length = 0;
+	[self.strings removeAllObjects];
+	[self.stringIndexes removeAllObjects];
+}
+
+- (void)replayWithBackend:(id<MBTableGridDisplayListBackend>)backend {
+	if ([backend respondsToSelector:@selector(beginDisplayList:)]) {
+		[backend beginDisplayList:self];
+	}
+	
+	const MBDisplayCommand *commands = self.commands.bytes;
+	NSUInteger count = self.count;
+	
+	for (NSUInteger i = 0; i < count; i++) {
+		MBDisplayCommand command = commands[i];
+		switch (command.type) {
+			case MBDisplayCommandFillRect:
+				[backend fillRect:command.rect color:command.color];
+				break;
+			case MBDisplayCommandStrokeLine:
+				[backend strokeLineFromPoint:command.rect.origin
+									 toPoint:NSMakePoint(NSMinX(command.rect) + command.rect.size.width, NSMinY(command.rect) + command.rect.size.height)
+									   width:command.lineWidth
+									   color:command.color];
+				break;
+			case MBDisplayCommandText:
+				[backend drawText:[self stringForCommand:command] inRect:command.rect color:command.color];
+				break;
+			case MBDisplayCommandImage:
+				[backend drawImageNamed:[self stringForCommand:command] inRect:command.rect];
+				break;
+			default:
+				break;
+		}
+	}
+	
+	if ([backend respondsToSelector:@selector(endDisplayList:)]) {
+		[backend endDisplayList:self];
+	}
+}
+
+@end
+
+#pragma mark -
+#pragma mark Headless Backends
+
+@interface MBTableGridCountingBackend ()
+
+@property (nonatomic, readwrite) NSUInteger fillCount;
+@property (nonatomic, readwrite) NSUInteger lineCount;
+@property (nonatomic, readwrite) NSUInteger textCount;
+@property (nonatomic, readwrite) NSUInteger imageCount;
+
+@end
+
+@implementation MBTableGridCountingBackend
+
+- (NSUInteger)totalCount {
+	return self.fillCount + self.lineCount + self.textCount + self.imageCount;
+}
+
+- (void)reset {
+	self.fillCount = 0;
+	self.lineCount = 0;
+	self.textCount = 0;
+	self.imageCount = 0;
+}
+
+- (void)fillRect:(NSRect)rect color:(MBDisplayColor)color {
+	self.fillCount++;
+}
+
+- (void)strokeLineFromPoint:(NSPoint)startPoint toPoint:(NSPoint)endPoint width:(CGFloat)lineWidth color:(MBDisplayColor)color {
+	self.lineCount++;
+}
+
+- (void)drawText:(NSString *)text inRect:(NSRect)rect color:(MBDisplayColor)color {
+	self.textCount++;
+}
+
+- (void)drawImageNamed:(NSString *)imageName inRect:(NSRect)rect {
+	self.imageCount++;
+}
+
+@end
+
+@interface MBTableGridSerializingBackend ()
+
+@property (nonatomic, strong) NSMutableString *output;
+
+@end
+
+@implementation MBTableGridSerializingBackend
+
+- (instancetype)init {
+	if (self = [super init]) {
+		_output = [NSMutableString string];
+	}
+	return self;
+}
+
+- (NSString *)serializedString {
+	return [self.output copy];
+}
+
+- (void)reset {
+	[self.output setString:@""];
+}
+
+static NSString *MBSerializedColor(MBDisplayColor color) {
+	return [NSString stringWithFormat:@"#%02x%02x%02x%02x",
+			(unsigned int)lround(color.red * 255), (unsigned int)lround(color.green * 255),
+			(unsigned int)lround(color.blue * 255), (unsigned int)lround(color.alpha * 255)];
+}
+
+static NSString *MBSerializedRect(NSRect rect) {
+	return [NSString stringWithFormat:@"%.2f %.2f %.2f %.2f", NSMinX(rect), NSMinY(rect), NSWidth(rect), NSHeight(rect)];
+}
+
+- (void)fillRect:(NSRect)rect color:(MBDisplayColor)color {
+	[self.output appendFormat:@"fill %@ %@\n", MBSerializedRect(rect), MBSerializedColor(color)];
+}
+
+- (void)strokeLineFromPoint:(NSPoint)startPoint toPoint:(NSPoint)endPoint width:(CGFloat)lineWidth color:(MBDisplayColor)color {
+	[self.output appendFormat:@"line %.2f %.2f %.2f %.2f %.2f %@\n", startPoint.x, startPoint.y, endPoint.x, endPoint.y, lineWidth, MBSerializedColor(color)];
+}
+
+- (void)drawText:(NSString *)text inRect:(NSRect)rect color:(MBDisplayColor)color {
+	// Escape line breaks so each command stays on a single line
+	NSString *escapedText = [[text stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"] stringByReplacingOccurrencesOfString:@"\n" withString:@"\\n"];
+	[self.output appendFormat:@"text %@ %@ \"%@\"\n", MBSerializedRect(rect), MBSerializedColor(color), escapedText];
+}
+
+- (void)drawImageNamed:(NSString *)imageName inRect:(NSRect)rect {
+	[self.output appendFormat:@"image %@ \"%@\"\n", MBSerializedRect(rect), imageName];
+}
+
+@end
+
+#if __has_include(<AppKit/AppKit.h>)
+
+#pragma mark -
+#pragma mark AppKit Backend
+
+MBDisplayColor MBDisplayColorFromColor(NSColor *color) {
+	NSColor *rgbColor = [color colorUsingColorSpace:[NSColorSpace sRGBColorSpace]];
+	if (!rgbColor) {
+		return MBDisplayColorMake(0, 0, 0, 0);
+	}
+	return MBDisplayColorMake(rgbColor.redComponent, rgbColor.greenComponent, rgbColor.blueComponent, rgbColor.alphaComponent);
+}
+
+static NSColor *MBColorFromDisplayColor(MBDisplayColor color) {
+	return [NSColor colorWithSRGBRed:color.red green:color.green blue:color.blue alpha:color.alpha];
+}
+
+@implementation MBTableGridAppKitBackend
+
+- (void)fillRect:(NSRect)rect color:(MBDisplayColor)color {
+	[MBColorFromDisplayColor(color) set];
+	NSRectFillUsingOperation(rect, NSCompositingOperationSourceOver);
+}
+
+- (void)strokeLineFromPoint:(NSPoint)startPoint toPoint:(NSPoint)endPoint width:(CGFloat)lineWidth color:(MBDisplayColor)color {
+	NSBezierPath *path = [NSBezierPath bezierPath];
+	[path moveToPoint:startPoint];
+	[path lineToPoint:endPoint];
+	[path setLineWidth:lineWidth];
+	[MBColorFromDisplayColor(color) set];
+	[path stroke];
+}
+
+- (void)drawText:(NSString *)text inRect:(NSRect)rect color:(MBDisplayColor)color {
+	NSDictionary *attributes = @{NSFontAttributeName : self.font ?: [NSFont systemFontOfSize:[NSFont systemFontSize]],
+								 NSForegroundColorAttributeName : MBColorFromDisplayColor(color)};
+	[text drawWithRect:rect options:NSStringDrawingUsesLineFragmentOrigin | NSStringDrawingTruncatesLastVisibleLine attributes:attributes];
+}
+
+- (void)drawImageNamed:(NSString *)imageName inRect:(NSRect)rect {
+	NSImage *image = [NSImage imageNamed:imageName];
+	[image drawInRect:rect fromRect:NSZeroRect operation:NSCompositingOperationSourceOver fraction:1.0 respectFlipped:YES hints:nil];
+}
+
+@end
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "MBTableGridCore.h"
+
+typedef NS_ENUM(NSUInteger, MBTableGridFilterKind) {
+	MBTableGridFilterEqual,
+	MBTableGridFilterRange,
+	MBTableGridFilterContains,
+	MBTableGridFilterEmpty
+};
+
+/**
+ * @brief		A condition on the cells of one column, which a row
+ *				has to meet to be shown.
+ *
+ * @details		Filters work on a whole column at once, and write
+ *				which rows match into a row bitmap. Numeric
+ *				conditions run over plain \c double values in
+ *				loops the compiler can vectorize. Text conditions
+ *				are checked in parallel chunks.
+ */
+@interface MBTableGridFilter : NSObject <NSCopying>
+
+/**
+ * @brief		Matches cells equal to \c value. Strings are
+ *				compared with the cell's formatted text.
+ */
++ (instancetype)filterWithColumn:(NSUInteger)columnIndex equalToValue:(id)value;
+
+/**
+ * @brief		Matches numbers, or dates as seconds since the
+ *				reference date, between two values inclusive.
+ *
+ * @details		Pass \c -INFINITY or \c INFINITY to leave either
+ *				end open.
+ */
++ (instancetype)filterWithColumn:(NSUInteger)columnIndex minimumValue:(double)minimumValue maximumValue:(double)maximumValue;
+
+/**
+ * @brief		Matches cells whose formatted text contains
+ *				\c string, ignoring case.
+ */
++ (instancetype)filterWithColumn:(NSUInteger)columnIndex containingString:(NSString *)string;
+
+/**
+ * @brief		Matches cells with no value, \c NSNull or an empty
+ *				string.
+ */
++ (instancetype)filterForEmptyCellsInColumn:(NSUInteger)columnIndex;
+
+/**
+ * @brief		Returns a filter matching exactly the cells this one
+ *				doesn't.
+ */
+- (MBTableGridFilter *)invertedFilter;
+
+@property (nonatomic, readonly) NSUInteger column;
+@property (nonatomic, readonly) MBTableGridFilterKind kind;
+@property (nonatomic, readonly) id value;
+@property (nonatomic, readonly) double minimumValue;
+@property (nonatomic, readonly) double maximumValue;
+@property (nonatomic, readonly, getter=isInverted) BOOL inverted;
+
+/**
+ * @brief		Whether the filter can be checked against numbers
+ *				alone.
+ */
+@property (nonatomic, readonly) BOOL canEvaluateNumericValues;
+
+/**
+ * @brief		Sets the bit of each row that matches, ignoring
+ *				\c inverted, and clears the rest.
+ *
+ * @param		values		One value per row of \c bitmap, with NaN
+ *							for empty cells.
+ */
+- (void)evaluateNumericValues:(const double *)values intoBitmap:(MBTableGridRowBitmap *)bitmap;
+
+/**
+ * @brief		Sets the bit of each row that matches, ignoring
+ *				\c inverted, and clears the rest.
+ *
+ * @param		values		One object per row of \c bitmap.
+ * @param		formatter	The column's formatter, or \c nil. Each
+ *							thread formats with its own copy.
+ */
+- (void)evaluateObjectValues:(NSArray *)values formatter:(NSFormatter *)formatter intoBitmap:(MBTableGridRowBitmap *)bitmap;
+
+@end
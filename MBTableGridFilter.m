@@ -0,0 +1,186 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridFilter.h"
+#import "MBTableGridTabularText.h"
+
+// Rows of object values checked per block, a whole number of bitmap words
+static const NSUInteger MBTableGridFilterChunkLength = 4096;
+
+@interface MBTableGridFilter ()
+
+@property (nonatomic, readwrite) NSUInteger column;
+@property (nonatomic, readwrite) MBTableGridFilterKind kind;
+@property (nonatomic, readwrite) id value;
+@property (nonatomic, readwrite) double minimumValue;
+@property (nonatomic, readwrite) double maximumValue;
+@property (nonatomic, readwrite, getter=isInverted) BOOL inverted;
+
+@end
+
+@implementation MBTableGridFilter
+
++ (instancetype)_filterWithColumn:(NSUInteger)columnIndex kind:(MBTableGridFilterKind)kind {
+	MBTableGridFilter *filter = [self new];
+	filter.column = columnIndex;
+	filter.kind = kind;
+	filter.minimumValue = -INFINITY;
+	filter.maximumValue = INFINITY;
+	return filter;
+}
+
++ (instancetype)filterWithColumn:(NSUInteger)columnIndex equalToValue:(id)value {
+	MBTableGridFilter *filter = [self _filterWithColumn:columnIndex kind:MBTableGridFilterEqual];
+	filter.value = value;
+	if ([value isKindOfClass:[NSNumber class]]) {
+		filter.minimumValue = [value doubleValue];
+		filter.maximumValue = [value doubleValue];
+	}
+	return filter;
+}
+
++ (instancetype)filterWithColumn:(NSUInteger)columnIndex minimumValue:(double)minimumValue maximumValue:(double)maximumValue {
+	MBTableGridFilter *filter = [self _filterWithColumn:columnIndex kind:MBTableGridFilterRange];
+	filter.minimumValue = minimumValue;
+	filter.maximumValue = maximumValue;
+	return filter;
+}
+
++ (instancetype)filterWithColumn:(NSUInteger)columnIndex containingString:(NSString *)string {
+	MBTableGridFilter *filter = [self _filterWithColumn:columnIndex kind:MBTableGridFilterContains];
+	filter.value = [string copy];
+	return filter;
+}
+
++ (instancetype)filterForEmptyCellsInColumn:(NSUInteger)columnIndex {
+	return [self _filterWithColumn:columnIndex kind:MBTableGridFilterEmpty];
+}
+
+- (MBTableGridFilter *)invertedFilter {
+	MBTableGridFilter *filter = [MBTableGridFilter _filterWithColumn:self.column kind:self.kind];
+	filter.value = self.value;
+	filter.minimumValue = self.minimumValue;
+	filter.maximumValue = self.maximumValue;
+	filter.inverted = !self.inverted;
+	return filter;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+	return self;
+}
+
+- (BOOL)canEvaluateNumericValues {
+	switch (self.kind) {
+		case MBTableGridFilterEqual:
+			return [self.value isKindOfClass:[NSNumber class]];
+		case MBTableGridFilterRange:
+		case MBTableGridFilterEmpty:
+			return YES;
+		default:
+			return NO;
+	}
+}
+
+#pragma mark -
+#pragma mark Evaluating
+
+- (void)evaluateNumericValues:(const double *)values intoBitmap:(MBTableGridRowBitmap *)bitmap {
+	NSAssert(self.canEvaluateNumericValues, @"Text filters need object values");
+	
+	if (self.kind == MBTableGridFilterEmpty) {
+		MBTableGridRowBitmapSetEmptyValues(bitmap, values);
+	} else {
+		MBTableGridRowBitmapSetValuesInRange(bitmap, values, self.minimumValue, self.maximumValue);
+	}
+}
+
+static BOOL MBTableGridFilterIsEmpty(id value) {
+	return !value || value == [NSNull null] || ([value isKindOfClass:[NSString class]] && [value length] == 0);
+}
+
+- (void)evaluateObjectValues:(NSArray *)values formatter:(NSFormatter *)formatter intoBitmap:(MBTableGridRowBitmap *)bitmap {
+	size_t count = MBTableGridRowBitmapCount(bitmap);
+	
+	// Ranges compare numbers and dates, so convert those and use the numeric loop
+	if (self.kind == MBTableGridFilterRange) {
+		double *numericValues = malloc(MAX(count, 1) * sizeof(double));
+		for (size_t row = 0; row < count; row++) {
+			id value = row < values.count ? values[row] : nil;
+			if ([value isKindOfClass:[NSNumber class]]) {
+				numericValues[row] = [value doubleValue];
+			} else if ([value isKindOfClass:[NSDate class]]) {
+				numericValues[row] = [value timeIntervalSinceReferenceDate];
+			} else {
+				numericValues[row] = NAN;
+			}
+		}
+		MBTableGridRowBitmapSetValuesInRange(bitmap, numericValues, self.minimumValue, self.maximumValue);
+		free(numericValues);
+		return;
+	}
+	
+	MBTableGridFilterKind kind = self.kind;
+	id target = self.value;
+	BOOL comparesText = [target isKindOfClass:[NSString class]];
+	uint64_t *words = MBTableGridRowBitmapWords(bitmap);
+	
+	// Each worker formats with its own copy of the formatter
+	size_t numberOfChunks = (count + MBTableGridFilterChunkLength - 1) / MBTableGridFilterChunkLength;
+	NSArray<NSArray *> *formatterCopies = [MBTableGridTabularText formatterCopiesForWorkers:@[formatter ?: [NSNull null]]];
+	[MBTableGridTabularText applyChunks:numberOfChunks formatterCopies:formatterCopies queue:dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0) block:^(NSUInteger chunk, NSArray *workerFormatters) {
+		id workerFormatter = workerFormatters.firstObject;
+		NSFormatter *chunkFormatter = workerFormatter == [NSNull null] ? nil : workerFormatter;
+		size_t start = chunk * MBTableGridFilterChunkLength;
+		size_t end = MIN(start + MBTableGridFilterChunkLength, count);
+		
+		// Each chunk owns whole words, so no two threads write to the same one
+		for (size_t word = start / 64; word * 64 < end; word++) {
+			uint64_t bits = 0;
+			for (size_t row = word * 64; row < MIN(word * 64 + 64, end); row++) {
+				id value = row < values.count ? values[row] : nil;
+				BOOL matches = NO;
+				switch (kind) {
+					case MBTableGridFilterEmpty:
+						matches = MBTableGridFilterIsEmpty(value);
+						break;
+					case MBTableGridFilterContains:
+						matches = [target length] == 0 || (!MBTableGridFilterIsEmpty(value) && [[MBTableGridTabularText stringForValue:value formatter:chunkFormatter] rangeOfString:target options:NSCaseInsensitiveSearch].location != NSNotFound);
+						break;
+					default:
+						if (comparesText) {
+							matches = !MBTableGridFilterIsEmpty(value) && [[MBTableGridTabularText stringForValue:value formatter:chunkFormatter] isEqualToString:target];
+						} else {
+							matches = [value isEqual:target];
+						}
+						break;
+				}
+				bits |= (uint64_t)matches << (row % 64);
+			}
+			words[word] = bits;
+		}
+	}];
+}
+
+@end
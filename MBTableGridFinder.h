@@ -0,0 +1,118 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief		\c MBTableGridFinder searches the text of a grid's
+ *				cells for a string.
+ *
+ * @details		Rows are split into chunks that are compared in
+ *				parallel on a background queue. Matches are handed
+ *				back on the main thread a chunk at a time, as they
+ *				are found, so they can be shown before the search
+ *				ends.
+ *
+ *				Cell values come from \c valueProvider. Unless
+ *				\c readsValuesConcurrently is set, values are read
+ *				on the main thread in short batches, between which
+ *				the run loop keeps going. Only the comparisons then
+ *				happen in the background.
+ */
+@interface MBTableGridFinder : NSObject
+
+/**
+ * @brief		Creates a finder for \c searchString.
+ *
+ * @param		searchString		The text to look for.
+ * @param		compareOptions		The options to compare cell text
+ *									with, such as
+ *									\c NSCaseInsensitiveSearch.
+ * @param		matchesWholeCell	Whether the whole text of a cell
+ *									has to match, rather than part
+ *									of it.
+ */
+- (instancetype)initWithSearchString:(NSString *)searchString compareOptions:(NSStringCompareOptions)compareOptions matchesWholeCell:(BOOL)matchesWholeCell;
+
+/**
+ * @brief		The text being looked for.
+ */
+@property (nonatomic, copy, readonly) NSString *searchString;
+
+/**
+ * @brief		Returns the value of a cell.
+ */
+@property (nonatomic, copy) id (^valueProvider)(NSUInteger columnIndex, NSUInteger rowIndex);
+
+/**
+ * @brief		The formatter for each column, or \c NSNull to
+ *				search a column's raw values.
+ *
+ * @details		When values are read concurrently, each thread
+ *				formats with its own copies.
+ */
+@property (nonatomic, copy) NSArray *formatters;
+
+/**
+ * @brief		Whether \c valueProvider can be called from any
+ *				thread. The default is \c NO.
+ */
+@property (nonatomic) BOOL readsValuesConcurrently;
+
+/**
+ * @brief		Whether \c cancel was called.
+ */
+@property (atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+/**
+ * @brief		Searches every column in the given rows.
+ *
+ * @param		numberOfColumns		The number of columns to search.
+ * @param		rowIndexes			The rows to search.
+ * @param		matchesHandler		Called on the main thread with the
+ *									matching rows of each column,
+ *									every time a chunk has matches.
+ *									Chunks can finish in any order.
+ * @param		completionHandler	Called on the main thread when all
+ *									the rows have been searched, unless
+ *									the search was cancelled.
+ */
+- (void)searchNumberOfColumns:(NSUInteger)numberOfColumns rows:(NSIndexSet *)rowIndexes matchesHandler:(void (^)(NSArray<NSIndexSet *> *matchesByColumn))matchesHandler completionHandler:(void (^)(void))completionHandler;
+
+/**
+ * @brief		Returns whether a cell value matches, such as the
+ *				new value of an edited cell.
+ *
+ * @details		Only call this on the main thread, since it formats
+ *				with \c formatters rather than copies.
+ */
+- (BOOL)matchesValue:(id)value column:(NSUInteger)columnIndex;
+
+/**
+ * @brief		Stops the search. No more handlers are called.
+ */
+- (void)cancel;
+
+@end
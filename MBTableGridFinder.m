@@ -0,0 +1,228 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridFinder.h"
+#import "MBTableGridTabularText.h"
+
+// Rows compared together as one unit of work
+static const NSUInteger MBTableGridFinderRowsPerChunk = 4096;
+
+// How long values are read on the main thread before the run loop gets a turn
+static const NSTimeInterval MBTableGridFinderReadInterval = 0.008;
+
+@interface MBTableGridFinder ()
+
+@property (nonatomic, copy, readwrite) NSString *searchString;
+@property (nonatomic) NSStringCompareOptions compareOptions;
+@property (nonatomic) BOOL matchesWholeCell;
+@property (atomic, readwrite, getter=isCancelled) BOOL cancelled;
+
+@property (nonatomic) NSUInteger numberOfColumns;
+@property (nonatomic) NSUInteger numberOfRows;
+@property (nonatomic, strong) NSData *rowData;
+@property (nonatomic, strong) dispatch_group_t group;
+@property (nonatomic, copy) void (^matchesHandler)(NSArray<NSIndexSet *> *matchesByColumn);
+
+@end
+
+@implementation MBTableGridFinder
+
+- (instancetype)initWithSearchString:(NSString *)searchString compareOptions:(NSStringCompareOptions)compareOptions matchesWholeCell:(BOOL)matchesWholeCell {
+	if (self = [super init]) {
+		_searchString = [searchString copy];
+		_compareOptions = compareOptions;
+		_matchesWholeCell = matchesWholeCell;
+	}
+	return self;
+}
+
+- (void)cancel {
+	self.cancelled = YES;
+}
+
+- (void)searchNumberOfColumns:(NSUInteger)numberOfColumns rows:(NSIndexSet *)rowIndexes matchesHandler:(void (^)(NSArray<NSIndexSet *> *matchesByColumn))matchesHandler completionHandler:(void (^)(void))completionHandler {
+	self.numberOfColumns = numberOfColumns;
+	self.numberOfRows = rowIndexes.count;
+	self.matchesHandler = matchesHandler;
+	self.group = dispatch_group_create();
+	
+	// Keep the rows in a flat buffer, so a chunk is just a range of it
+	NSMutableData *rowData = [NSMutableData dataWithLength:MAX(self.numberOfRows, 1) * sizeof(NSUInteger)];
+	[rowIndexes getIndexes:rowData.mutableBytes maxCount:self.numberOfRows inIndexRange:nil];
+	self.rowData = rowData;
+	
+	NSUInteger numberOfChunks = (self.numberOfRows + MBTableGridFinderRowsPerChunk - 1) / MBTableGridFinderRowsPerChunk;
+	dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+	
+	if (self.readsValuesConcurrently) {
+		// Formatters aren't thread-safe, so each worker formats with its own copies
+		NSArray<NSArray *> *formatterCopies = [MBTableGridTabularText formatterCopiesForWorkers:self.formatters];
+		dispatch_group_async(self.group, queue, ^{
+			[MBTableGridTabularText applyChunks:numberOfChunks formatterCopies:formatterCopies queue:queue block:^(NSUInteger chunk, NSArray *formatters) {
+				if (self.cancelled) {
+					return;
+				}
+				NSArray *strings = [self _stringsInChunk:chunk formatters:formatters];
+				[self _deliverMatches:[self _matchesInChunk:chunk strings:strings]];
+			}];
+		});
+		[self _notifyCompletion:completionHandler];
+	} else {
+		[self _readChunksFromChunk:0 numberOfChunks:numberOfChunks completionHandler:completionHandler];
+	}
+}
+
+- (void)_readChunksFromChunk:(NSUInteger)firstChunk numberOfChunks:(NSUInteger)numberOfChunks completionHandler:(void (^)(void))completionHandler {
+	if (self.cancelled) {
+		return;
+	}
+	
+	// Read as many chunks as fit in a short interval, then compare them in the background while reading goes on
+	NSMutableArray<NSArray<NSString *> *> *chunkStrings = [NSMutableArray array];
+	NSDate *start = [NSDate date];
+	NSUInteger chunk = firstChunk;
+	while (chunk < numberOfChunks && (chunkStrings.count == 0 || -[start timeIntervalSinceNow] < MBTableGridFinderReadInterval)) {
+		[chunkStrings addObject:[self _stringsInChunk:chunk formatters:self.formatters]];
+		chunk++;
+	}
+	
+	if (chunkStrings.count > 0) {
+		dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+		dispatch_group_async(self.group, queue, ^{
+			dispatch_apply(chunkStrings.count, queue, ^(size_t index) {
+				if (!self.cancelled) {
+					[self _deliverMatches:[self _matchesInChunk:firstChunk + index strings:chunkStrings[index]]];
+				}
+			});
+		});
+	}
+	
+	if (chunk < numberOfChunks) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self _readChunksFromChunk:chunk numberOfChunks:numberOfChunks completionHandler:completionHandler];
+		});
+	} else {
+		[self _notifyCompletion:completionHandler];
+	}
+}
+
+- (void)_notifyCompletion:(void (^)(void))completionHandler {
+	dispatch_group_notify(self.group, dispatch_get_main_queue(), ^{
+		if (!self.cancelled && completionHandler) {
+			completionHandler();
+		}
+	});
+}
+
+#pragma mark -
+#pragma mark Chunks
+
+- (NSRange)_rangeOfChunk:(NSUInteger)chunk {
+	NSUInteger location = chunk * MBTableGridFinderRowsPerChunk;
+	return NSMakeRange(location, MIN(MBTableGridFinderRowsPerChunk, self.numberOfRows - location));
+}
+
+- (NSArray<NSString *> *)_stringsInChunk:(NSUInteger)chunk formatters:(NSArray *)formatters {
+	NSRange range = [self _rangeOfChunk:chunk];
+	const NSUInteger *rows = (const NSUInteger *)self.rowData.bytes + range.location;
+	NSMutableArray<NSString *> *strings = [NSMutableArray arrayWithCapacity:range.length * self.numberOfColumns];
+	
+	// Column by column, so each column's formatter is looked up once
+	for (NSUInteger column = 0; column < self.numberOfColumns; column++) {
+		NSFormatter *formatter = column < formatters.count ? formatters[column] : nil;
+		if ((id)formatter == [NSNull null]) {
+			formatter = nil;
+		}
+		
+		for (NSUInteger i = 0; i < range.length; i++) {
+			id value = self.valueProvider(column, rows[i]);
+			[strings addObject:[MBTableGridTabularText stringForValue:value formatter:formatter]];
+		}
+	}
+	
+	return strings;
+}
+
+- (BOOL)_matchesString:(NSString *)string {
+	if (string.length == 0) {
+		return NO;
+	} else if (self.matchesWholeCell) {
+		return [string compare:self.searchString options:self.compareOptions] == NSOrderedSame;
+	}
+	return [string rangeOfString:self.searchString options:self.compareOptions].location != NSNotFound;
+}
+
+- (BOOL)matchesValue:(id)value column:(NSUInteger)columnIndex {
+	NSFormatter *formatter = columnIndex < self.formatters.count ? self.formatters[columnIndex] : nil;
+	if ((id)formatter == [NSNull null]) {
+		formatter = nil;
+	}
+	return [self _matchesString:[MBTableGridTabularText stringForValue:value formatter:formatter]];
+}
+
+- (NSArray<NSIndexSet *> *)_matchesInChunk:(NSUInteger)chunk strings:(NSArray<NSString *> *)strings {
+	NSRange range = [self _rangeOfChunk:chunk];
+	const NSUInteger *rows = (const NSUInteger *)self.rowData.bytes + range.location;
+	NSMutableArray<NSIndexSet *> *matchesByColumn = nil;
+	
+	for (NSUInteger column = 0; column < self.numberOfColumns; column++) {
+		NSMutableIndexSet *matches = nil;
+		
+		for (NSUInteger i = 0; i < range.length; i++) {
+			if ([self _matchesString:strings[column * range.length + i]]) {
+				matches = matches ?: [NSMutableIndexSet indexSet];
+				[matches addIndex:rows[i]];
+			}
+		}
+		
+		if (matches) {
+			if (!matchesByColumn) {
+				matchesByColumn = [NSMutableArray arrayWithCapacity:self.numberOfColumns];
+				for (NSUInteger previousColumn = 0; previousColumn < column; previousColumn++) {
+					[matchesByColumn addObject:[NSIndexSet indexSet]];
+				}
+			}
+			[matchesByColumn addObject:matches];
+		} else if (matchesByColumn) {
+			[matchesByColumn addObject:[NSIndexSet indexSet]];
+		}
+	}
+	
+	return matchesByColumn;
+}
+
+- (void)_deliverMatches:(NSArray<NSIndexSet *> *)matchesByColumn {
+	if (!matchesByColumn) {
+		return;
+	}
+	
+	dispatch_async(dispatch_get_main_queue(), ^{
+		if (!self.cancelled) {
+			self.matchesHandler(matchesByColumn);
+		}
+	});
+}
+
+@end
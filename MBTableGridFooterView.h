@@ -26,7 +26,7 @@
 #import <Cocoa/Cocoa.h>
 #import "MBFooterPopupButtonCell.h"
 
-@class MBTableGrid, MBFooterTextCell;
+@class MBTableGrid, MBFooterTextCell, MBTableGridDisplayList;
 
 /**
  * @brief		\c MBTableGridHeaderView deals with the
@@ -96,20 +96,26 @@
  */
 
 /**
- * @brief		Returns the rectangle containing the header tile for
+ * @brief		Returns the rectangle containing the footer tile for
  *				the column at \c columnIndex.
  * @param		columnIndex	The index of the column containing the
- *							header whose rectangle you want.
- * @return		A rectangle locating the header for the column at
- *				\c columnIndex. Returns \c NSZeroRect if \c columnIndex 
- *				lies outside the range of valid column indices for the 
- *				receiver.
- * @see			headerRectOfRow:
+ *							footer whose rectangle you want.
+ * @return		A rectangle locating the footer for the column at
+ *				\c columnIndex.
  */
-//- (NSRect)headerRectOfColumn:(NSUInteger)columnIndex;
+- (NSRect)footerRectOfColumn:(NSUInteger)columnIndex;
 
 /**
  * @}
  */
 
+/**
+ * @brief		Records the commands needed to draw \c rect into
+ *				a display list, without drawing anything.
+ * @param		displayList	The display list to record into.
+ * @param		rect		The rect to record, in the receiver's
+ *							coordinates.
+ */
+- (void)recordDisplayList:(MBTableGridDisplayList *)displayList inRect:(NSRect)rect;
+
 @end
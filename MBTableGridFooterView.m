@@ -29,12 +29,14 @@
 #import "MBFooterTextCell.h"
 #import "MBLevelIndicatorCell.h"
 #import "MBTableGridFooterCell.h"
+#import "MBTableGridDisplayList.h"
 
 @interface MBTableGrid ()
 - (MBTableGridContentView *)_contentView;
 - (NSCell *)_footerCellForColumn:(NSUInteger)columnIndex;
 - (id)_footerValueForColumn:(NSUInteger)columnIndex;
 - (void)_setFooterValue:(id)value forColumn:(NSUInteger)columnIndex;
+- (NSUInteger)_firstShownColumnFrom:(NSUInteger)columnIndex;
 @end
 
 @interface MBTableGridFooterView ()
@@ -57,11 +59,23 @@
 - (void)drawRect:(NSRect)rect {
 	
 	// Draw the column footers
-	NSUInteger numberOfColumns = [self tableGrid].numberOfColumns;
-	NSUInteger column = 0;
+	BOOL isFrozenView = self == [self tableGrid].frozenColumnFooterView;
+	NSRange columnRange = isFrozenView ? [[self tableGrid] frozenColumnRange] : [[self tableGrid] unfrozenColumnRange];
+	NSUInteger column = [[self tableGrid] _firstShownColumnFrom:columnRange.location];
 	NSColor *backgroundColor = [NSColor windowBackgroundColor];
 	
-	while (column < numberOfColumns) {
+	// The frozen columns are covered by the frozen footer view, so just
+	// fill their span once rather than visiting each of them
+	if (!isFrozenView && columnRange.location > 0) {
+		NSRect frozenRect = NSMakeRect(0, 0, NSMinX([self footerRectOfColumn:columnRange.location]), NSHeight(self.bounds));
+		if (columnRange.length == 0) {
+			frozenRect.size.width = NSMaxX([self footerRectOfColumn:columnRange.location - 1]);
+		}
+		[backgroundColor set];
+		NSRectFill(NSIntersectionRect(frozenRect, rect));
+	}
+	
+	while (column < NSMaxRange(columnRange)) {
 		NSRect cellFrame = [self footerRectOfColumn:column];
 		
 		// Only draw the header if we need to
@@ -83,12 +97,7 @@
                 [_cell setObjectValue:objectValue];
             }
             
-            BOOL isFrozenColumn = self != [self tableGrid].frozenColumnFooterView && [[self tableGrid] isFrozenColumn:column];
-            
-            if (isFrozenColumn) {
-                [backgroundColor set];
-                NSRectFill(cellFrame);
-            } else if ([_cell isKindOfClass:[MBFooterPopupButtonCell class]]) {
+            if ([_cell isKindOfClass:[MBFooterPopupButtonCell class]]) {
                 
                 MBFooterPopupButtonCell *cell = (MBFooterPopupButtonCell *)_cell;
                 [cell drawWithFrame:cellFrame inView:self withBackgroundColor:backgroundColor];// Draw background color
@@ -119,19 +128,17 @@
 				borderColor = [NSColor gridColor];
 			}
 			
-            if (!isFrozenColumn) {
-                // Draw the side bevels
-                NSRect sideLine = NSMakeRect(NSMinX(cellFrame), NSMinY(cellFrame), 1.0, NSHeight(cellFrame));
-                [sideColor set];
-                [[NSBezierPath bezierPathWithRect:sideLine] fill];
-                sideLine.origin.x = NSMaxX(cellFrame)-2.0;
-                [[NSBezierPath bezierPathWithRect:sideLine] fill];
-                
-                // Draw the right border
-                NSRect borderLine = NSMakeRect(NSMaxX(cellFrame)-1, NSMinY(cellFrame), 1.0, NSHeight(cellFrame));
-                [borderColor set];
-                NSRectFill(borderLine);
-            }
+            // Draw the side bevels
+            NSRect sideLine = NSMakeRect(NSMinX(cellFrame), NSMinY(cellFrame), 1.0, NSHeight(cellFrame));
+            [sideColor set];
+            [[NSBezierPath bezierPathWithRect:sideLine] fill];
+            sideLine.origin.x = NSMaxX(cellFrame)-2.0;
+            [[NSBezierPath bezierPathWithRect:sideLine] fill];
+            
+            // Draw the right border
+            NSRect borderLine = NSMakeRect(NSMaxX(cellFrame)-1, NSMinY(cellFrame), 1.0, NSHeight(cellFrame));
+            [borderColor set];
+            NSRectFill(borderLine);
             
             // Draw the bottom border
 //            NSRect bottomLine = NSMakeRect(NSMinX(cellFrame), NSMaxY(cellFrame)-1.0, NSWidth(cellFrame), 1.0);
@@ -140,7 +147,7 @@
 
 		}
 		
-		column++;
+		column = [[self tableGrid] _firstShownColumnFrom:column + 1];
 	}
 	
 	// Draw the top border
@@ -148,6 +155,38 @@
 	NSRectFill(topLine);
 }
 
+- (void)recordDisplayList:(MBTableGridDisplayList *)displayList inRect:(NSRect)rect {
+	BOOL isFrozenView = self == [self tableGrid].frozenColumnFooterView;
+	NSRange columnRange = isFrozenView ? [[self tableGrid] frozenColumnRange] : [[self tableGrid] unfrozenColumnRange];
+	
+	NSColor *borderColor = nil;
+	if (@available(macOS 10.13, *)) {
+		borderColor = [NSColor colorNamed:@"grid-line"];
+	} else {
+		borderColor = [NSColor gridColor];
+	}
+	MBDisplayColor gridLineColor = MBDisplayColorFromColor(borderColor);
+	MBDisplayColor textColor = MBDisplayColorFromColor([NSColor labelColor]);
+	
+	[displayList fillRect:rect color:MBDisplayColorFromColor([NSColor windowBackgroundColor])];
+	
+	for (NSUInteger column = [[self tableGrid] _firstShownColumnFrom:columnRange.location]; column < NSMaxRange(columnRange); column = [[self tableGrid] _firstShownColumnFrom:column + 1]) {
+		NSRect cellFrame = [self footerRectOfColumn:column];
+		if (!NSIntersectsRect(cellFrame, rect)) {
+			continue;
+		}
+		
+		id objectValue = [[self tableGrid] _footerValueForColumn:column];
+		if (objectValue) {
+			[displayList drawText:[objectValue description] inRect:NSInsetRect(cellFrame, 4.0, 0) color:textColor];
+		}
+		
+		[displayList strokeLineFromPoint:NSMakePoint(NSMaxX(cellFrame) - 0.5, NSMinY(cellFrame)) toPoint:NSMakePoint(NSMaxX(cellFrame) - 0.5, NSMaxY(cellFrame)) width:1.0 color:gridLineColor];
+	}
+	
+	[displayList strokeLineFromPoint:NSMakePoint(NSMinX(rect), 0.5) toPoint:NSMakePoint(NSMaxX(rect), 0.5) width:1.0 color:gridLineColor];
+}
+
 - (void)updateLevelIndicator:(NSNumber *)value {
     NSInteger selectedColumn = [[self tableGrid].selectedColumnIndexes firstIndex];
     // sanity check to make sure we have an NSNumber.
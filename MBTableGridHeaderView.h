@@ -26,7 +26,7 @@
 #import <Cocoa/Cocoa.h>
 #import "MBTableGridHeaderCell.h"
 
-@class MBTableGrid;
+@class MBTableGrid, MBTableGridDisplayList;
 
 /**
  * @brief		\c MBTableGridHeaderView deals with the
@@ -186,4 +186,29 @@
  * @}
  */
 
+/**
+ * @brief		Records the commands needed to draw \c rect into
+ *				a display list, without drawing anything.
+ * @param		displayList	The display list to record into.
+ * @param		rect		The rect to record, in the receiver's
+ *							coordinates.
+ */
+- (void)recordDisplayList:(MBTableGridDisplayList *)displayList inRect:(NSRect)rect;
+
+/**
+ * @brief		Saves the width of every column, and whether it is
+ *				hidden, into \c columnAutoSaveProperties, and passes
+ *				them to the delegate if the receiver has an
+ *				\c autosaveName.
+ */
+- (void)autoSaveColumnProperties;
+
+/**
+ * @brief		Saves the width of the columns at \c columnIndexes,
+ *				and of any column that hasn't been saved before.
+ *
+ * @see			autoSaveColumnProperties
+ */
+- (void)autoSaveColumnPropertiesOfColumns:(NSIndexSet *)columnIndexes;
+
 @end
@@ -26,6 +26,8 @@
 #import "MBTableGridHeaderView.h"
 #import "MBTableGrid.h"
 #import "MBTableGridContentView.h"
+#import "MBTableGridDisplayList.h"
+#import "MBTableGridSelection.h"
 
 NSString* kAutosavedColumnWidthKey = @"AutosavedColumnWidth";
 NSString* kAutosavedColumnIndexKey = @"AutosavedColumnIndex";
@@ -33,6 +35,9 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 
 #define kSortIndicatorXInset		4.0  	/* Number of pixels to inset the drawing of the indicator from the right edge */
 
+// Live resizing is applied at most this often, which is once a frame on most displays
+static const NSTimeInterval MBTableGridResizeInterval = 1.0 / 60.0;
+
 @interface MBTableGrid (Private)
 - (NSString *)_headerStringForColumn:(NSUInteger)columnIndex;
 - (NSString *)_headerStringForRow:(NSUInteger)rowIndex;
@@ -46,11 +51,18 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 - (void)_setStickyColumn:(MBTableGridEdge)stickyColumn row:(MBTableGridEdge)stickyRow;
 - (MBTableGridEdge)_stickyColumn;
 - (MBTableGridEdge)_stickyRow;
+- (NSIndexSet *)_rowIndexesExcludingGroupHeadingRows;
+- (NSUInteger)_firstShownColumnFrom:(NSUInteger)columnIndex;
+- (float)_widthForColumn:(NSUInteger)columnIndex;
 @end
 
 @interface MBTableGridHeaderView()
 
 @property (nonatomic, weak) MBTableGrid *cachedTableGrid;
+@property (nonatomic) CGFloat pendingResizeDistance;
+@property (nonatomic) NSPoint pendingResizeLocation;
+@property (nonatomic) BOOL hasPendingResize;
+@property (nonatomic) CFAbsoluteTime lastResizeTime;
 
 @end
 
@@ -122,16 +134,19 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 		NSRectFill(bottomLine);
 		
 		// Draw the column headers
-		NSUInteger numberOfColumns = [self tableGrid].numberOfColumns;
+		BOOL isFrozenView = self == [self tableGrid].frozenColumnHeaderView;
+		NSRange columnRange = isFrozenView ? [[self tableGrid] frozenColumnRange] : [[self tableGrid] unfrozenColumnRange];
 		[headerCell setOrientation:self.orientation];
-		NSUInteger column = 0;
-		while (column < numberOfColumns) {
+		
+		// Hidden columns are skipped over
+		NSUInteger column = [[self tableGrid] _firstShownColumnFrom:columnRange.location];
+		while (column < NSMaxRange(columnRange)) {
 			NSRect headerRect = [self headerRectOfColumn:column];
 			
 			// Only draw the header if we need to
 			if ([self needsToDrawRect:headerRect]) {
 				// Check if any part of the selection is in this column
-				NSIndexSet *selectedColumns = [[self tableGrid] selectedColumnIndexes];
+				NSIndexSet *selectedColumns = [[self tableGrid] selection].columnIndexes;
 				if ([selectedColumns containsIndex:column]) {
 					[headerCell setState:NSOnState];
 				} else {
@@ -159,15 +174,10 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 					[headerCell setStringValue:stringValue];
 				}
                 
-                BOOL isFrozenColumn = self != [self tableGrid].frozenColumnHeaderView && [[self tableGrid] isFrozenColumn:column];
-                
-                if (!isFrozenColumn) {
-                    [headerCell drawWithFrame:headerRect inView:self];
-                }
-                
+				[headerCell drawWithFrame:headerRect inView:self];
 			}
 			
-			column++;
+			column = [[self tableGrid] _firstShownColumnFrom:column + 1];
 		}
         
 	} else if (self.orientation == MBTableHeaderVerticalOrientation) {
@@ -177,7 +187,6 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 		[headerCell setOrientation:self.orientation];
 		
 		NSUInteger row = 0;
-		NSUInteger rowNumber = 0;
 		[[[self tableGrid] contentView] cacheGroupRows];
 		
 		while(row < numberOfRows) {
@@ -194,7 +203,7 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 			if ([self needsToDrawRect:headerRect]) {
                 
 				// Check if any part of the selection is in this column
-				NSIndexSet *selectedRows = [[self tableGrid] selectedRowIndexes];
+				NSIndexSet *selectedRows = [[self tableGrid] selection].rowIndexes;
 				if ([selectedRows containsIndex:row]) {
 					[headerCell setState:NSOnState];
 				} else {
@@ -202,7 +211,7 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 				}
 				
 				if (!isGroupRow && !isGroupSummaryRow) {
-					NSString *headerValue = [[self tableGrid] _headerStringForRow:rowNumber];
+					NSString *headerValue = [[self tableGrid] _headerStringForRow:row];
 					[headerCell setStringValue:headerValue];
 				} else {
 					[headerCell setStringValue:@""];
@@ -214,9 +223,6 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 				[headerCell drawWithFrame:headerRect inView:self];
 			}
 			
-			if (!isGroupRow && !isGroupSummaryRow) {
-				rowNumber++;
-			}
 			row++;
 		}
 		
@@ -227,6 +233,89 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 	}
 }
 
+- (void)recordDisplayList:(MBTableGridDisplayList *)displayList inRect:(NSRect)rect
+{
+	NSColor *borderColor = nil;
+	if (@available(macOS 10.13, *)) {
+		borderColor = [NSColor colorNamed:@"grid-line"];
+	} else {
+		borderColor = [NSColor gridColor];
+	}
+	MBDisplayColor gridLineColor = MBDisplayColorFromColor(borderColor);
+	MBDisplayColor backgroundColor = MBDisplayColorFromColor([NSColor windowBackgroundColor]);
+	MBDisplayColor selectedColor = MBDisplayColorFromColor([NSColor selectedControlColor]);
+	MBDisplayColor textColor = MBDisplayColorFromColor([NSColor headerTextColor]);
+	
+	if (self.orientation == MBTableHeaderHorizontalOrientation) {
+		BOOL isFrozenView = self == [self tableGrid].frozenColumnHeaderView;
+		NSRange columnRange = isFrozenView ? [[self tableGrid] frozenColumnRange] : [[self tableGrid] unfrozenColumnRange];
+		NSIndexSet *selectedColumns = [[self tableGrid] selection].columnIndexes;
+		
+		for (NSUInteger column = [[self tableGrid] _firstShownColumnFrom:columnRange.location]; column < NSMaxRange(columnRange); column = [[self tableGrid] _firstShownColumnFrom:column + 1]) {
+			NSRect headerRect = [self headerRectOfColumn:column];
+			if (!NSIntersectsRect(headerRect, rect)) {
+				continue;
+			}
+			
+			[displayList fillRect:headerRect color:[selectedColumns containsIndex:column] ? selectedColor : backgroundColor];
+			[displayList drawText:[[self tableGrid] _headerStringForColumn:column] inRect:NSInsetRect(headerRect, kSortIndicatorXInset, 0) color:textColor];
+			
+			NSImage *sortIndicatorImage = nil;
+			switch ([[self tableGrid] _sortDirectionForColumn:column]) {
+				case MBSortAscending:
+					sortIndicatorImage = self.sortAscendingImage;
+					break;
+				case MBSortDescending:
+					sortIndicatorImage = self.sortDescendingImage;
+					break;
+				case MBSortUndetermined:
+					sortIndicatorImage = self.sortUndeterminedImage;
+					break;
+				default:
+					break;
+			}
+			if (sortIndicatorImage) {
+				NSRect indicatorRect = NSMakeRect(NSMaxX(headerRect) - sortIndicatorImage.size.width - kSortIndicatorXInset, NSMinY(headerRect), sortIndicatorImage.size.width, NSHeight(headerRect));
+				[displayList drawImageNamed:sortIndicatorImage.name inRect:indicatorRect];
+			}
+			
+			[displayList strokeLineFromPoint:NSMakePoint(NSMaxX(headerRect) - 0.5, NSMinY(headerRect)) toPoint:NSMakePoint(NSMaxX(headerRect) - 0.5, NSMaxY(headerRect)) width:1.0 color:gridLineColor];
+		}
+		
+		[displayList strokeLineFromPoint:NSMakePoint(NSMinX(rect), NSMaxY(rect) - 0.5) toPoint:NSMakePoint(NSMaxX(rect), NSMaxY(rect) - 0.5) width:1.0 color:gridLineColor];
+		
+	} else if (self.orientation == MBTableHeaderVerticalOrientation) {
+		MBTableGridContentView *gridContentView = [[self tableGrid] contentView];
+		[gridContentView cacheGroupRows];
+		
+		NSUInteger numberOfRows = [self tableGrid].numberOfRows;
+		NSIndexSet *selectedRows = [[self tableGrid] selection].rowIndexes;
+		CGFloat rowHeight = gridContentView.cellRowHeight;
+		NSUInteger firstRow = MIN((NSUInteger)(MAX(NSMinY(rect), 0) / rowHeight), numberOfRows);
+		NSUInteger endRow = MIN((NSUInteger)ceil(MAX(NSMaxY(rect), 0) / rowHeight), numberOfRows);
+		
+		for (NSUInteger row = firstRow; row < endRow; row++) {
+			NSRect headerRect = [self headerRectOfRow:row];
+			BOOL isGroupRow = gridContentView.groupHeadingRowIndexes[@(row)] != nil || gridContentView.groupSummaryRowIndexes[@(row)] != nil;
+			
+			[displayList fillRect:headerRect color:[selectedRows containsIndex:row] ? selectedColor : backgroundColor];
+			
+			if (!isGroupRow) {
+				[displayList drawText:[[self tableGrid] _headerStringForRow:row] inRect:headerRect color:textColor];
+			}
+			
+			NSColor *rowTagColor = [[self tableGrid] _tagColorForRow:row];
+			if (rowTagColor) {
+				[displayList fillRect:NSMakeRect(NSMinX(headerRect), NSMinY(headerRect), 4.0, NSHeight(headerRect)) color:MBDisplayColorFromColor(rowTagColor)];
+			}
+			
+			[displayList strokeLineFromPoint:NSMakePoint(NSMinX(headerRect), NSMaxY(headerRect) - 0.5) toPoint:NSMakePoint(NSMaxX(headerRect), NSMaxY(headerRect) - 0.5) width:1.0 color:gridLineColor];
+		}
+		
+		[displayList strokeLineFromPoint:NSMakePoint(NSMaxX(rect) - 0.5, NSMinY(rect)) toPoint:NSMakePoint(NSMaxX(rect) - 0.5, NSMaxY(rect)) width:1.0 color:gridLineColor];
+	}
+}
+
 - (BOOL)isFlipped
 {
 	return YES;
@@ -244,7 +333,7 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 		// Draw the column headers
 		NSUInteger numberOfColumns = self.tableGrid.numberOfColumns;
 		[headerCell setOrientation:self.orientation];
-		NSUInteger column = 0;
+		NSUInteger column = [[self tableGrid] _firstShownColumnFrom:0];
 		
 //		BOOL rightToLeft = [[NSApplication sharedApplication] userInterfaceLayoutDirection] == NSUserInterfaceLayoutDirectionRightToLeft;
 		
@@ -267,7 +356,7 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 				[self addTrackingArea:resizeTrackingArea];
 			}
 			
-			column++;
+			column = [[self tableGrid] _firstShownColumnFrom:column + 1];
 		}
 	}
 }
@@ -292,7 +381,7 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 		
 		if([theEvent clickCount] == 2 && !rightMouse) {
 			// Check if the double click happened on the separator between two columns. This separator has the "resizing" cursor.
-			// If so, grab the corresponding column and inform the delegate.
+			// If so, grab the corresponding column and inform the delegate, or fit the column to its contents.
 			NSInteger columnWithResizingCursor = NSNotFound;
 			for (NSTrackingArea *trackingArea in self.trackingAreas) {
 				NSNumber *aColumn = trackingArea.userInfo[@"column"];
@@ -303,6 +392,8 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 			}
 			if (columnWithResizingCursor != NSNotFound && [self.tableGrid.delegate respondsToSelector:@selector(tableGrid:didDoubleClickSeparatorForColumn:)]) {
 				[self.tableGrid.delegate tableGrid:self.tableGrid didDoubleClickSeparatorForColumn:columnWithResizingCursor];
+			} else if (columnWithResizingCursor != NSNotFound) {
+				[self.tableGrid autosizeColumns:[NSIndexSet indexSetWithIndex:columnWithResizingCursor]];
 			} else if ([self.tableGrid.delegate respondsToSelector:@selector(tableGrid:didDoubleClickColumn:)]) {
 				[self.tableGrid.delegate tableGrid:self.tableGrid didDoubleClickColumn:column];
 			} else if (self.orientation == MBTableHeaderVerticalOrientation) {
@@ -423,19 +514,8 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 										shouldDragItems = YES;
 									} else {
 										[self tableGrid].selectedColumnIndexes = [NSIndexSet indexSetWithIndex:column];
-										// Select every row
-										
-										NSMutableIndexSet *indexSet = [[NSMutableIndexSet alloc] init];
-										NSInteger rowCount = [self tableGrid].numberOfRows;
-										
-										for (NSInteger row = 0; row < rowCount; row++) {
-											BOOL isGroupRow = [[[[self tableGrid] contentView] groupHeadingRowIndexes] objectForKey:@(row)] != nil;
-											if (!isGroupRow) {
-												[indexSet addIndex:row];
-											}
-										}
-										
-										[self tableGrid].selectedRowIndexes = indexSet;
+										// Select every row except the group headings
+										[self tableGrid].selectedRowIndexes = [[[self tableGrid] _rowIndexesExcludingGroupHeadingRows] mutableCopy];
 										
 									}
 								}
@@ -501,28 +581,16 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
         [[NSCursor resizeLeftRightCursor] set];
         [[self window] disableCursorRects];
         
-        // Set drag distance
-		CGFloat dragDistance = loc.x - lastMouseDraggingLocation.x;
+        // Drags arrive faster than the screen refreshes, so their distances are added up and applied once a frame
+		self.pendingResizeDistance += loc.x - lastMouseDraggingLocation.x;
+		self.pendingResizeLocation = loc;
 		
 		lastMouseDraggingLocation = loc;
 		
-		// Resize column and resize views
-		
-		if (draggingColumnIndex != NSNotFound) {
-			CGFloat offset = [self.tableGrid resizeColumnWithIndex:draggingColumnIndex withDistance:dragDistance location:loc];
-			BOOL rightToLeft = [[NSApplication sharedApplication] userInterfaceLayoutDirection] == NSUserInterfaceLayoutDirectionRightToLeft;
-			
-			if (rightToLeft) {
-				lastMouseDraggingLocation.x -= offset;
-			} else {
-				lastMouseDraggingLocation.x += offset;
-			}
-			
-			if (offset != 0.0) {
-				[[NSCursor resizeRightCursor] set];
-			} else {
-				[[NSCursor resizeLeftRightCursor] set];
-			}
+		if (!self.hasPendingResize) {
+			self.hasPendingResize = YES;
+			NSTimeInterval delay = MAX(self.lastResizeTime + MBTableGridResizeInterval - CFAbsoluteTimeGetCurrent(), 0);
+			[self performSelector:@selector(_applyPendingResize) withObject:nil afterDelay:delay inModes:@[NSRunLoopCommonModes]];
 		}
 		
     } else {
@@ -582,12 +650,49 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
     }
 }
 
+- (void)_applyPendingResize {
+	if (!self.hasPendingResize) {
+		return;
+	}
+	
+	CGFloat distance = self.pendingResizeDistance;
+	self.hasPendingResize = NO;
+	self.pendingResizeDistance = 0;
+	self.lastResizeTime = CFAbsoluteTimeGetCurrent();
+	
+	// Resize column and resize views
+	
+	if (draggingColumnIndex != NSNotFound && distance != 0.0) {
+		CGFloat offset = [self.tableGrid resizeColumnWithIndex:draggingColumnIndex withDistance:distance location:self.pendingResizeLocation];
+		BOOL rightToLeft = [[NSApplication sharedApplication] userInterfaceLayoutDirection] == NSUserInterfaceLayoutDirectionRightToLeft;
+		
+		if (rightToLeft) {
+			lastMouseDraggingLocation.x -= offset;
+		} else {
+			lastMouseDraggingLocation.x += offset;
+		}
+		
+		if (offset != 0.0) {
+			[[NSCursor resizeRightCursor] set];
+		} else {
+			[[NSCursor resizeLeftRightCursor] set];
+		}
+	}
+}
+
 - (void)mouseUp:(NSEvent *)theEvent
 {
 	
     if (canResize) {
 		
-		[self autoSaveColumnProperties];
+		// Apply the last of the drag before the width is saved
+		[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(_applyPendingResize) object:nil];
+		[self _applyPendingResize];
+		
+		// Only the dragged column has changed
+		if (draggingColumnIndex != NSNotFound) {
+			[self autoSaveColumnPropertiesOfColumns:[NSIndexSet indexSetWithIndex:draggingColumnIndex]];
+		}
 		
 		NSString *draggedColumn = [NSString stringWithFormat:@"C-%lu", draggingColumnIndex];
 		
@@ -604,10 +709,6 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
         [[self window] enableCursorRects];
         [[self window] resetCursorRects];
         
-		// update cache of column rects
-		
-		[[self tableGrid].columnRects removeAllObjects];
-		
 		if ([[[self tableGrid] delegate] respondsToSelector:@selector(tableGridDidResizeColumn:)]) {
 		
 			// Post the notification
@@ -627,18 +728,8 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 			
             if (self.orientation == MBTableHeaderHorizontalOrientation) {
                 [self tableGrid].selectedColumnIndexes = [NSIndexSet indexSetWithIndex:mouseDownItem];
-                // Select every row
-				NSMutableIndexSet *indexSet = [[NSMutableIndexSet alloc] init];
-				
-				NSInteger rowCount = [self tableGrid].numberOfRows;
-				for (NSInteger row = 0; row < rowCount; row++) {
-					BOOL isGroupRow = [[[[self tableGrid] contentView] groupHeadingRowIndexes] objectForKey:@(row)] != nil;
-					if (!isGroupRow) {
-						[indexSet addIndex:row];
-					}
-				}
-				
-				[self tableGrid].selectedRowIndexes = indexSet;
+                // Select every row except the group headings
+				[self tableGrid].selectedRowIndexes = [[[self tableGrid] _rowIndexesExcludingGroupHeadingRows] mutableCopy];
 				
 				
             } else if (self.orientation == MBTableHeaderVerticalOrientation) {
@@ -695,6 +786,10 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 }
 
 - (void)autoSaveColumnProperties {
+	[self autoSaveColumnPropertiesOfColumns:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, self.tableGrid.numberOfColumns)]];
+}
+
+- (void)autoSaveColumnPropertiesOfColumns:(NSIndexSet *)columnIndexes {
     if (!self.columnAutoSaveProperties && [[[self tableGrid] delegate] respondsToSelector:@selector(tableGridAutosavedColumnProperties:)]) {
         self.columnAutoSaveProperties = [[[[self tableGrid] delegate] tableGridAutosavedColumnProperties:[self tableGrid]] mutableCopy];
     }
@@ -703,14 +798,19 @@ NSString* kAutosavedColumnHiddenKey = @"AutosavedColumnHidden";
 		self.columnAutoSaveProperties = [NSMutableDictionary dictionary];
 	}
 	
-	__weak MBTableGridHeaderView *weakSelf = self;
+	// Until every column has been saved once, they're all saved
+	NSUInteger numberOfColumns = self.tableGrid.numberOfColumns;
+	NSMutableIndexSet *columns = [columnIndexes mutableCopy];
+	if (self.columnAutoSaveProperties.count < numberOfColumns) {
+		[columns addIndexesInRange:NSMakeRange(0, numberOfColumns)];
+	}
+	[columns removeIndexesInRange:NSMakeRange(numberOfColumns, NSNotFound - numberOfColumns)];
 	
-	[self.tableGrid.columnRects enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-		NSValue *rectValue = obj;
-		NSRect rect = [rectValue rectValue];
-		NSDictionary *columnDict = @{kAutosavedColumnWidthKey : @(rect.size.width),
-									 kAutosavedColumnHiddenKey : @NO};
-		weakSelf.columnAutoSaveProperties[[NSString stringWithFormat:@"C-%@", key]] = columnDict;
+	// Hidden columns have no width in the layout, so the width they'll have when shown is saved
+	[columns enumerateIndexesUsingBlock:^(NSUInteger column, BOOL *stop) {
+		NSDictionary *columnDict = @{kAutosavedColumnWidthKey : @([[self tableGrid] _widthForColumn:column]),
+									 kAutosavedColumnHiddenKey : @([[self tableGrid] isColumnHidden:column])};
+		self.columnAutoSaveProperties[[NSString stringWithFormat:@"C-%lu", column]] = columnDict;
 	}];
 	
 	if (self.autosaveName && [[[self tableGrid] delegate] respondsToSelector:@selector(tableGrid:didAutosaveColumnProperties:)]) {
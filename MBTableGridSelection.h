@@ -0,0 +1,109 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief		\c MBTableGridSelection describes a selection made of
+ *				one or more rectangles of cells.
+ *
+ * @details		Each rectangle is a set of columns and a set of
+ *				rows, so a whole column with its group rows left out
+ *				is still a single rectangle.
+ *
+ *				The rows are divided into bands at every edge of
+ *				every rectangle, and each band keeps the columns
+ *				selected in it. Finding the band for a row is a
+ *				binary search, so \c containsColumn:row: stays
+ *				O(log n) even with hundreds of disjoint ranges.
+ *
+ *				Selections are immutable.
+ */
+@interface MBTableGridSelection : NSObject <NSCopying>
+
+/**
+ * @brief		Creates an empty selection.
+ */
++ (instancetype)selection;
+
+/**
+ * @brief		Creates a selection with a single rectangle.
+ */
+- (instancetype)initWithColumnIndexes:(NSIndexSet *)columnIndexes rowIndexes:(NSIndexSet *)rowIndexes;
+
+/**
+ * @brief		Returns a new selection with another rectangle.
+ */
+- (MBTableGridSelection *)selectionByAddingColumnIndexes:(NSIndexSet *)columnIndexes rowIndexes:(NSIndexSet *)rowIndexes;
+
+/**
+ * @brief		The number of rectangles in the selection.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfRects;
+
+/**
+ * @brief		Whether no cells are selected.
+ */
+@property (nonatomic, readonly, getter=isEmpty) BOOL empty;
+
+/**
+ * @brief		Every column with at least one selected cell.
+ */
+@property (nonatomic, readonly) NSIndexSet *columnIndexes;
+
+/**
+ * @brief		Every row with at least one selected cell.
+ */
+@property (nonatomic, readonly) NSIndexSet *rowIndexes;
+
+/**
+ * @brief		Returns whether a cell is selected.
+ */
+- (BOOL)containsColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex;
+
+/**
+ * @brief		Returns whether every cell in the given columns and
+ *				rows is selected.
+ */
+- (BOOL)containsColumnIndexes:(NSIndexSet *)columnIndexes rowIndexes:(NSIndexSet *)rowIndexes;
+
+/**
+ * @brief		Returns whether any cell in the given ranges is
+ *				selected.
+ */
+- (BOOL)intersectsColumnRange:(NSRange)columnRange rowRange:(NSRange)rowRange;
+
+/**
+ * @brief		Returns the columns selected in a row.
+ */
+- (NSIndexSet *)columnIndexesInRow:(NSUInteger)rowIndex;
+
+/**
+ * @brief		Calls \c block with the columns and rows of each
+ *				rectangle, in the order they were added.
+ */
+- (void)enumerateRectsUsingBlock:(void (^)(NSIndexSet *columnIndexes, NSIndexSet *rowIndexes, BOOL *stop))block;
+
+@end
@@ -0,0 +1,217 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridSelection.h"
+
+@interface MBTableGridSelection ()
+
+@property (nonatomic, copy) NSArray<NSIndexSet *> *rectColumns;
+@property (nonatomic, copy) NSArray<NSIndexSet *> *rectRows;
+@property (nonatomic, readwrite) NSIndexSet *columnIndexes;
+@property (nonatomic, readwrite) NSIndexSet *rowIndexes;
+
+// The first row of each band, followed by the end of the last band
+@property (nonatomic, strong) NSData *bandStarts;
+@property (nonatomic, copy) NSArray<NSIndexSet *> *bandColumns;
+
+@end
+
+@implementation MBTableGridSelection
+
++ (instancetype)selection {
+	return [[self alloc] initWithRectColumns:@[] rectRows:@[]];
+}
+
+- (instancetype)initWithColumnIndexes:(NSIndexSet *)columnIndexes rowIndexes:(NSIndexSet *)rowIndexes {
+	return [self initWithRectColumns:@[[columnIndexes copy] ?: [NSIndexSet indexSet]] rectRows:@[[rowIndexes copy] ?: [NSIndexSet indexSet]]];
+}
+
+- (instancetype)initWithRectColumns:(NSArray<NSIndexSet *> *)rectColumns rectRows:(NSArray<NSIndexSet *> *)rectRows {
+	if (self = [super init]) {
+		_rectColumns = [rectColumns copy];
+		_rectRows = [rectRows copy];
+		[self _buildBands];
+	}
+	return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+	return self;
+}
+
+- (MBTableGridSelection *)selectionByAddingColumnIndexes:(NSIndexSet *)columnIndexes rowIndexes:(NSIndexSet *)rowIndexes {
+	NSArray *rectColumns = [self.rectColumns arrayByAddingObject:[columnIndexes copy] ?: [NSIndexSet indexSet]];
+	NSArray *rectRows = [self.rectRows arrayByAddingObject:[rowIndexes copy] ?: [NSIndexSet indexSet]];
+	return [[MBTableGridSelection alloc] initWithRectColumns:rectColumns rectRows:rectRows];
+}
+
+- (NSUInteger)numberOfRects {
+	return self.rectColumns.count;
+}
+
+- (BOOL)isEmpty {
+	return self.bandColumns.count == 0;
+}
+
+#pragma mark -
+#pragma mark Bands
+
+- (void)_buildBands {
+	NSMutableIndexSet *columnIndexes = [NSMutableIndexSet indexSet];
+	NSMutableIndexSet *rowIndexes = [NSMutableIndexSet indexSet];
+	NSMutableIndexSet *boundaries = [NSMutableIndexSet indexSet];
+	
+	NSUInteger numberOfRects = self.rectColumns.count;
+	for (NSUInteger i = 0; i < numberOfRects; i++) {
+		if (self.rectColumns[i].count == 0 || self.rectRows[i].count == 0) {
+			continue;
+		}
+		
+		[columnIndexes addIndexes:self.rectColumns[i]];
+		[rowIndexes addIndexes:self.rectRows[i]];
+		
+		[self.rectRows[i] enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+			[boundaries addIndex:range.location];
+			[boundaries addIndex:NSMaxRange(range)];
+		}];
+	}
+	
+	self.columnIndexes = columnIndexes;
+	self.rowIndexes = rowIndexes;
+	
+	NSUInteger numberOfBoundaries = boundaries.count;
+	NSMutableData *bandStarts = [NSMutableData dataWithLength:numberOfBoundaries * sizeof(NSUInteger)];
+	[boundaries getIndexes:bandStarts.mutableBytes maxCount:numberOfBoundaries inIndexRange:nil];
+	
+	// Membership is the same for every row of a band, so it's enough to check its first row
+	const NSUInteger *starts = bandStarts.bytes;
+	NSIndexSet *emptySet = [NSIndexSet indexSet];
+	NSMutableArray<NSIndexSet *> *bandColumns = [NSMutableArray arrayWithCapacity:numberOfBoundaries];
+	
+	for (NSUInteger band = 0; band + 1 < numberOfBoundaries; band++) {
+		NSMutableIndexSet *columns = nil;
+		for (NSUInteger i = 0; i < numberOfRects; i++) {
+			if ([self.rectRows[i] containsIndex:starts[band]]) {
+				columns = columns ?: [NSMutableIndexSet indexSet];
+				[columns addIndexes:self.rectColumns[i]];
+			}
+		}
+		[bandColumns addObject:columns ?: emptySet];
+	}
+	
+	self.bandStarts = bandStarts;
+	self.bandColumns = bandColumns;
+}
+
+- (NSUInteger)_bandForRow:(NSUInteger)rowIndex {
+	const NSUInteger *starts = self.bandStarts.bytes;
+	NSUInteger numberOfBands = self.bandColumns.count;
+	
+	if (numberOfBands == 0 || rowIndex < starts[0] || rowIndex >= starts[numberOfBands]) {
+		return NSNotFound;
+	}
+	
+	// Find the last band starting at or before the row
+	NSUInteger low = 0;
+	NSUInteger high = numberOfBands;
+	while (high - low > 1) {
+		NSUInteger middle = low + (high - low) / 2;
+		if (starts[middle] <= rowIndex) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+#pragma mark -
+#pragma mark Queries
+
+- (BOOL)containsColumn:(NSUInteger)columnIndex row:(NSUInteger)rowIndex {
+	NSUInteger band = [self _bandForRow:rowIndex];
+	return band != NSNotFound && [self.bandColumns[band] containsIndex:columnIndex];
+}
+
+- (BOOL)containsColumnIndexes:(NSIndexSet *)columnIndexes rowIndexes:(NSIndexSet *)rowIndexes {
+	if (columnIndexes.count == 0 || rowIndexes.count == 0) {
+		return NO;
+	}
+	
+	const NSUInteger *starts = self.bandStarts.bytes;
+	__block BOOL contains = YES;
+	
+	[rowIndexes enumerateRangesUsingBlock:^(NSRange range, BOOL *stop) {
+		NSUInteger row = range.location;
+		while (row < NSMaxRange(range)) {
+			NSUInteger band = [self _bandForRow:row];
+			if (band == NSNotFound || ![self.bandColumns[band] containsIndexes:columnIndexes]) {
+				contains = NO;
+				*stop = YES;
+				return;
+			}
+			row = starts[band + 1];
+		}
+	}];
+	
+	return contains;
+}
+
+- (BOOL)intersectsColumnRange:(NSRange)columnRange rowRange:(NSRange)rowRange {
+	const NSUInteger *starts = self.bandStarts.bytes;
+	NSUInteger numberOfBands = self.bandColumns.count;
+	
+	if (numberOfBands == 0 || rowRange.length == 0 || columnRange.length == 0) {
+		return NO;
+	}
+	
+	NSUInteger band = [self _bandForRow:rowRange.location];
+	if (band == NSNotFound) {
+		band = rowRange.location < starts[0] ? 0 : numberOfBands;
+	}
+	
+	for (; band < numberOfBands && starts[band] < NSMaxRange(rowRange); band++) {
+		if ([self.bandColumns[band] intersectsIndexesInRange:columnRange]) {
+			return YES;
+		}
+	}
+	
+	return NO;
+}
+
+- (NSIndexSet *)columnIndexesInRow:(NSUInteger)rowIndex {
+	NSUInteger band = [self _bandForRow:rowIndex];
+	return band == NSNotFound ? [NSIndexSet indexSet] : self.bandColumns[band];
+}
+
+- (void)enumerateRectsUsingBlock:(void (^)(NSIndexSet *columnIndexes, NSIndexSet *rowIndexes, BOOL *stop))block {
+	BOOL stop = NO;
+	NSUInteger numberOfRects = self.rectColumns.count;
+	for (NSUInteger i = 0; i < numberOfRects && !stop; i++) {
+		block(self.rectColumns[i], self.rectRows[i], &stop);
+	}
+}
+
+@end
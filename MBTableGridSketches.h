@@ -0,0 +1,96 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "MBTableGridCore.h"
+
+/**
+ * @brief		\c MBTableGridColumnSketches estimates the number
+ *				of distinct values and the quantiles of a column.
+ *
+ * @details		Exact answers need a hash set of every value or a
+ *				sorted copy of the column, which is too slow to keep
+ *				up to date for millions of rows. Sketches are a few
+ *				kilobytes whatever the number of rows, are built in
+ *				parallel chunks that are merged, and take edited
+ *				values as they come. See \c MBTableGridDistinctCount
+ *				and \c MBTableGridQuantiles for their error bounds.
+ *
+ *				Sketches can't forget values, so a replaced value
+ *				still counts. Once more than 1/64 of the rows have
+ *				been replaced, removed or set, the sketches are
+ *				\c stale and should be built again.
+ */
+@interface MBTableGridColumnSketches : NSObject
+
+/**
+ * @brief		Builds sketches on a background queue.
+ *
+ * @param		values		One \c double per row for the quantiles,
+ *							with NaN for cells to leave out.
+ * @param		hashes		One \c uint64_t per row for the distinct
+ *							count, with 0 for cells to leave out.
+ * @param		completionHandler	Called on the main queue with the
+ *									sketches, or \c nil if there wasn't
+ *									enough memory.
+ */
++ (void)buildSketchesWithValues:(NSData *)values hashes:(NSData *)hashes completionHandler:(void (^)(MBTableGridColumnSketches *sketches))completionHandler;
+
+/**
+ * @brief		Returns the hash a cell value is counted by:
+ *				numbers and dates by their numeric value, and
+ *				anything else by its text. Empty cells are 0.
+ */
++ (uint64_t)hashForObject:(id)value;
+
+/**
+ * @brief		Adds the new value of an edited cell, and counts
+ *				the value it replaced towards \c stale with
+ *				\c changeValues:.
+ */
+- (void)replaceValueWithValue:(double)value hash:(uint64_t)hash;
+
+/**
+ * @brief		Counts values the sketches can't take back, such
+ *				as removed rows or rows whose values were set as a
+ *				block, towards \c stale.
+ */
+- (void)changeValues:(NSUInteger)count;
+
+@property (nonatomic, readonly, getter=isStale) BOOL stale;
+
+/**
+ * @brief		The estimated number of distinct values.
+ */
+@property (nonatomic, readonly) NSUInteger distinctCount;
+
+/**
+ * @brief		Returns an estimate of the value with \c rank,
+ *				from 0 for the minimum to 1 for the maximum, or
+ *				NaN if there are no values.
+ */
+- (double)valueAtRank:(double)rank;
+
+@end
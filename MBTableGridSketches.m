@@ -0,0 +1,167 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridSketches.h"
+
+// Rows are sketched in parallel chunks of this size, then merged
+static const NSUInteger MBTableGridSketchesChunkLength = 65536;
+
+@interface MBTableGridColumnSketches ()
+
+@property (nonatomic, assign) MBTableGridDistinctCount *distinctValues;
+@property (nonatomic, assign) MBTableGridQuantiles *quantiles;
+@property (nonatomic) NSUInteger numberOfValues;
+@property (nonatomic) NSUInteger numberOfChangedValues;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSNumber *> *rankValues;
+
+@end
+
+@implementation MBTableGridColumnSketches
+
+- (instancetype)initWithDistinctValues:(MBTableGridDistinctCount *)distinctValues quantiles:(MBTableGridQuantiles *)quantiles numberOfValues:(NSUInteger)numberOfValues {
+	if (self = [super init]) {
+		_distinctValues = distinctValues;
+		_quantiles = quantiles;
+		_numberOfValues = numberOfValues;
+		_rankValues = [NSMutableDictionary dictionary];
+	}
+	return self;
+}
+
+- (void)dealloc {
+	free(_distinctValues);
+	MBTableGridQuantilesFree(_quantiles);
+}
+
++ (void)buildSketchesWithValues:(NSData *)values hashes:(NSData *)hashes completionHandler:(void (^)(MBTableGridColumnSketches *sketches))completionHandler {
+	dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+		const double *numericValues = values.bytes;
+		const uint64_t *hashValues = hashes.bytes;
+		size_t count = MAX(values.length / sizeof(double), hashes.length / sizeof(uint64_t));
+		size_t numberOfChunks = MAX((count + MBTableGridSketchesChunkLength - 1) / MBTableGridSketchesChunkLength, 1);
+		
+		MBTableGridDistinctCount *chunkDistinctValues = calloc(numberOfChunks, sizeof(MBTableGridDistinctCount));
+		MBTableGridQuantiles **chunkQuantiles = calloc(numberOfChunks, sizeof(MBTableGridQuantiles *));
+		
+		if (chunkDistinctValues && chunkQuantiles) {
+			dispatch_apply(numberOfChunks, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^(size_t chunk) {
+				size_t start = chunk * MBTableGridSketchesChunkLength;
+				size_t end = MIN(start + MBTableGridSketchesChunkLength, count);
+				
+				MBTableGridDistinctCountInit(&chunkDistinctValues[chunk]);
+				for (size_t row = start; row < end && row < hashes.length / sizeof(uint64_t); row++) {
+					if (hashValues[row] != 0) {
+						MBTableGridDistinctCountAdd(&chunkDistinctValues[chunk], hashValues[row]);
+					}
+				}
+				
+				MBTableGridQuantiles *quantiles = MBTableGridQuantilesCreate();
+				for (size_t row = start; quantiles && row < end && row < values.length / sizeof(double); row++) {
+					MBTableGridQuantilesAdd(quantiles, numericValues[row]);
+				}
+				chunkQuantiles[chunk] = quantiles;
+			});
+		}
+		
+		// Merge the chunks into the first
+		MBTableGridColumnSketches *sketches = nil;
+		BOOL didMerge = chunkDistinctValues && chunkQuantiles;
+		for (size_t chunk = 0; didMerge && chunk < numberOfChunks; chunk++) {
+			didMerge = chunkQuantiles[chunk] != NULL;
+			if (didMerge && chunk > 0) {
+				MBTableGridDistinctCountMerge(&chunkDistinctValues[0], &chunkDistinctValues[chunk]);
+				didMerge = MBTableGridQuantilesMerge(chunkQuantiles[0], chunkQuantiles[chunk]);
+			}
+		}
+		
+		MBTableGridDistinctCount *distinctValues = didMerge ? malloc(sizeof(MBTableGridDistinctCount)) : NULL;
+		if (distinctValues) {
+			*distinctValues = chunkDistinctValues[0];
+			sketches = [[MBTableGridColumnSketches alloc] initWithDistinctValues:distinctValues quantiles:chunkQuantiles[0] numberOfValues:count];
+		}
+		
+		for (size_t chunk = sketches ? 1 : 0; chunkQuantiles && chunk < numberOfChunks; chunk++) {
+			MBTableGridQuantilesFree(chunkQuantiles[chunk]);
+		}
+		free(chunkQuantiles);
+		free(chunkDistinctValues);
+		
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completionHandler(sketches);
+		});
+	});
+}
+
++ (uint64_t)hashForObject:(id)value {
+	if (!value || [value isKindOfClass:[NSNull class]]) {
+		return 0;
+	} else if ([value isKindOfClass:[NSNumber class]]) {
+		return MBTableGridHashDouble([value doubleValue]);
+	} else if ([value isKindOfClass:[NSDate class]]) {
+		return MBTableGridHashDouble([value timeIntervalSinceReferenceDate]);
+	}
+	
+	NSString *string = [value isKindOfClass:[NSString class]] ? value : [value description];
+	if (string.length == 0) {
+		return 0;
+	}
+	NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+	return MBTableGridHashBytes(data.bytes, data.length);
+}
+
+- (void)replaceValueWithValue:(double)value hash:(uint64_t)hash {
+	if (hash != 0) {
+		MBTableGridDistinctCountAdd(self.distinctValues, hash);
+	}
+	MBTableGridQuantilesAdd(self.quantiles, value);
+	
+	// The replaced value is still counted, just as if the row had been removed
+	[self changeValues:1];
+	[self.rankValues removeAllObjects];
+}
+
+- (void)changeValues:(NSUInteger)count {
+	self.numberOfChangedValues += count;
+}
+
+- (BOOL)isStale {
+	return self.numberOfChangedValues > self.numberOfValues / 64;
+}
+
+- (NSUInteger)distinctCount {
+	return (NSUInteger)llround(MBTableGridDistinctCountEstimate(self.distinctValues));
+}
+
+- (double)valueAtRank:(double)rank {
+	// Each quantile sorts the sketch, so remember them until it changes
+	NSNumber *rankValue = self.rankValues[@(rank)];
+	if (!rankValue) {
+		rankValue = @(MBTableGridQuantilesValue(self.quantiles, rank));
+		self.rankValues[@(rank)] = rankValue;
+	}
+	return rankValue.doubleValue;
+}
+
+@end
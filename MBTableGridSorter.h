@@ -0,0 +1,108 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief		A column to sort rows by, and in which direction.
+ */
+@interface MBTableGridSortKey : NSObject <NSCopying>
+
++ (instancetype)sortKeyWithColumn:(NSUInteger)columnIndex ascending:(BOOL)ascending;
+
+@property (nonatomic, readonly) NSUInteger column;
+@property (nonatomic, readonly) BOOL ascending;
+
+/**
+ * @brief		Returns a key for the same column in the other
+ *				direction.
+ */
+- (MBTableGridSortKey *)reversedSortKey;
+
+@end
+
+/**
+ * @brief		\c MBTableGridSorter works out the order of a grid's
+ *				rows without moving any data.
+ *
+ * @details		The result is a permutation: for each row on
+ *				screen, the row of the data source it shows.
+ *
+ *				Every key is turned into one double per row before
+ *				sorting. Numbers and dates are used as they are.
+ *				Anything else is replaced by its rank among the
+ *				column's distinct values, so only the distinct
+ *				values are ever compared as objects. The rows are
+ *				then sorted in chunks in parallel, and the chunks
+ *				merged.
+ *
+ *				Equal rows keep their data source order, so the
+ *				same keys always give the same permutation. Passing
+ *				the previous permutation in makes sorting again
+ *				after a few changes much cheaper, since runs that
+ *				are still in order are skipped.
+ */
+@interface MBTableGridSorter : NSObject
+
+/**
+ * @brief		Creates a sorter for a number of rows.
+ */
+- (instancetype)initWithNumberOfRows:(NSUInteger)numberOfRows;
+
+@property (nonatomic, readonly) NSUInteger numberOfRows;
+
+/**
+ * @brief		Adds a key from typed values.
+ *
+ * @param		values		One \c double per row, with NaN for empty
+ *							values.
+ * @param		ascending	The direction to sort in.
+ */
+- (void)addKeyWithNumericValues:(NSData *)values ascending:(BOOL)ascending;
+
+/**
+ * @brief		Adds a key from object values.
+ *
+ * @param		values		One object per row. \c NSNull and empty
+ *							strings sort last.
+ * @param		ascending	The direction to sort in.
+ */
+- (void)addKeyWithObjectValues:(NSArray *)values ascending:(BOOL)ascending;
+
+/**
+ * @brief		Sorts the rows.
+ *
+ * @param		segments				Ranges of rows, as \c NSValue,
+ *										that are each sorted on their own.
+ *										Rows outside them stay where they
+ *										are.
+ * @param		previousPermutation		An earlier result to start from,
+ *										or \c nil.
+ *
+ * @return		The data source row for each row, as \c NSUInteger.
+ */
+- (NSData *)permutationForSegments:(NSArray<NSValue *> *)segments previousPermutation:(NSData *)previousPermutation;
+
+@end
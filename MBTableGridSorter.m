@@ -0,0 +1,259 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridSorter.h"
+#import "MBTableGridCore.h"
+
+// Segments longer than this are sorted in parallel chunks of this size
+static const NSUInteger MBTableGridSorterChunkLength = 65536;
+
+@implementation MBTableGridSortKey
+
++ (instancetype)sortKeyWithColumn:(NSUInteger)columnIndex ascending:(BOOL)ascending {
+	MBTableGridSortKey *sortKey = [self new];
+	sortKey->_column = columnIndex;
+	sortKey->_ascending = ascending;
+	return sortKey;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+	return self;
+}
+
+- (MBTableGridSortKey *)reversedSortKey {
+	return [MBTableGridSortKey sortKeyWithColumn:self.column ascending:!self.ascending];
+}
+
+- (BOOL)isEqual:(id)object {
+	if (![object isKindOfClass:[MBTableGridSortKey class]]) {
+		return NO;
+	}
+	MBTableGridSortKey *other = object;
+	return other.column == self.column && other.ascending == self.ascending;
+}
+
+- (NSUInteger)hash {
+	return self.column * 2 + self.ascending;
+}
+
+@end
+
+@interface MBTableGridSorter ()
+
+@property (nonatomic, readwrite) NSUInteger numberOfRows;
+@property (nonatomic, strong) NSMutableArray<NSData *> *keyValues;
+@property (nonatomic, strong) NSMutableArray<NSNumber *> *keyDirections;
+
+@end
+
+@implementation MBTableGridSorter
+
+- (instancetype)initWithNumberOfRows:(NSUInteger)numberOfRows {
+	if (self = [super init]) {
+		_numberOfRows = numberOfRows;
+		_keyValues = [NSMutableArray array];
+		_keyDirections = [NSMutableArray array];
+	}
+	return self;
+}
+
+- (void)addKeyWithNumericValues:(NSData *)values ascending:(BOOL)ascending {
+	NSAssert(values.length >= self.numberOfRows * sizeof(double), @"There must be a value for every row");
+	[self.keyValues addObject:values];
+	[self.keyDirections addObject:@(ascending)];
+}
+
+- (void)addKeyWithObjectValues:(NSArray *)values ascending:(BOOL)ascending {
+	[self addKeyWithNumericValues:[MBTableGridSorter _numericValuesForObjects:values numberOfRows:self.numberOfRows] ascending:ascending];
+}
+
+#pragma mark -
+#pragma mark Converting Values
+
+static BOOL MBTableGridSorterIsEmpty(id value) {
+	return !value || value == [NSNull null] || ([value isKindOfClass:[NSString class]] && [value length] == 0);
+}
+
+// Numbers sort before dates, and dates before text
+static NSInteger MBTableGridSorterKindOfValue(id value) {
+	if ([value isKindOfClass:[NSNumber class]]) {
+		return 0;
+	} else if ([value isKindOfClass:[NSDate class]]) {
+		return 1;
+	}
+	return 2;
+}
+
++ (NSData *)_numericValuesForObjects:(NSArray *)objects numberOfRows:(NSUInteger)numberOfRows {
+	NSMutableData *data = [NSMutableData dataWithLength:MAX(numberOfRows, 1) * sizeof(double)];
+	double *values = data.mutableBytes;
+	
+	// Columns of plain numbers or dates need no ranking
+	BOOL hasNumbers = NO;
+	BOOL hasDates = NO;
+	BOOL hasOthers = NO;
+	for (id value in objects) {
+		if (MBTableGridSorterIsEmpty(value)) {
+			continue;
+		}
+		switch (MBTableGridSorterKindOfValue(value)) {
+			case 0: hasNumbers = YES; break;
+			case 1: hasDates = YES; break;
+			default: hasOthers = YES; break;
+		}
+	}
+	
+	if (!hasOthers && !(hasNumbers && hasDates)) {
+		for (NSUInteger row = 0; row < numberOfRows; row++) {
+			id value = row < objects.count ? objects[row] : nil;
+			if (MBTableGridSorterIsEmpty(value)) {
+				values[row] = NAN;
+			} else if (hasDates) {
+				values[row] = [value timeIntervalSinceReferenceDate];
+			} else {
+				values[row] = [value doubleValue];
+			}
+		}
+		return data;
+	}
+	
+	// Anything else is compared once per distinct value, and each row gets its value's rank
+	NSMutableDictionary<id, NSNumber *> *ranks = [NSMutableDictionary dictionary];
+	NSMutableArray *keys = [NSMutableArray arrayWithCapacity:numberOfRows];
+	for (NSUInteger row = 0; row < numberOfRows; row++) {
+		id value = row < objects.count ? objects[row] : nil;
+		if (MBTableGridSorterIsEmpty(value)) {
+			[keys addObject:[NSNull null]];
+			continue;
+		}
+		if (MBTableGridSorterKindOfValue(value) == 2 && ![value isKindOfClass:[NSString class]]) {
+			value = [value description];
+		}
+		[keys addObject:value];
+		ranks[value] = @0;
+	}
+	
+	NSArray *distinctValues = [ranks.allKeys sortedArrayUsingComparator:^NSComparisonResult(id value, id otherValue) {
+		NSInteger kind = MBTableGridSorterKindOfValue(value);
+		NSInteger otherKind = MBTableGridSorterKindOfValue(otherValue);
+		if (kind != otherKind) {
+			return kind < otherKind ? NSOrderedAscending : NSOrderedDescending;
+		}
+		if (kind == 2) {
+			return [value localizedStandardCompare:otherValue];
+		}
+		return [value compare:otherValue];
+	}];
+	
+	[distinctValues enumerateObjectsUsingBlock:^(id value, NSUInteger index, BOOL *stop) {
+		ranks[value] = @(index);
+	}];
+	
+	for (NSUInteger row = 0; row < numberOfRows; row++) {
+		id key = keys[row];
+		values[row] = key == [NSNull null] ? NAN : [ranks[key] doubleValue];
+	}
+	
+	return data;
+}
+
+#pragma mark -
+#pragma mark Sorting
+
+- (NSData *)permutationForSegments:(NSArray<NSValue *> *)segments previousPermutation:(NSData *)previousPermutation {
+	NSUInteger numberOfRows = self.numberOfRows;
+	NSMutableData *permutation = [NSMutableData dataWithLength:MAX(numberOfRows, 1) * sizeof(NSUInteger)];
+	size_t *rows = permutation.mutableBytes;
+	
+	for (NSUInteger row = 0; row < numberOfRows; row++) {
+		rows[row] = row;
+	}
+	
+	const size_t *previousRows = previousPermutation.length == numberOfRows * sizeof(NSUInteger) ? previousPermutation.bytes : NULL;
+	
+	NSUInteger numberOfKeys = self.keyValues.count;
+	if (numberOfKeys == 0 || numberOfRows == 0) {
+		return permutation;
+	}
+	
+	MBTableGridCoreSortKey *keys = malloc(numberOfKeys * sizeof(MBTableGridCoreSortKey));
+	for (NSUInteger index = 0; index < numberOfKeys; index++) {
+		keys[index].values = self.keyValues[index].bytes;
+		keys[index].descending = !self.keyDirections[index].boolValue;
+	}
+	
+	size_t *scratch = malloc(numberOfRows * sizeof(size_t));
+	dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+	
+	NSUInteger numberOfSegments = segments.count;
+	dispatch_apply(numberOfSegments, queue, ^(size_t segmentIndex) {
+		NSRange segment = NSIntersectionRange(segments[segmentIndex].rangeValue, NSMakeRange(0, numberOfRows));
+		size_t *segmentRows = rows + segment.location;
+		size_t *segmentScratch = scratch + segment.location;
+		
+		// A previous permutation can only be reused where it kept its rows inside the segment
+		if (previousRows) {
+			const size_t *previousSegmentRows = previousRows + segment.location;
+			BOOL isReusable = YES;
+			for (NSUInteger index = 0; index < segment.length && isReusable; index++) {
+				isReusable = previousSegmentRows[index] >= segment.location && previousSegmentRows[index] < NSMaxRange(segment);
+			}
+			if (isReusable) {
+				memcpy(segmentRows, previousSegmentRows, segment.length * sizeof(size_t));
+			}
+		}
+		
+		if (segment.length <= MBTableGridSorterChunkLength * 2) {
+			MBTableGridCoreSortRows(segmentRows, segmentScratch, segment.length, keys, numberOfKeys);
+			return;
+		}
+		
+		// Sort chunks in parallel, then merge pairs of them in parallel until one is left
+		size_t numberOfChunks = (segment.length + MBTableGridSorterChunkLength - 1) / MBTableGridSorterChunkLength;
+		dispatch_apply(numberOfChunks, queue, ^(size_t chunk) {
+			size_t start = chunk * MBTableGridSorterChunkLength;
+			size_t length = MIN(MBTableGridSorterChunkLength, segment.length - start);
+			MBTableGridCoreSortRows(segmentRows + start, segmentScratch + start, length, keys, numberOfKeys);
+		});
+		
+		for (size_t width = MBTableGridSorterChunkLength; width < segment.length; width *= 2) {
+			size_t numberOfMerges = (segment.length + 2 * width - 1) / (2 * width);
+			dispatch_apply(numberOfMerges, queue, ^(size_t merge) {
+				size_t start = merge * 2 * width;
+				size_t end = MIN(start + 2 * width, segment.length);
+				if (start + width < end) {
+					MBTableGridCoreMergeSortedRows(segmentRows + start, segmentScratch + start, width, end - start, keys, numberOfKeys);
+				}
+			});
+		}
+	});
+	
+	free(scratch);
+	free(keys);
+	
+	return permutation;
+}
+
+@end
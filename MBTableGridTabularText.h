@@ -0,0 +1,118 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * @brief		The pasteboard type used for comma separated text.
+ */
+FOUNDATION_EXTERN NSString * const MBTableGridCSVPasteboardType;
+
+/**
+ * @brief		The text formats understood by \c MBTableGridTabularText.
+ */
+typedef NS_ENUM(NSUInteger, MBTableGridTextFormat) {
+	MBTableGridTextFormatTSV = 0,
+	MBTableGridTextFormatCSV
+};
+
+/**
+ * @brief		\c MBTableGridTabularText converts between grid
+ *				values and tab or comma separated UTF-8 text.
+ *
+ * @details		This is what the grid uses for its built-in copy
+ *				and paste. Rows are formatted and parsed in chunks
+ *				on a concurrent queue, and the output is written
+ *				straight into a single UTF-8 buffer, so that large
+ *				selections can be transferred quickly.
+ *
+ *				Fields containing the separator, a line break or a
+ *				double quote are quoted, with double quotes doubled,
+ *				in both formats.
+ */
+@interface MBTableGridTabularText : NSObject
+
+/**
+ * @brief		Returns the text for a value, using \c formatter
+ *				if there is one.
+ */
++ (NSString *)stringForValue:(id)value formatter:(NSFormatter *)formatter;
+
+/**
+ * @brief		Formats a rectangle of values as UTF-8 text.
+ *
+ * @details		Formatting happens concurrently, so the values must
+ *				be safe to read from several threads at once. Each
+ *				worker formats with its own copies of the
+ *				formatters, made on the calling thread.
+ *
+ * @param		values				The values in row-major order.
+ *									\c NSNull stands for an empty cell.
+ * @param		numberOfColumns		The number of values in each row.
+ * @param		formatters			One formatter per column, or
+ *									\c NSNull for columns without one.
+ *									May be \c nil.
+ * @param		format				The output format.
+ */
++ (NSData *)UTF8DataWithValues:(NSArray *)values numberOfColumns:(NSUInteger)numberOfColumns formatters:(NSArray *)formatters format:(MBTableGridTextFormat)format;
+
+/**
+ * @brief		Parses UTF-8 text into rows of fields.
+ *
+ * @details		Row boundaries are found in a single pass, and the
+ *				rows are then split into fields concurrently.
+ *				\c "\n", \c "\r\n" and bare \c "\r" line endings
+ *				are all accepted.
+ *
+ * @return		An array of rows, each an array of strings.
+ */
++ (NSArray<NSArray<NSString *> *> *)rowsWithUTF8Data:(NSData *)data format:(MBTableGridTextFormat)format;
+
+/**
+ * @brief		Copies \c formatters once for each worker that
+ *				\c applyChunks:formatterCopies:queue:block: runs.
+ *
+ * @details		\c NSFormatter subclasses aren't thread-safe, so
+ *				formatters are copied on the thread that owns them,
+ *				and each worker only ever uses its own copies.
+ *				\c NSNull entries are kept as they are.
+ *
+ * @return		One array of copies per worker, or \c nil if
+ *				\c formatters is \c nil.
+ */
++ (NSArray<NSArray *> *)formatterCopiesForWorkers:(NSArray *)formatters;
+
+/**
+ * @brief		Calls \c block concurrently for every chunk from
+ *				\c 0 to \c numberOfChunks - 1.
+ *
+ * @details		Each worker takes every n-th chunk and passes its
+ *				own set of \c formatterCopies to \c block, so no two
+ *				threads use the same formatter. Returns once every
+ *				chunk is done.
+ */
++ (void)applyChunks:(NSUInteger)numberOfChunks formatterCopies:(NSArray<NSArray *> *)formatterCopies queue:(dispatch_queue_t)queue block:(void (^)(NSUInteger chunk, NSArray *formatters))block;
+
+@end
@@ -0,0 +1,313 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridTabularText.h"
+
+NSString * const MBTableGridCSVPasteboardType = @"public.comma-separated-values-text";
+
+// The number of rows formatted or parsed by each concurrent block
+static const NSUInteger MBTableGridTabularTextChunkSize = 4096;
+
+static inline char MBTableGridSeparatorForFormat(MBTableGridTextFormat format) {
+	return format == MBTableGridTextFormatCSV ? ',' : '\t';
+}
+
+static void MBTableGridAppendField(NSMutableData *data, NSString *string, char separator) {
+	const char *bytes = string.UTF8String;
+	size_t length = strlen(bytes);
+	
+	BOOL needsQuotes = NO;
+	for (size_t i = 0; i < length && !needsQuotes; i++) {
+		char c = bytes[i];
+		needsQuotes = c == separator || c == '\n' || c == '\r' || c == '"';
+	}
+	
+	if (!needsQuotes) {
+		[data appendBytes:bytes length:length];
+		return;
+	}
+	
+	[data appendBytes:"\"" length:1];
+	size_t runStart = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (bytes[i] == '"') {
+			// Write up to and including the quote, and start the next run on it so that it's doubled
+			[data appendBytes:bytes + runStart length:i - runStart + 1];
+			runStart = i;
+		}
+	}
+	[data appendBytes:bytes + runStart length:length - runStart];
+	[data appendBytes:"\"" length:1];
+}
+
+static NSString *MBTableGridStringWithBytes(const void *bytes, NSUInteger length) {
+	return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+static NSArray<NSString *> *MBTableGridFieldsInRow(const char *bytes, NSUInteger length, char separator) {
+	NSMutableArray<NSString *> *fields = [NSMutableArray array];
+	NSUInteger i = 0;
+	
+	while (YES) {
+		if (i < length && bytes[i] == '"') {
+			// A quoted field, where two quotes stand for one
+			NSMutableData *field = [NSMutableData data];
+			NSUInteger runStart = ++i;
+			while (i < length) {
+				if (bytes[i] == '"') {
+					[field appendBytes:bytes + runStart length:i - runStart];
+					if (i + 1 < length && bytes[i + 1] == '"') {
+						runStart = i + 1;
+						i += 2;
+						continue;
+					}
+					runStart = NSNotFound;
+					i++;
+					break;
+				}
+				i++;
+			}
+			
+			// Be forgiving about a missing closing quote
+			if (runStart != NSNotFound) {
+				[field appendBytes:bytes + runStart length:length - runStart];
+			}
+			
+			// Ignore anything between the closing quote and the next separator
+			while (i < length && bytes[i] != separator) {
+				i++;
+			}
+			
+			[fields addObject:MBTableGridStringWithBytes(field.bytes, field.length)];
+		} else {
+			const char *separatorPosition = memchr(bytes + i, separator, length - i);
+			NSUInteger fieldEnd = separatorPosition ? (NSUInteger)(separatorPosition - bytes) : length;
+			[fields addObject:MBTableGridStringWithBytes(bytes + i, fieldEnd - i)];
+			i = fieldEnd;
+		}
+		
+		if (i < length && bytes[i] == separator) {
+			i++;
+		} else {
+			break;
+		}
+	}
+	
+	return fields;
+}
+
+@implementation MBTableGridTabularText
+
++ (NSString *)stringForValue:(id)value formatter:(NSFormatter *)formatter {
+	if (!value || value == [NSNull null]) {
+		return @"";
+	}
+	
+	if (formatter) {
+		NSString *string = [formatter stringForObjectValue:value];
+		if (string) {
+			return string;
+		}
+	}
+	
+	if ([value isKindOfClass:[NSString class]]) {
+		return value;
+	} else if ([value respondsToSelector:@selector(stringValue)]) {
+		return [value stringValue];
+	}
+	
+	return [value description];
+}
+
++ (NSArray<NSArray *> *)formatterCopiesForWorkers:(NSArray *)formatters {
+	if (!formatters) {
+		return nil;
+	}
+	
+	NSUInteger numberOfWorkers = MAX([NSProcessInfo processInfo].activeProcessorCount, 1);
+	NSMutableArray<NSArray *> *formatterCopies = [NSMutableArray arrayWithCapacity:numberOfWorkers];
+	for (NSUInteger worker = 0; worker < numberOfWorkers; worker++) {
+		NSMutableArray *copies = [NSMutableArray arrayWithCapacity:formatters.count];
+		for (id formatter in formatters) {
+			[copies addObject:formatter == [NSNull null] ? formatter : [formatter copy]];
+		}
+		[formatterCopies addObject:copies];
+	}
+	return formatterCopies;
+}
+
++ (void)applyChunks:(NSUInteger)numberOfChunks formatterCopies:(NSArray<NSArray *> *)formatterCopies queue:(dispatch_queue_t)queue block:(void (^)(NSUInteger chunk, NSArray *formatters))block {
+	NSUInteger numberOfWorkers = formatterCopies ? formatterCopies.count : [NSProcessInfo processInfo].activeProcessorCount;
+	numberOfWorkers = MAX(MIN(numberOfWorkers, numberOfChunks), 1);
+	
+	dispatch_apply(numberOfWorkers, queue, ^(size_t worker) {
+		NSArray *formatters = formatterCopies[worker];
+		for (NSUInteger chunk = worker; chunk < numberOfChunks; chunk += numberOfWorkers) {
+			block(chunk, formatters);
+		}
+	});
+}
+
++ (NSData *)UTF8DataWithValues:(NSArray *)values numberOfColumns:(NSUInteger)numberOfColumns formatters:(NSArray *)formatters format:(MBTableGridTextFormat)format {
+	if (numberOfColumns == 0 || values.count == 0) {
+		return [NSData data];
+	}
+	
+	NSUInteger numberOfRows = values.count / numberOfColumns;
+	NSUInteger numberOfChunks = (numberOfRows + MBTableGridTabularTextChunkSize - 1) / MBTableGridTabularTextChunkSize;
+	char separator = MBTableGridSeparatorForFormat(format);
+	
+	// Each block writes its rows into its own buffer, sized for a typical short value per cell
+	NSMutableArray<NSMutableData *> *chunks = [NSMutableArray arrayWithCapacity:numberOfChunks];
+	for (NSUInteger chunk = 0; chunk < numberOfChunks; chunk++) {
+		[chunks addObject:[NSMutableData dataWithCapacity:MBTableGridTabularTextChunkSize * numberOfColumns * 8]];
+	}
+	
+	NSArray<NSArray *> *formatterCopies = [self formatterCopiesForWorkers:formatters];
+	[self applyChunks:numberOfChunks formatterCopies:formatterCopies queue:dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0) block:^(NSUInteger chunk, NSArray *workerFormatters) {
+		NSMutableData *data = chunks[chunk];
+		NSUInteger firstRow = chunk * MBTableGridTabularTextChunkSize;
+		NSUInteger endRow = MIN(firstRow + MBTableGridTabularTextChunkSize, numberOfRows);
+		
+		for (NSUInteger row = firstRow; row < endRow; row++) {
+			@autoreleasepool {
+				for (NSUInteger column = 0; column < numberOfColumns; column++) {
+					if (column > 0) {
+						[data appendBytes:&separator length:1];
+					}
+					
+					id formatter = workerFormatters[column];
+					NSString *string = [self stringForValue:values[row * numberOfColumns + column] formatter:formatter == [NSNull null] ? nil : formatter];
+					MBTableGridAppendField(data, string, separator);
+				}
+				
+				if (row + 1 < numberOfRows) {
+					[data appendBytes:"\n" length:1];
+				}
+			}
+		}
+	}];
+	
+	// Join the chunks, in order, into one buffer allocated up front
+	NSUInteger length = 0;
+	for (NSData *chunk in chunks) {
+		length += chunk.length;
+	}
+	
+	NSMutableData *output = [NSMutableData dataWithCapacity:length];
+	for (NSData *chunk in chunks) {
+		[output appendData:chunk];
+	}
+	
+	return output;
+}
+
++ (NSArray<NSArray<NSString *> *> *)rowsWithUTF8Data:(NSData *)data format:(MBTableGridTextFormat)format {
+	const char *bytes = data.bytes;
+	NSUInteger length = data.length;
+	
+	if (length == 0) {
+		return @[];
+	}
+	
+	// Find where each row starts, ignoring line breaks inside quoted fields.
+	// As in MBTableGridFieldsInRow, a quote only opens a quoted field at the
+	// start of a field, so a stray quote in an unquoted one is just text.
+	NSMutableData *rowStartData = [NSMutableData data];
+	NSUInteger rowStart = 0;
+	[rowStartData appendBytes:&rowStart length:sizeof(NSUInteger)];
+	
+	char separator = MBTableGridSeparatorForFormat(format);
+	BOOL inQuotes = NO;
+	BOOL atFieldStart = YES;
+	for (NSUInteger i = 0; i < length; i++) {
+		char c = bytes[i];
+		if (inQuotes) {
+			if (c == '"') {
+				// Two quotes stand for one and leave the field open
+				if (i + 1 < length && bytes[i + 1] == '"') {
+					i++;
+				} else {
+					inQuotes = NO;
+				}
+			}
+		} else if (c == '"' && atFieldStart) {
+			inQuotes = YES;
+			atFieldStart = NO;
+		} else if (c == separator) {
+			atFieldStart = YES;
+		} else if (c == '\n' || (c == '\r' && (i + 1 == length || bytes[i + 1] != '\n'))) {
+			// Rows end in \n, \r\n or a bare \r
+			atFieldStart = YES;
+			if (i + 1 < length) {
+				rowStart = i + 1;
+				[rowStartData appendBytes:&rowStart length:sizeof(NSUInteger)];
+			}
+		} else {
+			atFieldStart = NO;
+		}
+	}
+	
+	NSUInteger numberOfRows = rowStartData.length / sizeof(NSUInteger);
+	[rowStartData appendBytes:&length length:sizeof(NSUInteger)];
+	
+	const NSUInteger *rowStarts = rowStartData.bytes;
+	NSUInteger numberOfChunks = (numberOfRows + MBTableGridTabularTextChunkSize - 1) / MBTableGridTabularTextChunkSize;
+	
+	NSMutableArray<NSMutableArray *> *chunks = [NSMutableArray arrayWithCapacity:numberOfChunks];
+	for (NSUInteger chunk = 0; chunk < numberOfChunks; chunk++) {
+		[chunks addObject:[NSMutableArray arrayWithCapacity:MBTableGridTabularTextChunkSize]];
+	}
+	
+	dispatch_apply(numberOfChunks, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t chunk) {
+		NSMutableArray *rows = chunks[chunk];
+		NSUInteger firstRow = chunk * MBTableGridTabularTextChunkSize;
+		NSUInteger endRow = MIN(firstRow + MBTableGridTabularTextChunkSize, numberOfRows);
+		
+		for (NSUInteger row = firstRow; row < endRow; row++) {
+			NSUInteger start = rowStarts[row];
+			NSUInteger end = rowStarts[row + 1];
+			
+			// Drop the line ending
+			if (end > start && bytes[end - 1] == '\n') {
+				end--;
+			}
+			if (end > start && bytes[end - 1] == '\r') {
+				end--;
+			}
+			
+			[rows addObject:MBTableGridFieldsInRow(bytes + start, end - start, separator)];
+		}
+	});
+	
+	NSMutableArray<NSArray<NSString *> *> *rows = [NSMutableArray arrayWithCapacity:numberOfRows];
+	for (NSArray *chunk in chunks) {
+		[rows addObjectsFromArray:chunk];
+	}
+	
+	return rows;
+}
+
+@end
@@ -0,0 +1,58 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Cocoa/Cocoa.h>
+
+/**
+ * @brief		\c MBTableGridTextMeasurer works out how wide text
+ *				is in a font, quickly and from any thread.
+ *
+ * @details		The advances of the Latin-1 characters are looked up
+ *				once, so most cell text is measured by adding them
+ *				up. Text with other characters, which can need font
+ *				substitution or shaping, is measured in full. Kerning
+ *				is ignored, which can only make widths a little too
+ *				large.
+ */
+@interface MBTableGridTextMeasurer : NSObject
+
+/**
+ * @brief		Returns the measurer for \c font, which is shared by
+ *				everything that measures text in that font.
+ */
++ (instancetype)measurerForFont:(NSFont *)font;
+
+/**
+ * @brief		The font text is measured in.
+ */
+@property (nonatomic, strong, readonly) NSFont *font;
+
+/**
+ * @brief		Returns the width of \c string, rounded up to a whole
+ *				point. It can be called from any thread.
+ */
+- (CGFloat)widthOfString:(NSString *)string;
+
+@end
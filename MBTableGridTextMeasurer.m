@@ -0,0 +1,108 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridTextMeasurer.h"
+
+// Characters below this are measured from the table of advances
+static const NSUInteger MBTableGridTextMeasurerCachedCharacters = 256;
+
+// Characters are copied out of strings this many at a time
+static const NSUInteger MBTableGridTextMeasurerBufferLength = 128;
+
+@interface MBTableGridTextMeasurer ()
+
+@property (nonatomic, strong, readwrite) NSFont *font;
+@property (nonatomic, copy) NSDictionary *attributes;
+
+@end
+
+@implementation MBTableGridTextMeasurer {
+	CGFloat _advances[MBTableGridTextMeasurerCachedCharacters];
+	BOOL _hasAdvance[MBTableGridTextMeasurerCachedCharacters];
+}
+
++ (instancetype)measurerForFont:(NSFont *)font {
+	static NSMutableDictionary<NSFont *, MBTableGridTextMeasurer *> *measurers = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		measurers = [NSMutableDictionary dictionary];
+	});
+	
+	font = font ?: [NSFont systemFontOfSize:[NSFont systemFontSize]];
+	@synchronized (measurers) {
+		MBTableGridTextMeasurer *measurer = measurers[font];
+		if (!measurer) {
+			measurer = [[MBTableGridTextMeasurer alloc] initWithFont:font];
+			measurers[font] = measurer;
+		}
+		return measurer;
+	}
+}
+
+- (instancetype)initWithFont:(NSFont *)font {
+	if (self = [super init]) {
+		_font = font;
+		_attributes = @{ NSFontAttributeName: font };
+		
+		UniChar characters[MBTableGridTextMeasurerCachedCharacters];
+		CGGlyph glyphs[MBTableGridTextMeasurerCachedCharacters];
+		CGSize advances[MBTableGridTextMeasurerCachedCharacters];
+		for (NSUInteger character = 0; character < MBTableGridTextMeasurerCachedCharacters; character++) {
+			characters[character] = (UniChar)character;
+		}
+		
+		// Characters the font has no glyph for are measured in full, so they get a substituted font
+		CTFontRef ctFont = (__bridge CTFontRef)font;
+		CTFontGetGlyphsForCharacters(ctFont, characters, glyphs, MBTableGridTextMeasurerCachedCharacters);
+		CTFontGetAdvancesForGlyphs(ctFont, kCTFontOrientationHorizontal, glyphs, advances, MBTableGridTextMeasurerCachedCharacters);
+		for (NSUInteger character = 0; character < MBTableGridTextMeasurerCachedCharacters; character++) {
+			_hasAdvance[character] = glyphs[character] != 0 && character >= 0x20 && character != 0x7F;
+			_advances[character] = advances[character].width;
+		}
+	}
+	return self;
+}
+
+- (CGFloat)widthOfString:(NSString *)string {
+	NSUInteger length = string.length;
+	unichar buffer[MBTableGridTextMeasurerBufferLength];
+	CGFloat width = 0;
+	
+	for (NSUInteger location = 0; location < length; location += MBTableGridTextMeasurerBufferLength) {
+		NSUInteger bufferLength = MIN(MBTableGridTextMeasurerBufferLength, length - location);
+		[string getCharacters:buffer range:NSMakeRange(location, bufferLength)];
+		for (NSUInteger index = 0; index < bufferLength; index++) {
+			unichar character = buffer[index];
+			if (character >= MBTableGridTextMeasurerCachedCharacters || !_hasAdvance[character]) {
+				return ceil([string sizeWithAttributes:self.attributes].width);
+			}
+			width += _advances[character];
+		}
+	}
+	
+	return ceil(width);
+}
+
+@end
@@ -0,0 +1,139 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class MBTableGridColumnEdit, MBTableGridUndoJournal;
+
+/**
+ * @brief		The object that undo journal entries are applied to.
+ */
+@protocol MBTableGridUndoJournalTarget <NSObject>
+
+/**
+ * @brief		Applies the values of \c edit when its entry is
+ *				undone or redone.
+ *
+ * @details		The target should register the values it replaces
+ *				with the journal again, so that the change can be
+ *				redone (or undone again).
+ */
+- (void)undoJournal:(MBTableGridUndoJournal *)journal applyEdit:(MBTableGridColumnEdit *)edit actionName:(NSString *)actionName;
+
+@end
+
+/**
+ * @brief		\c MBTableGridUndoJournal keeps the undo state for
+ *				cell changes as compact, column-wise diffs.
+ *
+ * @details		Each entry holds the previous values of a set of
+ *				rows in one column as an \c MBTableGridColumnEdit,
+ *				and is registered with an \c NSUndoManager as a
+ *				single action, however many rows it covers.
+ *
+ *				The journal keeps track of roughly how much memory
+ *				its entries use. When that goes over
+ *				\c memoryLimit, the oldest undo groups are removed
+ *				from their undo managers, along with every entry in
+ *				them, until it fits again. Entries that an undo
+ *				manager drops by itself, such as when it clears its
+ *				redo stack or goes over \c levelsOfUndo, stop
+ *				counting as soon as the undo manager releases them.
+ *
+ *				Consecutive single-cell changes can be coalesced
+ *				into the previous entry, so that typing a value into
+ *				a cell, or typing down a column, is undone in one
+ *				step. Once the undo manager has opened another group
+ *				since the entry was registered, nothing is coalesced
+ *				into it.
+ */
+@interface MBTableGridUndoJournal : NSObject
+
+/**
+ * @brief		Creates a journal that applies its entries to
+ *				\c target.
+ */
+- (instancetype)initWithTarget:(id<MBTableGridUndoJournalTarget>)target;
+
+/**
+ * @brief		The object entries are applied to.
+ */
+@property (nonatomic, weak, readonly) id<MBTableGridUndoJournalTarget> target;
+
+/**
+ * @brief		The approximate number of bytes that entries may
+ *				use before the oldest are dropped.
+ *
+ * @details		The default is 64 MB. Set it to \c 0 for no limit.
+ */
+@property (nonatomic) NSUInteger memoryLimit;
+
+/**
+ * @brief		The longest time between two changes that can be
+ *				coalesced into one entry.
+ *
+ * @details		The default is 2 seconds. Set it to \c 0 to turn
+ *				coalescing off.
+ */
+@property (nonatomic) NSTimeInterval coalescingInterval;
+
+/**
+ * @brief		The approximate number of bytes used by the entries.
+ */
+@property (nonatomic, readonly) NSUInteger memoryUsage;
+
+/**
+ * @brief		The number of entries held for undo or redo.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfEntries;
+
+/**
+ * @brief		Registers an entry that restores \c previousValues.
+ *
+ * @param		previousValues	The values being replaced.
+ * @param		actionName		The name of the undo action.
+ * @param		undoManager		The undo manager to register with.
+ * @param		coalesce		Whether a single-cell change may be
+ *								merged into the previous entry.
+ */
+- (void)registerPreviousValues:(MBTableGridColumnEdit *)previousValues actionName:(NSString *)actionName undoManager:(NSUndoManager *)undoManager coalesce:(BOOL)coalesce;
+
+/**
+ * @brief		Registers an action that holds no cell values, such
+ *				as one that removes the rows a fill added.
+ *
+ * @details		The action is part of the same undo group as the
+ *				entries registered with it, so it is removed with
+ *				them when the group is trimmed. \c handler should
+ *				register the opposite action the same way.
+ */
+- (void)registerUndoWithUndoManager:(NSUndoManager *)undoManager handler:(void (^)(void))handler;
+
+/**
+ * @brief		Removes every entry, along with its undo action.
+ */
+- (void)removeAllEntries;
+
+@end
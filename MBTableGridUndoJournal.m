@@ -0,0 +1,325 @@
+/*
+ Copyright (c) 2008 Matthew Ball - http://www.mattballdesign.com
+ 
+ Permission is hereby granted, free of charge, to any person
+ obtaining a copy of this software and associated documentation
+ files (the "Software"), to deal in the Software without
+ restriction, including without limitation the rights to use,
+ copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following
+ conditions:
+ 
+ The above copyright notice and this permission notice shall be
+ included in all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "MBTableGridUndoJournal.h"
+#import "MBTableGridColumnEdit.h"
+
+@interface MBTableGridUndoJournalEntry : NSObject
+
+@property (nonatomic, weak) MBTableGridUndoJournal *journal;
+@property (nonatomic, weak) NSUndoManager *undoManager;
+@property (nonatomic, strong) MBTableGridColumnEdit *edit;
+@property (nonatomic, copy) void (^handler)(void);
+@property (nonatomic, copy) NSString *actionName;
+@property (nonatomic) NSUInteger memoryCost;
+@property (nonatomic) NSUInteger group;
+@property (nonatomic) BOOL coalesces;
+
+@end
+
+@interface MBTableGridUndoJournal ()
+
+@property (nonatomic, weak, readwrite) id<MBTableGridUndoJournalTarget> target;
+@property (nonatomic, strong) NSPointerArray *entries;
+@property (nonatomic, readwrite) NSUInteger memoryUsage;
+@property (nonatomic, readwrite) NSUInteger numberOfEntries;
+@property (nonatomic, weak) MBTableGridUndoJournalEntry *lastEntry;
+@property (nonatomic) NSTimeInterval lastEntryTime;
+@property (nonatomic) NSUInteger lastGroup;
+@property (nonatomic) NSUInteger openGroup;
+@property (nonatomic, weak) NSUndoManager *openGroupUndoManager;
+@property (nonatomic, weak) NSUndoManager *observedUndoManager;
+@property (nonatomic) NSUInteger numberOfGroupsOpenedSinceLastEntry;
+
+- (void)_applyEntry:(MBTableGridUndoJournalEntry *)entry;
+- (void)_forgetEntryWithMemoryCost:(NSUInteger)memoryCost;
+
+@end
+
+@implementation MBTableGridUndoJournalEntry
+
+- (void)dealloc {
+	// The undo manager has let go of the action, so the entry can no longer be undone or redone
+	[_journal _forgetEntryWithMemoryCost:_memoryCost];
+}
+
+@end
+
+@implementation MBTableGridUndoJournal
+
+- (instancetype)initWithTarget:(id<MBTableGridUndoJournalTarget>)target {
+	if (self = [super init]) {
+		_target = target;
+		_entries = [NSPointerArray weakObjectsPointerArray];
+		_memoryLimit = 64 * 1024 * 1024;
+		_coalescingInterval = 2.0;
+	}
+	return self;
+}
+
+- (void)dealloc {
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)setMemoryLimit:(NSUInteger)memoryLimit {
+	_memoryLimit = memoryLimit;
+	[self _trimToMemoryLimit];
+}
+
+#pragma mark -
+#pragma mark Undo Groups
+
++ (NSArray<NSString *> *)_groupEndingNotificationNames {
+	return @[NSUndoManagerDidCloseUndoGroupNotification, NSUndoManagerWillUndoChangeNotification, NSUndoManagerDidUndoChangeNotification, NSUndoManagerWillRedoChangeNotification, NSUndoManagerDidRedoChangeNotification];
+}
+
+- (NSUInteger)_groupForUndoManager:(NSUndoManager *)undoManager {
+	if (self.openGroup != 0 && self.openGroupUndoManager == undoManager) {
+		return self.openGroup;
+	}
+	
+	[self _closeGroup];
+	
+	self.openGroup = ++self.lastGroup;
+	self.openGroupUndoManager = undoManager;
+	
+	// Every entry registered until the undo manager closes its group, or
+	// starts undoing or redoing one, is undone as part of the same action
+	NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+	for (NSString *name in [MBTableGridUndoJournal _groupEndingNotificationNames]) {
+		[center addObserver:self selector:@selector(undoManagerDidEndGroup:) name:name object:undoManager];
+	}
+	
+	return self.openGroup;
+}
+
+- (void)_closeGroup {
+	if (self.openGroupUndoManager) {
+		for (NSString *name in [MBTableGridUndoJournal _groupEndingNotificationNames]) {
+			[[NSNotificationCenter defaultCenter] removeObserver:self name:name object:self.openGroupUndoManager];
+		}
+	}
+	
+	self.openGroup = 0;
+	self.openGroupUndoManager = nil;
+}
+
+- (void)undoManagerDidEndGroup:(NSNotification *)aNotification {
+	[self _closeGroup];
+}
+
+- (void)_countGroupsOpenedByUndoManager:(NSUndoManager *)undoManager {
+	// Any group the undo manager opens after the last entry, such as one for another kind of
+	// change, comes between that entry and the next change
+	NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+	if (self.observedUndoManager != undoManager) {
+		if (self.observedUndoManager) {
+			[center removeObserver:self name:NSUndoManagerDidOpenUndoGroupNotification object:self.observedUndoManager];
+		}
+		[center addObserver:self selector:@selector(undoManagerDidOpenGroup:) name:NSUndoManagerDidOpenUndoGroupNotification object:undoManager];
+		self.observedUndoManager = undoManager;
+	}
+	self.numberOfGroupsOpenedSinceLastEntry = 0;
+}
+
+- (void)undoManagerDidOpenGroup:(NSNotification *)aNotification {
+	self.numberOfGroupsOpenedSinceLastEntry++;
+}
+
+#pragma mark -
+#pragma mark Registering
+
+- (BOOL)_coalescePreviousValues:(MBTableGridColumnEdit *)previousValues actionName:(NSString *)actionName undoManager:(NSUndoManager *)undoManager {
+	MBTableGridUndoJournalEntry *entry = self.lastEntry;
+	
+	if (!entry || !entry.coalesces || previousValues.count != 1 || self.coalescingInterval <= 0) {
+		return NO;
+	}
+	
+	// Only merge into the entry on top of the undo stack, for the same kind of change, made recently.
+	// Once another group has been opened, the entry may no longer be on top, whatever its name.
+	if (entry.undoManager != undoManager || undoManager.isUndoing || undoManager.isRedoing || self.numberOfGroupsOpenedSinceLastEntry > 0 || ![undoManager.undoActionName isEqualToString:actionName]) {
+		return NO;
+	}
+	
+	if ([NSDate timeIntervalSinceReferenceDate] - self.lastEntryTime > self.coalescingInterval) {
+		return NO;
+	}
+	
+	// The same cell again, or a cell further down the same column
+	NSUInteger row = previousValues.rowIndexes.firstIndex;
+	NSUInteger lastRow = entry.edit.rowIndexes.lastIndex;
+	if (previousValues.column != entry.edit.column || row < lastRow) {
+		return NO;
+	}
+	
+	// The entry already holds the original value of its last cell
+	if (row > lastRow) {
+		self.memoryUsage -= entry.memoryCost;
+		[entry.edit addValue:[previousValues valueAtIndex:0] forRow:row];
+		entry.memoryCost = entry.edit.estimatedMemoryCost;
+		self.memoryUsage += entry.memoryCost;
+	}
+	
+	self.lastEntryTime = [NSDate timeIntervalSinceReferenceDate];
+	return YES;
+}
+
+- (void)registerPreviousValues:(MBTableGridColumnEdit *)previousValues actionName:(NSString *)actionName undoManager:(NSUndoManager *)undoManager coalesce:(BOOL)coalesce {
+	if (!undoManager || previousValues.count == 0) {
+		return;
+	}
+	
+	if (coalesce && [self _coalescePreviousValues:previousValues actionName:actionName undoManager:undoManager]) {
+		undoManager.actionName = actionName;
+		return;
+	}
+	
+	MBTableGridUndoJournalEntry *entry = [MBTableGridUndoJournalEntry new];
+	entry.edit = previousValues;
+	entry.actionName = actionName;
+	entry.memoryCost = previousValues.estimatedMemoryCost;
+	entry.coalesces = coalesce && !undoManager.isUndoing && !undoManager.isRedoing;
+	[self _registerEntry:entry undoManager:undoManager];
+	undoManager.actionName = actionName;
+}
+
+- (void)registerUndoWithUndoManager:(NSUndoManager *)undoManager handler:(void (^)(void))handler {
+	if (!undoManager || !handler) {
+		return;
+	}
+	
+	MBTableGridUndoJournalEntry *entry = [MBTableGridUndoJournalEntry new];
+	entry.handler = handler;
+	[self _registerEntry:entry undoManager:undoManager];
+}
+
+- (void)_registerEntry:(MBTableGridUndoJournalEntry *)entry undoManager:(NSUndoManager *)undoManager {
+	entry.journal = self;
+	entry.undoManager = undoManager;
+	entry.group = [self _groupForUndoManager:undoManager];
+	
+	[self.entries addPointer:(__bridge void *)entry];
+	self.numberOfEntries++;
+	self.memoryUsage += entry.memoryCost;
+	
+	// The undo manager doesn't retain the target, but it owns the entry through
+	// the handler that captures it, so the entry goes
+	// away, and stops counting against the limit, as soon as the undo manager
+	// drops the action for any reason
+	[undoManager registerUndoWithTarget:entry handler:^(id target) {
+		[entry.journal _applyEntry:entry];
+	}];
+	
+	self.lastEntry = entry;
+	self.lastEntryTime = [NSDate timeIntervalSinceReferenceDate];
+	[self _countGroupsOpenedByUndoManager:undoManager];
+	
+	[self _trimToMemoryLimit];
+}
+
+- (void)_trimToMemoryLimit {
+	if (self.memoryLimit == 0) {
+		return;
+	}
+	
+	[self.entries compact];
+	
+	// Drop the oldest undo groups whole, so that no action is left undoing only
+	// some of its columns, but always keep the newest group so the latest change
+	// can be undone
+	while (self.memoryUsage > self.memoryLimit) {
+		NSArray<MBTableGridUndoJournalEntry *> *entries = self.entries.allObjects;
+		MBTableGridUndoJournalEntry *oldestEntry = entries.firstObject;
+		if (!oldestEntry || oldestEntry.group == entries.lastObject.group) {
+			break;
+		}
+		
+		for (MBTableGridUndoJournalEntry *entry in entries) {
+			if (entry.group == oldestEntry.group) {
+				[self _removeEntry:entry];
+				[entry.undoManager removeAllActionsWithTarget:entry];
+			}
+		}
+		
+		[self.entries compact];
+	}
+}
+
+- (void)_removeEntry:(MBTableGridUndoJournalEntry *)entry {
+	if (!entry.journal) {
+		return;
+	}
+	
+	// Account for the entry now, rather than when it's deallocated
+	entry.journal = nil;
+	[self _forgetEntryWithMemoryCost:entry.memoryCost];
+	
+	for (NSUInteger i = 0; i < self.entries.count; i++) {
+		if ([self.entries pointerAtIndex:i] == (__bridge void *)entry) {
+			[self.entries replacePointerAtIndex:i withPointer:NULL];
+			break;
+		}
+	}
+	
+	if (self.lastEntry == entry) {
+		self.lastEntry = nil;
+	}
+}
+
+- (void)_forgetEntryWithMemoryCost:(NSUInteger)memoryCost {
+	self.memoryUsage -= MIN(memoryCost, self.memoryUsage);
+	self.numberOfEntries -= MIN(1, self.numberOfEntries);
+}
+
+- (void)removeAllEntries {
+	for (MBTableGridUndoJournalEntry *entry in self.entries.allObjects) {
+		entry.journal = nil;
+		[entry.undoManager removeAllActionsWithTarget:entry];
+	}
+	
+	self.entries = [NSPointerArray weakObjectsPointerArray];
+	self.memoryUsage = 0;
+	self.numberOfEntries = 0;
+	self.lastEntry = nil;
+	[self _closeGroup];
+}
+
+#pragma mark -
+#pragma mark Applying
+
+- (void)_applyEntry:(MBTableGridUndoJournalEntry *)entry {
+	// Keep the entry alive while it's applied, since applying it removes it from the journal
+	MBTableGridUndoJournalEntry *appliedEntry = entry;
+	[self _removeEntry:appliedEntry];
+	
+	if (appliedEntry.handler) {
+		appliedEntry.handler();
+	} else {
+		[self.target undoJournal:self applyEdit:appliedEntry.edit actionName:appliedEntry.actionName];
+	}
+}
+
+@end